@@ -7,6 +7,9 @@
 #include "MvrRobot.h"
 #include "MvrRobotPacket.h"
 #include "MvrRobotConnector.h"
+#include "MvrFastMutex.h"
+
+class MvrIOReactor;
 
 
 
@@ -55,6 +58,10 @@ public:
   MVREXPORT void setDeviceConnection(MvrDeviceConnection *conn);
   /// Gets the device this instance receives packets from
   MVREXPORT MvrDeviceConnection *getDeviceConnection(void);
+  /// Reads packets from this reactor instead of a thread of its own (call before connecting)
+  MVREXPORT void setIOReactor(MvrIOReactor *reactor);
+  /// Gets the reactor packets are read from, or NULL if it has its own thread
+  MvrIOReactor *getIOReactor(void) { return myIOReactor; }
 
 	MVREXPORT int getAsyncConnectState(void);
 
@@ -391,7 +398,7 @@ protected:
 	MvrRobotPacketReceiver *myReceiver;
   MvrRobotPacketSender *mySender;
 
-  MvrMutex myPacketsMutex;
+  MvrFastMutex myPacketsMutex;
   MvrMutex myDataMutex;
 	MvrMutex myDeviceMutex;
 	
@@ -528,6 +535,16 @@ enum Sizes {
   MvrFunctorC<MvrBatteryMTX> mySensorInterpTask;
   MvrRetFunctorC<bool, MvrBatteryMTX> myMvrExitCB;
 
+  // reads packets when using a reactor instead of runThread
+  void reactorReadable(void);
+  // checks for a lost connection when using a reactor
+  void reactorTimeout(void);
+  // reads from the reactor if there is one, otherwise starts runThread
+  void startReading(void);
+  MvrIOReactor *myIOReactor;
+  MvrFunctorC<MvrBatteryMTX> myReactorReadableCB;
+  MvrFunctorC<MvrBatteryMTX> myReactorTimeoutCB;
+
 };
 
 
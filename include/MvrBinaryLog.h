@@ -0,0 +1,92 @@
+#ifndef MVRBINARYLOG_H
+#define MVRBINARYLOG_H
+
+#include "mvriaTypedefs.h"
+#include "MvrLog.h"
+#include "MvrMutex.h"
+#include <stdio.h>
+#include <stdarg.h>
+#include <atomic>
+#include <string>
+
+class MvrBinaryLogFormat;
+
+/// Logs messages as a format id and the raw arguments, and formats them later
+/**
+   MvrLog::log() formats every message with vsnprintf on the thread
+   that logs it, which for messages logged at a high rate (like the
+   packet tracking MvrRobot does) costs more than the rest of logging
+   them.  With MvrBinaryLog the format is registered once with
+   registerFormat(), which works out the types of the arguments from
+   its conversions, then log() just copies the format id, the time and
+   the raw arguments into the calling thread's async log buffer (see
+   MvrLog::setAsync()).
+
+   The MvrLog writer thread then either formats the message and writes
+   it to the normal log like any other message, or if open() was
+   called, appends the record to a binary file instead.
+   decodeFile() (which is what utils/mvrBinaryLogDecode.cpp runs)
+   turns a binary file back into the text MvrLog would have written.
+   If async logging isn't on, the message is formatted (or written to
+   the binary file) right away with the log locked.
+
+   Formats can use any printf conversion (with flags, width, precision,
+   *, and the hh, h, l, ll, L, z, j and t lengths) except for %n and
+   wide characters and strings.  Strings are copied when the message is
+   logged, up to 1024 characters of each.
+
+   Binary files are in the byte order of the machine that wrote them,
+   decodeFile() refuses ones in the other order.
+
+   @ingroup UtilityClasses
+**/
+class MvrBinaryLog
+{
+public:
+  /// Registers a format to log with, returns its id or -1 if it can't be used
+  MVREXPORT static int registerFormat(MvrLog::LogLevel level,
+				      const char *format);
+  /// Logs a message with a format from registerFormat()
+  MVREXPORT static void log(int formatId, ...);
+  /// Logs a message with a format from registerFormat()
+  MVREXPORT static void log_v(int formatId, va_list ptr);
+  /// Writes records to a binary file instead of formatting them
+  MVREXPORT static bool open(const char *fileName);
+  /// Stops writing records to the binary file
+  MVREXPORT static void close(void);
+  /// Gets the name of the binary file being written, empty if there isn't one
+  MVREXPORT static std::string getFileName(void);
+  /// Gets the number of formats that have been registered
+  MVREXPORT static int getNumFormats(void);
+  /// Turns a binary log file back into text
+  MVREXPORT static bool decodeFile(const char *fileName, FILE *out,
+				   bool logTime = true);
+
+  enum {
+    MAX_FORMATS = 4096, ///< The most formats that can be registered
+    MAX_STRING = 1024 ///< The most characters of a string argument kept
+  };
+protected:
+  // writes or formats a record, MvrLog's mutex must be held
+  MVREXPORT static void writeNoLock(const char *buf, size_t len);
+  // flushes the binary file, MvrLog's mutex must be held
+  MVREXPORT static void flushNoLock(void);
+  // gets the format id out of a record, -1 if it is too short
+  MVREXPORT static int getRecordFormatId(const char *buf, size_t len);
+  // puts the time (like MvrLog does) and the formatted message into text
+  MVREXPORT static bool renderRecord(const MvrBinaryLogFormat *format,
+				     const char *buf, size_t len,
+				     bool logTime, std::string *text);
+
+  static MvrMutex ourFormatsMutex;
+  static std::atomic<MvrBinaryLogFormat *> ourFormats[MAX_FORMATS];
+  static std::atomic<int> ourNumFormats;
+  // only used with MvrLog's mutex held
+  static FILE *ourFile;
+  static std::string ourFileName;
+  static int ourNumFormatsWritten;
+
+  friend class MvrLog;
+};
+
+#endif // MVRBINARYLOG_H
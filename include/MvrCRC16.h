@@ -0,0 +1,59 @@
+#ifndef MVRCRC16_H
+#define MVRCRC16_H
+
+#include "mvriaTypedefs.h"
+#include <stddef.h>
+
+/// Calculates CCITT CRC16s (polynomial 0x1021, most significant bit first)
+/**
+   This is the checksum the SICK S300/S3000 and the Keyence SZ
+   safety scanners put on their frames; the S3 series starts it at
+   0xffff and the SZ series starts it at 0.
+
+   Bytes can be added one at a time with update(unsigned char) as
+   they come in off the connection, and blocks of data (like the
+   readings) with update(const unsigned char *, size_t), which works
+   through eight bytes at a time with slicing-by-8 tables instead of
+   one table lookup per byte.  getCRC() can be called at any point and
+   doesn't change the state, and reset() starts over for the next
+   frame.
+
+   @ingroup UtilityClasses
+**/
+class MvrCRC16
+{
+public:
+  /// Constructor, @param initial is the value the CRC starts at
+  MVREXPORT MvrCRC16(unsigned short initial = 0xffff);
+  /// Destructor
+  MVREXPORT ~MvrCRC16();
+  /// Starts the CRC over at the initial value
+  void reset(void) { myCRC = myInitial; }
+  /// Adds one byte to the CRC
+  void update(unsigned char c)
+    { myCRC = (unsigned short)((myCRC << 8) ^ ourTable[0][(myCRC >> 8) ^ c]); }
+  /// Adds a block of bytes to the CRC
+  MVREXPORT void update(const unsigned char *data, size_t length);
+  /// Gets the CRC of everything added since the last reset
+  unsigned short getCRC(void) const { return myCRC; }
+  /// Gets the value the CRC starts at
+  unsigned short getInitial(void) const { return myInitial; }
+  /// Sets the value the CRC starts at (takes effect at the next reset)
+  void setInitial(unsigned short initial) { myInitial = initial; }
+  /// Calculates the CRC of a block of bytes in one go
+  MVREXPORT static unsigned short calculate(const unsigned char *data,
+					   size_t length,
+					   unsigned short initial = 0xffff);
+protected:
+  MVREXPORT static unsigned short updateCRC(unsigned short crc,
+					   const unsigned char *data,
+					   size_t length);
+  unsigned short myInitial;
+  unsigned short myCRC;
+  // ourTable[0] is the usual byte table, ourTable[k] is a byte followed
+  // by k zero bytes
+  MVREXPORT static unsigned short ourTable[8][256];
+  friend class MvrCRC16TableInit;
+};
+
+#endif // MVRCRC16_H
@@ -37,6 +37,21 @@ class MvrDeviceConnection
   */
   MVREXPORT virtual int read(const char *data, unsigned int size, 
 			    unsigned int msWait = 0) = 0;
+  /// Reads whatever data the connection has, waiting for some if there isn't any
+  /**
+     Unlike read() this doesn't keep going until it has size bytes, it
+     waits up to msWait for data to show up and then returns whatever
+     was there (up to size bytes), so it can be used to pull in data a
+     chunk at a time without blocking any longer than needed.  The
+     default does a read() for one byte and then a read() of the rest
+     that doesn't wait, connections that can do better override it.
+     @param data pointer to a character array to read the data into
+     @param size maximum number of bytes to read
+     @param msWait how long to wait for the first data (not at all for == 0)
+     @return number of bytes read (0 if there wasn't any), or -1 for failure
+  */
+  MVREXPORT virtual int readAvailable(const char *data, unsigned int size,
+				      unsigned int msWait = 0);
   /// Writes data to connection
   /**
      Writes data to connection from a packet
@@ -108,6 +123,14 @@ class MvrDeviceConnection
   /// sees if timestamping is really going on or not
   /** @return true if real timestamping is happening, false otherwise */
   MVREXPORT virtual bool isTimeStamping(void) = 0;
+  /// Gets a file descriptor that becomes readable when there's data to read
+  /**
+     This is what lets MvrIOReactor wait on lots of connections with
+     one thread instead of a thread blocked in read() for each.
+     @return the descriptor, or -1 if the connection isn't open or
+     doesn't have one (which is what this base class returns)
+  */
+  virtual int getPollFD(void) { return -1; }
 
   /// Gets the port name
   MVREXPORT const char *getPortName(void) const;
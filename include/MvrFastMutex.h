@@ -0,0 +1,114 @@
+#ifndef MVRFASTMUTEX_H
+#define MVRFASTMUTEX_H
+
+#include "mvriaTypedefs.h"
+#include "MvrMutex.h"
+#include <atomic>
+#include <string>
+#ifdef MVRIA_NO_FAST_MUTEX
+#include <pthread.h>
+#endif
+
+/// Small non-recursive mutex for short critical sections on hot paths
+/**
+   MvrMutex is recursive and checks for logging, lock timing,
+   profiling and recursive nonrecursive locks on every lock() and
+   unlock().  This does none of that: an uncontended lock() or unlock()
+   is one atomic instruction, done inline.  If the mutex is held, lock()
+   spins a little (on machines with more than one CPU) in case the
+   holder is about to let go, then sleeps in the kernel (with a Linux
+   futex) until unlock() wakes it.
+
+   It is meant for data that is only locked for a few instructions at
+   a time and never recursively, like interpolation buffers and packet
+   queues.  Locking it again from the thread that holds it deadlocks
+   and unlocking it from a thread that doesn't hold it is not caught,
+   so use MvrMutex for anything that might, and for anything used with
+   MvrCondition.
+
+   lock(), tryLock() and unlock() return the same things as MvrMutex's
+   do, so switching a member between the two only means changing its
+   type.  Building with MVRIA_NO_FAST_MUTEX defined makes this use a
+   plain pthread mutex instead of the futex, which lets tools like
+   helgrind and ThreadSanitizer see the locking.
+
+   @ingroup UtilityClasses
+**/
+class MvrFastMutex
+{
+public:
+  /// Constructor
+  MVREXPORT MvrFastMutex();
+  /// Copy constructor (gives a new unlocked mutex, like MvrMutex's)
+  MVREXPORT MvrFastMutex(const MvrFastMutex &mutex);
+  /// Destructor
+  MVREXPORT ~MvrFastMutex();
+#ifndef MVRIA_NO_FAST_MUTEX
+  /// Locks the mutex, waiting for it if some other thread has it
+  int lock(void)
+    {
+      int c = UNLOCKED;
+      if (myState.compare_exchange_strong(c, LOCKED, 
+					  std::memory_order_acquire,
+					  std::memory_order_relaxed))
+	return 0;
+      return lockSlow(c);
+    }
+  /// Locks the mutex if nobody has it, returns MvrMutex::STATUS_ALREADY_LOCKED if somebody does
+  int tryLock(void)
+    {
+      int c = UNLOCKED;
+      if (myState.compare_exchange_strong(c, LOCKED, 
+					  std::memory_order_acquire,
+					  std::memory_order_relaxed))
+	return 0;
+      return MvrMutex::STATUS_ALREADY_LOCKED;
+    }
+  /// Unlocks the mutex, waking up a thread waiting for it if there is one
+  int unlock(void)
+    {
+      if (myState.fetch_sub(1, std::memory_order_release) != LOCKED)
+	unlockSlow();
+      return 0;
+    }
+#else
+  int lock(void) 
+    { return pthread_mutex_lock(&myMutex) == 0 ? 0 : MvrMutex::STATUS_FAILED; }
+  int tryLock(void) 
+    { return pthread_mutex_trylock(&myMutex) == 0 ? 
+	0 : MvrMutex::STATUS_ALREADY_LOCKED; }
+  int unlock(void) 
+    { return pthread_mutex_unlock(&myMutex) == 0 ? 0 : MvrMutex::STATUS_FAILED; }
+#endif
+  /// Sets a name for the mutex (only kept so it can be swapped with MvrMutex)
+  void setLogName(const char *logName) { myLogName = logName; }
+  /// Sets a name for the mutex with formatting
+  MVREXPORT void setLogNameVar(const char *logName, ...);
+  /// Gets the name of the mutex
+  const char *getLogName(void) const { return myLogName.c_str(); }
+  /// Sets how many times lock() checks the mutex before sleeping on it
+  void setSpinCount(int spinCount) { mySpinCount = spinCount; }
+  /// Gets how many times lock() checks the mutex before sleeping on it
+  int getSpinCount(void) const { return mySpinCount; }
+protected:
+  enum {
+    UNLOCKED = 0,
+    LOCKED = 1,
+    LOCKED_WAITERS = 2 // locked and something may be sleeping on it
+  };
+  // spins and then sleeps until the lock is ours
+  MVREXPORT int lockSlow(int c);
+  // wakes up a waiter
+  MVREXPORT void unlockSlow(void);
+  // how long to spin by default, 0 if there's only one CPU
+  static int getDefaultSpinCount(void);
+
+  std::atomic<int> myState;
+  int mySpinCount;
+  std::string myLogName;
+#ifdef MVRIA_NO_FAST_MUTEX
+  pthread_mutex_t myMutex;
+#endif
+};
+
+#endif // MVRFASTMUTEX_H
@@ -29,6 +29,7 @@ class MvrFileDeviceConnection: public MvrDeviceConnection
   MVREXPORT virtual const char *getOpenMessage(int err);
   MVREXPORT virtual MvrTime getTimeRead(int index);
   MVREXPORT virtual bool isTimeStamping(void);
+  MVREXPORT virtual int getPollFD(void);
 
   /// If >0 then only read at most this many bytes during read(), regardless of supplied size argument
   void setForceReadBufferSize(unsigned int s) { myForceReadBufferSize = s; }
@@ -0,0 +1,100 @@
+#ifndef MVRIOREACTOR_H
+#define MVRIOREACTOR_H
+
+#include "mvriaTypedefs.h"
+#include "mvriaUtil.h"
+#include "MvrASyncTask.h"
+#include "MvrMutex.h"
+#include "MvrFunctor.h"
+#include <map>
+
+class MvrDeviceConnection;
+
+/// One thread that waits on many device connections at once
+/**
+   Most devices run a thread of their own that sits in a blocking
+   read (or a sleep) waiting for data.  With a lot of devices that is a
+   lot of threads, each waking up on its own.  This instead waits on
+   all the connections added with addConnection() with one epoll
+   call, and calls the readable callback for a connection when it has
+   data (from this thread), or its timeout callback if it hasn't had
+   any for the timeout given.  The callbacks should read what's there
+   (with a read that doesn't wait, or waits very little) and return,
+   since every other connection waits while they run.
+
+   The descriptor comes from MvrDeviceConnection::getPollFD() and is
+   looked at again after each callback and twice a second, so a
+   connection that is closed and opened again (or isn't open yet) is
+   handled; while it isn't open only its timeouts happen.
+
+   Connections can be added and removed from any thread, including from
+   the callbacks.  Once remConnection() returns its callbacks won't be
+   called again, which means it waits for a callback that is running
+   to finish, so don't call it while holding a lock those callbacks
+   take.
+
+   Call runAsync() to start it.  This is Linux only (elsewhere
+   addConnection() fails, and devices keep using their own threads).
+
+   @ingroup UtilityClasses
+**/
+class MvrIOReactor : public MvrASyncTask
+{
+public:
+  /// Constructor
+  MVREXPORT MvrIOReactor(const char *name = "MvrIOReactor");
+  /// Destructor
+  MVREXPORT virtual ~MvrIOReactor();
+  /// Adds a connection (or changes the callbacks of one already added)
+  MVREXPORT bool addConnection(MvrDeviceConnection *conn, 
+			       MvrFunctor *readableCB,
+			       MvrFunctor *timeoutCB = NULL,
+			       unsigned int timeoutMS = 0);
+  /// Removes a connection, returns false if it wasn't added
+  MVREXPORT bool remConnection(MvrDeviceConnection *conn);
+  /// Sees if a connection has been added
+  MVREXPORT bool hasConnection(MvrDeviceConnection *conn);
+  /// Gets how many connections have been added
+  MVREXPORT size_t getNumConnections(void);
+  /// Stops the reactor thread (waking it up so it notices right away)
+  MVREXPORT virtual void stopRunning(void);
+  /// Gets the name
+  const char *getName(void) const { return myName.c_str(); }
+  MVREXPORT virtual void *runThread(void *arg);
+protected:
+  struct Entry
+  {
+    MvrDeviceConnection *myConn;
+    MvrFunctor *myReadableCB;
+    MvrFunctor *myTimeoutCB;
+    unsigned int myTimeoutMS;
+    // the descriptor the connection last had, -1 if none
+    int myFD;
+    // whether epoll is waiting on myFD
+    bool myRegistered;
+    // set when epoll says the descriptor hung up, so it isn't waited
+    // on again until the connection gives us a new one
+    bool myHungUp;
+    MvrTime myDeadline;
+  };
+  // makes epoll wait on whatever descriptor the connection has now
+  // (if check is true it makes sure epoll still has the descriptor,
+  // since closing one and opening another can give the same number)
+  void refresh(unsigned long long id, bool check = false);
+  // wakes up the thread so it sees changes
+  void wakeUp(void);
+  // how long until the next timeout, -1 if there aren't any
+  int getWaitMS(void);
+
+  std::string myName;
+  // held while callbacks run (it is recursive, so they can add and remove)
+  MvrMutex myMutex;
+  std::map<unsigned long long, Entry *> myEntries;
+  std::map<MvrDeviceConnection *, unsigned long long> myIDs;
+  unsigned long long myNextID;
+  int myEpollFD;
+  int myWakeFD;
+  MvrTime myLastCheck;
+};
+
+#endif // MVRIOREACTOR_H
@@ -3,6 +3,7 @@
 
 #include "mvriaTypedefs.h"
 #include "mvriaUtil.h"
+#include "MvrFastMutex.h"
 
 /** 
     Store a buffer of positions (MvrPose objects) with associated timestamps, can
@@ -73,7 +74,7 @@ public:
   /// Empties the interpolated positions
   MVREXPORT void reset(void);
 protected:
-  MvrMutex myDataMutex;
+  MvrFastMutex myDataMutex;
   std::string myName;
   std::list<MvrTime> myTimes;
   std::list<MvrPose> myPoses;
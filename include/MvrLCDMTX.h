@@ -7,6 +7,9 @@
 #include "MvrRobot.h"
 #include "MvrRobotPacket.h"
 #include "MvrRobotConnector.h"
+#include "MvrFastMutex.h"
+
+class MvrIOReactor;
 
 
 
@@ -60,6 +63,10 @@ public:
 	MVREXPORT void setDeviceConnection(MvrDeviceConnection *conn);
 	/// Gets the device this instance receives packets from
 	MVREXPORT MvrDeviceConnection *getDeviceConnection(void);
+	/// Reads packets from this reactor instead of its own thread (call before connecting)
+	MVREXPORT void setIOReactor(MvrIOReactor *reactor);
+	/// Gets the reactor packets are read from, or NULL if its own thread reads them
+	MvrIOReactor *getIOReactor(void) { return myIOReactor; }
 
 	MVREXPORT virtual bool blockingConnect(bool sendTracking, bool recvTracking,
 		int lcdNumber, MvrFunctor1<int> *onCallback,
@@ -284,7 +291,7 @@ protected:
 	MvrRobotPacketReceiver *myReceiver;
 	MvrRobotPacketSender *mySender;
 
-	MvrMutex myPacketsMutex;
+	MvrFastMutex myPacketsMutex;
 	MvrMutex myDataMutex;
 	MvrMutex myDeviceMutex;
 
@@ -369,6 +376,16 @@ protected:
 	MvrFunctorC<MvrLCDMTX> mySensorInterpTask;
 	MvrRetFunctorC<bool, MvrLCDMTX> myMvrExitCB;
 
+	// reads packets when using a reactor instead of runThread
+	void reactorReadable(void);
+	// checks for a lost connection when using a reactor
+	void reactorTimeout(void);
+	// reads from the reactor if there is one, and starts runThread
+	void startReading(void);
+	MvrIOReactor *myIOReactor;
+	MvrFunctorC<MvrLCDMTX> myReactorReadableCB;
+	MvrFunctorC<MvrLCDMTX> myReactorTimeoutCB;
+
 	static std::string ourFirmwareBaseDir;
 };
 
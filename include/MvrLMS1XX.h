@@ -5,12 +5,20 @@
 #include "MvrRobotPacket.h"
 #include "MvrLaser.h"   
 #include "MvrFunctor.h"
+#include "MvrFastMutex.h"
+#include <vector>
 
 /** @internal 
   Constructs packets for LMS1xx ASCII protocol. 
   The various ...ToBuf() methods select argument types and how
 they are written as ascii strings, the protocol is space delimited not fixed
 width values (as in other Packet implementations), so they don't imply number of bytes used in packet output.
+
+  If setBinary() is used the packet is instead a CoLa-B (binary)
+telegram: four STX bytes, a big endian length, the command type and
+name as space separated text, then the arguments as fixed width big
+endian values and an XOR checksum byte.  There the ...ToBuf() and
+bufTo...() methods do imply the number of bytes used.
 */
 class MvrLMS1XXPacket : public MvrBasePacket
 {
@@ -36,6 +44,11 @@ public:
 
   MVREXPORT virtual void duplicatePacket(MvrLMS1XXPacket *packet);
   MVREXPORT virtual void empty(void);
+
+  /// Sets if this is a CoLa-B (binary) packet instead of ASCII, empties the packet
+  MVREXPORT void setBinary(bool binary);
+  /// Gets if this is a CoLa-B (binary) packet instead of ASCII
+  bool isBinary(void) { return myBinary; }
   
   MVREXPORT virtual void byteToBuf(MvrTypes::Byte val);
   MVREXPORT virtual void byte2ToBuf(MvrTypes::Byte2 val);
@@ -52,14 +65,23 @@ public:
   MVREXPORT virtual MvrTypes::UByte2 bufToUByte2(void);
   MVREXPORT virtual MvrTypes::UByte4 bufToUByte4(void);
   MVREXPORT virtual void bufToStr(char *buf, int len);
+  /// Reads up to num values (like bufToUByte2) into values in one go, returns how many it read
+  MVREXPORT int bufToUByte2Array(MvrTypes::UByte2 *values, int num);
+  /// Reads up to num values (like bufToUByte) into values in one go, returns how many it read
+  MVREXPORT int bufToUByteArray(MvrTypes::UByte2 *values, int num);
 
   // adds a raw char to the buf
   MVREXPORT virtual void rawCharToBuf(unsigned char c);
 protected:
   int deascii(char c);
+  void binaryArgsToBuf(void);
+  void binaryTokenFromBuf(char *buf, int len);
 
   MvrTime myTimeReceived;
   bool myFirstAdd;
+  bool myBinary;
+  // if the arguments of a binary packet have started
+  bool myBinaryArgs;
 
   char myCommandType[1024]; 
   char myCommandName[1024]; 
@@ -85,6 +107,15 @@ public:
 					 bool shortcut = false, 
 					 bool ignoreRemainders = false);
 
+  /// Receives a CoLa-B (binary) packet, receivePacket calls this when binary is set
+  MVREXPORT MvrLMS1XXPacket *receiveBinaryPacket(unsigned int msWait = 0,
+					 bool ignoreRemainders = false);
+
+  /// Sets if the laser is talking CoLa-B (binary) instead of ASCII
+  MVREXPORT void setBinary(bool binary);
+  /// Gets if the laser is talking CoLa-B (binary) instead of ASCII
+  bool isBinary(void) { return myBinary; }
+
   /// Sets the device this instance receives packets from
   MVREXPORT void setDeviceConnection(MvrDeviceConnection *conn);
   /// Gets the device this instance receives packets from
@@ -123,6 +154,9 @@ protected:
 
 	int myLaserModel;
 
+  bool myBinary;
+  MvrTime myBinaryReceived;
+
   MvrLog::LogLevel myInfoLogLevel;
 };
 
@@ -135,6 +169,10 @@ protected:
   (aka TiM3xx), TiM551, TiM561, and TiM571  lasers. To use these lasers with MvrLaserConnector, specify 
   the appropriate type in program configuration (lms1xx, lms5xx, tim3xx or
   tim510, tim551, tim561, tim571).
+
+  The LMS1xx and LMS5xx talk ASCII (CoLa-A) by default, choose the
+  binary protocol (-laserProtocol binary or LaserProtocolChoice) to
+  use CoLa-B instead, the laser's own setting has to match.
 */
 class MvrLMS1XX : public MvrLaser
 {
@@ -204,9 +242,14 @@ protected:
 
   LaserModelFamily myLaserModelFamily;
 
+  // if we're talking CoLa-B (binary) to the laser instead of ASCII
+  bool myBinary;
+
   bool myIsConnected;
   bool myTryingToConnect;
   bool myStartConnect;
+  // so skipped 8 bit channels are only logged once per connection
+  bool myLoggedSkipped8Bit;
   int myScanFreq;
 
   int myVersionNumber;
@@ -228,7 +271,6 @@ protected:
   int myNumberEncoders;
   int myNumChans16Bit;
   int myNumChans8Bit;
-  int myFirstReadings;
   int myYear;
   int myMonth;
   int myMonthDay;
@@ -241,10 +283,12 @@ protected:
 
   MvrLMS1XXPacketReceiver myReceiver;
 
-  MvrMutex myPacketsMutex;
+  MvrFastMutex myPacketsMutex;
   MvrMutex myDataMutex;
 
   std::list<MvrLMS1XXPacket *> myPackets;
+  // the values of the channel being read out of a scan
+  std::vector<MvrTypes::UByte2> myChannelValues;
 
   MvrFunctorC<MvrLMS1XX> mySensorInterpTask;
   MvrRetFunctorC<bool, MvrLMS1XX> myMvrExitCB;
@@ -161,13 +161,12 @@ protected:
   MvrFunctorC<MvrLMS2xx> myRobotConnectCB;
   MvrRetFunctor1C<bool, MvrLMS2xx, MvrRobotPacket *> mySimPacketHandler;
   MvrFunctorC<MvrLMS2xx> mySensorInterpCB;
-  std::list<MvrSensorReading *>::iterator myIter;
   bool myStartConnect;
   bool myRunningOnRobot;
 
-  // range buffers to hold current range set and assembling range set
-  std::list<MvrSensorReading *> *myAssembleReadings;
-  std::list<MvrSensorReading *> *myCurrentReadings;
+  // the scan being assembled from the simulator's packets (swapped
+  // with the raw scan once it's all in)
+  MvrScan myAssembleScan;
 
   bool myProcessImmediately;
   bool myInterpolation;
@@ -3,6 +3,7 @@
 
 #include "mvriaTypedefs.h"
 #include "MvrRangeDeviceThreaded.h"
+#include "MvrRangeBufferGrid.h"
 
 class MvrDeviceConnection;
 
@@ -30,7 +31,8 @@ class MvrDeviceConnection;
    The
    canSetDegrees(), canChooseRange(), canSetIncrement(),
    canChooseIncrement(), canChooseUnits(), canChooseReflectorBits(),
-   canSetPowerControlled(), canChooseStartBaud(), and canChooseAutoBaud()  and
+   canSetPowerControlled(), canChooseStartBaud(), canChooseAutoBaud(),
+   and canChooseProtocol() and
 other similar functions are used by MvrLaserConnector to test if a parameter
    is relevant to a specific laser type.
 
@@ -460,6 +462,29 @@ public:
   /** @see canChooseAutoBaud **/
   const char *getAutoBaudChoice(void) { return myAutoBaudChoice.c_str(); }
 
+  /**
+     Gets if you can choose the protocol the laser is talked to with.
+
+     If so, call chooseProtocol with one of the choices in
+     getProtocolChoices, and see what the choice was with
+     getProtocolChoice.
+  **/
+  bool canChooseProtocol(void) { return myCanChooseProtocol; }
+  /// Gets the list of protocol choices 
+  /** @see canChooseProtocol **/
+  std::list<std::string> getProtocolChoices(void) 
+    { return myProtocolChoices; }
+  /// Gets a string with the list of protocol choices seperated by |s 
+  /** @see canChooseProtocol **/
+  const char *getProtocolChoicesString(void) 
+    { return myProtocolChoicesString.c_str(); }
+  /// Sets the protocol to one of the choices from getProtocolChoices
+  /** @see canChooseProtocol **/
+  MVREXPORT bool chooseProtocol(const char *protocol);
+  /// Gets the protocol that was chosen
+  /** @see canChooseProtocol **/
+  const char *getProtocolChoice(void) { return myProtocolChoice.c_str(); }
+
 
   /// Adds a connect callback
   void addConnectCB(MvrFunctor *functor,
@@ -595,6 +620,12 @@ protected:
 	  const char *defaultAutoBaudChoice, 
 	  std::list<std::string> autoBaudChoices);
 
+  /// Allows setting the protocol used to talk to the laser to one of
+  /// a number of choices
+  MVREXPORT void laserAllowProtocolChoices(
+	  const char *defaultProtocolChoice, 
+	  std::list<std::string> protocolChoices);
+
   /// Called when the lasers name is set
   MVREXPORT virtual void laserSetName(const char *name);
   
@@ -619,6 +650,8 @@ protected:
   // processes the individual reading, helper for base class
   MVREXPORT void internalProcessReading(double x, double y, unsigned int range,
 				    bool clean, bool onlyClean);
+  // makes sure the cumulative grid matches the cumulative buffer
+  void internalUpdateCumulativeGrid(void);
 
   // internal helper function for seeing if the choice matches
   MVREXPORT bool internalCheckChoice(const char *check, const char *choice,
@@ -655,6 +688,12 @@ protected:
   int myCumulativeCleanInterval;
   int myCumulativeCleanOffset;
   MvrTime myCumulativeLastClean;
+  // spatial index of the cumulative buffer, and the storage change
+  // count it was last in sync with
+  MvrRangeBufferGrid myCumulativeGrid;
+  bool myCumulativeGridGood;
+  unsigned int myCumulativeGridChangeCount;
+  std::vector<size_t> myCumulativeGridSlots;
   std::set<int> myIgnoreReadings;
 
   unsigned int myAbsoluteMaxRange;
@@ -726,6 +765,12 @@ protected:
   bool myAutoBaudChoiceSet;
   std::string myAutoBaudChoice;
 
+  bool myCanChooseProtocol; 
+  std::list<std::string> myProtocolChoices; 
+  std::string myProtocolChoicesString; 
+  bool myProtocolChoiceSet;
+  std::string myProtocolChoice;
+
   int myDefaultTcpPort;
   std::string myDefaultPortType;
 
@@ -129,6 +129,7 @@ protected:
 	myPowerControlled = true; myPowerControlledReallySet = false; 
 	myStartingBaud = NULL;
 	myAutoBaud = NULL;
+	myProtocol = NULL;
 	myMaxRange = INT_MAX; myMaxRangeReallySet = false; 
 	myAdditionalIgnoreReadings = NULL;
       }
@@ -187,6 +188,8 @@ protected:
     const char *myStartingBaud;
     /// the auto baud we want to use
     const char *myAutoBaud;
+    /// the protocol we want to use
+    const char *myProtocol;
     // if we set a new max range from the command line
     int myMaxRange;
     // if our new max range was really set
@@ -0,0 +1,70 @@
+#ifndef MVRLATENCYHISTOGRAM_H
+#define MVRLATENCYHISTOGRAM_H
+
+#include "mvriaTypedefs.h"
+#include <atomic>
+#include <string>
+
+/// Fixed size histogram of how long something took, in microseconds
+/**
+   Everything is allocated up front, so add() never touches the heap
+   and never locks anything, which makes it cheap enough to do on every
+   task every cycle (MvrSyncTask keeps one of these for each node).
+
+   Times are counted in buckets that are exact below 64 us and then
+   split each power of two into 32 buckets, so percentiles are within
+   about 3% of the real value, for anything up to about 71 minutes.
+   The last NUM_RECENT times are kept as they were too.
+
+   add() should only be called from one thread (the one running the
+   thing being timed), everything else can be called from any thread,
+   though what is read while add() is going on may be a sample behind.
+
+   @ingroup UtilityClasses
+**/
+class MvrLatencyHistogram
+{
+public:
+  enum {
+    NUM_RECENT = 64, ///< How many of the most recent times are kept
+    NUM_BUCKETS = 896 ///< How many buckets the times are counted in
+  };
+  /// Constructor
+  MVREXPORT MvrLatencyHistogram();
+  /// Destructor
+  MVREXPORT virtual ~MvrLatencyHistogram();
+  /// Adds a time, in microseconds
+  MVREXPORT void add(unsigned int uSecs);
+  /// Throws away everything that has been added
+  MVREXPORT void reset(void);
+  /// Gets how many times have been added
+  MVREXPORT unsigned long long getCount(void) const;
+  /// Gets the shortest time added (0 if there haven't been any)
+  MVREXPORT unsigned int getMin(void) const;
+  /// Gets the longest time added
+  MVREXPORT unsigned int getMax(void) const;
+  /// Gets the average time added
+  MVREXPORT double getMean(void) const;
+  /// Gets the time that this fraction (0 to 1) of the times were at or under
+  MVREXPORT unsigned int getPercentile(double fraction) const;
+  /// Gets the most recent times added, oldest first, returns how many it got
+  MVREXPORT int getRecent(unsigned int *uSecs, int maxNum) const;
+  /// Gets a one line summary (count, mean, min, p50, p99, p99.9, max in ms)
+  MVREXPORT std::string getSummary(int numRecent = 0) const;
+protected:
+  // which bucket a time goes in
+  static int getBucket(unsigned int uSecs);
+  // the longest time that goes in a bucket
+  static unsigned int getBucketMax(int bucket);
+
+  std::atomic<unsigned int> myBuckets[NUM_BUCKETS];
+  std::atomic<unsigned long long> myCount;
+  std::atomic<unsigned long long> mySum;
+  std::atomic<unsigned int> myMin;
+  std::atomic<unsigned int> myMax;
+  std::atomic<unsigned int> myRecent[NUM_RECENT];
+  // how many have ever gone into myRecent (so where the next one goes)
+  std::atomic<unsigned long long> myRecentNum;
+};
+
+#endif // MVRLATENCYHISTOGRAM_H
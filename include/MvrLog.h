@@ -5,11 +5,15 @@
 #include <stdio.h>
 #endif
 #include <string>
+#include <atomic>
+#include <stddef.h>
 #include "mvriaTypedefs.h"
 #include "MvrMutex.h"
 #include "MvrFunctor.h"
 
 class MvrConfig;
+class MvrFunctorASyncTask;
+class MvrLogAsyncRing;
 
 /// Logging utility class
 /**
@@ -19,11 +23,24 @@ class MvrConfig;
    of logging can be changed as well. Allowed levels are Terse, Normal,
    and Verbose. By default the level is set to Normal.
 
+   Normally every message is formatted, written and flushed by the
+   thread that logs it, with the log mutex held the whole time.  After
+   setAsync(true) messages are formatted by the thread that logs them
+   into a ring buffer of its own (so logging threads don't lock
+   anything or wait on the disk), and a background writer thread takes
+   them out of all the rings in the order they were logged, writes
+   them out in batches and flushes once per batch.  What happens when a
+   thread logs faster than the writer keeps up is set with
+   setAsyncOverflowPolicy().  flush() writes out everything logged so
+   far, Mvria::exit() and MvrSignalHandler call it so nothing is lost
+   on the way out.
+
    @ingroup ImportantClasses
    @ingroup easy
 */
 class MvrLog
 {
+  friend class MvrBinaryLog;
 public:
 
   typedef enum {
@@ -38,6 +55,11 @@ public:
     Normal, ///< Use normal logging
     Verbose ///< Use verbose logging
   } LogLevel;
+  typedef enum {
+    AsyncDrop, ///< Throw away messages that don't fit in the buffer
+    AsyncBlock, ///< Wait for the writer thread to make room for messages
+    AsyncCount ///< Throw away messages that don't fit, and log how many were thrown away
+  } AsyncOverflowPolicy;
 
 #ifndef SWIG
   /** @brief Log a message, with formatting and vmvriable number of arguments
@@ -92,6 +114,19 @@ public:
   /// Set log level
   MVREXPORT static void setLogLevel(LogLevel level);
 
+  /// Turns logging from a background writer thread on or off
+  MVREXPORT static bool setAsync(bool async, size_t bufferSize = 65536);
+  /// Gets whether logging is being done by the background writer thread
+  MVREXPORT static bool getAsync(void);
+  /// Sets what to do when a thread's async log buffer is full
+  MVREXPORT static void setAsyncOverflowPolicy(AsyncOverflowPolicy policy);
+  /// Gets what is done when a thread's async log buffer is full
+  MVREXPORT static AsyncOverflowPolicy getAsyncOverflowPolicy(void);
+  /// Gets how many messages async logging has thrown away
+  MVREXPORT static size_t getAsyncNumDropped(void);
+  /// Writes out everything that has been logged so far
+  MVREXPORT static void flush(void);
+
 #ifndef MVRINTERFACE
   // Init for aram behavior
   /// @internal
@@ -132,6 +167,17 @@ protected:
 #endif
   MVREXPORT static void invokeFunctor(const char *message);
   MVREXPORT static void checkFileSize(void);
+  // formats a message and gives it to the writer thread, false if
+  // async logging isn't running or the message couldn't be queued
+  MVREXPORT static bool asyncLog_v(LogLevel level, const char *prefix,
+				   const char *str, va_list ptr);
+  MVREXPORT static bool asyncLog(LogLevel level, const char *str, ...);
+  MVREXPORT static bool asyncPush(const char *buf, size_t len,
+				  bool binary = false);
+  // takes everything out of the rings and writes it, ourMutex must be held
+  MVREXPORT static size_t asyncDrainNoLock(void);
+  MVREXPORT static void asyncWriteNoLock(const char *buf, size_t len);
+  MVREXPORT static void *asyncWriterThread(void *arg);
 
   static MvrLog *ourLog;
   static MvrMutex ourMutex;
@@ -164,6 +210,21 @@ protected:
   
   static MvrFunctor1<const char *> *ourFunctor;
 
+  enum { ASYNC_MAX_THREADS = 256, ASYNC_MAX_RECORD = 10240 };
+  // set in a record's length if it is an MvrBinaryLog record
+  static const unsigned int ASYNC_BINARY_RECORD = 0x80000000u;
+  static std::atomic<bool> ourAsyncRunning;
+  static std::atomic<bool> ourAsyncWriterDone;
+  static std::atomic<int> ourAsyncOverflowPolicy;
+  static std::atomic<size_t> ourAsyncBufferSize;
+  static std::atomic<size_t> ourAsyncDropped;
+  static size_t ourAsyncDroppedReported;
+  static std::atomic<unsigned long long> ourAsyncSequence;
+  // one ring for each thread that has logged, NULL slots are free
+  static std::atomic<MvrLogAsyncRing *> ourAsyncRings[ASYNC_MAX_THREADS];
+  static MvrFunctorASyncTask *ourAsyncWriter;
+  static MvrGlobalRetFunctor1<void *, void *> ourAsyncWriterCB;
+
 };
 
 
@@ -5,10 +5,13 @@
 #include <pthread.h>
 #endif
 #include <string>
+#include <list>
+#include <atomic>
 #include "mvriaTypedefs.h"
 
 class MvrTime;
 class MvrFunctor;
+class MvrMutexProfile;
 
 /// Cross-platform mutex wrapper class 
 /**
@@ -42,6 +45,12 @@ other undesired effects of lock contention.
       long time.
     <li>Use setLogName() to name an MvrMutex object for logging.
     <li>Use setLog() to enable logging of various events such as lock, unlock, errors.
+    <li>Use setProfiling() to keep track of how often each mutex is
+      locked, how often and how long threads wait for it, how long it is
+      held and which threads wait the most (by the name given to
+      setLogName(), so all the mutexes with the same name are counted
+      together), then getProfileReport() or logProfile() to see it (or
+      setProfileDumpInterval() to log it every so often).
   </ul>
 
   @ingroup UtilityClasses
@@ -129,8 +138,9 @@ public:
     descriptive name for a thread.
   */
   void setLog(bool log) { myLog = log; } 
-  /// Sets a name we'll use to log with
-  void setLogName(const char *logName) { myLogName = logName; } 
+  /// Sets a name we'll use to log with (and profile under)
+  void setLogName(const char *logName) 
+    { myLogName = logName; myProfile = NULL; } 
 #ifndef SWIG
   /// Sets a name we'll use to log with formatting
   /** @swigomit use setLogName() */
@@ -158,6 +168,19 @@ public:
   */
   static double getUnlockWarningTime(void)
     { return ourUnlockWarningMS/1000.0; }
+  /// Turns the contention profiling of all mutexes on or off
+  MVREXPORT static void setProfiling(bool profiling);
+  /// Gets whether mutexes are being profiled
+  static bool getProfiling(void) { return ourProfiling; }
+  /// Throws away what has been profiled so far
+  MVREXPORT static void resetProfile(void);
+  /// Puts a line for each mutex that has been profiled into lines, most waited for first
+  MVREXPORT static void getProfileReport(std::list<std::string> *lines,
+					 int maxMutexes = 0);
+  /// Logs the profile report
+  MVREXPORT static void logProfile(int maxMutexes = 0);
+  /// Logs the profile report every so many ms while profiling (0 to stop)
+  MVREXPORT static void setProfileDumpInterval(unsigned int ms);
 protected:
   
   bool myFailedInit;
@@ -191,6 +214,17 @@ protected:
   // Check time it took between lock and unlock against ourUnlockWarningMS and log about it
   void checkUnlockTime();
 
+  // finds (or makes) the profile for myLogName
+  MvrMutexProfile *getProfile(void);
+  // locks myMutex, keeping track of how long it had to wait if profiling
+  int profiledLock(void);
+  // these are only changed by the thread holding the lock
+  MvrMutexProfile *myProfile;
+  int myProfileDepth;
+  unsigned long long myProfileLockedUSec;
+  // set from one thread and read by every lock, so atomic
+  MVREXPORT static std::atomic<bool> ourProfiling;
+
 
   static MvrFunctor *ourNonRecursiveDeadlockFunctor;
 };
@@ -7,6 +7,7 @@
 #include "mvriaUtil.h"
 
 #include <list>
+#include <vector>
 
 
 class MvrRobot;
@@ -42,6 +43,16 @@ class MvrArgumentBuilder;
    lock/sendToAllClients/unlock method is if you're highly concerned
    about synchronizing the different types of output.
 
+   If setUseEpoll() is turned on before open() (it only works on
+   Linux) the server uses epoll to find out which clients have sent
+   something instead of trying to read from every client every cycle,
+   and everything written to a client goes through a queue on its
+   socket (see MvrSocket::setWriteQueueLimit()) that gets sent as the
+   client takes it, so writing never waits on a client.  A client
+   that lets more than setMaxClientOutputQueue() bytes back up is
+   disconnected.  Commands are still run from runOnce() (so in the
+   robot's sync loop if the server was opened with a robot).
+
     @ingroup OptionalClasses
 **/
 class MvrNetServer
@@ -133,6 +144,18 @@ public:
   /// Gets whether we're using the wrong (legacy) end chars or not
   MVREXPORT bool getUseWrongEndChars(void);
 
+  /// Sets whether to use epoll and queued writes (call before open())
+  MVREXPORT void setUseEpoll(bool useEpoll);
+
+  /// Gets whether we're using epoll and queued writes
+  MVREXPORT bool getUseEpoll(void);
+
+  /// Sets how much output can back up for a client before it is disconnected
+  MVREXPORT void setMaxClientOutputQueue(size_t maxBytes);
+
+  /// Gets how much output can back up for a client before it is disconnected
+  MVREXPORT size_t getMaxClientOutputQueue(void);
+
   /// the internal sync task we use for our loop
   MVREXPORT void runOnce(void);
 
@@ -150,6 +173,9 @@ public:
   /// The internal function for shutting down
   MVREXPORT void internalShutdownServer(char **argv, int argc, 
 				       MvrSocket *socket);
+  /// The internal function for showing the sync task latencies
+  MVREXPORT void internalTaskLatencies(char **argv, int argc, 
+				      MvrSocket *socket);
   /// The internal function for parsing a command on a socket
   MVREXPORT void parseCommandOnSocket(MvrArgumentBuilder *args, 
 				     MvrSocket *socket, bool allowLog = true);
@@ -170,6 +196,17 @@ public:
   /// Unlock the server
   MVREXPORT int unlock() {return(myMutex.unlock());}
 protected:
+  // sets a client's socket up for epoll mode
+  void epollAdd(MvrSocket *socket);
+  // stops epoll from watching a client's socket
+  void epollRemove(MvrSocket *socket);
+  // fills in myReadySockets, returns true if someone is trying to connect
+  bool epollWait(void);
+  // sees if a socket was in the last epollWait
+  bool isReady(MvrSocket *socket);
+  // sends what's queued for the clients and drops the ones too far behind
+  void flushClients(void);
+
   std::string myName;
   MvrNetServer *myChildServer;
   MvrMutex myMutex;
@@ -191,6 +228,12 @@ protected:
   std::list<MvrSocket *> myConns;
   std::list<MvrSocket *> myConnectingConns;
   std::list<MvrSocket *> myDeleteList;
+
+  bool myUseEpoll;
+  size_t myMaxClientOutputQueue;
+  int myEpollFD;
+  // the clients epoll said had data this cycle, sorted
+  std::vector<MvrSocket *> myReadySockets;
   
   MvrMutex myNextCycleSendsMutex;
   std::list<std::string> myNextCycleSends;
@@ -200,6 +243,7 @@ protected:
   MvrFunctor3C<MvrNetServer, char **, int, MvrSocket *> myEchoCB;
   MvrFunctor3C<MvrNetServer, char **, int, MvrSocket *> myQuitCB;
   MvrFunctor3C<MvrNetServer, char **, int, MvrSocket *> myShutdownServerCB;
+  MvrFunctor3C<MvrNetServer, char **, int, MvrSocket *> myTaskLatenciesCB;
   MvrFunctorC<MvrNetServer> myMvrExitCB;
 };
 
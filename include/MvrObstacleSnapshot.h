@@ -0,0 +1,114 @@
+#ifndef MVROBSTACLESNAPSHOT_H
+#define MVROBSTACLESNAPSHOT_H
+
+#include "mvriaTypedefs.h"
+#include "mvriaUtil.h"
+#include "MvrMutex.h"
+#include "MvrRangeRegion.h"
+#include <list>
+#include <vector>
+
+class MvrRangeDevice;
+
+/// Snapshot of the current readings of a set of range devices, in robot coordinates
+/**
+   MvrRobot uses this to answer MvrRobot::checkRangeDevicesCurrentPolar()
+   and MvrRobot::checkRangeDevicesCurrentBox() once sensor
+   interpretation is done for the cycle, instead of locking and
+   walking every range device's buffer for every call.
+
+   build() locks each device once and copies the readings of its
+   current buffer out.  For polar queries the readings are kept sorted
+   by angle from the robot along with a table of range minimums, so a
+   query is a couple of binary searches and a lookup.  For box queries
+   the readings are kept in robot local coordinates sorted by x, so a
+   query only looks at the readings in the box's x span.
+
+   The answers are the same as the devices' own
+   MvrRangeDevice::currentReadingPolar() and
+   MvrRangeDevice::currentReadingBox() give for the same readings and
+   robot pose, but come from the readings in the buffers when build()
+   was called.
+
+   This should be locked (lock()) around building and querying it.
+**/
+class MvrObstacleSnapshot
+{
+public:
+  /// Constructor
+  MVREXPORT MvrObstacleSnapshot();
+  /// Destructor
+  MVREXPORT virtual ~MvrObstacleSnapshot();
+  /// Builds the snapshot from the current buffers of the devices
+  MVREXPORT void build(const std::list<MvrRangeDevice *> *devices,
+		       MvrPose robotPose, unsigned int counter);
+  /// Marks the snapshot as out of date
+  void invalidate(void) { myValid = false; }
+  /// Sees if the snapshot was built for this cycle and robot pose
+  bool isValid(unsigned int counter, MvrPose robotPose) const
+    {
+      return (myValid && myCounter == counter &&
+	      myRobotPose.getX() == robotPose.getX() &&
+	      myRobotPose.getY() == robotPose.getY() &&
+	      myRobotPose.getTh() == robotPose.getTh());
+    }
+  /// Same as MvrRobot::checkRangeDevicesCurrentPolar but from the snapshot
+  MVREXPORT double checkCurrentPolar(
+	  double startAngle, double endAngle, double *angle,
+	  const MvrRangeDevice **rangeDevice,
+	  bool useLocationDependentDevices) const;
+  /// Same as MvrRobot::checkRangeDevicesCurrentBox but from the snapshot
+  MVREXPORT double checkCurrentBox(
+	  double x1, double y1, double x2, double y2,
+	  MvrPose *readingPos, const MvrRangeDevice **rangeDevice,
+	  bool useLocationDependentDevices) const;
+  /// Same as MvrRobot::checkRangeDevicesCurrentRegions but from the snapshot
+  MVREXPORT void checkCurrentRegions(
+	  MvrRangeRegion *regions, size_t numRegions,
+	  bool useLocationDependentDevices) const;
+  /// Lock the snapshot
+  int lock(void) { return myMutex.lock(); }
+  /// Unlock the snapshot
+  int unlock(void) { return myMutex.unlock(); }
+protected:
+  // the readings from one device
+  class DeviceData
+  {
+  public:
+    const MvrRangeDevice *myDevice;
+    bool myLocationDependent;
+    unsigned int myMaxRange;
+    // sorted by angle from the robot
+    std::vector<double> myAngles;
+    std::vector<double> myDists;
+    // myMinTable[k][i] is the index of the smallest of myDists[i]
+    // through myDists[i + 2^k - 1]
+    std::vector<std::vector<unsigned int> > myMinTable;
+    // in robot local coordinates, sorted by x
+    std::vector<double> myBoxX;
+    std::vector<double> myBoxY;
+    double myBoxTh;
+  };
+  // builds the polar and box parts for the readings in myPoints
+  void buildDevice(DeviceData *data, MvrPose robotPose);
+  // gets the index of the smallest distance in [first, last)
+  unsigned int rangeMin(const DeviceData *data, size_t first,
+			size_t last) const;
+  // same as MvrRangeDevice::currentReadingPolar for one device
+  double devicePolar(const DeviceData *data, double startAngle,
+		     double endAngle, double *angle) const;
+  // same as MvrRangeDevice::currentReadingBox for one device
+  double deviceBox(const DeviceData *data, double x1, double y1,
+		   double x2, double y2, MvrPose *readingPos) const;
+
+  MvrMutex myMutex;
+  bool myValid;
+  unsigned int myCounter;
+  MvrPose myRobotPose;
+  std::vector<DeviceData> myDevices;
+  // scratch space for building
+  std::vector<std::pair<double, double> > myPoints;
+  std::vector<std::pair<double, double> > mySortPairs;
+};
+
+#endif // MVROBSTACLESNAPSHOT_H
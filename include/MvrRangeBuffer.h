@@ -4,10 +4,20 @@
 #include "mvriaUtil.h"
 #include "mvriaTypedefs.h"
 #include "MvrTransform.h"
+#include "MvrRangeBufferStorage.h"
+#include "MvrRangeRegion.h"
 #include <list>
 #include <vector>
 
 /// This class is a buffer that holds ranging information
+/**
+   The readings are kept in an MvrRangeBufferStorage (contiguous x, y
+   and time arrays, see getStorage()).  The std::list returned by
+   getBuffer() is a compatibility view that is rebuilt from the
+   storage when it is asked for after the readings changed, so call
+   getBuffer() again instead of holding on to the list between
+   changes.
+**/
 class MvrRangeBuffer
 {
 public:
@@ -38,6 +48,8 @@ public:
   MVREXPORT void beginInvalidationSweep(void);
   /// While doing an invalidation sweep a reading to the list to be invalidated
   MVREXPORT void invalidateReading(std::list<MvrPoseWithTime*>::iterator readingIt);
+  /// While doing an invalidation sweep a reading (by storage index) to be invalidated
+  MVREXPORT void invalidateReading(size_t index);
   /// Ends the invalidation sweep
   MVREXPORT void endInvalidationSweep(void);
 
@@ -45,6 +57,11 @@ public:
    *  @swigomit
    */
   MVREXPORT const std::list<MvrPoseWithTime *> *getBuffer(void) const;
+
+  /** @brief Gets the storage the readings are actually kept in
+   *  @swigomit
+   */
+  const MvrRangeBufferStorage *getStorage(void) const { return &myStorage; }
 #endif
   /// Gets a pointer to a list of readings
   MVREXPORT std::list<MvrPoseWithTime *> *getBuffer(void);
@@ -58,6 +75,10 @@ public:
 				MvrPose position, unsigned int maxRange, 
 				MvrPose *readingPos = NULL,
 				MvrPose targetPose = MvrPose(0, 0, 0)) const;
+  /// Gets the closest reading in each of several regions, in one pass
+  MVREXPORT void getClosestInRegions(MvrRangeRegion *regions, 
+				     size_t numRegions, MvrPose position,
+				     unsigned int maxRange) const;
   /// Applies a transform to the buffer
   MVREXPORT void applyTransform(MvrTransform trans);
   /// Clears all the readings in the range buffer
@@ -86,24 +107,44 @@ public:
 	  double x1, double y1, double x2, double y2, MvrPose position, 
 	  unsigned int maxRange, MvrPose *readingPos, 
 	  MvrPose targetPose, const std::list<MvrPoseWithTime *> *buffer);
+  /// Gets the closest reading, from an arbitrary storage
+  MVREXPORT static double getClosestPolarInStorage(
+	  double startAngle, double endAngle, MvrPose position, 
+	  unsigned int maxRange, double *angle, 
+	  const MvrRangeBufferStorage *storage);
+  /// Gets the closest reading, from an arbitrary storage
+  MVREXPORT static double getClosestBoxInStorage(
+	  double x1, double y1, double x2, double y2, MvrPose position, 
+	  unsigned int maxRange, MvrPose *readingPos, 
+	  MvrPose targetPose, const MvrRangeBufferStorage *storage);
+  /// Gets the closest reading in several regions, from an arbitrary storage
+  MVREXPORT static void getClosestInRegionsInStorage(
+	  MvrRangeRegion *regions, size_t numRegions, MvrPose position, 
+	  unsigned int maxRange, const MvrRangeBufferStorage *storage);
 protected:
+  // rebuilds the list that getBuffer returns if the storage changed
+  void updateBufferView(void) const;
+
   std::vector<MvrPoseWithTime> myVector;
   MvrPose myBufferPose;		// where the robot was when readings were acquired
   MvrPose myEncoderBufferPose;		// where the robot was when readings were acquired
 
-  std::list<MvrPoseWithTime *> myBuffer;
-  std::list<MvrPoseWithTime *> myInvalidBuffer;
-  std::list<std::list<MvrPoseWithTime *>::iterator > myInvalidSweepList;
-  std::list<std::list<MvrPoseWithTime *>::iterator >::iterator myInvalidIt;
-  std::list<MvrPoseWithTime *>::iterator myRedoIt;
+  MvrRangeBufferStorage myStorage;
+
+  // the compatibility view of the storage for getBuffer, the list
+  // points into myBufferPoses
+  mutable std::list<MvrPoseWithTime *> myBuffer;
+  mutable std::vector<MvrPoseWithTime> myBufferPoses;
+  mutable bool myBufferViewGood;
+  mutable unsigned int myBufferViewChangeCount;
+
+  std::vector<unsigned char> myInvalidMarks;
+  bool myInvalidAny;
+  size_t myRedoIndex;
   int myNumRedone;
   bool myHitEnd;
   
   size_t mySize;
-  std::list<MvrPoseWithTime *>::reverse_iterator myRevIterator;
-  std::list<MvrPoseWithTime *>::iterator myIterator;
-  
-  MvrPoseWithTime * myReading;
 };
 
 #endif // ARRANGEBUFFER_H
@@ -0,0 +1,80 @@
+#ifndef MVRRANGEBUFFERGRID_H
+#define MVRRANGEBUFFERGRID_H
+
+#include "mvriaTypedefs.h"
+#include "MvrRangeBufferStorage.h"
+#include <vector>
+
+/// Spatial hash of the readings in an MvrRangeBufferStorage
+/**
+   This keeps the slots (see MvrRangeBufferStorage::getSlot()) of
+   readings in a uniform grid of square cells, with the cells hashed
+   into a fixed number of buckets, so that finding the readings near a
+   point or near a line segment only has to look at the buckets for
+   the cells around it instead of every reading.
+
+   The grid doesn't watch the storage, whoever owns it has to call
+   add() and remove() as readings come and go, or rebuild() after
+   anything else changes the storage (MvrRangeBufferStorage::getChangeCount()
+   is handy for noticing that).
+
+   The queries return every slot in the buckets they look at, which is
+   a superset of the readings actually in range (cells can share
+   buckets), so callers still need to check the real distance.  Each
+   slot is returned at most once per query.
+
+   @ingroup UtilityClasses
+**/
+class MvrRangeBufferGrid
+{
+public:
+  /// Constructor
+  MVREXPORT MvrRangeBufferGrid(double cellSize = 400);
+  /// Destructor
+  MVREXPORT virtual ~MvrRangeBufferGrid();
+  /// Sets the size of the cells (in mm), this empties the grid
+  MVREXPORT void setCellSize(double cellSize);
+  /// Gets the size of the cells (in mm)
+  double getCellSize(void) const { return myCellSize; }
+  /// Empties the grid and puts all the readings from storage in it
+  MVREXPORT void rebuild(const MvrRangeBufferStorage *storage);
+  /// Empties the grid
+  MVREXPORT void clear(void);
+  /// Adds the reading in slot (at x, y) to the grid
+  MVREXPORT void add(size_t slot, double x, double y);
+  /// Removes the reading in slot (that was added at x, y) from the grid
+  MVREXPORT bool remove(size_t slot, double x, double y);
+  /// Gets the slots that may be within dist of x, y
+  MVREXPORT void getSlotsNearPoint(double x, double y, double dist,
+				   std::vector<size_t> *slots);
+  /// Gets the slots that may be within dist of the line segment
+  MVREXPORT void getSlotsNearSegment(double x1, double y1,
+				     double x2, double y2, double dist,
+				     std::vector<size_t> *slots);
+  /// Gets the number of readings in the grid
+  size_t getNumEntries(void) const { return myNumEntries; }
+protected:
+  long cellOf(double v) const
+    { return (long)floor(v / myCellSize); }
+  size_t bucketOf(long cellX, long cellY) const
+    {
+      return ((size_t)(cellX * 73856093L) ^ (size_t)(cellY * 19349663L)) &
+	(myBuckets.size() - 1);
+    }
+  // sizes the buckets for about this many readings
+  void setNumBuckets(size_t numReadings);
+  // starts a new query
+  void nextQuery(void);
+  // puts the slots from all the cells in the given range in slots
+  void gatherCells(long cellXMin, long cellXMax, long cellYMin,
+		   long cellYMax, std::vector<size_t> *slots);
+
+  double myCellSize;
+  std::vector<std::vector<size_t> > myBuckets;
+  // which query last looked at each bucket, so we only look once
+  std::vector<unsigned int> myBucketQuery;
+  unsigned int myQuery;
+  size_t myNumEntries;
+};
+
+#endif // MVRRANGEBUFFERGRID_H
@@ -0,0 +1,107 @@
+#ifndef MVRRANGEBUFFERKERNELS_H
+#define MVRRANGEBUFFERKERNELS_H
+
+#include "mvriaTypedefs.h"
+#include <stddef.h>
+
+/// Vectorized searches over contiguous x and y arrays of readings
+/**
+   These are the inner loops of MvrRangeBuffer::getClosestPolar() and
+   MvrRangeBuffer::getClosestBox() (see MvrRangeBufferStorage::getSpans()
+   for where the arrays come from).  They only compare squared
+   distances and, for the polar search, check the sector with cross
+   products instead of atan2, so the caller only has to do the one
+   sqrt and atan2 for the reading that was closest.
+
+   There are SSE2 and AVX2 versions along with a plain one, which one
+   is used is picked when the library is loaded based on what the CPU
+   supports (it can be changed with setLevel(), which is mostly for
+   testing and benchmarking).
+
+   Each search looks for a reading whose squared distance is strictly
+   less than *bestDistSq, and if it finds one it sets *bestDistSq and
+   returns the index of it (the earliest one if there's a tie),
+   otherwise it returns -1.  That way the searches can be chained over
+   several arrays by passing the same bestDistSq in.
+
+   @ingroup UtilityClasses
+**/
+class MvrRangeBufferKernels
+{
+public:
+  /// The instruction sets the searches can use
+  enum Level
+  {
+    SCALAR, ///< Plain C++
+    SSE2, ///< Two readings at a time
+    AVX2 ///< Four readings at a time
+  };
+
+  /// Finds the closest reading in a sector around a point
+  /**
+     The sector is the part of the circle going counterclockwise from
+     the start direction to the end direction, not including the edges
+     (like MvrMath::angleBetween()).
+
+     @param x the x coordinates of the readings
+     @param y the y coordinates of the readings
+     @param num the number of readings
+     @param originX the x of the point to search around
+     @param originY the y of the point to search around
+     @param startDirX the x of the unit vector for the start of the sector
+     @param startDirY the y of the unit vector for the start of the sector
+     @param endDirX the x of the unit vector for the end of the sector
+     @param endDirY the y of the unit vector for the end of the sector
+     @param wide true if the sector is more than 180 degrees
+     @param bestDistSq the squared distance to beat, set if something beats it
+     @return the index of the reading that beat bestDistSq, or -1
+  **/
+  MVREXPORT static long closestInSector(
+	  const double *x, const double *y, size_t num,
+	  double originX, double originY,
+	  double startDirX, double startDirY,
+	  double endDirX, double endDirY, bool wide,
+	  double *bestDistSq);
+
+  /// Finds the closest reading in a box, after transforming the readings
+  /**
+     Each reading is transformed the same way as MvrTransform::doTransform()
+     does (x' = transX + cos * x + sin * y, y' = transY + cos * y -
+     sin * x), then checked against the box (edges included) and its
+     squared distance to the target is checked.
+
+     @param x the x coordinates of the readings
+     @param y the y coordinates of the readings
+     @param num the number of readings
+     @param transCos the cos of the transform
+     @param transSin the sin of the transform
+     @param transX the x offset of the transform
+     @param transY the y offset of the transform
+     @param x1 the smaller x of the box
+     @param y1 the smaller y of the box
+     @param x2 the larger x of the box
+     @param y2 the larger y of the box
+     @param targetX the x of the point to find the closest reading to
+     @param targetY the y of the point to find the closest reading to
+     @param bestDistSq the squared distance to beat, set if something beats it
+     @return the index of the reading that beat bestDistSq, or -1
+  **/
+  MVREXPORT static long closestInBox(
+	  const double *x, const double *y, size_t num,
+	  double transCos, double transSin, double transX, double transY,
+	  double x1, double y1, double x2, double y2,
+	  double targetX, double targetY, double *bestDistSq);
+
+  /// Gets the instruction set the searches are using
+  MVREXPORT static Level getLevel(void);
+  /// Sets the instruction set the searches use (if the CPU supports it)
+  MVREXPORT static bool setLevel(Level level);
+  /// Gets the best instruction set the CPU supports
+  MVREXPORT static Level getBestLevel(void);
+  /// Gets the name of an instruction set
+  MVREXPORT static const char *getLevelName(Level level);
+protected:
+  static Level ourLevel;
+};
+
+#endif // MVRRANGEBUFFERKERNELS_H
@@ -0,0 +1,178 @@
+#ifndef MVRRANGEBUFFERSTORAGE_H
+#define MVRRANGEBUFFERSTORAGE_H
+
+#include "mvriaTypedefs.h"
+#include "mvriaUtil.h"
+#include <vector>
+
+/// Contiguous fixed-capacity storage for the readings of an MvrRangeBuffer
+/**
+   The readings are kept in a ring of parallel x, y and time arrays
+   (structure of arrays) instead of a list of heap allocated poses, so
+   walking all the readings only touches a few contiguous blocks of
+   memory.
+
+   Readings are indexed from 0 (the newest) to size() - 1 (the
+   oldest), which is the same order MvrRangeBuffer::getBuffer() has
+   always had.  Once the storage is full adding a reading overwrites
+   the oldest one.
+
+   The iterators walk the readings newest to oldest.  For bulk work
+   where the order doesn't matter getSpans() gives out the (at most
+   two) contiguous runs of the ring, so the x and y arrays can be
+   walked directly.
+
+   Each reading also has a slot, which is where it is in the arrays.
+   Unlike the index a reading's slot doesn't change as newer readings
+   are added, it only changes when readings are removed (or the
+   capacity changes), which makes slots useful for keeping other
+   structures (like an MvrRangeBufferGrid) pointed at readings.
+
+   This class does no locking, the range device that owns the
+   MvrRangeBuffer should be locked while using it.
+
+   @ingroup UtilityClasses
+**/
+class MvrRangeBufferStorage
+{
+public:
+  /// A contiguous run of readings from the storage
+  struct Span
+  {
+    /// x coordinates of the readings in this run
+    const double *x;
+    /// y coordinates of the readings in this run
+    const double *y;
+    /// times of the readings in this run
+    const MvrTime *time;
+    /// number of readings in this run
+    size_t size;
+  };
+
+  /// Iterator over the readings, newest to oldest
+  class const_iterator
+  {
+  public:
+    const_iterator(const MvrRangeBufferStorage *storage = NULL,
+		   size_t index = 0)
+      { myStorage = storage; myIndex = index; }
+    /// Gets the index (0 is the newest) of the reading this points at
+    size_t getIndex(void) const { return myIndex; }
+    /// Gets the x of the reading this points at
+    double getX(void) const { return myStorage->getX(myIndex); }
+    /// Gets the y of the reading this points at
+    double getY(void) const { return myStorage->getY(myIndex); }
+    /// Gets the time of the reading this points at
+    MvrTime getTime(void) const { return myStorage->getTime(myIndex); }
+    /// Gets the reading this points at as a pose
+    MvrPoseWithTime operator*() const
+      { return myStorage->getPoseWithTime(myIndex); }
+    const_iterator &operator++() { myIndex++; return *this; }
+    const_iterator operator++(int)
+      { const_iterator ret = *this; myIndex++; return ret; }
+    bool operator==(const const_iterator &other) const
+      { return myIndex == other.myIndex && myStorage == other.myStorage; }
+    bool operator!=(const const_iterator &other) const
+      { return !(*this == other); }
+  protected:
+    const MvrRangeBufferStorage *myStorage;
+    size_t myIndex;
+  };
+
+  /// Constructor
+  MVREXPORT MvrRangeBufferStorage(size_t capacity = 0);
+  /// Destructor
+  MVREXPORT virtual ~MvrRangeBufferStorage();
+  /// Gets the number of readings in the storage
+  size_t size(void) const { return mySize; }
+  /// Gets the maximum number of readings the storage holds
+  size_t capacity(void) const { return myCapacity; }
+  /// Sees if there are no readings in the storage
+  bool empty(void) const { return mySize == 0; }
+  /// Sets the maximum number of readings, dropping the oldest if needed
+  MVREXPORT void setCapacity(size_t capacity);
+
+  /// Adds a reading as the newest one (overwriting the oldest if full)
+  MVREXPORT void push(double x, double y, const MvrTime &time);
+  /// Gets the x of the reading at index (0 is the newest)
+  double getX(size_t index) const { return myX[physicalIndex(index)]; }
+  /// Gets the y of the reading at index (0 is the newest)
+  double getY(size_t index) const { return myY[physicalIndex(index)]; }
+  /// Gets the time of the reading at index (0 is the newest)
+  MvrTime getTime(size_t index) const
+    { return myTime[physicalIndex(index)]; }
+  /// Gets the reading at index (0 is the newest) as a pose
+  MvrPoseWithTime getPoseWithTime(size_t index) const
+    {
+      size_t i = physicalIndex(index);
+      return MvrPoseWithTime(myX[i], myY[i], 0, myTime[i]);
+    }
+  /// Sets the position of the reading at index (0 is the newest)
+  void setXY(size_t index, double x, double y)
+    {
+      size_t i = physicalIndex(index);
+      myX[i] = x;
+      myY[i] = y;
+      myChanges++;
+    }
+  /// Sets the time of the reading at index (0 is the newest)
+  void setTime(size_t index, const MvrTime &time)
+    { myTime[physicalIndex(index)] = time; myChanges++; }
+
+  /// Gets the slot of the reading at index (0 is the newest)
+  size_t getSlot(size_t index) const { return physicalIndex(index); }
+  /// Gets the index of the reading in slot, or size() if it has no reading
+  size_t getIndexOfSlot(size_t slot) const
+    {
+      if (slot >= myCapacity)
+	return mySize;
+      size_t index = myEnd + myCapacity - 1 - slot;
+      if (index >= myCapacity)
+	index -= myCapacity;
+      if (index >= mySize)
+	return mySize;
+      return index;
+    }
+  /// Gets the x of the reading in slot
+  double getSlotX(size_t slot) const { return myX[slot]; }
+  /// Gets the y of the reading in slot
+  double getSlotY(size_t slot) const { return myY[slot]; }
+
+  /// Drops the oldest readings so there are at most newSize left
+  MVREXPORT void truncate(size_t newSize);
+  /// Removes every reading whose slot's entry in marks is non zero
+  MVREXPORT void removeMarked(const std::vector<unsigned char> &marks);
+  /// Removes all the readings
+  MVREXPORT void clear(void);
+
+  /// Gets the contiguous runs the readings are in, returns how many there are
+  MVREXPORT int getSpans(Span *first, Span *second) const;
+
+  /// Gets an iterator at the newest reading
+  const_iterator begin(void) const { return const_iterator(this, 0); }
+  /// Gets an iterator past the oldest reading
+  const_iterator end(void) const { return const_iterator(this, mySize); }
+
+  /// Gets a counter that changes every time the storage is modified
+  unsigned int getChangeCount(void) const { return myChanges; }
+protected:
+  // maps from the index (0 is newest) to where it is in the arrays
+  size_t physicalIndex(size_t index) const
+    {
+      size_t i = myEnd + myCapacity - 1 - index;
+      if (i >= myCapacity)
+	i -= myCapacity;
+      return i;
+    }
+
+  std::vector<double> myX;
+  std::vector<double> myY;
+  std::vector<MvrTime> myTime;
+  size_t myCapacity;
+  size_t mySize;
+  // one past where the newest reading is in the arrays
+  size_t myEnd;
+  unsigned int myChanges;
+};
+
+#endif // MVRRANGEBUFFERSTORAGE_H
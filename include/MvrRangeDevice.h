@@ -4,6 +4,7 @@
 #include "mvriaTypedefs.h"
 #include "MvrRangeBuffer.h"
 #include "MvrSensorReading.h"
+#include "MvrScan.h"
 #include "MvrDrawingData.h"
 #include "MvrMutex.h"
 #include <set>
@@ -94,6 +95,9 @@ public:
   MVREXPORT virtual double currentReadingBox(double x1, double y1, double x2,
 					    double y2, 
 					    MvrPose *readingPos = NULL) const;
+  /// Gets the closest current reading in each of several regions
+  MVREXPORT virtual void currentReadingRegions(MvrRangeRegion *regions,
+					      size_t numRegions) const;
   /// Gets the closest current reading from the given box region
   MVREXPORT virtual double cumulativeReadingBox(double x1, double y1, double x2,
 					       double y2, 
@@ -161,7 +165,24 @@ laser-like subclassses of MvrRangeDevice and MvrRangeDeviceThreaded
       any "raw" information provided would usually require very different interpretation.
   **/
   virtual const std::list<MvrSensorReading *> *getRawReadings(void) const
-    { return myRawReadings; }
+    { 
+      if (myRawScan.getGeneration() != myRawReadingsGeneration)
+	fillRawReadingsFromScan();
+      return myRawReadings; 
+    }
+
+  /// Gets the raw unfiltered readings from the device as one MvrScan
+  /** This is the same data as getRawReadings(), but kept in flat
+      arrays (see MvrScan).  Lasers fill this in directly, and
+      getRawReadings() is built from it (only when someone asks for
+      it), so walking this is cheaper.  The pointer is good for as long
+      as the range device is around, but like the rest of the device's
+      data should only be looked at while the device is locked.
+
+      @note Only lasers provide this data currently, for other range
+      devices it will have no readings.
+  **/
+  const MvrScan *getRawScan(void) const { return &myRawScan; }
 
   ///  Gets the raw unfiltered readings from the device into a vector 
   MVREXPORT virtual std::vector<MvrSensorReading> *getRawReadingsAsVector(void);
@@ -181,7 +202,19 @@ laser-like subclassses of MvrRangeDevice and MvrRangeDeviceThreaded
       etc. do not provide raw readings.
   **/
   virtual const std::list<MvrSensorReading *> *getAdjustedRawReadings(void) const
-    { return myAdjustedRawReadings; }
+    { 
+      if (myAdjustedRawScan.getGeneration() != 
+	  myAdjustedRawReadingsGeneration)
+	fillAdjustedRawReadingsFromScan();
+      return myAdjustedRawReadings; 
+    }
+
+  /// Gets the adjusted raw readings from the device as one MvrScan
+  /** This is the same data as getAdjustedRawReadings(), and like
+      getRawScan() should only be looked at while the device is locked.
+      It has no readings unless the readings are being adjusted.
+  **/
+  const MvrScan *getAdjustedRawScan(void) const { return &myAdjustedRawScan; }
 
   ///  Gets the raw adjusted readings from the device into a vector 
   MVREXPORT virtual std::vector<MvrSensorReading> *getAdjustedRawReadingsAsVector(void);
@@ -376,9 +409,14 @@ protected:
     happens (which should be the case if you're doing it in the robot
     callback). The code currently assumes that all readings were taken
     at the same point, so if that isn't true with your device then you
-    can't use this mechanism.
+    can't use this mechanism.  Only readings in myRawScan are adjusted
+    (into myAdjustedRawScan), and only once per scan.
   **/
   MVREXPORT void adjustRawReadings(bool interlaced);
+  /// Rebuilds myRawReadings from myRawScan
+  MVREXPORT void fillRawReadingsFromScan(void) const;
+  /// Rebuilds myAdjustedRawReadings from myAdjustedRawScan
+  MVREXPORT void fillAdjustedRawReadingsFromScan(void) const;
   std::vector<MvrSensorReading> myRawReadingsVector;
   std::vector<MvrSensorReading> myAdjustedRawReadingsVector;
   std::string myName;
@@ -401,8 +439,18 @@ protected:
   MvrPose myMaxInsertDistCumulativePose;
 
   MvrFunctorC<MvrRangeDevice> myFilterCB;
-  std::list<MvrSensorReading *> *myRawReadings;
-  std::list<MvrSensorReading *> *myAdjustedRawReadings;
+  // devices that fill in myRawScan leave this alone, it gets built
+  // from the scan (and deleted) by this class
+  mutable std::list<MvrSensorReading *> *myRawReadings;
+  mutable std::list<MvrSensorReading *> *myAdjustedRawReadings;
+  MvrScan myRawScan;
+  // myRawScan corrected for the odometry delay by adjustRawReadings
+  MvrScan myAdjustedRawScan;
+  // the generation of myRawScan that myAdjustedRawScan was made from
+  unsigned int myAdjustedFromGeneration;
+  mutable unsigned int myRawReadingsGeneration;
+  mutable unsigned int myAdjustedRawReadingsGeneration;
+  mutable bool myOwnRawReadings;
   MvrDrawingData *myCurrentDrawingData;
   bool myOwnCurrentDrawingData;
   MvrDrawingData *myCumulativeDrawingData;
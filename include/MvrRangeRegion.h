@@ -0,0 +1,119 @@
+#ifndef MVRRANGEREGION_H
+#define MVRRANGEREGION_H
+
+#include "mvriaTypedefs.h"
+#include "mvriaUtil.h"
+
+class MvrRangeDevice;
+
+/// A region to find the closest reading in, along with what was found
+/**
+   This is for asking for the closest readings in several regions at
+   once with MvrRobot::checkRangeDevicesCurrentRegions() (or
+   MvrRangeDevice::currentReadingRegions() or
+   MvrRangeBuffer::getClosestInRegions()), which looks at each reading
+   once for all of the regions instead of once per region.
+
+   A region is either polar (like
+   MvrRobot::checkRangeDevicesCurrentPolar()) or a box in robot local
+   coordinates (like MvrRobot::checkRangeDevicesCurrentBox()), set it
+   with setPolar() or setBox().  After the check getDist(),
+   getAngle(), getReadingPos() and getRangeDevice() have the results,
+   which mean the same thing as the results of the single region
+   calls.
+
+   @ingroup UtilityClasses
+**/
+class MvrRangeRegion
+{
+public:
+  /// The kinds of region
+  enum Type
+  {
+    POLAR, ///< Between two angles from the robot
+    BOX ///< A box in robot local coordinates
+  };
+  /// Constructor
+  MvrRangeRegion()
+    { setBox(0, 0, 0, 0); clearResult(); }
+  /// Makes this a polar region between startAngle and endAngle
+  void setPolar(double startAngle, double endAngle)
+    {
+      myType = POLAR;
+      myStartAngle = startAngle;
+      myEndAngle = endAngle;
+    }
+  /// Makes this a box region between the two corners (robot local coords)
+  void setBox(double x1, double y1, double x2, double y2)
+    {
+      myType = BOX;
+      // keep them in order so the checks don't have to sort them
+      myX1 = MvrUtil::findMin(x1, x2);
+      myX2 = MvrUtil::findMax(x1, x2);
+      myY1 = MvrUtil::findMin(y1, y2);
+      myY2 = MvrUtil::findMax(y1, y2);
+    }
+  /// Gets the type of the region
+  Type getType(void) const { return myType; }
+  /// Gets the start angle of a polar region
+  double getStartAngle(void) const { return myStartAngle; }
+  /// Gets the end angle of a polar region
+  double getEndAngle(void) const { return myEndAngle; }
+  /// Gets the smaller x of a box region
+  double getX1(void) const { return myX1; }
+  /// Gets the smaller y of a box region
+  double getY1(void) const { return myY1; }
+  /// Gets the larger x of a box region
+  double getX2(void) const { return myX2; }
+  /// Gets the larger y of a box region
+  double getY2(void) const { return myY2; }
+
+  /// Gets the distance to the closest reading (-1 if nothing was checked)
+  double getDist(void) const { return myDist; }
+  /// Gets the angle to the closest reading (polar regions)
+  double getAngle(void) const { return myAngle; }
+  /// Gets where the closest reading is, in local coordinates (box regions)
+  MvrPose getReadingPos(void) const { return myReadingPos; }
+  /// Gets the range device the closest reading came from
+  const MvrRangeDevice *getRangeDevice(void) const { return myRangeDevice; }
+
+  /// Clears the results, internal
+  /// @internal
+  void clearResult(void)
+    {
+      myDist = -1;
+      myAngle = 0;
+      myReadingPos.setPose(0, 0, 0);
+      myRangeDevice = NULL;
+      myFound = false;
+    }
+  /// Sets the results, internal
+  /// @internal
+  void setResult(double dist, double angle, MvrPose readingPos,
+		 const MvrRangeDevice *rangeDevice)
+    {
+      myDist = dist;
+      myAngle = angle;
+      myReadingPos = readingPos;
+      myRangeDevice = rangeDevice;
+    }
+protected:
+  friend class MvrRangeBuffer;
+
+  Type myType;
+  double myStartAngle;
+  double myEndAngle;
+  double myX1;
+  double myY1;
+  double myX2;
+  double myY2;
+
+  double myDist;
+  double myAngle;
+  MvrPose myReadingPos;
+  const MvrRangeDevice *myRangeDevice;
+  // used while MvrRangeBuffer is checking readings
+  bool myFound;
+};
+
+#endif // MVRRANGEREGION_H
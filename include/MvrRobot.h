@@ -17,7 +17,12 @@
 #include "MvrTransform.h"
 #include "MvrInterpolation.h"
 #include "MvrKeyHandler.h"
+#include "MvrObstacleSnapshot.h"
+#include "MvrRangeRegion.h"
+#include "MvrRobotPacketQueue.h"
+#include "MvrRobotStateSnapshot.h"
 #include <list>
+#include <atomic>
 
 class MvrAction;
 class MvrRobotConfigPacketReader;
@@ -903,6 +908,31 @@ public:
 	  const MvrRangeDevice **rangeDevice = NULL,
 	  bool useLocationDependentDevices = true) const;
 
+  /// Goes through all the range devices once and checks several regions
+  MVREXPORT void checkRangeDevicesCurrentRegions(
+	  MvrRangeRegion *regions, size_t numRegions,
+	  bool useLocationDependentDevices = true) const;
+
+  /// Sets whether the current checks use a snapshot of the readings built once per cycle
+  /**
+     When this is on (the default) the first
+     checkRangeDevicesCurrentPolar() or checkRangeDevicesCurrentBox()
+     call after sensor interpretation in a cycle takes a snapshot of
+     every range device's current buffer (see MvrObstacleSnapshot),
+     and the rest of the calls that cycle are answered from that
+     instead of locking and searching each device again.  The snapshot
+     is retaken if the robot's pose changes or range devices are added
+     or removed.
+
+     The snapshot reads the current buffers directly, so if you have a
+     range device that overrides MvrRangeDevice::currentReadingPolar()
+     or MvrRangeDevice::currentReadingBox() you should turn this off.
+  **/
+  void setUseObstacleSnapshot(bool useObstacleSnapshot)
+    { myUseObstacleSnapshot = useObstacleSnapshot; }
+  /// Gets whether the current checks use a snapshot built once per cycle
+  bool getUseObstacleSnapshot(void) const { return myUseObstacleSnapshot; }
+
   /// Adds a laser to the robot's map of them
   MVREXPORT bool addLaser(MvrLaser *laser, int laserNumber, 
 			 bool addAsRangeDevice = true);
@@ -1182,6 +1212,20 @@ public:
   MVREXPORT void setCycleTime(unsigned int ms);
   /// Gets the number of ms between cycles
   MVREXPORT unsigned int getCycleTime(void) const;
+  /// Sets the number of us between cycles
+  MVREXPORT void setCycleTimeUSec(unsigned int uSec);
+  /// Gets the number of us between cycles
+  MVREXPORT unsigned int getCycleTimeUSec(void) const;
+  /// Sets whether cycles are kept on an absolute schedule (see MvrSyncLoop::setAbsoluteTiming)
+  MVREXPORT void setAbsoluteCycleTiming(bool absoluteCycleTiming);
+  /// Gets whether cycles are kept on an absolute schedule
+  MVREXPORT bool getAbsoluteCycleTiming(void);
+  /// Gets how late each cycle started, in us (see MvrSyncLoop::getJitter)
+  MVREXPORT const MvrLatencyHistogram *getCycleJitter(void);
+  /// Gets how many cycles missed their deadline
+  MVREXPORT unsigned long long getCycleNumMissedDeadlines(void);
+  /// Resets the cycle jitter and missed deadlines
+  MVREXPORT void resetCycleTimingStats(void);
   /// Sets the number of ms between cycles to warn over
   MVREXPORT void setCycleWarningTime(unsigned int ms);
   /// Gets the number of ms between cycles to warn over
@@ -1265,6 +1309,9 @@ public:
   /// Gets the Counter for the time through the loop
   unsigned int getCounter(void) const { return myCounter; }
 
+  /// Gets a copy of the robot's state from the last cycle, without locking
+  MVREXPORT MvrRobotStateSnapshot getStateSnapshot(void) const;
+
   /// Gets the parameters the robot is using
   MVREXPORT const MvrRobotParams *getRobotParams(void) const;
 
@@ -1473,6 +1520,12 @@ public:
   /// Robot unlocker, internal
   /// @internal
   MVREXPORT void robotUnlocker(void);
+  /// Marks sensor interpretation done for the obstacle snapshot, internal
+  /// @internal
+  MVREXPORT void obstacleSnapshotReady(void);
+  /// Puts out the state snapshot for getStateSnapshot(), internal
+  /// @internal
+  MVREXPORT void publishStateSnapshot(void);
 
   /// Packet handler, internal, for use in the syncloop when there's no threading
   /// @internal
@@ -1521,6 +1574,7 @@ public:
   MvrFunctorC<MvrRobot> myStateReflectorCB;
   MvrFunctorC<MvrRobot> myRobotLockerCB;
   MvrFunctorC<MvrRobot> myRobotUnlockerCB;
+  MvrFunctorC<MvrRobot> myObstacleSnapshotReadyCB;
   MvrFunctorC<MvrRobot> myKeyHandlerExitCB;
   MvrFunctorC<MvrKeyHandler> *myKeyHandlerCB;
 
@@ -1691,10 +1745,8 @@ protected:
   MvrSyncLoop mySyncLoop;
   MvrRobotPacketReaderThread myPacketReader;
 
-  // the data items for reading packets in one thread and processing them in another
-  MvrMutex myPacketMutex;
-  std::list<MvrRobotPacket *> myPacketList;
-  MvrCondition myPacketReceivedCondition;
+  // the queue for reading packets in one thread and processing them in another
+  MvrRobotPacketQueue myPacketQueue;
   bool myRunningNonThreaded;
 
 
@@ -1707,6 +1759,13 @@ protected:
 
   MvrRetFunctor1<double, MvrPoseWithTime> *myEncoderCorrectionCB;
   std::list<MvrRangeDevice *> myRangeDeviceList;
+  bool myUseObstacleSnapshot;
+  // the counter sensor interpretation was last finished for
+  unsigned int myObstacleSnapshotReadyCounter;
+  mutable MvrObstacleSnapshot myObstacleSnapshot;
+  // seqlock for myStateSnapshot, odd while it is being written
+  std::atomic<unsigned int> myStateSnapshotSeq;
+  MvrRobotStateSnapshot myStateSnapshot;
   std::map<int, MvrLaser *> myLaserMap;
 
   std::map<int, MvrBatteryMTX *> myBatteryMap;
@@ -1854,6 +1913,7 @@ protected:
   int mySonarPacCurrentCount;
   int mySonarPacCount;
   unsigned int myCycleTime;
+  unsigned int myCycleTimeUSec;
   unsigned int myCycleWarningTime;
   unsigned int myConnectionCycleMultiplier;
   bool myCycleChained;
@@ -0,0 +1,75 @@
+#ifndef MVRROBOTPACKETPOOL_H
+#define MVRROBOTPACKETPOOL_H
+
+#include "mvriaTypedefs.h"
+#include "MvrMutex.h"
+#include <vector>
+#include <stddef.h>
+
+class MvrRobotPacket;
+
+/// Recycles robot packets so receiving them doesn't hit the heap
+/**
+   MvrRobotPacketReceiver takes its packets from one of these when it
+   is allocating packets (which is how MvrRobot's packet reader thread
+   runs), and whoever ends up with a packet gives it back with put()
+   (or MvrRobotPacketReceiver::releasePacket()) when they're done with
+   it instead of deleting it.  All the packets are the same size
+   (MvrRobotPacket's fixed buffer), so any of them can be used again
+   for anything.
+
+   get() only allocates a new packet when there isn't a free one, so
+   once enough packets are in circulation to cover however many are in
+   flight at once there are no more allocations; getNumAllocated()
+   is there so that can be checked.  Packets that are deleted instead
+   of given back are just lost to the pool (it'll make a new one next
+   time it runs out), so older code that deletes what it gets from
+   the receiver still works.
+
+   get() and put() can be called from different threads, the free
+   list is only locked long enough to take a pointer off of or put
+   one onto it.
+
+   @ingroup UtilityClasses
+**/
+class MvrRobotPacketPool
+{
+public:
+  /// Constructor
+  MVREXPORT MvrRobotPacketPool(unsigned char sync1 = 0xAA,
+			       unsigned char sync2 = 0xAA,
+			       size_t maxFree = 1024);
+  /// Destructor, deletes the free packets
+  MVREXPORT virtual ~MvrRobotPacketPool();
+  /// Gets a packet, the caller owns it until it is put back
+  MVREXPORT MvrRobotPacket *get(void);
+  /// Gives a packet from get() back to the pool
+  MVREXPORT void put(MvrRobotPacket *packet);
+  /// Makes sure there are at least this many free packets
+  MVREXPORT void preallocate(size_t num);
+  /// Gets the number of packets the pool has ever had to allocate
+  MVREXPORT size_t getNumAllocated(void);
+  /// Gets the number of times get() has been called
+  MVREXPORT size_t getNumGets(void);
+  /// Gets the number of times get() used a free packet instead of allocating
+  MVREXPORT size_t getNumReused(void);
+  /// Gets the number of packets that have been gotten but not put back
+  MVREXPORT size_t getNumOutstanding(void);
+  /// Gets the number of packets sitting in the pool waiting to be used
+  MVREXPORT size_t getNumFree(void);
+  /// Resets the allocated, gets and reused counters
+  MVREXPORT void resetCounters(void);
+protected:
+  unsigned char mySync1;
+  unsigned char mySync2;
+  size_t myMaxFree;
+  MvrMutex myMutex;
+  // reserved to myMaxFree up front so put() never allocates
+  std::vector<MvrRobotPacket *> myFree;
+  size_t myNumAllocated;
+  size_t myNumGets;
+  size_t myNumReused;
+  size_t myNumOutstanding;
+};
+
+#endif // MVRROBOTPACKETPOOL_H
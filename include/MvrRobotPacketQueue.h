@@ -0,0 +1,90 @@
+#ifndef MVRROBOTPACKETQUEUE_H
+#define MVRROBOTPACKETQUEUE_H
+
+#include "mvriaTypedefs.h"
+#include <vector>
+#include <atomic>
+#include <stddef.h>
+
+class MvrRobotPacket;
+class MvrRobotPacketPool;
+
+/// Bounded lock free queue of packets from one reader thread to one processor
+/**
+   This is how MvrRobot hands packets from its packet reader thread
+   (MvrRobot::packetHandlerThreadedReader()) to the sync loop
+   (MvrRobot::packetHandlerThreadedProcessor()) when it is running
+   threaded.  It is a single producer, single consumer ring: push()
+   must only be called from one thread and pop() and waitForPacket()
+   from one (other) thread, neither of them ever blocks on a lock.
+
+   The queue also keeps count of how many SIPs (packets with an ID of
+   0x3X) are in it, so the processor can see if there's another one
+   coming without looking through the queue.
+
+   On Linux waitForPacket() sleeps on a futex the producer only wakes
+   if the consumer is actually waiting, elsewhere it polls.
+
+   The queue doesn't throw anything away when it's full, push() just
+   says so and the producer has to wait for room (robot packets can't
+   be dropped).
+
+   The queue owns the packets in it, anything cleared out of it goes
+   back to the packet pool if one was given with setPacketPool() (or
+   gets deleted if not), anything left in it when it is destroyed gets
+   deleted.
+
+   @ingroup UtilityClasses
+**/
+class MvrRobotPacketQueue
+{
+public:
+  /// Constructor, capacity is rounded up to a power of two
+  MVREXPORT MvrRobotPacketQueue(size_t capacity = 1024);
+  /// Destructor
+  MVREXPORT virtual ~MvrRobotPacketQueue();
+  /// Adds a packet to the queue (producer only), false if it was full
+  MVREXPORT bool push(MvrRobotPacket *packet);
+  /// Takes the oldest packet out of the queue (consumer only), or NULL
+  MVREXPORT MvrRobotPacket *pop(void);
+  /// Waits for the queue to have a packet (consumer only)
+  MVREXPORT bool waitForPacket(int msecs);
+  /// Gets the number of SIPs in the queue
+  int getNumPendingSips(void) const { return myPendingSips.load(); }
+  /// Gets the number of times push() found the queue full
+  size_t getNumFull(void) const { return myNumFull.load(); }
+  /// Gets the number of packets the queue can hold
+  size_t getCapacity(void) const { return mySlots.size(); }
+  /// Throws away everything in the queue (any thread)
+  MVREXPORT void clear(void);
+  /// Sets the pool cleared packets are given back to
+  void setPacketPool(MvrRobotPacketPool *pool) { myPacketPool = pool; }
+  /// Sees if a packet is a SIP
+  MVREXPORT static bool isSip(MvrRobotPacket *packet);
+protected:
+  // takes a packet off without looking at clear requests
+  MvrRobotPacket *popOne(void);
+  // wakes the consumer up if it is waiting
+  void wake(void);
+
+  std::vector<MvrRobotPacket *> mySlots;
+  size_t myMask;
+  MvrRobotPacketPool *myPacketPool;
+  // the consumer's and producer's positions, padded so they're on
+  // different cache lines and the threads don't fight over them
+  char myPad0[64];
+  std::atomic<size_t> myHead;
+  char myPad1[64];
+  std::atomic<size_t> myTail;
+  char myPad2[64];
+  std::atomic<int> myPendingSips;
+  // bumped every push, the futex the consumer sleeps on
+  std::atomic<int> mySequence;
+  std::atomic<int> myWaiting;
+  // everything pushed before this position has been cleared, pop()
+  // skips (and frees) it, so only the consumer takes things off
+  std::atomic<size_t> myClearedBefore;
+  std::atomic<size_t> myNumFull;
+};
+
+#endif // MVRROBOTPACKETQUEUE_H
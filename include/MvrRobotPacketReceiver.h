@@ -3,6 +3,7 @@
 
 #include "mvriaTypedefs.h"
 #include "MvrRobotPacket.h"
+#include "MvrRobotPacketPool.h"
 
 
 class MvrDeviceConnection;
@@ -32,6 +33,10 @@ public:
   
   /// Receives a packet from the robot if there is one available
   MVREXPORT MvrRobotPacket *receivePacket(unsigned int msWait = 0);
+  /// Gives a packet from receivePacket() back when allocating packets
+  MVREXPORT void releasePacket(MvrRobotPacket *packet);
+  /// Gets the pool packets come from when allocating packets (for its counters)
+  MvrRobotPacketPool *getPacketPool(void) { return &myPacketPool; }
 
   /// Sets the device this instance receives packets from
   MVREXPORT void setDeviceConnection(MvrDeviceConnection *deviceConnection);
@@ -70,11 +75,30 @@ protected:
 
   bool myAllocatePackets;
   MvrRobotPacket myPacket;
+  MvrRobotPacketPool myPacketPool;
   enum { STATE_SYNC1, STATE_SYNC2, STATE_ACQUIRE_DATA };
   unsigned char mySync1;
   unsigned char mySync2;
 
   MvrFunctor1<MvrRobotPacket *> *myPacketReceivedCallback;
+
+  // pulls whatever the connection has into myReadBuf
+  int fillReadBuffer(unsigned int msWait);
+  // gets the time the byte at index in myReadBuf was read
+  MvrTime getReadBufferTime(int index);
+  // takes num bytes off the front of myReadBuf
+  void consumeReadBuffer(int num);
+
+  // bytes read from the connection but not framed into packets yet,
+  // packets are at most 258 bytes so one always fits
+  enum { READ_BUFFER_SIZE = 1024, MAX_READ_CHUNKS = 32 };
+  char myReadBuf[READ_BUFFER_SIZE];
+  int myReadStart;
+  int myReadEnd;
+  // where each read ended in myReadBuf and when it was read
+  int myReadChunkEnds[MAX_READ_CHUNKS];
+  MvrTime myReadChunkTimes[MAX_READ_CHUNKS];
+  int myNumReadChunks;
 };
 
 #endif // ARROBOTPACKETRECEIVER_H
@@ -417,6 +417,14 @@ public:
       else
 	return NULL;
     }
+  /// Gets the string that is choice for the protocol the laser should use
+  const char *getLaserProtocolChoice(int laserNumber = 1) const 
+    {
+      if (getLaserData(laserNumber) != NULL)
+	return getLaserData(laserNumber)->myLaserProtocolChoice; 
+      else
+	return NULL;
+    }
 
   /// Gets the name of the section the laser information is in (this
   /// mostly doesn't mean anything except for commercial)
@@ -965,6 +973,7 @@ protected:
 	myLaserReflectorBitsChoice[0] = '\0';
 	myLaserStartingBaudChoice[0] = '\0';
 	myLaserAutoBaudChoice[0] = '\0';
+	myLaserProtocolChoice[0] = '\0';
 	mySection[0] = '\0';
 	myLaserPowerOutput[0] = '\0';
       }
@@ -992,6 +1001,7 @@ protected:
     char myLaserReflectorBitsChoice[256];
     char myLaserStartingBaudChoice[256];
     char myLaserAutoBaudChoice[256];
+    char myLaserProtocolChoice[256];
     char mySection[256];
     char myLaserPowerOutput[256];
   };
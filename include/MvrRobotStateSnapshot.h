@@ -0,0 +1,113 @@
+#ifndef MVRROBOTSTATESNAPSHOT_H
+#define MVRROBOTSTATESNAPSHOT_H
+
+#include "mvriaTypedefs.h"
+#include "mvriaUtil.h"
+
+/// A copy of the robot's state from the end of a cycle
+/**
+   MvrRobot::getStateSnapshot() returns one of these without locking
+   the robot, so threads that only want to look at where the robot is
+   and what it's doing (GUIs, loggers, network handlers) don't have to
+   wait for the robot's cycle to let go of the lock.  The robot puts a
+   new one out at the end of every cycle, so it is at most a cycle old,
+   and everything in it is from the same cycle.
+
+   The getters are named the same as the MvrRobot ones they're copies
+   of.  This only has plain values in it (so the poses are put back
+   together by getPose() and getEncoderPose()), which is what lets it
+   be copied without a lock.
+
+   @ingroup UtilityClasses
+**/
+class MvrRobotStateSnapshot
+{
+public:
+  /// Constructor
+  MvrRobotStateSnapshot() 
+    { 
+      myX = myY = myTh = 0;
+      myEncoderX = myEncoderY = myEncoderTh = 0;
+      myVel = myRotVel = myLatVel = myLeftVel = myRightVel = 0;
+      myStallValue = myFlags = myFaultFlags = myFlags3 = 0;
+      myBatteryVoltage = myRealBatteryVoltage = myStateOfCharge = 0;
+      myTemperature = 0;
+      myCounter = 0;
+      myIsConnected = false;
+      myTimeUSec = 0;
+    }
+  /// Gets the global pose of the robot
+  MvrPose getPose(void) const { return MvrPose(myX, myY, myTh); }
+  /// Gets the encoder pose of the robot
+  MvrPose getEncoderPose(void) const 
+    { return MvrPose(myEncoderX, myEncoderY, myEncoderTh); }
+  /// Gets the translational velocity of the robot
+  double getVel(void) const { return myVel; }
+  /// Gets the rotational velocity of the robot
+  double getRotVel(void) const { return myRotVel; }
+  /// Gets the lateral velocity of the robot
+  double getLatVel(void) const { return myLatVel; }
+  /// Gets the velocity of the left wheel
+  double getLeftVel(void) const { return myLeftVel; }
+  /// Gets the velocity of the right wheel
+  double getRightVel(void) const { return myRightVel; }
+  /// Gets the 2 bytes of stall and bumper flags from the robot
+  int getStallValue(void) const { return myStallValue; }
+  /// Returns true if the left motor is stalled
+  bool isLeftMotorStalled(void) const 
+    { return (myStallValue & 0xff) & MvrUtil::BIT0; }
+  /// Returns true if the right motor is stalled
+  bool isRightMotorStalled(void) const
+    { return ((myStallValue & 0xff00) >> 8) & MvrUtil::BIT0; }
+  /// Gets the flags values
+  int getFlags(void) const { return myFlags; }
+  /// Gets the fault flags values
+  int getFaultFlags(void) const { return myFaultFlags; }
+  /// Gets the flags3 values
+  int getFlags3(void) const { return myFlags3; }
+  /// returns true if the motors are enabled
+  bool areMotorsEnabled(void) const { return (myFlags & MvrUtil::BIT0); }
+  /// returns true if the estop is pressed
+  bool isEStopPressed(void) const { return (myFlags & MvrUtil::BIT5); }
+  /// Gets the (averaged) battery voltage
+  double getBatteryVoltage(void) const { return myBatteryVoltage; }
+  /// Gets the real battery voltage
+  double getRealBatteryVoltage(void) const { return myRealBatteryVoltage; }
+  /// Gets the state of charge (percent)
+  double getStateOfCharge(void) const { return myStateOfCharge; }
+  /// Gets the temperature of the robot
+  int getTemperature(void) const { return myTemperature; }
+  /// Gets the robot's cycle counter from the cycle this is from
+  unsigned int getCounter(void) const { return myCounter; }
+  /// Gets whether the robot was connected
+  bool isConnected(void) const { return myIsConnected; }
+  /// Gets when this was taken (MvrUtil::getTimeUSec()), 0 if it never was
+  unsigned long long getTimeUSec(void) const { return myTimeUSec; }
+protected:
+  double myX;
+  double myY;
+  double myTh;
+  double myEncoderX;
+  double myEncoderY;
+  double myEncoderTh;
+  double myVel;
+  double myRotVel;
+  double myLatVel;
+  double myLeftVel;
+  double myRightVel;
+  int myStallValue;
+  int myFlags;
+  int myFaultFlags;
+  int myFlags3;
+  double myBatteryVoltage;
+  double myRealBatteryVoltage;
+  double myStateOfCharge;
+  int myTemperature;
+  unsigned int myCounter;
+  bool myIsConnected;
+  unsigned long long myTimeUSec;
+
+  friend class MvrRobot;
+};
+
+#endif // MVRROBOTSTATESNAPSHOT_H
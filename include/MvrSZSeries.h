@@ -6,6 +6,7 @@
 #include "MvrRobotPacket.h"
 #include "MvrLaser.h"   
 #include "MvrFunctor.h"
+#include "MvrCRC16.h"
 
 /** @internal */
 class MvrSZSeriesPacket : public MvrBasePacket
@@ -109,6 +110,7 @@ protected:
   char myName[1024];
   unsigned int myNameLength;
   unsigned char myReadBuf[100000];
+  MvrCRC16 myCRC;
   int myReadCount;
   bool myIsSZ00;
   MvrLog::LogLevel myInfoLogLevel;
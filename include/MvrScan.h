@@ -0,0 +1,215 @@
+#ifndef MVRSCAN_H
+#define MVRSCAN_H
+
+#include "mvriaTypedefs.h"
+#include "mvriaUtil.h"
+#include "MvrTransform.h"
+#include "MvrSensorReading.h"
+#include <list>
+#include <vector>
+
+/// One scan from a laser (or laser-like device), stored in flat arrays
+/**
+   The range, intensity, angle index, ignore flag, angle and local and
+   global x/y of each reading are kept in their own contiguous arrays
+   (indexed from 0 to getNumReadings() - 1, in the same order as
+   MvrRangeDevice::getRawReadings()), and where the robot was and when
+   the scan was taken are kept once for the whole scan.  Lasers fill
+   in their MvrRangeDevice::getRawScan() with this as the readings come
+   in and everything downstream (MvrLaser::laserProcessReadings(),
+   MvrLaserFilter, MvrLineFinder) walks the arrays, instead of chasing
+   a pointer per reading through a list.
+
+   The pointers from getRanges() and friends are only good for the
+   current scan, and only while the device is locked.  Drivers that
+   build a scan up over several packets swapScan() it in when it's
+   done, which trades the arrays, so the next scan can be in different
+   memory.
+
+   A driver fills in a scan by calling beginScan() with where the
+   robot was, setReading() for each reading and then endScan().
+
+   @ingroup UtilityClasses
+**/
+class MvrScan
+{
+public:
+  /// Constructor
+  MVREXPORT MvrScan();
+  /// Destructor
+  MVREXPORT ~MvrScan();
+
+  /// Sets how many readings there are (angle indexes are reset to 0 to numReadings - 1)
+  MVREXPORT void setNumReadings(int numReadings);
+  /// Gets how many readings there are
+  int getNumReadings(void) const { return myNumReadings; }
+
+  /// Starts a new scan
+  MVREXPORT void beginScan(MvrPose poseTaken, MvrPose encoderPoseTaken,
+			   MvrTransform toGlobal, unsigned int counterTaken,
+			   MvrTime timeTaken);
+  /// Sets one reading, working out its local and global position
+  /**
+     @param i which reading this is
+     @param range the range from the sensor (mm)
+     @param sensorX where the sensor is on the robot (mm)
+     @param sensorY where the sensor is on the robot (mm)
+     @param th the angle of the reading on the robot (deg)
+     @param ignore whether this reading should be ignored
+     @param intensity the device specific intensity/reflectance
+     (MvrSensorReading::getExtraInt())
+  **/
+  void setReading(int i, unsigned int range, double sensorX, double sensorY,
+		  double th, bool ignore = false, int intensity = 0)
+    {
+      double localX;
+      double localY;
+      // the sin and cos only get redone when the angle changes
+      if (th != myTh[i])
+      {
+	myTh[i] = th;
+	myCos[i] = MvrMath::cos(th);
+	mySin[i] = MvrMath::sin(th);
+      }
+      myRanges[i] = range;
+      myIntensities[i] = intensity;
+      myIgnores[i] = ignore;
+      mySensorXs[i] = sensorX;
+      mySensorYs[i] = sensorY;
+      myTimeOffsets[i] = 0;
+      localX = sensorX + range * myCos[i];
+      localY = sensorY + range * mySin[i];
+      myLocalXs[i] = localX;
+      myLocalYs[i] = localY;
+      myXs[i] = myTransX + myTransCos * localX + myTransSin * localY;
+      myYs[i] = myTransY + myTransCos * localY - myTransSin * localX;
+    }
+  /// Finishes the scan
+  void endScan(void) { myGeneration++; }
+
+  /// Gets the ranges (mm)
+  const unsigned int *getRanges(void) const { return myRanges.data(); }
+  /// Gets the intensities
+  const int *getIntensities(void) const { return myIntensities.data(); }
+  /// Gets the angle indexes
+  const int *getAngleIndexes(void) const { return myAngleIndexes.data(); }
+  /// Gets the ignore flags
+  const unsigned char *getIgnores(void) const { return myIgnores.data(); }
+  /// Gets the angles of the readings on the robot (deg)
+  const double *getThs(void) const { return myTh.data(); }
+  /// Gets the global x coordinates
+  const double *getXs(void) const { return myXs.data(); }
+  /// Gets the global y coordinates
+  const double *getYs(void) const { return myYs.data(); }
+  /// Gets the x coordinates relative to the robot
+  const double *getLocalXs(void) const { return myLocalXs.data(); }
+  /// Gets the y coordinates relative to the robot
+  const double *getLocalYs(void) const { return myLocalYs.data(); }
+
+  /// Gets the range of a reading (mm)
+  unsigned int getRange(int i) const { return myRanges[i]; }
+  /// Gets the intensity of a reading
+  int getIntensity(int i) const { return myIntensities[i]; }
+  /// Gets the angle index of a reading
+  int getAngleIndex(int i) const { return myAngleIndexes[i]; }
+  /// Gets whether a reading should be ignored
+  bool getIgnore(int i) const { return myIgnores[i] != 0; }
+  /// Gets the angle of a reading on the robot (deg)
+  double getTh(int i) const { return myTh[i]; }
+  /// Gets the global x coordinate of a reading
+  double getX(int i) const { return myXs[i]; }
+  /// Gets the global y coordinate of a reading
+  double getY(int i) const { return myYs[i]; }
+  /// Gets the x coordinate of a reading relative to the robot
+  double getLocalX(int i) const { return myLocalXs[i]; }
+  /// Gets the y coordinate of a reading relative to the robot
+  double getLocalY(int i) const { return myLocalYs[i]; }
+  /// Gets where the sensor was on the robot for a reading
+  double getSensorX(int i) const { return mySensorXs[i]; }
+  /// Gets where the sensor was on the robot for a reading
+  double getSensorY(int i) const { return mySensorYs[i]; }
+  /// Gets the time a reading was taken
+  MVREXPORT MvrTime getTimeTaken(int i) const;
+
+  /// Sets whether a reading should be ignored
+  void setIgnore(int i, bool ignore) { myIgnores[i] = ignore; }
+  /// Sets the intensity of a reading
+  void setIntensity(int i, int intensity) { myIntensities[i] = intensity; }
+  /// Sets the angle index of a reading (for devices that report a step number)
+  void setAngleIndex(int i, int angleIndex) { myAngleIndexes[i] = angleIndex; }
+  /// Sets how many ms after the scan's time a reading was taken
+  void setTimeOffset(int i, int mSec) { myTimeOffsets[i] = mSec; }
+
+  /// Gets the robot pose when the scan was taken
+  MvrPose getPoseTaken(void) const { return myPoseTaken; }
+  /// Gets the robot encoder pose when the scan was taken
+  MvrPose getEncoderPoseTaken(void) const { return myEncoderPoseTaken; }
+  /// Gets the robot counter when the scan was taken
+  unsigned int getCounterTaken(void) const { return myCounterTaken; }
+  /// Gets the time the scan was taken
+  MvrTime getTimeTaken(void) const { return myTimeTaken; }
+  /// Gets a number that changes every time the scan does
+  unsigned int getGeneration(void) const { return myGeneration; }
+
+  /// Applies a transform to the reading positions and where they were taken
+  MVREXPORT void applyTransform(MvrTransform trans);
+  /// Applies a transform to every step'th reading starting with first
+  MVREXPORT void applyTransform(MvrTransform trans, int first, int step);
+  /// Applies a transform to where every step'th reading, starting with first, was taken by the encoder
+  MVREXPORT void applyEncoderTransform(MvrTransform trans, int first = 0,
+				       int step = 1);
+  /// Copies the readings from another scan
+  MVREXPORT void copyScan(const MvrScan *scan);
+  /// Swaps the readings with another scan (for building a scan up over several packets)
+  MVREXPORT void swapScan(MvrScan *scan);
+  /// Fills in a list of MvrSensorReading from the scan (for MvrRangeDevice::getRawReadings())
+  MVREXPORT void fillReadings(std::list<MvrSensorReading *> *readings) const;
+  /// Fills in one MvrSensorReading from reading i of the scan
+  MVREXPORT void fillReading(int i, MvrSensorReading *reading) const;
+protected:
+  int myNumReadings;
+  unsigned int myGeneration;
+
+  std::vector<unsigned int> myRanges;
+  std::vector<int> myIntensities;
+  std::vector<int> myAngleIndexes;
+  std::vector<unsigned char> myIgnores;
+  std::vector<double> myTh;
+  std::vector<double> myCos;
+  std::vector<double> mySin;
+  std::vector<double> mySensorXs;
+  std::vector<double> mySensorYs;
+  std::vector<double> myLocalXs;
+  std::vector<double> myLocalYs;
+  std::vector<double> myXs;
+  std::vector<double> myYs;
+  std::vector<int> myTimeOffsets;
+
+  MvrPose myPoseTaken;
+  MvrPose myEncoderPoseTaken;
+  unsigned int myCounterTaken;
+  MvrTime myTimeTaken;
+
+  // the to global transform split up so setReading can use it directly
+  double myTransX;
+  double myTransY;
+  double myTransCos;
+  double myTransSin;
+
+  // what the scan was taken with and what's been applied since,
+  // so fillReadings can build readings the same way the drivers did
+  MvrPose myOrigPoseTaken;
+  MvrTransform myToGlobal;
+  // a transform applied to every step'th reading starting with first
+  // (to the encoder pose taken if encoder is set)
+  struct AppliedTransform
+  {
+    MvrTransform myTrans;
+    int myFirst;
+    int myStep;
+    bool myEncoder;
+  };
+  std::vector<AppliedTransform> myAppliedTransforms;
+};
+
+#endif // MVRSCAN_H
@@ -39,6 +39,8 @@ class MvrSerialConnection: public MvrDeviceConnection
   MVREXPORT virtual bool close(void);
   MVREXPORT virtual int read(const char *data, unsigned int size, 
 			    unsigned int msWait = 0);
+  MVREXPORT virtual int readAvailable(const char *data, unsigned int size,
+				      unsigned int msWait = 0);
   MVREXPORT virtual int write(const char *data, unsigned int size);
   MVREXPORT virtual const char * getOpenMessage(int messageNumber);
 
@@ -81,6 +83,7 @@ class MvrSerialConnection: public MvrDeviceConnection
   };
   MVREXPORT virtual MvrTime getTimeRead(int index);
   MVREXPORT virtual bool isTimeStamping(void);
+  MVREXPORT virtual int getPollFD(void);
 
  protected:
   void buildStrMap(void);
@@ -18,7 +18,8 @@ class MvrRobotPacket;
    To see the different things you can set on a laser, call the
    functions canSetDegrees, canChooseRange, canSetIncrement,
    canChooseIncrement, canChooseUnits, canChooseReflectorBits,
-   canSetPowerControlled, canChooseStartBaud, and canChooseAutoBaud to
+   canSetPowerControlled, canChooseStartBaud, canChooseAutoBaud, and
+   canChooseProtocol to
    see what is available (the help for each of those tells you what
    functions they are associated with, and for each function
    associated with one of those it tells you to see the associated
@@ -66,18 +67,15 @@ protected:
   MvrTransform mySimPacketTrans;
   MvrTransform mySimPacketEncoderTrans;
   unsigned int mySimPacketCounter;
-  unsigned int myWhichReading;
-  unsigned int myTotalNumReadings;
 
   bool myStartConnect;
   bool myIsConnected;
   bool myTryingToConnect;
   bool myReceivedData;
 
-  std::list<MvrSensorReading *>::iterator myIter;
-  // range buffers to hold current range set and assembling range set
-  std::list<MvrSensorReading *> *myAssembleReadings;
-  std::list<MvrSensorReading *> *myCurrentReadings;
+  // the scan being assembled from the simulator's packets (swapped
+  // with the raw scan once it's all in)
+  MvrScan myAssembleScan;
 
   MvrRetFunctor1C<bool, MvrSimulatedLaser, MvrRobotPacket *> mySimPacketHandler;
 };
@@ -244,6 +244,17 @@ public:
   /// Gets if we've had a bad read (you have to use error tracking for this)
   MVREXPORT bool getBadRead(void) const { return myBadRead; }
 
+  /// Sets the most bytes to queue up when the socket can't take a write right away
+  MVREXPORT void setWriteQueueLimit(size_t maxBytes);
+  /// Gets the most bytes that will be queued up (0 means writes aren't queued)
+  size_t getWriteQueueLimit(void) const { return myWriteQueueLimit; }
+  /// Sends as much of the queued writes as the socket will take without blocking
+  MVREXPORT bool flushWriteQueue(void);
+  /// Gets the number of queued bytes waiting to be sent
+  MVREXPORT size_t getWriteQueueBytes(void);
+  /// Gets if a write was thrown away because the write queue was full
+  bool getWriteQueueOverflowed(void) const { return myWriteQueueOverflowed; }
+
 
 #ifndef SWIG
   /** @brief Writes a string to the socket (adding end of line characters)
@@ -316,6 +327,8 @@ protected:
   void setRawIPString(void);
   /// internal function that echos strings from read string
   void doStringEcho(void);
+  // internal function that does write() when writes are being queued
+  int queueWrite(const void *buff, size_t len);
   // internal crossplatform init (mostly for string reading stuff)
   void internalInit(void);
 
@@ -360,6 +373,18 @@ protected:
   bool myStringGotEscapeChars;
   bool myStringGotComplete;
   bool myStringHaveEchoed;
+  // what readString() has pulled off the socket but not used yet,
+  // read() hands this out first so mixing the two doesn't lose data
+  char myStringReadBuf[1024];
+  size_t myStringReadStart;
+  size_t myStringReadEnd;
+
+  // writes that couldn't go out right away, from myWriteQueueStart on
+  MvrMutex myWriteQueueMutex;
+  std::string myWriteQueue;
+  size_t myWriteQueueStart;
+  size_t myWriteQueueLimit;
+  bool myWriteQueueOverflowed;
 
   long mySends;
   long myBytesSent;
@@ -7,6 +7,8 @@
 #include "MvrRobot.h"
 #include "MvrRobotPacket.h"
 
+class MvrIOReactor;
+
 
 
 // Packets are in the format of 
@@ -118,6 +120,10 @@ public:
   MVREXPORT void setDeviceConnection(MvrDeviceConnection *conn);
   /// Gets the device this instance receives packets from
   MVREXPORT MvrDeviceConnection *getDeviceConnection(void);
+  /// Reads packets from this reactor instead of a thread of its own (call before connecting)
+  MVREXPORT void setIOReactor(MvrIOReactor *reactor);
+  /// Gets the reactor packets are read from, or NULL if it has its own thread
+  MvrIOReactor *getIOReactor(void) { return myIOReactor; }
 
   /// Very Internal call that gets the packet sender, shouldn't be used
   MvrRobotPacketSender *getPacketSender(void)
@@ -566,6 +572,16 @@ enum Commands {
   MvrFunctorC<MvrSonarMTX> mySensorInterpTask;
   MvrRetFunctorC<bool, MvrSonarMTX> myMvrExitCB;
 
+  // reads packets when using a reactor instead of runThread
+  void reactorReadable(void);
+  // checks for a lost connection when using a reactor
+  void reactorTimeout(void);
+  // reads from the reactor if there is one, otherwise starts runThread
+  void startReading(void);
+  MvrIOReactor *myIOReactor;
+  MvrFunctorC<MvrSonarMTX> myReactorReadableCB;
+  MvrFunctorC<MvrSonarMTX> myReactorTimeoutCB;
+
 };
 
 
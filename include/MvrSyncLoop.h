@@ -5,6 +5,8 @@
 #include "mvriaTypedefs.h"
 #include "MvrASyncTask.h"
 #include "MvrSyncTask.h"
+#include "MvrLatencyHistogram.h"
+#include <atomic>
 
 
 class MvrRobot;
@@ -24,11 +26,27 @@ public:
 
   MVREXPORT virtual const char *getThreadActivity(void);
 
+  /// Sets whether cycles are timed from absolute deadlines instead of sleeps
+  MVREXPORT void setAbsoluteTiming(bool absoluteTiming);
+  /// Gets whether cycles are timed from absolute deadlines instead of sleeps
+  MVREXPORT bool getAbsoluteTiming(void);
+  /// Gets how late each cycle started compared to when it should have, in us
+  MVREXPORT const MvrLatencyHistogram *getJitter(void);
+  /// Gets how many cycles missed their deadline
+  MVREXPORT unsigned long long getNumMissedDeadlines(void);
+  /// Resets the jitter histogram and missed deadline count
+  MVREXPORT void resetTimingStats(void);
+
 
 protected:
   bool myStopRunIfNotConnected;
   MvrRobot *myRobot;
   bool myInRun;
+  // sleeps until the monotonic clock (MvrUtil::getTimeUSec) reaches uSec
+  void sleepUntil(unsigned long long uSec);
+  std::atomic<bool> myAbsoluteTiming;
+  MvrLatencyHistogram myJitter;
+  std::atomic<unsigned long long> myNumMissedDeadlines;
 
 };
 
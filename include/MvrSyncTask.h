@@ -3,9 +3,14 @@
 
 #include <string>
 #include <map>
+#include <list>
+#include <vector>
 #include "mvriaTypedefs.h"
 #include "MvrFunctor.h"
 #include "MvrTaskState.h"
+#include "MvrLatencyHistogram.h"
+
+class MvrSyncTaskWorkerPool;
 
 /// Class used internally to manage the tasks that are called every cycle
 /**
@@ -47,6 +52,26 @@
    The state of a task can be stored in the target of a given MvrTaskState::State pointer,
    or if NULL than MvrSyncTask will use its own member vmvriable.
 
+   Every node keeps an MvrLatencyHistogram of how long it took to run
+   each cycle (its functor and all of its children), which can be gotten
+   with getLatencyHistogram() or logged for the whole tree with
+   logLatencies().
+
+   Normally every task runs one after another on the robot's thread.  If
+   setNumWorkerThreads() has been called on the root, then children that
+   have been marked with setIndependent() can run at the same time as
+   the independent siblings next to them: each run of independent
+   siblings (in position order) is split up onto the worker threads (the
+   thread running the parent works on them too), and the parent waits
+   for all of them to finish before running the next sibling that isn't
+   independent.  Independent siblings given the same resource name
+   (like "sensor interp" or "actions") run one after another (in
+   position order) on the same thread, so only ones that use different
+   things run at once.  Independent tasks must not lock the robot (the
+   robot thread has it locked while they run), and anything they share
+   other than through their resource has to be thread safe.  Independent
+   tasks below an independent task run one after another like normal.
+
   @internal
 */
 
@@ -64,6 +89,27 @@ public:
   MVREXPORT void run(void);
   /// Prints the node, which prints all the children of this node as well
   MVREXPORT void log(int depth = 0);
+  /// Logs how long the node and all its children have been taking to run
+  MVREXPORT void logLatencies(int depth = 0, int numRecent = 0);
+  /// Puts a line for the node and each of its children into lines, like logLatencies
+  MVREXPORT void getLatencies(std::list<std::string> *lines, int depth = 0,
+			      int numRecent = 0);
+  /// Throws away the run times of the node and all its children
+  MVREXPORT void resetLatencies(void);
+  /// Lets this task run at the same time as its independent siblings
+  MVREXPORT void setIndependent(bool independent, 
+				const char *resource = NULL);
+  /// Gets whether this task can run at the same time as its independent siblings
+  MVREXPORT bool getIndependent(void);
+  /// Gets the resource this task has to share with its independent siblings
+  MVREXPORT std::string getResource(void);
+  /// Sets how many worker threads run independent tasks (0 for none)
+  MVREXPORT void setNumWorkerThreads(int numWorkerThreads);
+  /// Gets how many worker threads run independent tasks
+  MVREXPORT int getNumWorkerThreads(void);
+  /// Gets the histogram of this node's run times
+  MVREXPORT const MvrLatencyHistogram *getLatencyHistogram(void) const
+    { return &myLatency; }
 
   /// Gets the state of the task
   MVREXPORT MvrTaskState::State getState(void);
@@ -128,6 +174,27 @@ protected:
   bool myRunning;
   // this is just a pointer to what we're invoking so we can know later
   MvrSyncTask *myInvokingOtherFunctor;
+  // how long each run took, functor and children
+  MvrLatencyHistogram myLatency;
+
+  // a child to run (if myTask isn't NULL) or lanes of children to run at once
+  struct RunStep
+  {
+    MvrSyncTask *myTask;
+    int myFirstLane;
+    int myNumLanes;
+  };
+  // works out myRunSteps and myRunLanes from the children
+  void buildRunPlan(void);
+  // gets the worker pool from the root of the tree
+  MvrSyncTaskWorkerPool *getWorkerPool(void);
+  bool myIndependent;
+  std::string myResource;
+  bool myRunPlanDirty;
+  std::vector<RunStep> myRunSteps;
+  std::vector<std::vector<MvrSyncTask *> > myRunLanes;
+  // only the root has one of these
+  MvrSyncTaskWorkerPool *myWorkerPool;
 };
 
 
@@ -26,10 +26,13 @@ class MvrTcpConnection: public MvrDeviceConnection
   MVREXPORT virtual bool close(void);
   MVREXPORT virtual int read(const char *data, unsigned int size, 
 			    unsigned int msWait = 0);
+  MVREXPORT virtual int readAvailable(const char *data, unsigned int size,
+				      unsigned int msWait = 0);
   MVREXPORT virtual int write(const char *data, unsigned int size);
   MVREXPORT virtual const char * getOpenMessage(int messageNumber);
   MVREXPORT virtual MvrTime getTimeRead(int index);
   MVREXPORT virtual bool isTimeStamping(void);
+  MVREXPORT virtual int getPollFD(void);
 
   /// Gets the name of the host connected to
   MVREXPORT std::string getHost(void);
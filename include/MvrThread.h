@@ -239,6 +239,8 @@ protected:
 #endif
 
   static std::string ourUnknownThreadName;
+
+  friend class MvrThreadScheduling;
 };
 
 
@@ -0,0 +1,118 @@
+#ifndef MVRTHREADSCHEDULING_H
+#define MVRTHREADSCHEDULING_H
+
+#include "mvriaTypedefs.h"
+#include "MvrThread.h"
+#include "MvrFunctor.h"
+#include <string>
+#include <map>
+
+class MvrConfig;
+
+/// Which CPUs a thread runs on and how it is scheduled, set by thread name
+/**
+   Normally every thread runs wherever the OS puts it with the normal
+   time sharing scheduling, which is what lets other things running on
+   the machine add latency to the robot's threads.  With this the
+   threads that matter can be given CPUs of their own (ideally ones
+   isolated from everything else, ie with the isolcpus kernel option)
+   and a real time scheduling policy.
+
+   Scheduling is set for threads by their names (MvrThread::setThreadName),
+   with setForThread() from code or with addToConfig() from MvrConfig,
+   and is applied by the thread itself when it starts (and right away
+   to threads with that name that are already running).  The robot's
+   threads are named "MvrRobotSyncLoop" (the robot cycle) and
+   "MvrRobotPacketReader" (the packet reader, if the robot is using
+   one), lasers' threads are named the same as the lasers.
+
+   lockMemory() (or the LockMemory config parameter) locks all the
+   memory the program has and will get into RAM, so that the real time
+   threads never wait for pages to come in.
+
+   Real time policies and locking memory need privileges (root or
+   CAP_SYS_NICE and CAP_IPC_LOCK, or rtprio and memlock in
+   limits.conf), anything that can't be done is logged and skipped.
+   This only does anything on Linux.
+
+   @ingroup UtilityClasses
+**/
+class MvrThreadScheduling
+{
+public:
+  /// The scheduling policies
+  enum Policy 
+  {
+    INHERIT, ///< Leave the policy (and priority) as they are
+    OTHER, ///< Normal time sharing (SCHED_OTHER)
+    FIFO, ///< Real time, run until done or preempted (SCHED_FIFO)
+    RR ///< Real time, round robin with the same priority (SCHED_RR)
+  };
+  /// Constructor
+  MVREXPORT MvrThreadScheduling(const char *cpus = NULL, 
+				Policy policy = INHERIT, int priority = 0);
+  /// Destructor
+  MVREXPORT virtual ~MvrThreadScheduling();
+  /// Sets the CPUs to run on, like "2" or "0,2-3" (empty or NULL to leave alone)
+  MVREXPORT void setCPUs(const char *cpus);
+  /// Gets the CPUs to run on
+  const char *getCPUs(void) const { return myCPUs.c_str(); }
+  /// Sets the scheduling policy
+  void setPolicy(Policy policy) { myPolicy = policy; }
+  /// Gets the scheduling policy
+  Policy getPolicy(void) const { return myPolicy; }
+  /// Sets the priority (1 to 99 for FIFO and RR, ignored otherwise)
+  void setPriority(int priority) { myPriority = priority; }
+  /// Gets the priority
+  int getPriority(void) const { return myPriority; }
+  /// Applies this to a thread, returns false if any of it couldn't be
+  MVREXPORT bool apply(MvrThread::ThreadType thread, 
+		       const char *threadName) const;
+
+  /// Sets the scheduling for the threads with this name
+  MVREXPORT static void setForThread(const char *threadName,
+				     const MvrThreadScheduling &scheduling);
+  /// Gets the scheduling set for threads with this name, false if there isn't any
+  MVREXPORT static bool getForThread(const char *threadName,
+				     MvrThreadScheduling *scheduling);
+  /// Stops setting the scheduling for threads with this name
+  MVREXPORT static void remForThread(const char *threadName);
+  /// Applies the scheduling set for this thread's name to this thread
+  MVREXPORT static void applyToThisThread(const char *threadName);
+  /// Locks all the memory the program has and will have into RAM
+  MVREXPORT static bool lockMemory(void);
+  /// Adds the parameters for a thread's scheduling (and LockMemory) to a config
+  MVREXPORT static void addToConfig(MvrConfig *config, 
+				    const char *threadName,
+				    const char *section = "Thread scheduling");
+  /// Parses a policy name (inherit, other, fifo or rr), false if it isn't one
+  MVREXPORT static bool parsePolicy(const char *str, Policy *policy);
+  /// Gets the name of a policy
+  MVREXPORT static const char *getPolicyName(Policy policy);
+protected:
+  // parses a list of cpus into cpuList, false if it is bad
+  static bool parseCPUs(const char *cpus, int *cpuList, int maxCPUs, 
+			int *numCPUs);
+  static bool processFile(char *errorBuffer, size_t errorBufferLen);
+
+  std::string myCPUs;
+  Policy myPolicy;
+  int myPriority;
+
+  // what config sets for a thread
+  class ConfigEntry
+  {
+  public:
+    std::string myCPUs;
+    std::string myPolicy;
+    int myPriority;
+  };
+  static MvrMutex ourMutex;
+  static std::map<std::string, MvrThreadScheduling> ourSchedulings;
+  static std::map<std::string, ConfigEntry *> ourConfigEntries;
+  static bool ourConfigLockMemory;
+  static bool ourMemoryLocked;
+  static MvrGlobalRetFunctor2<bool, char *, size_t> ourProcessFileCB;
+};
+
+#endif // MVRTHREADSCHEDULING_H
@@ -117,6 +117,10 @@ public:
   double getY() { return myY; }
   /// Gets the transform angle value (degrees)
   double getTh() { return myTh; }
+  /// Gets the cos used for the rotation part of the transform
+  double getCos() { return myCos; }
+  /// Gets the sin used for the rotation part of the transform
+  double getSin() { return mySin; }
   /// Internal function for setting the transform from low level data not poses
   MVREXPORT void setTransformLowLevel(double x, double y, double th);
 protected:
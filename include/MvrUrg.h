@@ -76,6 +76,8 @@ protected:
   bool myFlipped;
   char myRequestString[1024];
   double myClusterMiddleAngle;
+  // the angle of each reading in the raw scan
+  std::vector<double> myStepThs;
 
   bool internalConnect(void);
 
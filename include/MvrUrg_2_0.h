@@ -4,6 +4,7 @@
 #include "mvriaTypedefs.h"
 #include "MvrLaser.h"
 #include "MvrDeviceConnection.h"
+#include <vector>
 
 /** 
     Hokuyo URG laser range device (SCIP 2.0).
@@ -64,6 +65,13 @@ protected:
   bool readLine(char *buf, unsigned int size, unsigned int msWait, 
 		bool noChecksum, bool stripLastSemicolon, 
 		MvrTime *firstByte = NULL);
+  /// internal call to get the next line out of the receive buffer
+  bool nextLine(char **line, unsigned int *len, unsigned int msWait,
+		MvrTime *firstByte = NULL);
+  /// internal call to check and take off the checksum on a line
+  bool checkLine(char *line, unsigned int *len, bool stripLastSemicolon);
+  /// internal call to decode a line of distance reading data
+  void decodeLine(const char *data, unsigned int len);
 
   /// internal call to write a command and get the response back into the buf
   bool sendCommandAndRecvStatus(
@@ -80,7 +88,26 @@ protected:
   MvrMutex myDataMutex;
 
   MvrTime myReadingRequested;
-  std::string myReading;
+
+  // what's been read from the urg but not used yet
+  char myReceiveBuf[8192];
+  unsigned int myReceiveStart;
+  unsigned int myReceiveEnd;
+  MvrTime myReceiveTime;
+
+  // the ranges of the reading being read, the last whole reading
+  // (under myReadingMutex), and the one sensorInterp is using, these
+  // get swapped around instead of copied
+  std::vector<int> myRanges;
+  int myNumRanges;
+  std::vector<int> myReadingRanges;
+  int myReadingNumRanges;
+  std::vector<int> myInterpRanges;
+  // the angle of each reading in the raw scan
+  std::vector<double> myStepThs;
+  // characters of a value split across the end of a line
+  char myCarry[3];
+  int myCarryCount;
 
   int myStartingStep;
   int myEndingStep;
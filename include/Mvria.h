@@ -8,6 +8,8 @@
 #include "MvrSimpleConnector.h"
 #include "MvrLogFileConnection.h"
 #include "MvrLog.h"
+#include "MvrLatencyHistogram.h"
+#include "MvrBinaryLog.h"
 #include "MvrRobotPacket.h"
 #include "MvrRobotPacketSender.h"
 #include "MvrRobotPacketReceiver.h"
@@ -21,6 +23,7 @@
 #include "MvrConfigArg.h"
 #include "MvrConfigGroup.h"
 #include "MvrRobot.h"
+#include "MvrRobotStateSnapshot.h"
 #include "MvrCommands.h"
 #include "MvrJoyHandler.h"
 #include "MvrSyncTask.h"
@@ -129,6 +132,11 @@
 #include "MvrS3Series.h"
 #include "MvrSZSeries.h"
 #include "MvrRobotPacketReaderThread.h"
+#include "MvrThreadScheduling.h"
+#include "MvrFastMutex.h"
+#include "MvrIOReactor.h"
+#include "MvrCRC16.h"
+#include "MvrScan.h"
 #include "MvrHasFileName.h"
 
 #endif // ARIA_H
@@ -82,6 +82,9 @@ public:
   /// Get the time in milliseconds
   MVREXPORT static unsigned int getTime(void);
 
+  /// Get the time in microseconds
+  MVREXPORT static unsigned long long getTimeUSec(void);
+
   /// Delete all members of a set. Does NOT empty the set.
   /** 
       Assumes that T is an iterator that supports the operator*, operator!=
@@ -5,6 +5,7 @@
 #include "mvriaOSDef.h"
 #include "MvrASyncTask.h"
 #include "MvrLog.h"
+#include "MvrThreadScheduling.h"
 
 
 MVREXPORT MvrASyncTask::MvrASyncTask() :
@@ -31,6 +32,11 @@ MVREXPORT int MvrASyncTask::create(bool joinable, bool lowerPriority)
 */
 MVREXPORT void * MvrASyncTask::runInThisThread(void *arg)
 {
+  // CPUs and real time scheduling set up for this thread's name (this
+  // doesn't go through the MvrThread run trampoline, which does that
+  // for created threads)
+  MvrThreadScheduling::applyToThisThread(getThreadName());
+
   myJoinable=true;
   myRunning=true;
 #if defined(WIN32) && !defined(MINGW)
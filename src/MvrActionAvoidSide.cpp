@@ -35,10 +35,14 @@ MVREXPORT MvrActionDesired *MvrActionAvoidSide::fire(
 {
   double leftDist, rightDist;
 
-  leftDist = (myRobot->checkRangeDevicesCurrentPolar(60, 120) - 
-	      myRobot->getRobotRadius());
-  rightDist = (myRobot->checkRangeDevicesCurrentPolar(-120, -60) - 
-	      myRobot->getRobotRadius());
+  // check both sides together so the readings are only gone through once
+  MvrRangeRegion regions[2];
+  regions[0].setPolar(60, 120);
+  regions[1].setPolar(-120, -60);
+  myRobot->checkRangeDevicesCurrentRegions(regions, 2);
+
+  leftDist = regions[0].getDist() - myRobot->getRobotRadius();
+  rightDist = regions[1].getDist() - myRobot->getRobotRadius();
   
   myDesired.reset();
   if (leftDist < myObsDist)
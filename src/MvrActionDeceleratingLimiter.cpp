@@ -236,76 +236,76 @@ MvrActionDeceleratingLimiter::fire(MvrActionDesired currentDesired)
 		
   MvrPose obstaclePose(-1, -1, -1);
   MvrPose obstacleInnerPose(-1, -1, -1);
+  // the outer box (with padding for our speed) and the inner box
+  // (what we estop for), checked together so the readings are only
+  // gone through once
+  MvrRangeRegion regions[2];
 
   if (myType == FORWARDS)
-    dist = myRobot->checkRangeDevicesCurrentBox(
+  {
+    regions[0].setBox(
 	    0,
 	    -(myRobot->getRobotWidth()/2.0 + sideClearance),
 	    myRobot->getRobotLength()/2.0 + myClearance + padding + lookAhead,
-	    (myRobot->getRobotWidth()/2.0 + sideClearance),
-	    &obstaclePose,
-	    &distRangeDevice, myUseLocationDependentDevices);
+	    (myRobot->getRobotWidth()/2.0 + sideClearance));
+    regions[1].setBox(
+	    0,
+	    -(myRobot->getRobotWidth()/2.0 + mySideClearanceAtSlowSpeed),
+	    myRobot->getRobotLength()/2.0 + myClearance + lookAhead,
+	    (myRobot->getRobotWidth()/2.0 + mySideClearanceAtSlowSpeed));
+  }
   else if (myType == BACKWARDS)
-    dist = myRobot->checkRangeDevicesCurrentBox(
+  {
+    regions[0].setBox(
 	    0,
 	    -(myRobot->getRobotWidth()/2.0 + sideClearance),
 	    -(myRobot->getRobotLength()/2.0 + myClearance + padding + lookAhead),
-	    (myRobot->getRobotWidth()/2.0 + sideClearance),
-	    &obstaclePose,
-	    &distRangeDevice, myUseLocationDependentDevices);
+	    (myRobot->getRobotWidth()/2.0 + sideClearance));
+    regions[1].setBox(
+	    0,
+	    -(myRobot->getRobotWidth()/2.0 + mySideClearanceAtSlowSpeed),
+	    -(myRobot->getRobotLength()/2.0 + myClearance + lookAhead),
+	    (myRobot->getRobotWidth()/2.0 + mySideClearanceAtSlowSpeed));
+  }
   //todo
   else if (myType == LATERAL_LEFT)
-    dist = myRobot->checkRangeDevicesCurrentBox(
+  {
+    regions[0].setBox(
 	    -(myRobot->getRobotLength()/2.0 + sideClearance),
 	    0,
 	    (myRobot->getRobotLength()/2.0 + sideClearance),
-	    myRobot->getRobotWidth()/2.0 + myClearance + padding + lookAhead,
-	    &obstaclePose,
-	    &distRangeDevice, myUseLocationDependentDevices);
+	    myRobot->getRobotWidth()/2.0 + myClearance + padding + lookAhead);
+    regions[1].setBox(
+	    -(myRobot->getRobotLength()/2.0 + mySideClearanceAtSlowSpeed),
+	    0,
+	    (myRobot->getRobotLength()/2.0 + mySideClearanceAtSlowSpeed),
+	    myRobot->getRobotWidth()/2.0 + myClearance + lookAhead);
+  }
   //todo
   else if (myType == LATERAL_RIGHT)
-    dist = myRobot->checkRangeDevicesCurrentBox(
+  {
+    regions[0].setBox(
 	    -(myRobot->getRobotLength()/2.0 + sideClearance),
 	    -(myRobot->getRobotWidth()/2.0 + myClearance + padding + lookAhead),  
 	    (myRobot->getRobotLength()/2.0 + sideClearance),
-	    0,
-	    &obstaclePose,
-	    &distRangeDevice, myUseLocationDependentDevices);
-
-  if (myType == FORWARDS)
-    distInner = myRobot->checkRangeDevicesCurrentBox(
-	    0,
-	    -(myRobot->getRobotWidth()/2.0 + mySideClearanceAtSlowSpeed),
-	    myRobot->getRobotLength()/2.0 + myClearance + lookAhead,
-	    (myRobot->getRobotWidth()/2.0 + mySideClearanceAtSlowSpeed),
-	    &obstacleInnerPose,
-	    &distInnerRangeDevice, myUseLocationDependentDevices);
-  else if (myType == BACKWARDS)
-    distInner = myRobot->checkRangeDevicesCurrentBox(
-	    0,
-	    -(myRobot->getRobotWidth()/2.0 + mySideClearanceAtSlowSpeed),
-	    -(myRobot->getRobotLength()/2.0 + myClearance + lookAhead),
-	    (myRobot->getRobotWidth()/2.0 + mySideClearanceAtSlowSpeed),
-	    &obstacleInnerPose,
-	    &distInnerRangeDevice, myUseLocationDependentDevices);
-  // todo
-  else if (myType == LATERAL_LEFT)
-    distInner = myRobot->checkRangeDevicesCurrentBox(
-	    -(myRobot->getRobotLength()/2.0 + mySideClearanceAtSlowSpeed),
-	    0,
-	    (myRobot->getRobotLength()/2.0 + mySideClearanceAtSlowSpeed),
-	    myRobot->getRobotWidth()/2.0 + myClearance + lookAhead,
-	    &obstacleInnerPose,
-	    &distInnerRangeDevice, myUseLocationDependentDevices);
-  // todo
-  else if (myType == LATERAL_RIGHT)
-    distInner = myRobot->checkRangeDevicesCurrentBox(
+	    0);
+    regions[1].setBox(
 	    -(myRobot->getRobotLength()/2.0 + mySideClearanceAtSlowSpeed),
 	    -(myRobot->getRobotWidth()/2.0 + myClearance + lookAhead),
 	    (myRobot->getRobotLength()/2.0 + mySideClearanceAtSlowSpeed),
-	    0,
-	    &obstacleInnerPose,
-	    &distInnerRangeDevice, myUseLocationDependentDevices);
+	    0);
+  }
+
+  myRobot->checkRangeDevicesCurrentRegions(regions, 2, 
+					   myUseLocationDependentDevices);
+  dist = regions[0].getDist();
+  distRangeDevice = regions[0].getRangeDevice();
+  if (distRangeDevice != NULL)
+    obstaclePose = regions[0].getReadingPos();
+  distInner = regions[1].getDist();
+  distInnerRangeDevice = regions[1].getRangeDevice();
+  if (distInnerRangeDevice != NULL)
+    obstacleInnerPose = regions[1].getReadingPos();
 
   // subtract off our clearance and padding to see how far we have to stop
   if (myType != LATERAL_LEFT && myType != LATERAL_RIGHT)
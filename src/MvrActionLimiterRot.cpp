@@ -81,9 +81,7 @@ MvrActionLimiterRot::fire(MvrActionDesired currentDesired)
   }
 
   double leftDist;
-  const MvrRangeDevice *leftRangeDevice = NULL;
   double rightDist;
-  const MvrRangeDevice *rightRangeDevice = NULL;
 
   double dist;
   //const MvrRangeDevice *rangeDevice = NULL;
@@ -94,33 +92,37 @@ MvrActionLimiterRot::fire(MvrActionDesired currentDesired)
   //  verboseLogLevel = MvrLog::Normal;
 
 
-  leftDist = myRobot->checkRangeDevicesCurrentPolar(
-	  0, 179.999, NULL, &leftRangeDevice, myUseLocationDependentDevices);
+  // check both sides together so the readings are only gone through once
+  MvrRangeRegion regions[2];
+  regions[0].setPolar(0, 179.999);
+  regions[1].setPolar(-179.999, 0);
+  myRobot->checkRangeDevicesCurrentRegions(regions, 2, 
+					   myUseLocationDependentDevices);
 
-  rightDist = myRobot->checkRangeDevicesCurrentPolar(
-	  -179.999, 0, NULL, &rightRangeDevice, myUseLocationDependentDevices);
+  leftDist = regions[0].getDist();
+  rightDist = regions[1].getDist();
   
   if (leftDist > 0 && rightDist < 0)
   {
     dist = leftDist;
-    //rangeDevice = leftRangeDevice;
+    //rangeDevice = regions[0].getRangeDevice();
   }
   else if (rightDist > 0 && leftDist < 0)
   {
     dist = rightDist;
-    //rangeDevice = rightRangeDevice;
+    //rangeDevice = regions[1].getRangeDevice();
   }
   else if (leftDist > 0 && rightDist > 0)
   {
     if (leftDist < rightDist)
     {
       dist = leftDist;
-      //rangeDevice = leftRangeDevice;
+      //rangeDevice = regions[0].getRangeDevice();
     }
     else 
     {
       dist = rightDist;
-      //rangeDevice = rightRangeDevice;
+      //rangeDevice = regions[1].getRangeDevice();
     }
   }
   else
@@ -176,8 +176,13 @@ void MvrActionStallRecover::doit(void)
       mySideStalled += 2;
     if (myDoing & TURN) 
     {
-      rightDist = myRobot->checkRangeDevicesCurrentPolar(-120, -60);
-      leftDist = myRobot->checkRangeDevicesCurrentPolar(60, 120);
+      // check both sides together so the readings are only gone through once
+      MvrRangeRegion regions[2];
+      regions[0].setPolar(-120, -60);
+      regions[1].setPolar(60, 120);
+      myRobot->checkRangeDevicesCurrentRegions(regions, 2);
+      rightDist = regions[0].getDist();
+      leftDist = regions[1].getDist();
       if (mySideStalled == 1 || rightDist < 0)
 	turnDirection = -1;
       else if (mySideStalled == 2 || leftDist < 0)
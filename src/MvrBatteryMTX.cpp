@@ -5,6 +5,7 @@
 //#include "MvrRobot.h"
 #include "mvriaOSDef.h"
 #include "MvrSerialConnection.h"
+#include "MvrIOReactor.h"
 #include "mvriaInternal.h"
 #include <time.h>
 
@@ -24,7 +25,10 @@ MVREXPORT MvrBatteryMTX::MvrBatteryMTX (int batteryBoardNum, const char *name,
 	myConn (conn),
 	myName (name),
 	myBoardNum (batteryBoardNum),
-	myMvrExitCB (this, &MvrBatteryMTX::disconnect)
+	myMvrExitCB (this, &MvrBatteryMTX::disconnect),
+	myIOReactor (NULL),
+	myReactorReadableCB (this, &MvrBatteryMTX::reactorReadable),
+	myReactorTimeoutCB (this, &MvrBatteryMTX::reactorTimeout)
 {
 
 	myInfoLogLevel = MvrLog::Normal;
@@ -59,6 +63,8 @@ MVREXPORT MvrBatteryMTX::MvrBatteryMTX (int batteryBoardNum, const char *name,
 
 MVREXPORT MvrBatteryMTX::~MvrBatteryMTX()
 {
+	if (myIOReactor != NULL)
+		myIOReactor->remConnection (myConn);
 	if (myRobot != NULL) {
 		myRobot->remSensorInterpTask (&myProcessCB);
 	}
@@ -616,7 +622,7 @@ MVREXPORT bool MvrBatteryMTX::blockingConnect (bool sendTracking, bool recvTrack
 
   myLastReading.setToNow();
 
-	runAsync();
+	startReading();
 	return true;
 } // end blockingConnect
 
@@ -680,6 +686,53 @@ while (getRunning() )
 	return NULL;
 }
 
+/**
+   With a reactor the battery doesn't need a thread of its own, the
+   reactor calls it when there's data and checks for a lost connection
+   when there hasn't been any for a while.
+**/
+MVREXPORT void MvrBatteryMTX::setIOReactor (MvrIOReactor *reactor)
+{
+	myIOReactor = reactor;
+}
+
+void MvrBatteryMTX::startReading (void)
+{
+	if (myIOReactor != NULL &&
+	    myIOReactor->addConnection (myConn, &myReactorReadableCB,
+	                                &myReactorTimeoutCB, 500))
+		return;
+	runAsync();
+}
+
+void MvrBatteryMTX::reactorReadable (void)
+{
+	MvrRobotPacket *packet;
+
+	// the data is already here, so this doesn't wait (except for the
+	// rest of a packet that's partway in)
+	while (myIsConnected && (packet = myReceiver->receivePacket (0)) != NULL) {
+		myPacketsMutex.lock();
+		myPackets.push_back (packet);
+		myPacketsMutex.unlock();
+		if (myRobot == NULL)
+			sensorInterp();
+	}
+}
+
+void MvrBatteryMTX::reactorTimeout (void)
+{
+	if (myIsConnected && checkLostConnection() ) {
+		MvrLog::log (MvrLog::Terse,
+		            "%s::reactorTimeout()  Lost connection to the MTX battery because of error.  Nothing received for %g seconds (greater than the timeout of %g).", getName(),
+		            myLastReading.mSecSince() / 1000.0,
+		            getConnectionTimeoutSeconds() );
+		myIsConnected = false;
+		myIOReactor->remConnection (myConn);
+		disconnectOnError();
+	}
+}
+
 /**
    This will check if the battery has lost connection.  If there is no
    robot it is a straightforward check of last reading time against
@@ -0,0 +1,808 @@
+#include "MvrExport.h"
+#include "mvriaOSDef.h"
+#include "MvrBinaryLog.h"
+#include "mvriaUtil.h"
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+/**
+   A registered format, split up into its conversions.  Every argument
+   is stored as 8 bytes (integers as long long, doubles as double,
+   pointers as unsigned long long) except long doubles (stored as they
+   are) and strings (a 2 byte length and then the characters), and is
+   turned back into the type the conversion expects when it is
+   formatted.
+**/
+class MvrBinaryLogFormat
+{
+public:
+  enum ArgType {
+    ARG_PERCENT, // %%, there's no argument
+    ARG_INT,
+    ARG_LONG,
+    ARG_LONGLONG,
+    ARG_SIZE,
+    ARG_INTMAX,
+    ARG_PTRDIFF,
+    ARG_DOUBLE,
+    ARG_LONGDOUBLE,
+    ARG_STRING,
+    ARG_POINTER
+  };
+  struct Conversion
+  {
+    std::string myLiteral; // the text before this conversion
+    std::string mySpec; // the whole conversion, like %-5.2f
+    int myNumStars; // how many * widths/precisions come before the argument
+    ArgType myType;
+  };
+
+  // parses a format, NULL if it has a conversion we can't log
+  static MvrBinaryLogFormat *parse(MvrLog::LogLevel level, const char *format);
+  // copies the arguments for this format into buf
+  bool capture(char *buf, size_t *len, size_t size, va_list ptr) const;
+  // formats arguments from capture() into text
+  bool render(const char *args, size_t len, std::string *text) const;
+
+  MvrLog::LogLevel myLevel;
+  std::string myFormat;
+  std::vector<Conversion> myConversions;
+  std::string myTrailing; // the text after the last conversion
+};
+
+MvrBinaryLogFormat *MvrBinaryLogFormat::parse(MvrLog::LogLevel level,
+					      const char *format)
+{
+  MvrBinaryLogFormat *ret = new MvrBinaryLogFormat;
+  Conversion conversion;
+  const char *literalStart = format;
+  const char *specStart;
+  const char *p = format;
+  // 0 none, 1 hh, 2 h, 3 l, 4 ll, 5 L, 6 z, 7 j, 8 t
+  int length;
+  char conv;
+
+  ret->myLevel = level;
+  ret->myFormat = format;
+  while (*p != '\0')
+  {
+    if (*p != '%')
+    {
+      p++;
+      continue;
+    }
+    conversion.myLiteral.assign(literalStart, p - literalStart);
+    conversion.myNumStars = 0;
+    specStart = p;
+    p++;
+    if (*p == '%')
+    {
+      p++;
+      conversion.mySpec = "%%";
+      conversion.myType = ARG_PERCENT;
+      ret->myConversions.push_back(conversion);
+      literalStart = p;
+      continue;
+    }
+    while (*p != '\0' && strchr("-+ #0'", *p) != NULL)
+      p++;
+    if (*p == '*')
+    {
+      conversion.myNumStars++;
+      p++;
+    }
+    else
+      while (isdigit(*p))
+	p++;
+    if (*p == '.')
+    {
+      p++;
+      if (*p == '*')
+      {
+	conversion.myNumStars++;
+	p++;
+      }
+      else
+	while (isdigit(*p))
+	  p++;
+    }
+    length = 0;
+    if (p[0] == 'h' && p[1] == 'h')
+    {
+      length = 1;
+      p += 2;
+    }
+    else if (p[0] == 'l' && p[1] == 'l')
+    {
+      length = 4;
+      p += 2;
+    }
+    else if (*p == 'h')
+    {
+      length = 2;
+      p++;
+    }
+    else if (*p == 'l')
+    {
+      length = 3;
+      p++;
+    }
+    else if (*p == 'L' || *p == 'q')
+    {
+      // q is the old BSD spelling of ll, L on an integer means ll too
+      length = (*p == 'q') ? 4 : 5;
+      p++;
+    }
+    else if (*p == 'z')
+    {
+      length = 6;
+      p++;
+    }
+    else if (*p == 'j')
+    {
+      length = 7;
+      p++;
+    }
+    else if (*p == 't')
+    {
+      length = 8;
+      p++;
+    }
+
+    conv = *p;
+    if (conv == '\0')
+    {
+      delete ret;
+      return NULL;
+    }
+    p++;
+    switch (conv)
+    {
+    case 'd':
+    case 'i':
+    case 'o':
+    case 'u':
+    case 'x':
+    case 'X':
+    case 'c':
+      if (conv == 'c' && length != 0)
+      {
+	delete ret;
+	return NULL;
+      }
+      if (length <= 2)
+	conversion.myType = ARG_INT;
+      else if (length == 3)
+	conversion.myType = ARG_LONG;
+      else if (length == 4 || length == 5)
+	conversion.myType = ARG_LONGLONG;
+      else if (length == 6)
+	conversion.myType = ARG_SIZE;
+      else if (length == 7)
+	conversion.myType = ARG_INTMAX;
+      else
+	conversion.myType = ARG_PTRDIFF;
+      break;
+    case 'f':
+    case 'F':
+    case 'e':
+    case 'E':
+    case 'g':
+    case 'G':
+    case 'a':
+    case 'A':
+      if (length == 5)
+	conversion.myType = ARG_LONGDOUBLE;
+      else if (length == 0 || length == 3)
+	conversion.myType = ARG_DOUBLE;
+      else
+      {
+	delete ret;
+	return NULL;
+      }
+      break;
+    case 's':
+      if (length != 0)
+      {
+	delete ret;
+	return NULL;
+      }
+      conversion.myType = ARG_STRING;
+      break;
+    case 'p':
+      conversion.myType = ARG_POINTER;
+      break;
+    default:
+      // %n, wide characters, %m and anything we don't know
+      delete ret;
+      return NULL;
+    }
+    conversion.mySpec.assign(specStart, p - specStart);
+    ret->myConversions.push_back(conversion);
+    literalStart = p;
+  }
+  ret->myTrailing = literalStart;
+  return ret;
+}
+
+static bool putBytes(char *buf, size_t *len, size_t size, const void *data,
+		     size_t num)
+{
+  if (*len + num > size)
+    return false;
+  memcpy(buf + *len, data, num);
+  *len += num;
+  return true;
+}
+
+static bool putLongLong(char *buf, size_t *len, size_t size, long long val)
+{
+  return putBytes(buf, len, size, &val, sizeof(val));
+}
+
+/**
+   @return false if the arguments didn't fit in size (only possible for
+   formats with a whole lot of conversions, strings are cut short to
+   fit instead)
+**/
+bool MvrBinaryLogFormat::capture(char *buf, size_t *len, size_t size,
+				 va_list ptr) const
+{
+  std::vector<Conversion>::const_iterator it;
+  int i;
+  const char *str;
+  size_t strLen;
+  unsigned short strLenShort;
+  double doubleVal;
+  long double longDoubleVal;
+
+  for (it = myConversions.begin(); it != myConversions.end(); it++)
+  {
+    for (i = 0; i < (*it).myNumStars; i++)
+      if (!putLongLong(buf, len, size, va_arg(ptr, int)))
+	return false;
+    switch ((*it).myType)
+    {
+    case ARG_PERCENT:
+      break;
+    case ARG_INT:
+      if (!putLongLong(buf, len, size, va_arg(ptr, int)))
+	return false;
+      break;
+    case ARG_LONG:
+      if (!putLongLong(buf, len, size, va_arg(ptr, long)))
+	return false;
+      break;
+    case ARG_LONGLONG:
+      if (!putLongLong(buf, len, size, va_arg(ptr, long long)))
+	return false;
+      break;
+    case ARG_SIZE:
+      if (!putLongLong(buf, len, size, (long long)va_arg(ptr, size_t)))
+	return false;
+      break;
+    case ARG_INTMAX:
+      if (!putLongLong(buf, len, size, (long long)va_arg(ptr, intmax_t)))
+	return false;
+      break;
+    case ARG_PTRDIFF:
+      if (!putLongLong(buf, len, size, (long long)va_arg(ptr, ptrdiff_t)))
+	return false;
+      break;
+    case ARG_DOUBLE:
+      doubleVal = va_arg(ptr, double);
+      if (!putBytes(buf, len, size, &doubleVal, sizeof(doubleVal)))
+	return false;
+      break;
+    case ARG_LONGDOUBLE:
+      longDoubleVal = va_arg(ptr, long double);
+      if (!putBytes(buf, len, size, &longDoubleVal, sizeof(longDoubleVal)))
+	return false;
+      break;
+    case ARG_STRING:
+      str = va_arg(ptr, const char *);
+      if (str == NULL)
+	str = "(null)";
+      strLen = strlen(str);
+      if (strLen > MvrBinaryLog::MAX_STRING)
+	strLen = MvrBinaryLog::MAX_STRING;
+      if (*len + sizeof(strLenShort) > size)
+	return false;
+      if (strLen > size - *len - sizeof(strLenShort))
+	strLen = size - *len - sizeof(strLenShort);
+      strLenShort = strLen;
+      putBytes(buf, len, size, &strLenShort, sizeof(strLenShort));
+      putBytes(buf, len, size, str, strLen);
+      break;
+    case ARG_POINTER:
+      if (!putLongLong(buf, len, size,
+		       (long long)(uintptr_t)va_arg(ptr, void *)))
+	return false;
+      break;
+    }
+  }
+  return true;
+}
+
+template <class T>
+static void appendFormatted(std::string *text, const char *spec,
+			    int numStars, const int *stars, T val)
+{
+  char buf[2048];
+  int ret;
+
+  if (numStars == 0)
+    ret = snprintf(buf, sizeof(buf), spec, val);
+  else if (numStars == 1)
+    ret = snprintf(buf, sizeof(buf), spec, stars[0], val);
+  else
+    ret = snprintf(buf, sizeof(buf), spec, stars[0], stars[1], val);
+  if (ret < 0)
+    return;
+  if ((size_t)ret > sizeof(buf) - 1)
+    ret = sizeof(buf) - 1;
+  text->append(buf, ret);
+}
+
+static bool getBytes(const char *args, size_t len, size_t *pos, void *data,
+		     size_t num)
+{
+  if (*pos + num > len)
+    return false;
+  memcpy(data, args + *pos, num);
+  *pos += num;
+  return true;
+}
+
+/**
+   @return false if the arguments were cut short (what could be
+   formatted still is)
+**/
+bool MvrBinaryLogFormat::render(const char *args, size_t len,
+				std::string *text) const
+{
+  std::vector<Conversion>::const_iterator it;
+  size_t pos = 0;
+  int stars[2];
+  int i;
+  long long val;
+  double doubleVal;
+  long double longDoubleVal;
+  unsigned short strLen;
+  std::string str;
+
+  for (it = myConversions.begin(); it != myConversions.end(); it++)
+  {
+    const Conversion &conversion = (*it);
+    text->append(conversion.myLiteral);
+    if (conversion.myType == ARG_PERCENT)
+    {
+      text->append("%");
+      continue;
+    }
+    for (i = 0; i < conversion.myNumStars; i++)
+    {
+      if (!getBytes(args, len, &pos, &val, sizeof(val)))
+	return false;
+      stars[i] = (int)val;
+    }
+    const char *spec = conversion.mySpec.c_str();
+    switch (conversion.myType)
+    {
+    case ARG_DOUBLE:
+      if (!getBytes(args, len, &pos, &doubleVal, sizeof(doubleVal)))
+	return false;
+      appendFormatted(text, spec, conversion.myNumStars, stars, doubleVal);
+      break;
+    case ARG_LONGDOUBLE:
+      if (!getBytes(args, len, &pos, &longDoubleVal, sizeof(longDoubleVal)))
+	return false;
+      appendFormatted(text, spec, conversion.myNumStars, stars,
+		      longDoubleVal);
+      break;
+    case ARG_STRING:
+      if (!getBytes(args, len, &pos, &strLen, sizeof(strLen)) ||
+	  pos + strLen > len)
+	return false;
+      str.assign(args + pos, strLen);
+      pos += strLen;
+      appendFormatted(text, spec, conversion.myNumStars, stars, str.c_str());
+      break;
+    default:
+      if (!getBytes(args, len, &pos, &val, sizeof(val)))
+	return false;
+      if (conversion.myType == ARG_INT)
+	appendFormatted(text, spec, conversion.myNumStars, stars, (int)val);
+      else if (conversion.myType == ARG_LONG)
+	appendFormatted(text, spec, conversion.myNumStars, stars, (long)val);
+      else if (conversion.myType == ARG_LONGLONG)
+	appendFormatted(text, spec, conversion.myNumStars, stars, val);
+      else if (conversion.myType == ARG_SIZE)
+	appendFormatted(text, spec, conversion.myNumStars, stars,
+			(size_t)val);
+      else if (conversion.myType == ARG_INTMAX)
+	appendFormatted(text, spec, conversion.myNumStars, stars,
+			(intmax_t)val);
+      else if (conversion.myType == ARG_PTRDIFF)
+	appendFormatted(text, spec, conversion.myNumStars, stars,
+			(ptrdiff_t)val);
+      else
+	appendFormatted(text, spec, conversion.myNumStars, stars,
+			(void *)(uintptr_t)val);
+      break;
+    }
+  }
+  text->append(myTrailing);
+  return true;
+}
+
+MvrMutex MvrBinaryLog::ourFormatsMutex;
+std::atomic<MvrBinaryLogFormat *> MvrBinaryLog::ourFormats[MvrBinaryLog::MAX_FORMATS];
+std::atomic<int> MvrBinaryLog::ourNumFormats(0);
+FILE *MvrBinaryLog::ourFile = NULL;
+std::string MvrBinaryLog::ourFileName;
+int MvrBinaryLog::ourNumFormatsWritten = 0;
+
+// a record is the time it was logged, the format id, then the arguments
+static const size_t ourRecordHeaderSize = sizeof(long long) + sizeof(int);
+// the start of a binary file, then a number to check the byte order with
+static const char ourFileMagic[8] = { 'M', 'V', 'R', 'B', 'L', 'O', 'G', '1' };
+static const unsigned int ourFileByteOrder = 0x01020304;
+
+/**
+   This is meant to be done once for each message, and the id kept
+   (like in a function static) to log with.
+
+   @param level the level the messages are logged at, like
+   MvrLog::log()'s level
+
+   @param format the printf format for the message
+
+   @return the id to give to log(), or -1 if the format has a
+   conversion that can't be logged this way (%n or wide characters) or
+   too many formats have been registered
+**/
+MVREXPORT int MvrBinaryLog::registerFormat(MvrLog::LogLevel level,
+					   const char *format)
+{
+  MvrBinaryLogFormat *parsed;
+  int id;
+
+  if (format == NULL ||
+      (parsed = MvrBinaryLogFormat::parse(level, format)) == NULL)
+  {
+    MvrLog::log(MvrLog::Terse,
+	       "MvrBinaryLog::registerFormat: Can't log '%s', it has a conversion that isn't supported",
+	       format != NULL ? format : "(null)");
+    return -1;
+  }
+
+  ourFormatsMutex.lock();
+  id = ourNumFormats.load();
+  if (id >= MAX_FORMATS)
+  {
+    ourFormatsMutex.unlock();
+    delete parsed;
+    MvrLog::log(MvrLog::Terse,
+	       "MvrBinaryLog::registerFormat: Too many formats, can't log '%s'",
+	       format);
+    return -1;
+  }
+  ourFormats[id].store(parsed);
+  ourNumFormats.store(id + 1);
+  ourFormatsMutex.unlock();
+  return id;
+}
+
+/**
+   The arguments have to be the types the format's conversions say (no
+   passing an int to %ld), just like with printf.  Nothing is done if
+   formatId isn't a registered format.
+**/
+MVREXPORT void MvrBinaryLog::log(int formatId, ...)
+{
+  va_list ptr;
+  va_start(ptr, formatId);
+  log_v(formatId, ptr);
+  va_end(ptr);
+}
+
+MVREXPORT void MvrBinaryLog::log_v(int formatId, va_list ptr)
+{
+  const MvrBinaryLogFormat *format;
+  char buf[MvrLog::ASYNC_MAX_RECORD];
+  size_t len = 0;
+  long long now;
+
+  if (formatId < 0 || formatId >= ourNumFormats.load() ||
+      (format = ourFormats[formatId].load()) == NULL ||
+      format->myLevel > MvrLog::ourLevel)
+    return;
+
+  now = time(NULL);
+  putBytes(buf, &len, sizeof(buf), &now, sizeof(now));
+  putBytes(buf, &len, sizeof(buf), &formatId, sizeof(formatId));
+  if (!format->capture(buf, &len, sizeof(buf) - 1, ptr))
+    return;
+
+  if (MvrLog::ourAsyncRunning.load() && MvrLog::asyncPush(buf, len, true))
+    return;
+
+  // no writer thread to hand it to, so do it here like MvrLog::log() would
+  MvrLog::ourMutex.lock();
+  writeNoLock(buf, len);
+  flushNoLock();
+  if (MvrLog::ourFP)
+    fflush(MvrLog::ourFP);
+  fflush(stdout);
+  MvrLog::ourMutex.unlock();
+}
+
+MVREXPORT int MvrBinaryLog::getRecordFormatId(const char *buf, size_t len)
+{
+  int id;
+  if (len < ourRecordHeaderSize)
+    return -1;
+  memcpy(&id, buf + sizeof(long long), sizeof(id));
+  return id;
+}
+
+/**
+   @return false if the record was cut short (what could be formatted
+   still is)
+**/
+MVREXPORT bool MvrBinaryLog::renderRecord(const MvrBinaryLogFormat *format,
+					  const char *buf, size_t len,
+					  bool logTime, std::string *text)
+{
+  long long when;
+  time_t whenTime;
+  char timeBuf[64];
+
+  if (len < ourRecordHeaderSize)
+    return false;
+  if (logTime)
+  {
+    memcpy(&when, buf, sizeof(when));
+    whenTime = when;
+#ifndef WIN32
+    ctime_r(&whenTime, timeBuf);
+#else
+    ctime_s(timeBuf, sizeof(timeBuf), &whenTime);
+#endif
+    // the same part of the time MvrLog puts in
+    text->append(timeBuf, 20);
+  }
+  return format->render(buf + ourRecordHeaderSize,
+			len - ourRecordHeaderSize, text);
+}
+
+MVREXPORT void MvrBinaryLog::writeNoLock(const char *buf, size_t len)
+{
+  const MvrBinaryLogFormat *format;
+  int numFormats;
+  int id;
+  char tag;
+  unsigned int recordLen;
+  int level;
+  std::string text;
+
+  if ((id = getRecordFormatId(buf, len)) < 0 || id >= ourNumFormats.load() ||
+      (format = ourFormats[id].load()) == NULL)
+    return;
+
+  if (ourFile != NULL)
+  {
+    // the file gets the formats before the first record that uses them
+    numFormats = ourNumFormats.load();
+    while (ourNumFormatsWritten < numFormats)
+    {
+      const MvrBinaryLogFormat *newFormat =
+	ourFormats[ourNumFormatsWritten].load();
+      tag = 'F';
+      recordLen = sizeof(int) * 2 + newFormat->myFormat.size();
+      level = newFormat->myLevel;
+      fwrite(&tag, 1, 1, ourFile);
+      fwrite(&recordLen, sizeof(recordLen), 1, ourFile);
+      fwrite(&ourNumFormatsWritten, sizeof(int), 1, ourFile);
+      fwrite(&level, sizeof(level), 1, ourFile);
+      fwrite(newFormat->myFormat.c_str(), 1, newFormat->myFormat.size(),
+	     ourFile);
+      ourNumFormatsWritten++;
+    }
+    tag = 'M';
+    recordLen = len;
+    fwrite(&tag, 1, 1, ourFile);
+    fwrite(&recordLen, sizeof(recordLen), 1, ourFile);
+    fwrite(buf, 1, len, ourFile);
+    return;
+  }
+
+  renderRecord(format, buf, len, MvrLog::ourLoggingTime, &text);
+  MvrLog::asyncWriteNoLock(text.c_str(), text.size());
+}
+
+MVREXPORT void MvrBinaryLog::flushNoLock(void)
+{
+  if (ourFile != NULL)
+    fflush(ourFile);
+}
+
+/**
+   Records already logged but not written yet go in the file too, and
+   records logged after close() are formatted into the normal log
+   again.
+
+   @return true if the file could be opened
+**/
+MVREXPORT bool MvrBinaryLog::open(const char *fileName)
+{
+  FILE *file;
+
+  // anything already logged goes wherever it was going to go
+  MvrLog::flush();
+  if ((file = MvrUtil::fopen(fileName, "wb")) == NULL)
+  {
+    MvrLog::log(MvrLog::Terse,
+	       "MvrBinaryLog::open: Could not open file %s for logging",
+	       fileName);
+    return false;
+  }
+  fwrite(ourFileMagic, 1, sizeof(ourFileMagic), file);
+  fwrite(&ourFileByteOrder, sizeof(ourFileByteOrder), 1, file);
+
+  MvrLog::ourMutex.lock();
+  if (ourFile != NULL)
+    fclose(ourFile);
+  ourFile = file;
+  ourFileName = fileName;
+  ourNumFormatsWritten = 0;
+  MvrLog::ourMutex.unlock();
+  MvrLog::log(MvrLog::Normal, "MvrBinaryLog: Logging records to %s",
+	     fileName);
+  return true;
+}
+
+MVREXPORT void MvrBinaryLog::close(void)
+{
+  MvrLog::ourMutex.lock();
+  // get what's been logged so far into the file
+  MvrLog::flush();
+  if (ourFile != NULL)
+  {
+    fclose(ourFile);
+    ourFile = NULL;
+    ourFileName = "";
+  }
+  MvrLog::ourMutex.unlock();
+}
+
+MVREXPORT std::string MvrBinaryLog::getFileName(void)
+{
+  std::string ret;
+  MvrLog::ourMutex.lock();
+  ret = ourFileName;
+  MvrLog::ourMutex.unlock();
+  return ret;
+}
+
+MVREXPORT int MvrBinaryLog::getNumFormats(void)
+{
+  return ourNumFormats.load();
+}
+
+/**
+   Each message is written as a line, just like MvrLog would have
+   written it.
+
+   @param fileName the binary file open() wrote
+   @param out where to write the text
+   @param logTime whether to put the time at the start of each line
+
+   @return true if the whole file was decoded, false if it couldn't be
+   opened, isn't a binary log (or is from a machine with the other byte
+   order), or was cut short or damaged (everything before that is
+   still decoded)
+**/
+MVREXPORT bool MvrBinaryLog::decodeFile(const char *fileName, FILE *out,
+					bool logTime)
+{
+  FILE *file;
+  char magic[sizeof(ourFileMagic)];
+  unsigned int byteOrder;
+  char tag;
+  unsigned int recordLen;
+  std::vector<char> record;
+  std::vector<MvrBinaryLogFormat *> formats;
+  std::vector<MvrBinaryLogFormat *>::iterator it;
+  MvrBinaryLogFormat *format;
+  std::string text;
+  int id;
+  int level;
+  bool ret = true;
+
+  if ((file = MvrUtil::fopen(fileName, "rb")) == NULL)
+  {
+    MvrLog::log(MvrLog::Terse, "MvrBinaryLog::decodeFile: Could not open %s",
+	       fileName);
+    return false;
+  }
+  if (fread(magic, 1, sizeof(magic), file) != sizeof(magic) ||
+      memcmp(magic, ourFileMagic, sizeof(magic)) != 0 ||
+      fread(&byteOrder, sizeof(byteOrder), 1, file) != 1 ||
+      byteOrder != ourFileByteOrder)
+  {
+    MvrLog::log(MvrLog::Terse,
+	       "MvrBinaryLog::decodeFile: %s isn't a binary log from a machine with this byte order",
+	       fileName);
+    fclose(file);
+    return false;
+  }
+
+  while (fread(&tag, 1, 1, file) == 1)
+  {
+    // nothing that was written is anywhere near a megabyte
+    if (fread(&recordLen, sizeof(recordLen), 1, file) != 1 ||
+	recordLen > 1024 * 1024)
+    {
+      ret = false;
+      break;
+    }
+    record.resize(recordLen + 1);
+    if (fread(&record[0], 1, recordLen, file) != recordLen)
+    {
+      ret = false;
+      break;
+    }
+    record[recordLen] = '\0';
+
+    if (tag == 'F')
+    {
+      if (recordLen < sizeof(int) * 2)
+      {
+	ret = false;
+	break;
+      }
+      memcpy(&id, &record[0], sizeof(id));
+      memcpy(&level, &record[sizeof(int)], sizeof(level));
+      if (id < 0 || id >= MAX_FORMATS)
+      {
+	ret = false;
+	break;
+      }
+      if ((size_t)id >= formats.size())
+	formats.resize(id + 1, NULL);
+      delete formats[id];
+      formats[id] = MvrBinaryLogFormat::parse((MvrLog::LogLevel)level,
+					      &record[sizeof(int) * 2]);
+    }
+    else if (tag == 'M')
+    {
+      id = getRecordFormatId(&record[0], recordLen);
+      if (id < 0 || (size_t)id >= formats.size() ||
+	  (format = formats[id]) == NULL)
+      {
+	ret = false;
+	break;
+      }
+      text.clear();
+      if (!renderRecord(format, &record[0], recordLen, logTime, &text))
+	ret = false;
+      fprintf(out, "%s\n", text.c_str());
+    }
+    else
+    {
+      ret = false;
+      break;
+    }
+  }
+
+  for (it = formats.begin(); it != formats.end(); it++)
+    delete (*it);
+  fclose(file);
+  return ret;
+}
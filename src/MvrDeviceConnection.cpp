@@ -72,6 +72,22 @@ MVREXPORT const char * MvrDeviceConnection::getStatusMessage(int messageNumber)
     return NULL;
 }
 
+MVREXPORT int MvrDeviceConnection::readAvailable(const char *data,
+						 unsigned int size,
+						 unsigned int msWait)
+{
+  int ret;
+  int more;
+
+  if (size == 0)
+    return 0;
+  if ((ret = read(data, 1, msWait)) <= 0 || size == 1)
+    return ret;
+  if ((more = read(data + 1, size - 1, 0)) > 0)
+    ret += more;
+  return ret;
+}
+
 MVREXPORT void MvrDeviceConnection::setPortName(const char *portName)
 {
   if (portName != NULL)
@@ -0,0 +1,113 @@
+#include "MvrExport.h"
+#include "mvriaOSDef.h"
+#include "MvrFastMutex.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <sched.h>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+MVREXPORT MvrFastMutex::MvrFastMutex() :
+  myState(UNLOCKED),
+  mySpinCount(getDefaultSpinCount())
+{
+#ifdef MVRIA_NO_FAST_MUTEX
+  pthread_mutex_init(&myMutex, NULL);
+#endif
+}
+
+MVREXPORT MvrFastMutex::MvrFastMutex(const MvrFastMutex &mutex) :
+  myState(UNLOCKED),
+  mySpinCount(mutex.mySpinCount),
+  myLogName(mutex.myLogName)
+{
+#ifdef MVRIA_NO_FAST_MUTEX
+  pthread_mutex_init(&myMutex, NULL);
+#endif
+}
+
+MVREXPORT MvrFastMutex::~MvrFastMutex()
+{
+#ifdef MVRIA_NO_FAST_MUTEX
+  pthread_mutex_destroy(&myMutex);
+#endif
+}
+
+MVREXPORT void MvrFastMutex::setLogNameVar(const char *logName, ...)
+{
+  char arg[2048];
+  va_list ptr;
+  va_start(ptr, logName);
+  vsnprintf(arg, sizeof(arg), logName, ptr);
+  arg[sizeof(arg) - 1] = '\0';
+  va_end(ptr);
+  setLogName(arg);
+}
+
+int MvrFastMutex::getDefaultSpinCount(void)
+{
+  // spinning only helps if the holder can run while we spin
+  static int spinCount = (sysconf(_SC_NPROCESSORS_ONLN) > 1) ? 100 : 0;
+  return spinCount;
+}
+
+static inline void fastMutexWait(std::atomic<int> *state, int val)
+{
+#ifdef __linux__
+  syscall(SYS_futex, reinterpret_cast<int *>(state), FUTEX_WAIT_PRIVATE, 
+	  val, NULL, NULL, 0);
+#else
+  sched_yield();
+#endif
+}
+
+static inline void fastMutexWake(std::atomic<int> *state)
+{
+#ifdef __linux__
+  syscall(SYS_futex, reinterpret_cast<int *>(state), FUTEX_WAKE_PRIVATE, 
+	  1, NULL, NULL, 0);
+#endif
+}
+
+/**
+   This is the mutex from Drepper's "Futexes Are Tricky": the state is
+   LOCKED_WAITERS whenever something might be asleep on it, so unlock()
+   only has to make a system call when that's so.
+
+   @param c the state lock() found the mutex in
+**/
+MVREXPORT int MvrFastMutex::lockSlow(int c)
+{
+  int i;
+
+  for (i = 0; i < mySpinCount; i++)
+  {
+#if defined(__i386__) || defined(__x86_64__)
+    __builtin_ia32_pause();
+#endif
+    c = myState.load(std::memory_order_relaxed);
+    if (c == UNLOCKED && 
+	myState.compare_exchange_weak(c, LOCKED, std::memory_order_acquire,
+				      std::memory_order_relaxed))
+      return 0;
+  }
+  // once anything has had to wait we can't tell if others still are,
+  // so it takes the lock as LOCKED_WAITERS and the unlock wakes someone
+  if (c != LOCKED_WAITERS)
+    c = myState.exchange(LOCKED_WAITERS, std::memory_order_acquire);
+  while (c != UNLOCKED)
+  {
+    fastMutexWait(&myState, LOCKED_WAITERS);
+    c = myState.exchange(LOCKED_WAITERS, std::memory_order_acquire);
+  }
+  return 0;
+}
+
+MVREXPORT void MvrFastMutex::unlockSlow(void)
+{
+  myState.store(UNLOCKED, std::memory_order_release);
+  fastMutexWake(&myState);
+}
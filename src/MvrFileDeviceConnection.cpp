@@ -120,6 +120,13 @@ MVREXPORT bool MvrFileDeviceConnection::isTimeStamping(void)
   return false;
 }
 
+MVREXPORT int MvrFileDeviceConnection::getPollFD(void)
+{
+  if (myStatus != STATUS_OPEN)
+    return -1;
+  return myInFD;
+}
+
 MVREXPORT MvrTime MvrFileDeviceConnection::getTimeRead(int index)
 {
   MvrTime now;
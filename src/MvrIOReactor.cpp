@@ -0,0 +1,343 @@
+#include "MvrExport.h"
+#include "mvriaOSDef.h"
+#include "MvrIOReactor.h"
+#include "MvrDeviceConnection.h"
+#include "MvrLog.h"
+#include <unistd.h>
+#include <errno.h>
+#include <vector>
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#endif
+
+// the epoll data for the wake up descriptor (entries start from 1)
+static const unsigned long long WAKE_ID = 0;
+// how often the connections are checked to see if their descriptors
+// changed without us hearing about it
+static const int CHECK_MS = 500;
+
+MVREXPORT MvrIOReactor::MvrIOReactor(const char *name) :
+  myName(name),
+  myNextID(1),
+  myEpollFD(-1),
+  myWakeFD(-1)
+{
+  myMutex.setLogNameVar("%s::myMutex", name);
+  setThreadName(name);
+#ifdef __linux__
+  struct epoll_event event;
+  if ((myEpollFD = epoll_create1(EPOLL_CLOEXEC)) < 0 ||
+      (myWakeFD = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) < 0)
+  {
+    MvrLog::logErrorFromOS(MvrLog::Terse, 
+			   "%s: Could not create the epoll or wake up descriptor",
+			   getName());
+    return;
+  }
+  event.events = EPOLLIN;
+  event.data.u64 = WAKE_ID;
+  epoll_ctl(myEpollFD, EPOLL_CTL_ADD, myWakeFD, &event);
+#endif
+}
+
+MVREXPORT MvrIOReactor::~MvrIOReactor()
+{
+  std::map<unsigned long long, Entry *>::iterator it;
+
+  stopRunning();
+  if (getJoinable() && isThreadStarted() && !isThreadFinished())
+    join();
+  for (it = myEntries.begin(); it != myEntries.end(); ++it)
+    delete (*it).second;
+  if (myWakeFD >= 0)
+    ::close(myWakeFD);
+  if (myEpollFD >= 0)
+    ::close(myEpollFD);
+}
+
+/**
+   @param conn the connection to wait on
+
+   @param readableCB called (from the reactor thread) when the
+   connection has data to read
+
+   @param timeoutCB if not NULL, called (from the reactor thread) when
+   the connection hasn't had any data for timeoutMS, and then every
+   timeoutMS after that until it does
+
+   @param timeoutMS how long the connection can go without data before
+   timeoutCB is called (0 for never)
+
+   @return true if it was added, false if the reactor couldn't be set
+   up (or isn't supported here)
+**/
+MVREXPORT bool MvrIOReactor::addConnection(MvrDeviceConnection *conn, 
+					   MvrFunctor *readableCB,
+					   MvrFunctor *timeoutCB,
+					   unsigned int timeoutMS)
+{
+  std::map<MvrDeviceConnection *, unsigned long long>::iterator it;
+  unsigned long long id;
+  Entry *entry;
+
+  if (conn == NULL || myEpollFD < 0)
+    return false;
+  myMutex.lock();
+  if ((it = myIDs.find(conn)) != myIDs.end())
+  {
+    id = (*it).second;
+    entry = myEntries[id];
+  }
+  else
+  {
+    id = myNextID++;
+    entry = new Entry;
+    entry->myConn = conn;
+    entry->myFD = -1;
+    entry->myRegistered = false;
+    entry->myHungUp = false;
+    myEntries[id] = entry;
+    myIDs[conn] = id;
+  }
+  entry->myReadableCB = readableCB;
+  entry->myTimeoutCB = timeoutCB;
+  entry->myTimeoutMS = timeoutMS;
+  entry->myDeadline.setToNow();
+  entry->myDeadline.addMSec(timeoutMS);
+  refresh(id);
+  myMutex.unlock();
+  wakeUp();
+  return true;
+}
+
+MVREXPORT bool MvrIOReactor::remConnection(MvrDeviceConnection *conn)
+{
+  std::map<MvrDeviceConnection *, unsigned long long>::iterator it;
+  Entry *entry;
+
+  myMutex.lock();
+  if ((it = myIDs.find(conn)) == myIDs.end())
+  {
+    myMutex.unlock();
+    return false;
+  }
+  entry = myEntries[(*it).second];
+#ifdef __linux__
+  // if the descriptor was already closed this fails, which is fine
+  // since closing it took it out of epoll
+  if (entry->myRegistered)
+    epoll_ctl(myEpollFD, EPOLL_CTL_DEL, entry->myFD, NULL);
+#endif
+  myEntries.erase((*it).second);
+  myIDs.erase(it);
+  delete entry;
+  myMutex.unlock();
+  return true;
+}
+
+MVREXPORT bool MvrIOReactor::hasConnection(MvrDeviceConnection *conn)
+{
+  bool ret;
+  myMutex.lock();
+  ret = (myIDs.find(conn) != myIDs.end());
+  myMutex.unlock();
+  return ret;
+}
+
+MVREXPORT size_t MvrIOReactor::getNumConnections(void)
+{
+  size_t ret;
+  myMutex.lock();
+  ret = myEntries.size();
+  myMutex.unlock();
+  return ret;
+}
+
+MVREXPORT void MvrIOReactor::stopRunning(void)
+{
+  MvrASyncTask::stopRunning();
+  wakeUp();
+}
+
+void MvrIOReactor::wakeUp(void)
+{
+  unsigned long long one = 1;
+  if (myWakeFD >= 0 && ::write(myWakeFD, &one, sizeof(one)) < 0)
+  {
+    // the counter is already set so the thread will wake anyway
+  }
+}
+
+/// Must be called with myMutex locked
+void MvrIOReactor::refresh(unsigned long long id, bool check)
+{
+  std::map<unsigned long long, Entry *>::iterator it;
+  Entry *entry;
+  int fd;
+
+  // the callback may have removed the connection
+  if ((it = myEntries.find(id)) == myEntries.end())
+    return;
+  entry = (*it).second;
+  fd = entry->myConn->getPollFD();
+#ifdef __linux__
+  struct epoll_event event;
+  event.events = EPOLLIN;
+  event.data.u64 = id;
+  if (fd != entry->myFD)
+  {
+    // if the old one was closed this fails, which is fine since
+    // closing it took it out of epoll
+    if (entry->myRegistered)
+      epoll_ctl(myEpollFD, EPOLL_CTL_DEL, entry->myFD, NULL);
+    entry->myFD = fd;
+    entry->myRegistered = false;
+    entry->myHungUp = false;
+  }
+  else if (check)
+  {
+    // try a hung up one again now and then, and make sure epoll still
+    // has this one (it won't if it was closed and this is a new one
+    // that got the same number)
+    entry->myHungUp = false;
+    if (entry->myRegistered && 
+	epoll_ctl(myEpollFD, EPOLL_CTL_MOD, fd, &event) != 0)
+      entry->myRegistered = false;
+  }
+  if (entry->myHungUp)
+  {
+    // stop waiting on it, or epoll would keep telling us about the
+    // hang up
+    if (entry->myRegistered)
+      epoll_ctl(myEpollFD, EPOLL_CTL_DEL, entry->myFD, NULL);
+    entry->myRegistered = false;
+    return;
+  }
+  if (fd >= 0 && !entry->myRegistered)
+  {
+    if (epoll_ctl(myEpollFD, EPOLL_CTL_ADD, fd, &event) == 0)
+      entry->myRegistered = true;
+    else
+      MvrLog::logErrorFromOS(MvrLog::Normal, 
+			     "%s: Could not wait on %s (descriptor %d)",
+			     getName(), entry->myConn->getPortName(), fd);
+  }
+#endif
+}
+
+/// Must be called with myMutex locked
+int MvrIOReactor::getWaitMS(void)
+{
+  std::map<unsigned long long, Entry *>::iterator it;
+  long ms;
+  long ret = -1;
+
+  if (!myEntries.empty())
+  {
+    ret = CHECK_MS - myLastCheck.mSecSince();
+    if (ret < 0)
+      ret = 0;
+  }
+
+  for (it = myEntries.begin(); it != myEntries.end(); ++it)
+  {
+    if ((*it).second->myTimeoutCB == NULL || (*it).second->myTimeoutMS == 0)
+      continue;
+    ms = (*it).second->myDeadline.mSecTo();
+    if (ms < 0)
+      ms = 0;
+    if (ret < 0 || ms < ret)
+      ret = ms;
+  }
+  return (int)ret;
+}
+
+MVREXPORT void *MvrIOReactor::runThread(void *arg)
+{
+#ifdef __linux__
+  const int maxEvents = 32;
+  struct epoll_event events[maxEvents];
+  std::map<unsigned long long, Entry *>::iterator it;
+  std::vector<unsigned long long> timedOut;
+  unsigned long long count;
+  unsigned long long id;
+  Entry *entry;
+  int numEvents;
+  int waitMS;
+  int i;
+
+  threadStarted();
+  while (getRunning() && myEpollFD >= 0)
+  {
+    myMutex.lock();
+    waitMS = getWaitMS();
+    myMutex.unlock();
+
+    numEvents = epoll_wait(myEpollFD, events, maxEvents, waitMS);
+    if (numEvents < 0 && errno != EINTR)
+    {
+      MvrLog::logErrorFromOS(MvrLog::Terse, "%s: epoll_wait failed", 
+			     getName());
+      break;
+    }
+
+    myMutex.lock();
+    for (i = 0; i < numEvents; i++)
+    {
+      id = events[i].data.u64;
+      if (id == WAKE_ID)
+      {
+	if (::read(myWakeFD, &count, sizeof(count)) < 0)
+	{
+	  // nothing to do, it just means someone else read it
+	}
+	continue;
+      }
+      // the connection may have been removed by an earlier callback
+      if ((it = myEntries.find(id)) == myEntries.end())
+	continue;
+      entry = (*it).second;
+      if (events[i].events & (EPOLLHUP | EPOLLERR))
+	entry->myHungUp = true;
+      entry->myDeadline.setToNow();
+      entry->myDeadline.addMSec(entry->myTimeoutMS);
+      if (entry->myReadableCB != NULL)
+	entry->myReadableCB->invoke();
+      refresh(id);
+    }
+
+    // gather these first since the callbacks can change the map
+    timedOut.clear();
+    for (it = myEntries.begin(); it != myEntries.end(); ++it)
+    {
+      entry = (*it).second;
+      if (entry->myTimeoutCB != NULL && entry->myTimeoutMS > 0 &&
+	  entry->myDeadline.mSecTo() <= 0)
+	timedOut.push_back((*it).first);
+    }
+    for (i = 0; i < (int)timedOut.size(); i++)
+    {
+      if ((it = myEntries.find(timedOut[i])) == myEntries.end())
+	continue;
+      entry = (*it).second;
+      entry->myDeadline.setToNow();
+      entry->myDeadline.addMSec(entry->myTimeoutMS);
+      entry->myTimeoutCB->invoke();
+      refresh(timedOut[i]);
+    }
+
+    // see if connections that weren't open are now, or were closed
+    // and opened again without any callbacks to notice
+    if (myLastCheck.mSecSince() >= CHECK_MS)
+    {
+      myLastCheck.setToNow();
+      for (it = myEntries.begin(); it != myEntries.end(); ++it)
+	refresh((*it).first, true);
+    }
+    myMutex.unlock();
+  }
+  threadFinished();
+#endif
+  return NULL;
+}
@@ -46,8 +46,8 @@ MVREXPORT void MvrIrrfDevice::processReadings(void)
   double rx, ry, nx, ny, dx, dy, dist;
   MvrSensorReading *reading;
   std::list<MvrSensorReading *>::iterator rawIt;
-  std::list<MvrPoseWithTime *> *readingList;
-  std::list<MvrPoseWithTime *>::iterator readIt;
+  const MvrRangeBufferStorage *storage;
+  size_t j;
   lockDevice();
 
   rx = myRobot->getX();
@@ -71,40 +71,32 @@ MVREXPORT void MvrIrrfDevice::processReadings(void)
     if (dist < (myCumulativeMaxRange * myCumulativeMaxRange))
     {
       myCumulativeBuffer.beginInvalidationSweep();
-      readingList = myCumulativeBuffer.getBuffer();
+      storage = myCumulativeBuffer.getStorage();
 
-      if (readingList != NULL)
+      for (j = 0; j < storage->size(); j++)
       {
-        for (readIt = readingList->begin(); 
-	     readIt != readingList->end();
-	     readIt++)
-        {
-          dx = (*readIt)->getX() - nx;
-          dy = (*readIt)->getY() - ny;
-          if ((dx*dx + dy*dy) < (myFilterNearDist * myFilterNearDist))
-            myCumulativeBuffer.invalidateReading(readIt);
-        }
+        dx = storage->getX(j) - nx;
+        dy = storage->getY(j) - ny;
+        if ((dx*dx + dy*dy) < (myFilterNearDist * myFilterNearDist))
+          myCumulativeBuffer.invalidateReading(j);
       }
       myCumulativeBuffer.endInvalidationSweep();
       myCumulativeBuffer.addReading(nx, ny);
     }
   }
  
-  readingList = myCumulativeBuffer.getBuffer();
+  storage = myCumulativeBuffer.getStorage();
 
   rx = myRobot->getX();
   ry = myRobot->getY();
 
   myCumulativeBuffer.beginInvalidationSweep();
-  if (readingList != NULL)
+  for (j = 0; j < storage->size(); j++)
   {
-    for (readIt = readingList->begin(); readIt != readingList->end();readIt++)
-    {
-      dx = (*readIt)->getX() - rx;
-      dy = (*readIt)->getY() - ry;
-      if ((dx*dx + dy*dy) > (myFilterFarDist * myFilterFarDist))
-        myCumulativeBuffer.invalidateReading(readIt);
-    }
+    dx = storage->getX(j) - rx;
+    dy = storage->getY(j) - ry;
+    if ((dx*dx + dy*dy) > (myFilterFarDist * myFilterFarDist))
+      myCumulativeBuffer.invalidateReading(j);
   }
   myCumulativeBuffer.endInvalidationSweep();
 
@@ -4,6 +4,7 @@
 #include "MvrSensorReading.h"
 #include "mvriaOSDef.h"
 #include "MvrSerialConnection.h"
+#include "MvrIOReactor.h"
 #include "mvriaInternal.h"
 #include "MvrSystemStatus.h"
 
@@ -36,7 +37,10 @@ MVREXPORT MvrLCDMTX::MvrLCDMTX(int lcdBoardNum, const char *name,
 	myBoardNum(lcdBoardNum),
 	myConnFailOption(false),
 	myFirmwareVersion(""),
-	myMvrExitCB(this, &MvrLCDMTX::disconnect)
+	myMvrExitCB(this, &MvrLCDMTX::disconnect),
+	myIOReactor(NULL),
+	myReactorReadableCB(this, &MvrLCDMTX::reactorReadable),
+	myReactorTimeoutCB(this, &MvrLCDMTX::reactorTimeout)
 {
 
 	myInfoLogLevel = MvrLog::Normal;
@@ -68,6 +72,8 @@ MVREXPORT MvrLCDMTX::MvrLCDMTX(int lcdBoardNum, const char *name,
 
 MVREXPORT MvrLCDMTX::~MvrLCDMTX()
 {
+	if (myIOReactor != NULL)
+		myIOReactor->remConnection(myConn);
 	if (myRobot != NULL) {
 		myRobot->remSensorInterpTask(&myProcessCB);
 	}
@@ -426,7 +432,7 @@ MVREXPORT bool MvrLCDMTX::blockingConnect(bool sendTracking, bool recvTracking,
 
 			myLastReading.setToNow();
 
-			runAsync();
+			startReading();
 			return true;
 		}
 	} while (timeDone.mSecTo() >= 0);
@@ -542,6 +548,13 @@ MVREXPORT void * MvrLCDMTX::runThread(void *arg)
 				"%s::runThread() call to sendKeepAlive failed", getName()));
 		}
 
+		// with a reactor it reads the responses and watches for a lost
+		// connection, this thread just sends
+		if (myIOReactor != NULL && myIOReactor->hasConnection(myConn)) {
+			MvrUtil::sleep(500);
+			continue;
+		}
+
 		while (getRunning() && myIsConnected &&
 			(packet = myReceiver->receivePacket(500)) != NULL) {
 			myPacketsMutex.lock();
@@ -928,6 +941,54 @@ MVREXPORT void MvrLCDMTX::disconnectOnError(void)
 	myDisconnectOnErrorCBList.invoke();
 }
 
+/**
+   With a reactor the reactor reads the lcd's responses and checks for
+   a lost connection when there haven't been any for a while.  The
+   lcd still runs its own thread, but only to send it the status,
+   meters and keep alives.
+**/
+MVREXPORT void MvrLCDMTX::setIOReactor(MvrIOReactor *reactor)
+{
+	myIOReactor = reactor;
+}
+
+void MvrLCDMTX::startReading(void)
+{
+	if (myIOReactor != NULL)
+		myIOReactor->addConnection(myConn, &myReactorReadableCB,
+			&myReactorTimeoutCB, 500);
+	runAsync();
+}
+
+void MvrLCDMTX::reactorReadable(void)
+{
+	MvrRobotPacket *packet;
+
+	// the data is already here, so this doesn't wait (except for the
+	// rest of a packet that's partway in)
+	while (myIsConnected && (packet = myReceiver->receivePacket(0)) != NULL) {
+		myPacketsMutex.lock();
+		myPackets.push_back(packet);
+		myPacketsMutex.unlock();
+		if (myRobot == NULL)
+			sensorInterp();
+	}
+}
+
+void MvrLCDMTX::reactorTimeout(void)
+{
+	if (myIsConnected && checkLostConnection()) {
+		MvrLog::log(MvrLog::Terse,
+			"%s::reactorTimeout()  Lost connection to the MTX lcd because of error.  Nothing received for %g seconds (greater than the timeout of %g).", getName(),
+			myLastReading.mSecSince() / 1000.0,
+			getConnectionTimeoutSeconds());
+		myIsConnected = false;
+		myIOReactor->remConnection(myConn);
+		if (myConnFailOption)
+			disconnectOnError();
+	}
+}
+
 MVREXPORT bool MvrLCDMTX::sendKeepAlive()
 {
 
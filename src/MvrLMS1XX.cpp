@@ -5,6 +5,9 @@
 #include "MvrSerialConnection.h"
 #include "mvriaInternal.h"
 #include <time.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 //#define TRACE
 #if (defined(TRACE))
@@ -17,6 +20,8 @@ MVREXPORT MvrLMS1XXPacket::MvrLMS1XXPacket() :
 MvrBasePacket(10000, 1, NULL, 1)
 {
 	myFirstAdd = true;
+	myBinary = false;
+	myBinaryArgs = false;
 	myCommandType[0] = '\0';
 	myCommandName[0] = '\0';
 }
@@ -39,6 +44,26 @@ MVREXPORT const char *MvrLMS1XXPacket::getCommandName(void)
 
 MVREXPORT void MvrLMS1XXPacket::finalizePacket(void)
 {
+	if (myBinary)
+	{
+		MvrTypes::UByte4 len = myLength - 8;
+		unsigned char checksum = 0;
+		int i;
+
+		myBuf[0] = '\002';
+		myBuf[1] = '\002';
+		myBuf[2] = '\002';
+		myBuf[3] = '\002';
+		myBuf[4] = (len >> 24) & 0xff;
+		myBuf[5] = (len >> 16) & 0xff;
+		myBuf[6] = (len >> 8) & 0xff;
+		myBuf[7] = len & 0xff;
+		for (i = 8; i < myLength; i++)
+			checksum ^= (unsigned char)myBuf[i];
+		rawCharToBuf(checksum);
+		myBuf[myLength] = '\0';
+		return;
+	}
 	myBuf[0] = '\002';
 	rawCharToBuf('\003');
 	myBuf[myLength] = '\0';
@@ -46,6 +71,15 @@ MVREXPORT void MvrLMS1XXPacket::finalizePacket(void)
 
 MVREXPORT void MvrLMS1XXPacket::resetRead(void)
 {
+	if (myBinary)
+	{
+		myReadLength = 8;
+
+		binaryTokenFromBuf(myCommandType, sizeof(myCommandType));
+		binaryTokenFromBuf(myCommandName, sizeof(myCommandName));
+		return;
+	}
+
 	myReadLength = 1;
 
 	myCommandType[0] = '\0';
@@ -71,6 +105,8 @@ MVREXPORT void MvrLMS1XXPacket::duplicatePacket(MvrLMS1XXPacket *packet)
 	myReadLength = packet->getReadLength();
 	myTimeReceived = packet->getTimeReceived();
 	myFirstAdd = packet->myFirstAdd;
+	myBinary = packet->myBinary;
+	myBinaryArgs = packet->myBinaryArgs;
 	strcpy(myCommandType, packet->myCommandType);
 	strcpy(myCommandName, packet->myCommandName);
 	memcpy(myBuf, packet->getBuf(), myLength);
@@ -81,13 +117,62 @@ MVREXPORT void MvrLMS1XXPacket::empty(void)
 	myLength = 0;
 	myReadLength = 0;
 	myFirstAdd = false;
+	myBinaryArgs = false;
 	myCommandType[0] = '\0';
 	myCommandName[0] = '\0';
+	// leave room for the STXs and length, finalizePacket fills them in
+	if (myBinary)
+	{
+		myLength = 8;
+		myFirstAdd = true;
+	}
+}
+
+MVREXPORT void MvrLMS1XXPacket::setBinary(bool binary)
+{
+	myBinary = binary;
+	empty();
+}
+
+/**
+   The arguments of a binary telegram are separated from the command
+   name by one space, then follow each other with no separators.
+**/
+void MvrLMS1XXPacket::binaryArgsToBuf(void)
+{
+	if (!myBinaryArgs && !myFirstAdd)
+		rawCharToBuf(' ');
+	myBinaryArgs = true;
+	myFirstAdd = false;
+}
+
+/**
+   Reads a space delimited token (the command type or name) out of a
+   binary telegram and skips the space after it.
+**/
+void MvrLMS1XXPacket::binaryTokenFromBuf(char *buf, int len)
+{
+	int i;
+
+	for (i = 0; isNextGood(1) && myBuf[myReadLength] != ' '; myReadLength++)
+	{
+		if (i < len - 1)
+			buf[i++] = myBuf[myReadLength];
+	}
+	buf[i] = '\0';
+	if (isNextGood(1))
+		myReadLength++;
 }
 
 
 MVREXPORT void MvrLMS1XXPacket::byteToBuf(MvrTypes::Byte val)
 {
+	if (myBinary)
+	{
+		binaryArgsToBuf();
+		rawCharToBuf(val);
+		return;
+	}
 	char buf[1024];
 	if (val > 0)
 		sprintf(buf, "+%d", val);
@@ -98,6 +183,13 @@ MVREXPORT void MvrLMS1XXPacket::byteToBuf(MvrTypes::Byte val)
 
 MVREXPORT void MvrLMS1XXPacket::byte2ToBuf(MvrTypes::Byte2 val)
 {
+	if (myBinary)
+	{
+		binaryArgsToBuf();
+		rawCharToBuf((val >> 8) & 0xff);
+		rawCharToBuf(val & 0xff);
+		return;
+	}
 	char buf[1024];
 	if (val > 0)
 		sprintf(buf, "+%d", val);
@@ -108,6 +200,11 @@ MVREXPORT void MvrLMS1XXPacket::byte2ToBuf(MvrTypes::Byte2 val)
 
 MVREXPORT void MvrLMS1XXPacket::byte4ToBuf(MvrTypes::Byte4 val)
 {
+	if (myBinary)
+	{
+		uByte4ToBuf(val);
+		return;
+	}
 	char buf[1024];
 	if (val > 0)
 		sprintf(buf, "+%d", val);
@@ -118,11 +215,22 @@ MVREXPORT void MvrLMS1XXPacket::byte4ToBuf(MvrTypes::Byte4 val)
 
 MVREXPORT void MvrLMS1XXPacket::uByteToBuf(MvrTypes::UByte val)
 {
+	if (myBinary)
+	{
+		binaryArgsToBuf();
+		rawCharToBuf(val);
+		return;
+	}
 	char buf[1024];
 	sprintf(buf, "%u", val);
 	strToBuf(buf);
 }
 
+/**
+   This writes the value as two separate bytes, low byte first, which
+   is what the two byte fields the lasers are sent (like the output
+   channel of LMDscandatacfg) want in both ASCII and binary.
+**/
 MVREXPORT void MvrLMS1XXPacket::uByte2ToBuf(MvrTypes::UByte2 val)
 {
 	uByteToBuf(val & 0xff);
@@ -131,6 +239,15 @@ MVREXPORT void MvrLMS1XXPacket::uByte2ToBuf(MvrTypes::UByte2 val)
 
 MVREXPORT void MvrLMS1XXPacket::uByte4ToBuf(MvrTypes::UByte4 val)
 {
+	if (myBinary)
+	{
+		binaryArgsToBuf();
+		rawCharToBuf((val >> 24) & 0xff);
+		rawCharToBuf((val >> 16) & 0xff);
+		rawCharToBuf((val >> 8) & 0xff);
+		rawCharToBuf(val & 0xff);
+		return;
+	}
 	char buf[1024];
 	sprintf(buf, "%u", val);
 	strToBuf(buf);
@@ -164,6 +281,8 @@ MVREXPORT MvrTypes::Byte MvrLMS1XXPacket::bufToByte(void)
 {
 	MvrTypes::Byte ret=0;
 
+	if (myBinary)
+		return bufToUByte();
 
 	if (!isNextGood(1))
 		return 0;
@@ -188,6 +307,9 @@ MVREXPORT MvrTypes::Byte2 MvrLMS1XXPacket::bufToByte2(void)
 {
 	MvrTypes::Byte2 ret=0;
 
+	if (myBinary)
+		return bufToUByte2();
+
 	if (!isNextGood(1))
 		return 0;
 
@@ -213,6 +335,9 @@ MVREXPORT MvrTypes::Byte4 MvrLMS1XXPacket::bufToByte4(void)
 {
 	MvrTypes::Byte4 ret=0;
 
+	if (myBinary)
+		return bufToUByte4();
+
 	if (!isNextGood(1))
 		return 0;
 
@@ -244,6 +369,13 @@ MVREXPORT MvrTypes::UByte MvrLMS1XXPacket::bufToUByte(void)
 	if (!isNextGood(1))
 		return 0;
 
+	if (myBinary)
+	{
+		ret = myBuf[myReadLength];
+		myReadLength += 1;
+		return ret;
+	}
+
 	if (myBuf[myReadLength] == ' ')
 		myReadLength++;
 
@@ -266,6 +398,16 @@ MVREXPORT MvrTypes::UByte2 MvrLMS1XXPacket::bufToUByte2(void)
 
 	MvrTypes::UByte2 ret=0;
 
+	if (myBinary)
+	{
+		if (!isNextGood(2))
+			return 0;
+		ret = ((unsigned char)myBuf[myReadLength] << 8 |
+		       (unsigned char)myBuf[myReadLength+1]);
+		myReadLength += 2;
+		return ret;
+	}
+
 	if (!isNextGood(1))
 		return 0;
 
@@ -294,6 +436,18 @@ MVREXPORT MvrTypes::UByte4 MvrLMS1XXPacket::bufToUByte4(void)
 {
 	MvrTypes::Byte4 ret=0;
 
+	if (myBinary)
+	{
+		if (!isNextGood(4))
+			return 0;
+		ret = ((MvrTypes::UByte4)(unsigned char)myBuf[myReadLength] << 24 |
+		       (MvrTypes::UByte4)(unsigned char)myBuf[myReadLength+1] << 16 |
+		       (MvrTypes::UByte4)(unsigned char)myBuf[myReadLength+2] << 8 |
+		       (MvrTypes::UByte4)(unsigned char)myBuf[myReadLength+3]);
+		myReadLength += 4;
+		return ret;
+	}
+
 	if (!isNextGood(1))
 		return 0;
 
@@ -319,6 +473,8 @@ Copy a string from the packet buffer into the given buffer, stopping when
 the end of the packet buffer is reached, the given length is reached,
 or a NUL character ('\\0') is reached.  If the given length is not large
 enough, then the remainder of the string is flushed from the packet.
+In a binary packet strings are fixed width, so this reads exactly
+@a len - 1 characters (unless a NUL comes first).
 A NUL character ('\\0') is appended to @a buf if there is sufficient room
 after copying the sting from the packet, otherwise no NUL is added (i.e.
 if @a len bytes are copied).
@@ -340,6 +496,18 @@ MVREXPORT void MvrLMS1XXPacket::bufToStr(char *buf, int len)
 	if (!isNextGood(1))
 		return;
 
+	if (myBinary)
+	{
+		for (i = 0; isNextGood(1) && i < (len - 1); i++)
+		{
+			buf[i] = myBuf[myReadLength++];
+			if (buf[i] == '\0')
+				break;
+		}
+		buf[i] = '\0';
+		return;
+	}
+
 	if (myBuf[myReadLength] == ' ')
 		myReadLength++;
 
@@ -379,6 +547,182 @@ MVREXPORT void MvrLMS1XXPacket::bufToStr(char *buf, int len)
 	buf[len - 1] = '\0';
 }
 
+/**
+   This does what calling bufToUByte2() num times would, but in one
+   pass over the buffer instead of building a string and calling
+   strtol for each value, which matters for the distance and
+   reflectance channels of a scan (over a thousand values each, many
+   times a second).  With SSE2 it finds the spaces between the values
+   and turns the hex digits into numbers 16 characters at a time.
+
+   Like bufToUByte2() it skips one space before the first value, and
+   stops at the end of the data or the end of the telegram (ETX),
+   leaving the read position on the delimiter after the last value
+   read.
+
+   In a binary packet the values are already two byte big endian
+   numbers, so they are just swapped into place.
+
+   @param values where to put the values, must have room for num
+
+   @param num how many values to read
+
+   @return how many values were read (less than num if the data ran
+   out first)
+**/
+MVREXPORT int MvrLMS1XXPacket::bufToUByte2Array(MvrTypes::UByte2 *values, 
+						int num)
+{
+	const char *buf = myBuf;
+	int end = myLength - myFooterLength;
+	int at = myReadLength;
+	int numRead = 0;
+	unsigned int value = 0;
+	bool inValue = false;
+	unsigned char c;
+	int nibble;
+
+	if (num <= 0 || at >= end)
+		return 0;
+
+	if (myBinary)
+	{
+		if (num > (end - at) / 2)
+			num = (end - at) / 2;
+		const unsigned char *data = (const unsigned char *)buf + at;
+		for (numRead = 0; numRead < num; numRead++)
+			values[numRead] = (data[numRead * 2] << 8) | data[numRead * 2 + 1];
+		myReadLength = at + num * 2;
+		return numRead;
+	}
+
+	if (buf[at] == ' ')
+		at++;
+
+#ifdef __SSE2__
+	const __m128i space = _mm_set1_epi8(' ');
+	const __m128i etx = _mm_set1_epi8('\003');
+	const __m128i zero = _mm_set1_epi8('0');
+	const __m128i caseBit = _mm_set1_epi8(0x20);
+	const __m128i beforeA = _mm_set1_epi8('a' - 1);
+	const __m128i afterF = _mm_set1_epi8('f' + 1);
+	const __m128i letterOffset = _mm_set1_epi8('a' - 10);
+	unsigned char nibbles[16];
+	int delims;
+	int start;
+	int stop;
+	int j;
+
+	while (at + 16 <= end && numRead < num)
+	{
+		__m128i chars = _mm_loadu_si128((const __m128i *)(buf + at));
+		__m128i isEtx = _mm_cmpeq_epi8(chars, etx);
+		// the end of the telegram, let the scalar code stop on it
+		if (_mm_movemask_epi8(isEtx) != 0)
+			break;
+		delims = _mm_movemask_epi8(_mm_cmpeq_epi8(chars, space));
+		// '0'-'9' are chars - '0', 'a'-'f' and 'A'-'F' are (chars | 0x20) - 'a' + 10
+		__m128i lower = _mm_or_si128(chars, caseBit);
+		__m128i isLetter = _mm_and_si128(_mm_cmpgt_epi8(lower, beforeA),
+						 _mm_cmplt_epi8(lower, afterF));
+		__m128i nibs = _mm_or_si128(
+			_mm_and_si128(isLetter, _mm_sub_epi8(lower, letterOffset)),
+			_mm_andnot_si128(isLetter, _mm_sub_epi8(chars, zero)));
+		_mm_storeu_si128((__m128i *)nibbles, nibs);
+
+		// each set bit in delims ends a value, values can also carry on
+		// from the last 16 characters or into the next 16
+		start = 0;
+		while (delims != 0 && numRead < num)
+		{
+			stop = __builtin_ctz(delims);
+			delims &= delims - 1;
+			for (j = start; j < stop; j++)
+				value = (value << 4) | nibbles[j];
+			values[numRead++] = (MvrTypes::UByte2)value;
+			value = 0;
+			inValue = false;
+			start = stop + 1;
+		}
+		if (numRead >= num)
+		{
+			// leave the read position on the delimiter after the last value
+			myReadLength = at + start - 1;
+			return numRead;
+		}
+		for (j = start; j < 16; j++)
+			value = (value << 4) | nibbles[j];
+		inValue = inValue || start < 16;
+		at += 16;
+	}
+#endif
+
+	// whatever is left (or all of it without SSE2)
+	for (; at < end; at++)
+	{
+		c = buf[at];
+		if (c == '\003')
+		{
+			if (inValue)
+				values[numRead++] = (MvrTypes::UByte2)value;
+			inValue = false;
+			break;
+		}
+		if (c == ' ')
+		{
+			values[numRead++] = (MvrTypes::UByte2)value;
+			value = 0;
+			inValue = false;
+			if (numRead >= num)
+				break;
+			continue;
+		}
+		if (c >= '0' && c <= '9')
+			nibble = c - '0';
+		else if ((c | 0x20) >= 'a' && (c | 0x20) <= 'f')
+			nibble = (c | 0x20) - 'a' + 10;
+		else
+			nibble = 0;
+		value = (value << 4) | nibble;
+		inValue = true;
+	}
+	// a value that runs right up to the end of the data
+	if (inValue && at >= end && numRead < num)
+		values[numRead++] = (MvrTypes::UByte2)value;
+	myReadLength = at;
+	return numRead;
+}
+
+/**
+   This is bufToUByte2Array() for the 8 bit channels of a scan.  In
+   ASCII the values look the same as 16 bit ones so it just calls
+   that, in binary they are one byte each.
+
+   @param values where to put the values, must have room for num
+
+   @param num how many values to read
+
+   @return how many values were read (less than num if the data ran
+   out first)
+**/
+MVREXPORT int MvrLMS1XXPacket::bufToUByteArray(MvrTypes::UByte2 *values, 
+					       int num)
+{
+	int end = myLength - myFooterLength;
+	int numRead;
+
+	if (!myBinary)
+		return bufToUByte2Array(values, num);
+
+	if (num > end - myReadLength)
+		num = end - myReadLength;
+	for (numRead = 0; numRead < num; numRead++)
+		values[numRead] = (unsigned char)myBuf[myReadLength + numRead];
+	if (numRead > 0)
+		myReadLength += numRead;
+	return numRead;
+}
+
 MVREXPORT void MvrLMS1XXPacket::rawCharToBuf(unsigned char c)
 {
 	if (!hasWriteCapacity(1)) {
@@ -404,6 +748,8 @@ int MvrLMS1XXPacket::deascii(char c)
 MVREXPORT MvrLMS1XXPacketReceiver::MvrLMS1XXPacketReceiver()
 {
 	myState = STARTING;
+	myReadCount = 0;
+	myBinary = false;
 }
 
 MVREXPORT MvrLMS1XXPacketReceiver::~MvrLMS1XXPacketReceiver()
@@ -421,6 +767,14 @@ MVREXPORT MvrDeviceConnection *MvrLMS1XXPacketReceiver::getDeviceConnection(void
 	return myConn;
 }
 
+MVREXPORT void MvrLMS1XXPacketReceiver::setBinary(bool binary)
+{
+	myBinary = binary;
+	myPacket.setBinary(binary);
+	myState = STARTING;
+	myReadCount = 0;
+}
+
 
 MvrLMS1XXPacket *MvrLMS1XXPacketReceiver::receivePacket(unsigned int msWait,
 						      bool scandataShortcut,
@@ -437,6 +791,8 @@ MvrLMS1XXPacket *MvrLMS1XXPacketReceiver::receivePacket(unsigned int msWait,
 
 	//if (myLaserModel == MvrLMS1XX::TiM3XX)
 	//	return receiveTiMPacket(msWait, scandataShortcut, ignoreRemainders);
+	if (myBinary)
+		return receiveBinaryPacket(msWait, ignoreRemainders);
 
 	if (myConn == NULL ||
 			myConn->getStatus() != MvrDeviceConnection::STATUS_OPEN)
@@ -883,6 +1239,149 @@ MvrLMS1XXPacket *MvrLMS1XXPacketReceiver::receiveTiMPacket(unsigned int msWait,
 	return NULL;
 }
 
+/**
+   CoLa-B telegrams are four STX bytes, a four byte big endian length
+   of the data, the data, then a checksum byte that is the XOR of the
+   data.  Since STX can show up in the data this frames on the length
+   instead of looking for the end, and the checksum is checked before
+   a packet is handed back, anything in front of the start of a
+   telegram (or a telegram with a bad length or checksum) is thrown
+   away.
+**/
+MVREXPORT MvrLMS1XXPacket *MvrLMS1XXPacketReceiver::receiveBinaryPacket(
+	unsigned int msWait, bool ignoreRemainders)
+{
+	MvrLMS1XXPacket *packet;
+	long timeToRunFor;
+	MvrTime timeDone;
+	int numRead;
+	int i;
+	int j;
+	MvrTypes::UByte4 length;
+	int frameLength;
+	unsigned char checksum;
+
+	if (myConn == NULL ||
+			myConn->getStatus() != MvrDeviceConnection::STATUS_OPEN)
+	{
+		return NULL;
+	}
+
+	timeDone.setToNow();
+	if (!timeDone.addMSec(msWait)) {
+		MvrLog::log(MvrLog::Terse,
+				"%s::receiveBinaryPacket() error adding msecs (%i)",
+				myName,msWait);
+	}
+
+	while (1)
+	{
+		// find the start of a telegram (or what could be the start of
+		// one at the end of what we have)
+		for (i = 0; i < myReadCount; i++)
+		{
+			for (j = 0; j < 4 && i + j < myReadCount &&
+					 myReadBuf[i + j] == '\002'; j++)
+				;
+			if (j == 4 || i + j == myReadCount)
+				break;
+		}
+		if (i > 0)
+		{
+			MvrLog::log(MvrLog::Verbose,
+					"%s::receiveBinaryPacket() Skipping %d bytes looking for the start of a telegram",
+					myName, i);
+			memmove(myReadBuf, &myReadBuf[i], myReadCount - i);
+			myReadCount -= i;
+		}
+
+		if (myReadCount >= 8)
+		{
+			length = ((MvrTypes::UByte4)(unsigned char)myReadBuf[4] << 24 |
+				  (MvrTypes::UByte4)(unsigned char)myReadBuf[5] << 16 |
+				  (MvrTypes::UByte4)(unsigned char)myReadBuf[6] << 8 |
+				  (MvrTypes::UByte4)(unsigned char)myReadBuf[7]);
+			if (length == 0 || length > (MvrTypes::UByte4)myPacket.getMaxLength() - 10)
+			{
+				MvrLog::log(MvrLog::Normal,
+						"%s::receiveBinaryPacket() Bad telegram length %u, looking for the next telegram",
+						myName, length);
+				memmove(myReadBuf, &myReadBuf[1], myReadCount - 1);
+				myReadCount -= 1;
+				continue;
+			}
+
+			frameLength = length + 9;
+			if (myReadCount >= frameLength)
+			{
+				checksum = 0;
+				for (i = 8; i < frameLength - 1; i++)
+					checksum ^= (unsigned char)myReadBuf[i];
+
+				packet = NULL;
+				if (checksum != (unsigned char)myReadBuf[frameLength - 1])
+				{
+					MvrLog::log(MvrLog::Normal,
+							"%s::receiveBinaryPacket() Bad checksum (got 0x%02x, calculated 0x%02x), skipping telegram",
+							myName, (unsigned char)myReadBuf[frameLength - 1], checksum);
+				}
+				else
+				{
+					myPacket.empty();
+					myPacket.setLength(0);
+					myPacket.dataToBuf(myReadBuf, frameLength);
+					myPacket.setTimeReceived(myBinaryReceived);
+					myPacket.resetRead();
+					packet = new MvrLMS1XXPacket;
+					packet->duplicatePacket(&myPacket);
+					myPacket.empty();
+				}
+
+				myReadCount -= frameLength;
+				if (myReadCount > 0 && ignoreRemainders)
+				{
+					MvrLog::log(myInfoLogLevel, "%s::receiveBinaryPacket() Got remainder, %d bytes beyond one packet ... ignoring it",
+							myName, myReadCount);
+					myReadCount = 0;
+				}
+				else if (myReadCount > 0)
+				{
+					memmove(myReadBuf, &myReadBuf[frameLength], myReadCount);
+					myBinaryReceived = myConn->getTimeRead(0);
+				}
+
+				if (packet != NULL)
+					return packet;
+				continue;
+			}
+		}
+
+		timeToRunFor = timeDone.mSecTo();
+		if (timeToRunFor < 0)
+			timeToRunFor = 0;
+
+		numRead = myConn->read(&myReadBuf[myReadCount],
+				sizeof(myReadBuf) - myReadCount, timeToRunFor);
+		if (numRead < 0)
+		{
+			MvrLog::log(MvrLog::Normal,
+					"%s::receiveBinaryPacket() Failed read (%d)",
+					myName,numRead);
+			myReadCount = 0;
+			return NULL;
+		}
+		if (numRead == 0)
+		{
+			if (timeDone.mSecTo() <= 0)
+				return NULL;
+			continue;
+		}
+		if (myReadCount == 0)
+			myBinaryReceived = myConn->getTimeRead(0);
+		myReadCount += numRead;
+	}
+}
+
 
 MVREXPORT MvrLMS1XX::MvrLMS1XX(int laserNumber,
 		const char *name, LaserModel laserModel) :
@@ -898,8 +1397,9 @@ MVREXPORT MvrLMS1XX::MvrLMS1XX(int laserNumber,
   else
     myLaserModelFamily = TiM;
 
+	myBinary = false;
+
 	clear();
-	myRawReadings = new std::list<MvrSensorReading *>;
 
 	Mvria::addExitCallback(&myMvrExitCB, -10);
 
@@ -1045,6 +1545,16 @@ MVREXPORT MvrLMS1XX::MvrLMS1XX(int laserNumber,
   // serial, only used for tim if manually set to tcp.
   laserSetDefaultTcpPort(2111);
 
+  // the LMSs can talk CoLa-B (binary) too, which is a lot less to
+  // send and parse for a scan
+  if (myLaserModelFamily == LMS)
+  {
+    std::list<std::string> protocolChoices;
+    protocolChoices.push_back("ascii");
+    protocolChoices.push_back("binary");
+    laserAllowProtocolChoices("ascii", protocolChoices);
+  }
+
 	// PS = add new field for scan freq
 //	myScanFreq = 5;
 
@@ -1115,13 +1625,6 @@ MVREXPORT MvrLMS1XX::~MvrLMS1XX()
 		myRobot->remLaser(this);
 		myRobot->remSensorInterpTask(&mySensorInterpTask);
 	}
-	if (myRawReadings != NULL)
-	{
-		MvrUtil::deleteSet(myRawReadings->begin(), myRawReadings->end());
-		myRawReadings->clear();
-		delete myRawReadings;
-		myRawReadings = NULL;
-	}
 	lockDevice();
 	if (isConnected())
 		disconnect();
@@ -1133,6 +1636,7 @@ void MvrLMS1XX::clear(void)
 	myIsConnected = false;
 	myTryingToConnect = false;
 	myStartConnect = false;
+	myLoggedSkipped8Bit = false;
 
 	myVersionNumber = 0;
 	myDeviceNumber = 0;
@@ -1153,7 +1657,6 @@ void MvrLMS1XX::clear(void)
 	myNumberEncoders = 0;
 	myNumChans16Bit = 0;
 	myNumChans8Bit = 0;
-	myFirstReadings = true;
 }
 
 MVREXPORT void MvrLMS1XX::laserSetName(const char *name)
@@ -1291,7 +1794,6 @@ void MvrLMS1XX::sensorInterp (void)
 		int dist;
 		int refl;
 		//int onStep;
-		MvrSensorReading *reading;
 		// read the extra stuff
 		myVersionNumber = packet->bufToUByte2(); // first value after LMDscandata
 		myDeviceNumber = packet->bufToUByte2();
@@ -1416,11 +1918,11 @@ void MvrLMS1XX::sensorInterp (void)
 		int eachScalingOffset;
 		double eachStartingAngle;
 		double eachAngularStepWidth;
-		int eachNumberData;
-		std::list<MvrSensorReading *>::iterator it;
+		int eachNumberData = 0;
 		double atDeg; // angle of reading transformed according to sensorPoseTh parameter
     double atDegLocal = 0; // angle of reading local to laser
 		int onReading;
+		int numValues;
 		double start = 0;
     double startLocal = 0;
 		double increment = 0;
@@ -1430,7 +1932,11 @@ void MvrLMS1XX::sensorInterp (void)
 			bool measuringDistance = false;
 			bool measuringReflectance = false;
 			eachChanMeasured[0] = '\0';
-			packet->bufToStr (eachChanMeasured, sizeof (eachChanMeasured));
+			// binary channel names are always 5 characters
+			if (packet->isBinary())
+				packet->bufToStr (eachChanMeasured, 6);
+			else
+				packet->bufToStr (eachChanMeasured, sizeof (eachChanMeasured));
 			if (strcasecmp (eachChanMeasured, "DIST1") == 0)
 				measuringDistance = true;
 			else if (strcasecmp (eachChanMeasured, "RSSI1") == 0)
@@ -1472,14 +1978,13 @@ void MvrLMS1XX::sensorInterp (void)
 			eachStartingAngle, eachAngularStepWidth,
 			eachNumberData);
 			*/
-			// If we don't have any sensor readings created at all, make 'em all
-			if (myRawReadings->size() == 0)
-				for (i = 0; i < eachNumberData; i++)
-					myRawReadings->push_back (new MvrSensorReading);
+			// If we don't have any sensor readings at all, make 'em all
+			if (myRawScan.getNumReadings() == 0)
+				myRawScan.setNumReadings (eachNumberData);
 
-			if (eachNumberData > myRawReadings->size()) {
+			if (eachNumberData > myRawScan.getNumReadings()) {
 				MvrLog::log (MvrLog::Terse, "%s::sensorInterp() Bad data, in theory have %d readings but can only have %d... skipping this packet\n",
-				            getName(), myRawReadings->size(), eachNumberData);
+				            getName(), myRawScan.getNumReadings(), eachNumberData);
 				//printf("%s\n", packet->getBuf());
 				delete packet;
 				unlockDevice();
@@ -1494,6 +1999,7 @@ void MvrLMS1XX::sensorInterp (void)
 
       // first iteration:
 			if (!startedProcessing) {
+				myRawScan.beginScan (pose, encoderPose, transform, counter, time);
         startLocal = -1 * ((eachNumberData - 1) * eachAngularStepWidth) / 2.0;
 				if (getFlipped()) {
 					// original from LMS100, but this seems to have some problems
@@ -1522,27 +2028,27 @@ void MvrLMS1XX::sensorInterp (void)
 			startedProcessing = true;
 			bool ignore;
 
+			// pull the whole channel out at once, anything missing is 0
+			// (like it'd be reading the values one at a time)
+			if ((int)myChannelValues.size() < eachNumberData)
+				myChannelValues.resize (eachNumberData);
+			numValues = packet->bufToUByte2Array (myChannelValues.data(),
+			                                      eachNumberData);
+			for (onReading = numValues; onReading < eachNumberData; onReading++)
+				myChannelValues[onReading] = 0;
+
 			for (atDeg = start,
            atDegLocal = startLocal,
-			     it = myRawReadings->begin(),
 			     onReading = 0;
 			     onReading < eachNumberData;
 			     // MPL trying to fix bug with negative readings
 			     //atDeg += increment,
 			     atDeg = MvrMath::addAngle(atDeg, increment),
            atDegLocal = MvrMath::addAngle(atDegLocal, eachAngularStepWidth),
-			     it++,
 			     onReading++) {
 
 				ignore = false;
 
-        reading = (*it);
-
-				if (myFirstReadings)
-					reading->resetSensorPosition (MvrMath::roundInt (mySensorPose.getX()),
-					                              MvrMath::roundInt (mySensorPose.getY()),
-					                              atDeg);
-
         // was configured to have restricted fov, set ignore flag. (Move to MvrLaser or other shared class?)
         if (    (canSetDegrees()    && (atDegLocal < getStartDegrees()             || atDegLocal > getEndDegrees()))
              || (canChooseDegrees() && (atDegLocal < -getDegreesChoiceDouble()/2.0 || atDegLocal > getDegreesChoiceDouble()/2.0))
@@ -1553,10 +2059,10 @@ void MvrLMS1XX::sensorInterp (void)
         //fprintf(stderr, "onReading=%d (n=%d), atDeg=%f atDegLocal=%f, (canSetDegrees=%d, startDeg=%f, endDeg=%f, increment=%f, eachAngularStepWidth=%f) => ignore=%d\n", onReading, eachNumberData, atDeg, atDegLocal, canSetDegrees(), getStartDegrees(), getEndDegrees(), increment, eachAngularStepWidth, ignore); 
 
         // calculate either obstacle position data or reflectance value data
-        // and update the MvrSensorReading reading with the new data
+        // and update the reading in the scan with the new data
 				if (measuringDistance)  
         {
-					dist = packet->bufToUByte2();
+					dist = myChannelValues[onReading];
 					// this was the original code, that just ignored 0s as a
 					// reading... however sometimes the sensor reports very close
 					// distances for rays it gets no return on... Sick wasn't very
@@ -1598,12 +2104,14 @@ void MvrLMS1XX::sensorInterp (void)
 					  eachChanMeasured, dist);
 					  }
 					*/
-					reading->newData (dist, pose, encoderPose, transform, counter,
-					                  time, ignore, 0); // no reflector yet
+					myRawScan.setReading (onReading, dist,
+					                      MvrMath::roundInt (mySensorPose.getX()),
+					                      MvrMath::roundInt (mySensorPose.getY()),
+					                      atDeg, ignore, 0); // no reflector yet
 				} else if (measuringReflectance) {
-					refl = packet->bufToUByte2();
+					refl = myChannelValues[onReading];
 					if (refl > 254 * 255) {
-						reading->setExtraInt (refl/255);
+						myRawScan.setIntensity (onReading, refl/255);
 						//MvrLog::log (MvrLog::Normal, "%s: refl at %g of %d (raw %d)", getName(), atDeg, refl/255, refl);
 					}
 					// if the bit is dazzled we could set it to be ignored, but
@@ -1620,11 +2128,6 @@ void MvrLMS1XX::sensorInterp (void)
 			*/
 		} // end for 16bit
 
-		// if we processed the readings and they were our first ones set
-		// it so it's not our first ones anymore so that we only do the
-		// sin/cos once
-		if (startedProcessing && myFirstReadings)
-			myFirstReadings = false;
 		// read the 8 bit channels, that's just reflectance for now
 		myNumChans8Bit = packet->bufToUByte2();
 		//myLogLevel,
@@ -1633,7 +2136,10 @@ void MvrLMS1XX::sensorInterp (void)
 
 		for (i = 0; i < myNumChans8Bit; i++) {
 			eachChanMeasured8Bit[0] = '\0';
-			packet->bufToStr (eachChanMeasured8Bit, sizeof (eachChanMeasured));
+			if (packet->isBinary())
+				packet->bufToStr (eachChanMeasured8Bit, 6);
+			else
+				packet->bufToStr (eachChanMeasured8Bit, sizeof (eachChanMeasured));
 			/*
 			// for LMS5XX Scaling Factor is a real number
 			if (myIsLMS5XX)
@@ -1668,21 +2174,37 @@ void MvrLMS1XX::sensorInterp (void)
 				}
 			}
 
+			// the number of readings comes from the 16 bit channels, so
+			// if there weren't any there's nothing to put this with
+			if (eachNumberData <= 0) {
+				if (!myLoggedSkipped8Bit) {
+					MvrLog::log (MvrLog::Normal, "%s: Got 8bit %s with no 16bit data, skipping it (won't log this again this connection)", 
+					            getName(), eachChanMeasured8Bit);
+					myLoggedSkipped8Bit = true;
+				}
+				continue;
+			}
+
 			if (printing)
 				MvrLog::log (MvrLog::Normal, "%s: Processing 8bit %s", getName(),
 				            eachChanMeasured8Bit);
 
+			if ((int)myChannelValues.size() < eachNumberData)
+				myChannelValues.resize (eachNumberData);
+			numValues = packet->bufToUByteArray (myChannelValues.data(),
+			                                     eachNumberData);
+			for (onReading = numValues; onReading < eachNumberData; onReading++)
+				myChannelValues[onReading] = 0;
+
 			for (atDeg = start,
-			     it = myRawReadings->begin(),
 			     onReading = 0;
-			     onReading < eachNumberData;
+			     onReading < eachNumberData && 
+			       onReading < myRawScan.getNumReadings();
 			     atDeg += increment,
-			     it++,
 			     onReading++) {
-				reading = (*it);
-				refl = packet->bufToUByte();
+				refl = (MvrTypes::UByte)myChannelValues[onReading];
 				if (refl == 254) {
-					reading->setExtraInt (32);
+					myRawScan.setIntensity (onReading, 32);
 					// MvrLog::log(MvrLog::Normal, "%s: refl at %g of %d", getName(), atDeg, refl);
 				}
 				// if the bit is dazzled we could set it to be ignored, but
@@ -1720,6 +2242,8 @@ void MvrLMS1XX::sensorInterp (void)
 				}
 			}
 		}
+		if (startedProcessing)
+			myRawScan.endScan();
 		myDataMutex.unlock();
 		//MvrTime test;
 		laserProcessReadings();
@@ -1887,11 +2411,18 @@ MVREXPORT bool MvrLMS1XX::blockingConnect(void)
 
 	lockDevice();
 	myTryingToConnect = true;
+	myLoggedSkipped8Bit = false;
 	unlockDevice();
 
 	laserPullUnsetParamsFromRobot();
 	laserCheckParams();
 
+	myBinary = (canChooseProtocol() &&
+		    strcasecmp(getProtocolChoice(), "binary") == 0);
+	myReceiver.setBinary(myBinary);
+	if (myBinary)
+		MvrLog::log(MvrLog::Normal, "%s: Using binary (CoLa-B) protocol.", getName());
+
 	int size = (270 / .25 + 1);
 	MvrLog::log(myInfoLogLevel, "%s::blockingConnect() Setting current buffer size to %d",
 			getName(), size);
@@ -1953,6 +2484,7 @@ MVREXPORT bool MvrLMS1XX::lms5xxConnect(void)
 		MvrLMS1XXPacket *packet;
 
 		MvrLMS1XXPacket sendPacket;
+		sendPacket.setBinary(myBinary);
 
 
 		// 1. Log in
@@ -1960,7 +2492,10 @@ MVREXPORT bool MvrLMS1XX::lms5xxConnect(void)
 		sendPacket.strToBuf("sMN");
 		sendPacket.strToBuf("SetAccessMode");
 		sendPacket.uByteToBuf(0x3); // level
-		sendPacket.strToBuf("F4724744"); // hashed password
+		if (myBinary)
+			sendPacket.uByte4ToBuf(0xF4724744); // hashed password
+		else
+			sendPacket.strToBuf("F4724744"); // hashed password
     sendPacket.finalizePacket();
 
     MvrLog::log(myLogLevel, "%s::lms5xxConnect() sending SetAccessMode: %s", getName(),
@@ -2093,7 +2628,7 @@ MVREXPORT bool MvrLMS1XX::lms5xxConnect(void)
 		sendPacket.byteToBuf(Tm->tm_hour);
 		sendPacket.byteToBuf(Tm->tm_min);
 		sendPacket.byteToBuf(Tm->tm_sec);
-		sendPacket.byteToBuf(0x0);
+		sendPacket.byte4ToBuf(0x0); // microseconds
 
 		sendPacket.finalizePacket();
 
@@ -2142,11 +2677,11 @@ MVREXPORT bool MvrLMS1XX::lms5xxConnect(void)
 
 		// PS 9/1/11 - based on increment choice set which scan
 		if (strcmp(getIncrementChoice(),"quarter") == 0)
-			sendPacket.byteToBuf(2); // which scan
+			sendPacket.byte2ToBuf(2); // which scan
 		else if (strcmp(getIncrementChoice(),"half") == 0)
-			sendPacket.byteToBuf(4); // which scan
+			sendPacket.byte2ToBuf(4); // which scan
 		else
-			sendPacket.byteToBuf(8); // which scan
+			sendPacket.byte2ToBuf(8); // which scan
 
 
    		//sendPacket.byteToBuf(myScanFreq); // which scan
@@ -2337,7 +2872,8 @@ MVREXPORT bool MvrLMS1XX::lms5xxConnect(void)
 			if ((packet = sendAndRecv(timeDone, &sendPacket, "STlms")) != NULL)
 			{
 				int val;
-				val = packet->bufToUByte();
+				// the status is two bytes in binary
+				val = packet->bufToUByte2();
 				delete packet;
 				packet = NULL;
 				if (val == 7)
@@ -2515,12 +3051,16 @@ MVREXPORT bool MvrLMS1XX::lms1xxConnect(void)
 		MvrLMS1XXPacket *packet;
 
 		MvrLMS1XXPacket sendPacket;
+		sendPacket.setBinary(myBinary);
 
 		sendPacket.empty();
 		sendPacket.strToBuf("sMN");
 		sendPacket.strToBuf("SetAccessMode");
 		sendPacket.uByteToBuf(0x3); // level
-		sendPacket.strToBuf("F4724744"); // hashed password
+		if (myBinary)
+			sendPacket.uByte4ToBuf(0xF4724744); // hashed password
+		else
+			sendPacket.strToBuf("F4724744"); // hashed password
 		sendPacket.finalizePacket();
 
 		if ((packet = sendAndRecv(timeDone, &sendPacket, "SetAccessMode")) != NULL)
@@ -2629,7 +3169,7 @@ MVREXPORT bool MvrLMS1XX::lms1xxConnect(void)
 		sendPacket.uByteToBuf(0x0); // time
 		//sendPacket.byteToBuf(5); // every 5th scan only???
 		//sendPacket.byteToBuf(1); // which scan ?
-    sendPacket.uByteToBuf(1); // send all scans
+    sendPacket.byte2ToBuf(1); // send all scans
 		sendPacket.finalizePacket();
 
 		MvrLog::log(myLogLevel, "%s::lms1xxConnect() scandatacfg: %s", getName(), sendPacket.getBuf());
@@ -54,10 +54,6 @@ MVREXPORT MvrLMS2xx::MvrLMS2xx(
   laserAllowAutoBaudChoices("38400", baudChoices);
 
 
-  myAssembleReadings = new std::list<MvrSensorReading *>;
-  myCurrentReadings = new std::list<MvrSensorReading *>;
-  myRawReadings = myCurrentReadings;
-  myIter = myAssembleReadings->begin();
   myConn = NULL;
   myRobot = NULL;
   myStartConnect = false;
@@ -164,9 +160,9 @@ MVREXPORT bool MvrLMS2xx::simPacketHandler(MvrRobotPacket *packet)
   unsigned int readingNumber;
   double atDeg;
   unsigned int i;
-  MvrSensorReading *reading;
-  std::list<MvrSensorReading *>::iterator tempIt;
+  unsigned int onReading;
   unsigned int newReadings;
+  int timeOffset;
   int range;
   int refl = 0;
   MvrPose encoderPose;
@@ -209,57 +205,29 @@ MVREXPORT bool MvrLMS2xx::simPacketHandler(MvrRobotPacket *packet)
     mySimPacketCounter = myRobot->getCounter();
   }
   //printf("MvrLMS2xx::simPacketHandler: On reading number %d out of %d, new %d\n", readingNumber, totalNumReadings, newReadings);
-  // if we have too many readings in our list of raw readings, pop the extras
-  while (myAssembleReadings->size() > totalNumReadings)
-  {
-    MvrLog::log(MvrLog::Verbose, "MvrLMS2xx::simPacketHandler, too many readings, popping one.");
-    tempIt = myAssembleReadings->begin();
-    if (tempIt != myAssembleReadings->end())
-      delete (*tempIt);
-    myAssembleReadings->pop_front();
-  }
-  
-  // If we don't have any sensor readings created at all, make 'em all now
-  if (myAssembleReadings->size() == 0)
-    for (i = 0; i < totalNumReadings; i++)
-      myAssembleReadings->push_back(new MvrSensorReading);
-  
-  // Okay, we know where we're at, so get an iterator to the right spot, or 
-  // make sure the one we keep around is in the right spot... if neither of
-  // these trigger, then the iter should be in the right spot
-  if ((readingNumber != myWhichReading + 1) || 
-      totalNumReadings != myTotalNumReadings)
-  {
-    //printf("2\n");
-    myWhichReading = readingNumber;
-    myTotalNumReadings = totalNumReadings;
-    for (i = 0, myIter = myAssembleReadings->begin(); i < readingNumber; i++)
-    {
-      tempIt = myIter;
-      tempIt++;
-      if (tempIt == myAssembleReadings->end() && (i + 1 != myTotalNumReadings))
-	myAssembleReadings->push_back(new MvrSensorReading);
-      myIter++;
-    }
-  }
-  else
-  {
-    //printf("3\n");
-    myWhichReading = readingNumber;
-  }
+  // make sure the scan we're assembling is the right size
+  if (myAssembleScan.getNumReadings() != (int)totalNumReadings)
+    myAssembleScan.setNumReadings(totalNumReadings);
+
+  encoderPose = mySimPacketEncoderTrans.doInvTransform(mySimPacketStart);
+  if (readingNumber == 0)
+    myAssembleScan.beginScan(mySimPacketStart, encoderPose, 
+			     mySimPacketTrans, mySimPacketCounter, 
+			     packet->getTimeReceived());
+  // the readings in this packet came in this long after the first ones
+  timeOffset = packet->getTimeReceived().mSecSince(
+	  myAssembleScan.getTimeTaken());
 
   atDeg = (mySensorPose.getTh() - myOffsetAmount + 
 	   readingNumber * myIncrementAmount);
   //printf("4\n");
-  encoderPose = mySimPacketEncoderTrans.doInvTransform(mySimPacketStart);
   // while we have in the readings and have stuff left we can read 
-  for (i = 0; 
+  for (i = 0, onReading = readingNumber; 
        //	 (myWhichReading < myTotalNumReadings && 
        //	  packet->getReadLength() < packet->getLength() - 4);
        i < newReadings;
-       i++, myWhichReading++, atDeg += myIncrementAmount)
+       i++, onReading++, atDeg += myIncrementAmount)
   {
-    reading = (*myIter);
     range = packet->bufToUByte2();
     if(isExtendedPacket)
     {
@@ -288,36 +256,26 @@ MVREXPORT bool MvrLMS2xx::simPacketHandler(MvrRobotPacket *packet)
     if (myMaxRange != 0 && range > (int)myMaxRange)
       ignore = true;
     */
-    reading->resetSensorPosition(MvrMath::roundInt(mySensorPose.getX()),
-				 MvrMath::roundInt(mySensorPose.getY()),
-				 atDeg);
+    // the simulator shouldn't send more than it said it would, but
+    // don't write past the end if it does
+    if (onReading >= totalNumReadings)
+      continue;
     //      printf("dist %d\n", dist);
-    reading->newData(range, mySimPacketStart, 
-		     encoderPose,
-		     mySimPacketTrans,
-		     mySimPacketCounter, packet->getTimeReceived(), ignore, refl);
+    myAssembleScan.setReading(onReading, range, 
+			      MvrMath::roundInt(mySensorPose.getX()),
+			      MvrMath::roundInt(mySensorPose.getY()),
+			      atDeg, ignore, refl);
+    myAssembleScan.setTimeOffset(onReading, timeOffset);
     //printf("%d ", range);
-
-    //addReading(reading->getX(), reading->getY());
-    tempIt = myIter;
-    tempIt++;
-    if (tempIt == myAssembleReadings->end() && 
-	myWhichReading + 1 != myTotalNumReadings)
-    {
-      myAssembleReadings->push_back(new MvrSensorReading);
-    }
-    myIter++;
   }
   
   // check if the sensor set is complete
   //printf("%d %d %d\n", newReadings, readingNumber, totalNumReadings);
   if (newReadings + readingNumber >= totalNumReadings)
   {
-    // set MvrRangeDevice buffer
-    myRawReadings = myAssembleReadings;
-    // switch internal buffers
-    myAssembleReadings = myCurrentReadings;
-    myCurrentReadings = myRawReadings;
+    // switch the assembled scan in as the MvrRangeDevice raw scan
+    myRawScan.swapScan(&myAssembleScan);
+    myRawScan.endScan();
     // We have in all the readings, now sort 'em and update the current ones
     //filterReadings();
     laserProcessReadings();
@@ -1288,12 +1246,9 @@ MVREXPORT void MvrLMS2xx::processPacket(MvrLMS2xxPacket *packet, MvrPose pose,
   unsigned int value;
   unsigned int reflector = 0;
   unsigned int numReadings;
-  unsigned int i;
   double atDeg;
   unsigned int onReading;
-  MvrSensorReading *reading;
   int dist;
-  std::list<MvrSensorReading *>::iterator tempIt;
   int multiplier;
   MvrTransform transform;
   //std::list<double>::iterator ignoreIt;  
@@ -1336,32 +1291,19 @@ MVREXPORT void MvrLMS2xx::processPacket(MvrLMS2xxPacket *packet, MvrPose pose,
     /*printf("Reading number %d, complete %d, unit: %d %d:\n", numReadings,
       !(bool)(value & MvrUtil::BIT13), (bool)(value & MvrUtil::BIT14),
       (bool)(value & MvrUtil::BIT15));*/
-    while (myAssembleReadings->size() > numReadings)
-    {
-      MvrLog::log(MvrLog::Verbose, "%s::processPacket, too many readings, popping one.",
-		 getName());
-      tempIt = myAssembleReadings->begin();
-      if (tempIt != myAssembleReadings->end())
-	delete (*tempIt);
-      myAssembleReadings->pop_front();
-    }
-    
-    // If we don't have any sensor readings created at all, make 'em all 
-    if (myAssembleReadings->size() == 0)
-      for (i = 0; i < numReadings; i++)
-	myAssembleReadings->push_back(new MvrSensorReading);
+    // make sure the scan is the right size
+    if (myRawScan.getNumReadings() != (int)numReadings)
+      myRawScan.setNumReadings(numReadings);
 
     transform.setTransform(pose);
+    myRawScan.beginScan(pose, encoderPose, transform, counter, arTime);
     //deinterlaceDelta = transform.doInvTransform(deinterlacePose);
     // printf("usePose2 %d, th1 %.0f th2 %.0f\n",  usePose2, pose.getTh(), pose2.getTh());
-    for (atDeg = mySensorPose.getTh() - myOffsetAmount, onReading = 0,
-	 myIter = myAssembleReadings->begin();
+    for (atDeg = mySensorPose.getTh() - myOffsetAmount, onReading = 0;
 	 (onReading < numReadings && 
 	  packet->getReadLength() < packet->getLength() - 4);
-	 myWhichReading++, atDeg += myIncrementAmount, myIter++, onReading++)
+	 myWhichReading++, atDeg += myIncrementAmount, onReading++)
     {
-      reading = (*myIter);
-      //reading->resetSensorPosition(0, 0, 0);
 
       //value = packet->bufToUByte2() & 0x1fff;
       //dist = (value & 0x1fff) * multiplier ;
@@ -1413,39 +1355,24 @@ MVREXPORT void MvrLMS2xx::processPacket(MvrLMS2xxPacket *packet, MvrPose pose,
       */
       if (deinterlace && (onReading % 2) == 0)
       {
-	reading->resetSensorPosition(
+	myRawScan.setReading(onReading, dist,
 	       MvrMath::roundInt(mySensorPose.getX() + deinterlaceDelta.getX()),
 	       MvrMath::roundInt(mySensorPose.getY() + deinterlaceDelta.getY()),
-	       MvrMath::addAngle(atDeg, deinterlaceDelta.getTh()));
-	reading->newData(dist, pose, encoderPose, transform, counter, 
-			 deinterlaceTime, ignore, reflector);
+	       MvrMath::addAngle(atDeg, deinterlaceDelta.getTh()),
+			     ignore, reflector);
+	// these were taken at deinterlaceTime
+	myRawScan.setTimeOffset(onReading, 
+				deinterlaceTime.mSecSince(arTime));
       }
       else
       {
-	reading->resetSensorPosition(MvrMath::roundInt(mySensorPose.getX()),
-				     MvrMath::roundInt(mySensorPose.getY()),
-				     atDeg); 
-	reading->newData(dist, pose, encoderPose, transform, counter, 
-			 arTime, ignore, reflector);
-      }
-      /*
-      reading->newData(onReading, 0, 0, 0,
-		       MvrTransform(), counter, 
-		       packet->getTimeReceived());
-      */
-      tempIt = myIter;
-      tempIt++;
-      if (tempIt == myAssembleReadings->end() && 
-	  onReading + 1 != numReadings)
-      {
-	myAssembleReadings->push_back(new MvrSensorReading);
+	myRawScan.setReading(onReading, dist,
+			     MvrMath::roundInt(mySensorPose.getX()),
+			     MvrMath::roundInt(mySensorPose.getY()),
+			     atDeg, ignore, reflector);
       }
     }
-    // set MvrRangeDevice buffer, switch internal buffers
-    myRawReadings = myAssembleReadings;
-    //printf("Readings? 0x%x\n", myRawReadings);
-    myAssembleReadings = myCurrentReadings;
-    myCurrentReadings = myRawReadings;
+    myRawScan.endScan();
     //printf("\n");
     myLastReading.setToNow();
     //filterReadings();
@@ -37,6 +37,9 @@ MVREXPORT MvrLaser::MvrLaser(
   myAbsoluteMaxRange = absoluteMaxRange;
   myMaxRangeSet = false;
 
+  myCumulativeGridGood = false;
+  myCumulativeGridChangeCount = 0;
+
   setSensorPosition(0, 0, 0, 0);
   myTimeoutSeconds = 8;
 
@@ -78,6 +81,8 @@ MVREXPORT MvrLaser::MvrLaser(
   myCanChooseStartingBaud = false;
 
   myCanChooseAutoBaud = false;
+
+  myCanChooseProtocol = false;
   
   myDefaultTcpPort = 8102;
 
@@ -161,12 +166,17 @@ MVREXPORT void MvrLaser::laserSetAbsoluteMaxRange(unsigned int absoluteMaxRange)
 
 void MvrLaser::laserProcessReadings(void)
 {
+  int numReadings = myRawScan.getNumReadings();
   // if we have no readings... don't do anything
-  if (myRawReadings == NULL || myRawReadings->begin() == myRawReadings->end())
+  if (numReadings == 0)
     return;
 
-  std::list<MvrSensorReading *>::iterator sensIt;
-  MvrSensorReading *sReading;
+  const unsigned int *ranges = myRawScan.getRanges();
+  const unsigned char *ignores = myRawScan.getIgnores();
+  const double *ths = myRawScan.getThs();
+  const double *xs = myRawScan.getXs();
+  const double *ys = myRawScan.getYs();
+  int i;
   double x, y;
   double lastX = 0.0, lastY = 0.0;
   //unsigned int i = 0;
@@ -186,53 +196,48 @@ void MvrLaser::laserProcessReadings(void)
     clean = false;
   }
   
-  myCurrentBuffer.setPoseTaken(myRawReadings->front()->getPoseTaken());
-  myCurrentBuffer.setEncoderPoseTaken(
-	  myRawReadings->front()->getEncoderPoseTaken());
+  myCurrentBuffer.setPoseTaken(myRawScan.getPoseTaken());
+  myCurrentBuffer.setEncoderPoseTaken(myRawScan.getEncoderPoseTaken());
   myCurrentBuffer.beginRedoBuffer();	  
 
+  // one sweep for the whole scan, the readings that get cleaned come
+  // out of the cumulative grid right away so later readings in this
+  // scan don't see them
+  if (clean)
+    myCumulativeBuffer.beginInvalidationSweep();
+
   // walk the buffer of all the readings and see if we want to add them
-  for (sensIt = myRawReadings->begin(); 
-       sensIt != myRawReadings->end(); 
-       ++sensIt)
+  for (i = 0; i < numReadings; i++)
   {
-    sReading = (*sensIt);
-
     // if we have ignore readings then check them here
     if (!myIgnoreReadings.empty() && 
-	(myIgnoreReadings.find(
-		(int) ceil(sReading->getSensorTh())) != 
+	(myIgnoreReadings.find((int) ceil(ths[i])) != 
 	 myIgnoreReadings.end()) || 
-	myIgnoreReadings.find(
-		(int) floor(sReading->getSensorTh())) != 
+	myIgnoreReadings.find((int) floor(ths[i])) != 
 	myIgnoreReadings.end())
-      sReading->setIgnoreThisReading(true);
+      myRawScan.setIgnore(i, true);
 
     // see if the reading is valid
-    if (sReading->getIgnoreThisReading())
+    if (ignores[i])
       continue;
 
     // if we have a max range then check it here... 
-    if (myMaxRange != 0 && 
-	sReading->getRange() > myMaxRange)
-    {
-      sReading->setIgnoreThisReading(true);
-    }
+    if (myMaxRange != 0 && ranges[i] > myMaxRange)
+      myRawScan.setIgnore(i, true);
+
+    // get our coords
+    x = xs[i];
+    y = ys[i];
 
     // see if the reading is valid... this is set up this way so that
     // max range readings can cancel out other readings, but will
     // still be ignored other than that... ones ignored for other
     // reasons were skipped above
-    if (sReading->getIgnoreThisReading())
+    if (ignores[i])
     {
-      internalProcessReading(sReading->getX(), sReading->getY(), 
-			     sReading->getRange(), clean, true);
+      internalProcessReading(x, y, ranges[i], clean, true);
       continue;
     }
-
-    // get our coords
-    x = sReading->getX();
-    y = sReading->getY();
     
     // see if we're checking on the filter near dist... if we are
     // and the reading is a good one we'll check the cumulative
@@ -249,7 +254,7 @@ void MvrLaser::laserProcessReadings(void)
 	lastY = y;
 	// since it was a good reading, see if we should toss it in
 	// the cumulative buffer... 
-	internalProcessReading(x, y, sReading->getRange(), clean, false);
+	internalProcessReading(x, y, ranges[i], clean, false);
 	
 	/* we don't do this part anymore since it wound up leaving
 	// too many things not really tehre... if its outside of our
@@ -267,13 +272,15 @@ void MvrLaser::laserProcessReadings(void)
     // cumulative buffer anyways
     else
     {
-      internalProcessReading(x, y, sReading->getRange(), clean, false);
+      internalProcessReading(x, y, ranges[i], clean, false);
     }
     // now drop the reading into the current buffer
     myCurrentBuffer.redoReading(x, y);
     //i++;
   }
   myCurrentBuffer.endRedoBuffer();
+  if (clean)
+    myCumulativeBuffer.endInvalidationSweep();
   /*  Put this in to see how long the cumulative filtering is taking  
   if (clean)
     printf("### %ld %d\n", len.mSecSince(), myCumulativeBuffer.getBuffer()->size());
@@ -294,7 +301,10 @@ void MvrLaser::internalProcessReading(double x, double y,
     clean = false;
 
 
-  std::list<MvrPoseWithTime *>::iterator cit;
+  const MvrRangeBufferStorage *storage = myCumulativeBuffer.getStorage();
+  std::vector<size_t>::iterator slotIt;
+  size_t slot;
+  MvrPose cumReading;
   bool addReading = true;
 
   //double squaredDist;
@@ -324,52 +334,125 @@ void MvrLaser::internalProcessReading(double x, double y,
   if (!clean && !addReading)
     return;
   // until here
-  
-  // if we're cleaning we start our sweep
-  if (clean)
-    myCumulativeBuffer.beginInvalidationSweep();
-  // run through all the readings
-  for (cit = getCumulativeBuffer()->begin(); 
-       cit != getCumulativeBuffer()->end(); 
-       ++cit)
+
+  internalUpdateCumulativeGrid();
+
+  // see if its closer to a reading than the filter near dist, only
+  // the cells around the reading can have readings that close
+  if (addReading)
   {
-    // if its closer to a reading than the filter near dist, just return
-    if (addReading && myMinDistBetweenCumulativeSquared < .0000001 ||
-	(MvrMath::squaredDistanceBetween(x, y, (*cit)->getX(), (*cit)->getY()) <
-	 myMinDistBetweenCumulativeSquared))
+    bool tooClose = false;
+    if (myMinDistBetweenCumulativeSquared < .0000001)
+    {
+      tooClose = !storage->empty();
+    }
+    else
+    {
+      myCumulativeGrid.getSlotsNearPoint(x, y, myMinDistBetweenCumulative,
+					 &myCumulativeGridSlots);
+      for (slotIt = myCumulativeGridSlots.begin(); 
+	   slotIt != myCumulativeGridSlots.end(); 
+	   ++slotIt)
+      {
+	if (MvrMath::squaredDistanceBetween(x, y, storage->getSlotX(*slotIt),
+					   storage->getSlotY(*slotIt)) <
+	    myMinDistBetweenCumulativeSquared)
+	{
+	  tooClose = true;
+	  break;
+	}
+      }
+    }
+    // if we're not cleaning it and its too close just return,
+    // otherwise keep going (to clear out invalid readings)
+    if (tooClose)
     {
-      // if we're not cleaning it and its too close just return,
-      // otherwise keep going (to clear out invalid readings)
       if (!clean)
 	return;
       addReading = false;
     }
-    // see if this reading invalidates some other readings by coming too close
-    if (clean)
+  }
+
+  // see if this reading invalidates some other readings by coming
+  // too close to the line from the laser to it, only the cells along
+  // the beam can have readings that close
+  if (clean)
+  {
+    // set up our line
+    line.newEndPoints(x, y, xTaken, yTaken);
+    myCumulativeGrid.getSlotsNearSegment(x, y, xTaken, yTaken, 
+					 myCumulativeCleanDist,
+					 &myCumulativeGridSlots);
+    for (slotIt = myCumulativeGridSlots.begin(); 
+	 slotIt != myCumulativeGridSlots.end(); 
+	 ++slotIt)
     {
-      // set up our line
-      line.newEndPoints(x, y, xTaken, yTaken);
+      slot = (*slotIt);
+      cumReading.setPose(storage->getSlotX(slot), storage->getSlotY(slot));
       // see if the cumulative buffer reading perpindicular intersects
       // this line segment, and then see if its too close if it does,
       // but if the intersection is very near the endpoint then leave it
-      if (line.getPerpPoint((*cit), &intersection) &&
-	  (intersection.squaredFindDistanceTo(*(*cit)) < 
+      if (line.getPerpPoint(cumReading, &intersection) &&
+	  (intersection.squaredFindDistanceTo(cumReading) < 
 	   myCumulativeCleanDistSquared) &&
 	  (intersection.squaredFindDistanceTo(reading) > 
 	   50 * 50))
       {
 	//printf("Found one too close to the line\n");
-	myCumulativeBuffer.invalidateReading(cit);
+	myCumulativeBuffer.invalidateReading(storage->getIndexOfSlot(slot));
+	myCumulativeGrid.remove(slot, cumReading.getX(), cumReading.getY());
       }
     }
   }
-  // if we're cleaning finish the sweep
-  if (clean)
-    myCumulativeBuffer.endInvalidationSweep();
+
   // toss the reading in
   if (addReading)
+  {
+    // if its full the oldest reading gets replaced, so take it out
+    // of the grid first
+    if (storage->size() > 0 && storage->size() == storage->capacity())
+    {
+      slot = storage->getSlot(storage->size() - 1);
+      myCumulativeGrid.remove(slot, storage->getSlotX(slot), 
+			      storage->getSlotY(slot));
+    }
     myCumulativeBuffer.addReading(x, y);
+    myCumulativeGrid.add(storage->getSlot(0), x, y);
+  }
+  myCumulativeGridChangeCount = storage->getChangeCount();
+}
 
+/**
+   The grid is kept up to date by internalProcessReading as it adds
+   and cleans readings, anything else that changes the cumulative
+   buffer (the age and distance filtering, clearing it, changing its
+   size, transforming it) changes the storage's change count and the
+   grid is rebuilt here.
+**/
+void MvrLaser::internalUpdateCumulativeGrid(void)
+{
+  const MvrRangeBufferStorage *storage = myCumulativeBuffer.getStorage();
+  double cellSize;
+
+  // make the cells about twice as big as the distances we look for,
+  // so a query only has to look at a few cells
+  cellSize = myMinDistBetweenCumulative;
+  if (myCumulativeCleanDist > cellSize)
+    cellSize = myCumulativeCleanDist;
+  cellSize *= 2;
+  if (cellSize < 100)
+    cellSize = 100;
+
+  if (myCumulativeGridGood && 
+      myCumulativeGrid.getCellSize() == cellSize &&
+      myCumulativeGridChangeCount == storage->getChangeCount())
+    return;
+
+  if (myCumulativeGrid.getCellSize() != cellSize)
+    myCumulativeGrid.setCellSize(cellSize);
+  myCumulativeGrid.rebuild(storage);
+  myCumulativeGridChangeCount = storage->getChangeCount();
+  myCumulativeGridGood = true;
 }
 
 MVREXPORT bool MvrLaser::laserPullUnsetParamsFromRobot(void)
@@ -579,6 +662,16 @@ MVREXPORT bool MvrLaser::laserPullUnsetParamsFromRobot(void)
     chooseAutoBaud(paramStr);
   }
 
+  paramStr = params->getLaserProtocolChoice(getLaserNumber());
+  if (canChooseProtocol() && !myProtocolChoiceSet && 
+      paramStr != NULL && paramStr[0] != '\0')
+  {
+    MvrLog::log(myInfoLogLevel, 
+	       "%s: Setting protocol choice to %s from robot params",
+	       getName(), paramStr);
+    chooseProtocol(paramStr);
+  }
+
   if (!addIgnoreReadings(params->getLaserIgnore(getLaserNumber())))
     return false;
 
@@ -1240,6 +1333,39 @@ MVREXPORT bool MvrLaser::chooseAutoBaud(const char *autoBaudChoice)
   return true;      
 }
 
+/**
+   @param defaultProtocolChoice Default protocol choice.  This should
+   be whatever the laser speaks out of the box.
+
+   @param protocolChoices The available choices for protocol
+**/
+MVREXPORT void MvrLaser::laserAllowProtocolChoices(
+	const char *defaultProtocolChoice, 
+	std::list<std::string> protocolChoices)
+{
+  myCanChooseProtocol = true;
+  myProtocolChoices = protocolChoices;
+  internalBuildChoicesString(&myProtocolChoices, &myProtocolChoicesString);
+  chooseProtocol(defaultProtocolChoice);
+  myProtocolChoiceSet = false;
+}
+
+MVREXPORT bool MvrLaser::chooseProtocol(const char *protocolChoice)
+{
+  if (!myCanChooseProtocol)
+  {
+    MvrLog::log(MvrLog::Terse, "%s::chooseProtocol: Cannot choose protocol on this laser", myName.c_str());
+    return false;
+  }
+
+  if (!internalCheckChoice("chooseProtocol", protocolChoice, 
+		   &myProtocolChoices, myProtocolChoicesString.c_str()))
+    return false;
+
+  myProtocolChoice = protocolChoice;
+  return true;      
+}
+
 MVREXPORT void MvrLaser::laserSetDefaultTcpPort(int defaultTcpPort)
 {
   myDefaultTcpPort = defaultTcpPort;
@@ -1329,10 +1455,7 @@ MVREXPORT void MvrLaser::applyTransform(MvrTransform trans,
 				       bool doCumulative)
 {
   myCurrentBuffer.applyTransform(trans);
-  std::list<MvrSensorReading *>::iterator it;
-
-  for (it = myRawReadings->begin(); it != myRawReadings->end(); ++it)
-    (*it)->applyTransform(trans);
+  myRawScan.applyTransform(trans);
 
   if (doCumulative)
     myCumulativeBuffer.applyTransform(trans);
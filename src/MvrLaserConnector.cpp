@@ -124,6 +124,12 @@ MVREXPORT bool MvrLaserConnector::parseArgs(void)
     reflectance levels, but also may force a reduction in range.  (Note, the SICK LMS-200 only detects high reflectance on special reflector material
     manufactured by SICK.)
     </dd>
+
+    <dt>-laserProtocol <i>protocol</i></dt>
+    <dt>-lpr <i>protocol</i></dt>
+    <dd>Selects the protocol used to talk to the laser, for lasers that
+    speak more than one.  The SICK LMS1xx and LMS5xx may use
+    <code>ascii</code> (CoLa-A, the default) or <code>binary</code> (CoLa-B).</dd>
   </dl>
 
  **/
@@ -431,6 +437,15 @@ MVREXPORT bool MvrLaserConnector::parseLaserArgs(MvrArgumentParser *parser,
 	       NULL, &laserData->myAutoBaud,
 	       "-lab%s", buf)) ||
 
+      (laser->canChooseProtocol() && 
+       !parser->checkParameterArgumentStringVar(
+	       NULL, &laserData->myProtocol, 
+	       "-laserProtocol%s", buf)) ||
+      (laser->canChooseProtocol() && 
+       !parser->checkParameterArgumentStringVar(
+	       NULL, &laserData->myProtocol,
+	       "-lpr%s", buf)) ||
+
       !parser->checkParameterArgumentStringVar(
 	      NULL, &laserData->myAdditionalIgnoreReadings, 
 	      "-laserAdditionalIgnoreReadings%s", buf) || 
@@ -509,6 +524,10 @@ bool MvrLaserConnector::internalConfigureLaser(
       !laser->chooseAutoBaud(laserData->myAutoBaud))
     return false;
 
+  if (laser->canChooseProtocol() && laserData->myProtocol != NULL &&
+      !laser->chooseProtocol(laserData->myProtocol))
+    return false;
+
   if (laserData->myAdditionalIgnoreReadings != NULL && 
       !laser->addIgnoreReadings(laserData->myAdditionalIgnoreReadings))
     return false;
@@ -880,6 +899,14 @@ MVREXPORT void MvrLaserConnector::logLaserOptions(
 	       laser->getAutoBaudChoicesString());
   }
 
+  if (laser->canChooseProtocol())
+  {
+    MvrLog::log(MvrLog::Terse, "-laserProtocol%s <%s>", buf,
+	       laser->getProtocolChoicesString());
+    MvrLog::log(MvrLog::Terse, "-lpr%s <%s>", buf,
+	       laser->getProtocolChoicesString());
+  }
+
   MvrLog::log(MvrLog::Terse, "-laserAdditionalIgnoreReadings%s <readings>", buf);
   MvrLog::log(MvrLog::Terse, "-lair%s <readings>", buf);
   MvrLog::log(MvrLog::Terse, "\t<readings> is a string that contains readings to ignore separated by commas, where ranges are acceptable with a -, example '75,76,90-100,-75,-76,-90--100'");
@@ -24,8 +24,6 @@ MVREXPORT MvrLaserFilter::MvrLaserFilter(
     laserSetName(filteredName.c_str());
   }
 
-  myRawReadings = new std::list<MvrSensorReading *>;
-
   char buf[1024];
   sprintf(buf, "%sProcessCB", getName());
   myProcessCB.setName(buf);
@@ -118,6 +116,10 @@ MVREXPORT MvrLaserFilter::MvrLaserFilter(
   if (myLaser->canChooseAutoBaud())
     laserAllowAutoBaudChoices(myLaser->getAutoBaudChoice(), 
 			      myLaser->getAutoBaudChoices());
+
+  if (myLaser->canChooseProtocol())
+    laserAllowProtocolChoices(myLaser->getProtocolChoice(), 
+			      myLaser->getProtocolChoices());
   
   laserSetDefaultTcpPort(myLaser->getDefaultTcpPort());
   laserSetDefaultPortType(myLaser->getDefaultPortType());
@@ -215,61 +217,35 @@ void MvrLaserFilter::processReadings(void)
   myLaser->lockDevice();
   selfLockDevice();
 
-  const std::list<MvrSensorReading *> *rdRawReadings;
-  std::list<MvrSensorReading *>::const_iterator rdIt;
+  const MvrScan *rdRawScan = myLaser->getRawScan();
   
-  if ((rdRawReadings = myLaser->getRawReadings()) == NULL)
+  if (rdRawScan->getGeneration() == 0)
   {
     selfUnlockDevice();
     myLaser->unlockDevice();
     return;
   }
 
-  size_t rawSize = myRawReadings->size();
-  size_t rdRawSize = myLaser->getRawReadings()->size();
-  
-  while (rawSize < rdRawSize)
-  {
-    myRawReadings->push_back(new MvrSensorReading);
-    rawSize++;
-  }
-
   // set where the pose was taken
   myCurrentBuffer.setPoseTaken(
 	  myLaser->getCurrentRangeBuffer()->getPoseTaken());
   myCurrentBuffer.setEncoderPoseTaken(
 	  myLaser->getCurrentRangeBuffer()->getEncoderPoseTaken());
 
-
-  std::list<MvrSensorReading *>::iterator it;
-  MvrSensorReading *rdReading;
-  MvrSensorReading *reading;
-
 #ifdef DEBUGRANGEFILTER
   FILE *file = NULL;
   //file = MvrUtil::fopen("/mnt/rdsys/tmp/filter", "w");
   file = MvrUtil::fopen("/tmp/filter", "w");
 #endif
 
-  std::map<int, MvrSensorReading *> readingMap;
-  int numReadings = 0;
-
-  // first pass to copy the readings and put them into a map
-  for (rdIt = rdRawReadings->begin(), it = myRawReadings->begin();
-       rdIt != rdRawReadings->end() && it != myRawReadings->end();
-       rdIt++, it++)
-  {
-    rdReading = (*rdIt);
-    reading = (*it);
-    *reading = *rdReading;
-
-    readingMap[numReadings] = reading;
-    numReadings++;
-  }
+  // copy the readings, the filtering below just walks them by index
+  myRawScan.copyScan(rdRawScan);
+  int numReadings = myRawScan.getNumReadings();
 
   // if we're not doing any filtering, just short circuit out now
   if (myAllFactor <= 0 && myAnyFactor <= 0 && myAnyMinRange <= 0)
   {
+    myRawScan.endScan();
     laserProcessReadings();
     copyReadingCount(myLaser);
 
@@ -285,71 +261,35 @@ void MvrLaserFilter::processReadings(void)
   char buf[1024];
   int i;
   int j;
-  //MvrSensorReading *lastAddedReading = NULL;
+  unsigned int range;
+  double th;
   
   // now walk through the readings to filter them
   for (i = 0; i < numReadings; i++)
   {
-    reading = readingMap[i];
-
     // if we're ignoring this reading then just get on with life
-    if (reading->getIgnoreThisReading())
+    if (myRawScan.getIgnore(i))
       continue;
 
-    /* Taking this check out since the base class does it now and if
-     * it gets marked ignore now it won't get used for clearing
-     * cumulative readings
+    range = myRawScan.getRange(i);
+    th = myRawScan.getTh(i);
 
-    if (myMaxRange >= 0 && reading->getRange() > myMaxRange)
-    {
-#ifdef DEBUGRANGEFILTER
-      if (file != NULL)
-	fprintf(file, "%.1f beyond max range at %d\n", 
-		reading->getSensorTh(), reading->getRange());
-#endif
-      reading->setIgnoreThisReading(true);
-      continue;
-    }
-    */
-    if (myAnyMinRange >= 0 && reading->getRange() < myAnyMinRange &&
-	(reading->getSensorTh() < myAnyMinRangeLessThanAngle ||
-	 reading->getSensorTh() > myAnyMinRangeGreaterThanAngle))
+    /* Taking the max range check out since the base class does it now
+     * and if it gets marked ignore now it won't get used for clearing
+     * cumulative readings
+     */
+    if (myAnyMinRange >= 0 && range < myAnyMinRange &&
+	(th < myAnyMinRangeLessThanAngle ||
+	 th > myAnyMinRangeGreaterThanAngle))
     {
 #ifdef DEBUGRANGEFILTER
       if (file != NULL)
-	fprintf(file, "%.1f within min range at %d\n", 
-		reading->getSensorTh(), reading->getRange());
+	fprintf(file, "%.1f within min range at %d\n", th, range);
 #endif
-      reading->setIgnoreThisReading(true);
+      myRawScan.setIgnore(i, true);
       continue;
     }
 
-    /*
-    if (lastAddedReading != NULL)
-    {
-
-      if (lastAddedReading->getPose().findDistanceTo(reading->getPose()) < 50)
-      {
-#ifdef DEBUGRANGEFILTER
-	if (file != NULL)
-	  fprintf(file, "%.1f too close from last %6.0f\n", 
-		  reading->getSensorTh(),
-		  lastAddedReading->getPose().findDistanceTo(
-			  reading->getPose()));
-#endif
-	reading->setIgnoreThisReading(true);
-	continue;
-      }
-#ifdef DEBUGRANGEFILTER
-      else if (file != NULL)
-	fprintf(file, "%.1f from last %6.0f\n", 
-		reading->getSensorTh(),
-		lastAddedReading->getPose().findDistanceTo(
-			reading->getPose()));
-#endif
-    }
-    */
-
     buf[0] = '\0';
     bool goodAll = true;
     bool goodAny = false;
@@ -358,85 +298,58 @@ void MvrLaserFilter::processReadings(void)
       goodAny = true;
     for (j = i - 1; 
 	 (j >= 0 && //good && 
-	  fabs(MvrMath::subAngle(readingMap[j]->getSensorTh(),
-				reading->getSensorTh())) <= myAngleToCheck);
+	  fabs(MvrMath::subAngle(myRawScan.getTh(j), th)) <= myAngleToCheck);
 	 j--)
     {
-      /* You can't skip these, or you get onesided filtering
-      if (readingMap[j]->getIgnoreThisReading())
-      {
+      // You can't skip the ignored ones, or you get onesided filtering
 #ifdef DEBUGRANGEFILTER
-	sprintf(buf, "%s %6s", buf, "i");
-#endif
-	continue;
-      }
-      */
-#ifdef DEBUGRANGEFILTER
-      sprintf(buf, "%s %6d", buf, readingMap[j]->getRange());
+      sprintf(buf, "%s %6d", buf, myRawScan.getRange(j));
 #endif
       if (myAllFactor > 0 && 
-	  !checkRanges(reading->getRange(), 
-		       readingMap[j]->getRange(), myAllFactor))
+	  !checkRanges(range, myRawScan.getRange(j), myAllFactor))
 	goodAll = false;
       if (myAnyFactor > 0 &&
-	  checkRanges(reading->getRange(), 
-		      readingMap[j]->getRange(), myAnyFactor))
+	  checkRanges(range, myRawScan.getRange(j), myAnyFactor))
 	goodAny = true;
       if (myAnyMinRange > 0 && 
-	  (reading->getSensorTh() < myAnyMinRangeLessThanAngle ||
-	   reading->getSensorTh() > myAnyMinRangeGreaterThanAngle) &&
-	  readingMap[j]->getRange() <= myAnyMinRange)
+	  (th < myAnyMinRangeLessThanAngle ||
+	   th > myAnyMinRangeGreaterThanAngle) &&
+	  myRawScan.getRange(j) <= myAnyMinRange)
 	goodMinRange = false;
 	
     }
 #ifdef DEBUGRANGEFILTER
-    sprintf(buf, "%s %6d*", buf, reading->getRange());
+    sprintf(buf, "%s %6d*", buf, range);
 #endif 
     for (j = i + 1; 
 	 (j < numReadings && //good &&
-	  fabs(MvrMath::subAngle(readingMap[j]->getSensorTh(),
-				reading->getSensorTh())) <= myAngleToCheck);
+	  fabs(MvrMath::subAngle(myRawScan.getTh(j), th)) <= myAngleToCheck);
 	 j++)
     {
       // you can't ignore these or you get one sided filtering
-      /*
-      if (readingMap[j]->getIgnoreThisReading())
-      {
-#ifdef DEBUGRANGEFILTER
-	sprintf(buf, "%s %6s", buf, "i");
-#endif
-	continue;
-      }
-      */
 #ifdef DEBUGRANGEFILTER
-      sprintf(buf, "%s %6d", buf, readingMap[j]->getRange());
+      sprintf(buf, "%s %6d", buf, myRawScan.getRange(j));
 #endif
       if (myAllFactor > 0 && 
-	  !checkRanges(reading->getRange(), 
-		       readingMap[j]->getRange(), myAllFactor))
+	  !checkRanges(range, myRawScan.getRange(j), myAllFactor))
 	goodAll = false;
       if (myAnyFactor > 0 &&
-	  checkRanges(reading->getRange(), 
-		       readingMap[j]->getRange(), myAnyFactor))
+	  checkRanges(range, myRawScan.getRange(j), myAnyFactor))
 	goodAny = true;
       if (myAnyMinRange > 0 && 
-	  (reading->getSensorTh() < myAnyMinRangeLessThanAngle ||
-	   reading->getSensorTh() > myAnyMinRangeGreaterThanAngle) &&
-	  readingMap[j]->getRange() <= myAnyMinRange)
+	  (th < myAnyMinRangeLessThanAngle ||
+	   th > myAnyMinRangeGreaterThanAngle) &&
+	  myRawScan.getRange(j) <= myAnyMinRange)
 	goodMinRange = false;
     }
     
 
     if (!goodAll || !goodAny || !goodMinRange)
-      reading->setIgnoreThisReading(true);
-    /*
-    else
-      lastAddedReading = reading;
-    */
+      myRawScan.setIgnore(i, true);
 #ifdef DEBUGRANGEFILTER
     if (file != NULL)
       fprintf(file, 
-	      "%5.1f %6d %c\t%s\n", reading->getSensorTh(), reading->getRange(),
+	      "%5.1f %6d %c\t%s\n", th, range,
 	      goodAll && goodAny && goodMinRange ? 'g' : 'b', buf);
 #endif
 	    
@@ -448,6 +361,7 @@ void MvrLaserFilter::processReadings(void)
     fclose(file);
 #endif
 
+  myRawScan.endScan();
   laserProcessReadings();
   copyReadingCount(myLaser);
 
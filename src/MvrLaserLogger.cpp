@@ -343,7 +343,7 @@ void MvrLaserLogger::internalPrintLaserPoseAndConf(MvrLaser *laser, int laserNum
   double firstAngle = 0;
   double lastAngle = 0;
 
-  if (!readings->empty())
+  if (readings != NULL && !readings->empty())
   {
     firstAngle = MvrMath::subAngle(readings->front()->getSensorTh(),
 				  laser->getSensorPositionTh());
@@ -61,29 +61,25 @@ MVREXPORT void MvrLaserReflectorDevice::addToConfig(MvrConfig *config,
 
 MVREXPORT void MvrLaserReflectorDevice::processReadings(void)
 {
-  //int i;
-  MvrSensorReading *reading;
+  int i;
   myLaser->lockDevice();
   lockDevice();
   
-  const std::list<MvrSensorReading *> *rawReadings;
-  std::list<MvrSensorReading *>::const_iterator rawIt;
-  rawReadings = myLaser->getRawReadings();
+  const MvrScan *rawScan = myLaser->getRawScan();
+  int numReadings = rawScan->getNumReadings();
+  const int *intensities = rawScan->getIntensities();
+  const unsigned char *ignores = rawScan->getIgnores();
+  const double *xs = rawScan->getXs();
+  const double *ys = rawScan->getYs();
   myCurrentBuffer.beginRedoBuffer();
 
   if (myReflectanceThreshold < 0 || myReflectanceThreshold > 255)
     myReflectanceThreshold = 0;
 
-  if (rawReadings->begin() != rawReadings->end())
+  for (i = 0; i < numReadings; i++)
   {
-    for (rawIt = rawReadings->begin(); rawIt != rawReadings->end(); rawIt++)
-    {
-      reading = (*rawIt);
-      if (!reading->getIgnoreThisReading() && 
-	  reading->getExtraInt() > myReflectanceThreshold)
-	myCurrentBuffer.redoReading(reading->getPose().getX(), 
-				    reading->getPose().getY());
-    }
+    if (!ignores[i] && intensities[i] > myReflectanceThreshold)
+      myCurrentBuffer.redoReading(xs[i], ys[i]);
   }
 
   myCurrentBuffer.endRedoBuffer();
@@ -0,0 +1,195 @@
+#include "MvrExport.h"
+#include "mvriaOSDef.h"
+#include "MvrLatencyHistogram.h"
+#include <stdio.h>
+
+MVREXPORT MvrLatencyHistogram::MvrLatencyHistogram()
+{
+  reset();
+}
+
+MVREXPORT MvrLatencyHistogram::~MvrLatencyHistogram()
+{
+}
+
+int MvrLatencyHistogram::getBucket(unsigned int uSecs)
+{
+  int msb;
+
+  if (uSecs < 64)
+    return uSecs;
+  msb = 31 - __builtin_clz(uSecs);
+  // the top 6 bits of the time, so 32 buckets for each power of two
+  return (msb - 5) * 32 + (uSecs >> (msb - 5));
+}
+
+unsigned int MvrLatencyHistogram::getBucketMax(int bucket)
+{
+  int shift;
+  unsigned long long top;
+
+  if (bucket < 64)
+    return bucket;
+  shift = bucket / 32 - 1;
+  top = ((unsigned long long)(bucket - shift * 32 + 1) << shift) - 1;
+  if (top > 0xffffffffULL)
+    top = 0xffffffffULL;
+  return (unsigned int)top;
+}
+
+MVREXPORT void MvrLatencyHistogram::add(unsigned int uSecs)
+{
+  unsigned long long count;
+  unsigned long long recentNum;
+
+  myBuckets[getBucket(uSecs)].fetch_add(1, std::memory_order_relaxed);
+  count = myCount.load(std::memory_order_relaxed);
+  if (count == 0 || uSecs < myMin.load(std::memory_order_relaxed))
+    myMin.store(uSecs, std::memory_order_relaxed);
+  if (uSecs > myMax.load(std::memory_order_relaxed))
+    myMax.store(uSecs, std::memory_order_relaxed);
+  mySum.fetch_add(uSecs, std::memory_order_relaxed);
+  recentNum = myRecentNum.load(std::memory_order_relaxed);
+  myRecent[recentNum % NUM_RECENT].store(uSecs, std::memory_order_relaxed);
+  myRecentNum.store(recentNum + 1, std::memory_order_release);
+  myCount.store(count + 1, std::memory_order_release);
+}
+
+MVREXPORT void MvrLatencyHistogram::reset(void)
+{
+  int i;
+
+  for (i = 0; i < NUM_BUCKETS; i++)
+    myBuckets[i].store(0, std::memory_order_relaxed);
+  for (i = 0; i < NUM_RECENT; i++)
+    myRecent[i].store(0, std::memory_order_relaxed);
+  mySum.store(0, std::memory_order_relaxed);
+  myMin.store(0, std::memory_order_relaxed);
+  myMax.store(0, std::memory_order_relaxed);
+  myRecentNum.store(0, std::memory_order_relaxed);
+  myCount.store(0, std::memory_order_release);
+}
+
+MVREXPORT unsigned long long MvrLatencyHistogram::getCount(void) const
+{
+  return myCount.load(std::memory_order_acquire);
+}
+
+MVREXPORT unsigned int MvrLatencyHistogram::getMin(void) const
+{
+  return myMin.load(std::memory_order_relaxed);
+}
+
+MVREXPORT unsigned int MvrLatencyHistogram::getMax(void) const
+{
+  return myMax.load(std::memory_order_relaxed);
+}
+
+MVREXPORT double MvrLatencyHistogram::getMean(void) const
+{
+  unsigned long long count = getCount();
+  if (count == 0)
+    return 0;
+  return (double)mySum.load(std::memory_order_relaxed) / count;
+}
+
+/**
+   @param fraction how far through the times to go, .5 for the median,
+   .99 for the 99th percentile and so on
+
+   @return the longest time in the bucket the percentile falls in (but
+   never more than getMax()), 0 if nothing has been added
+**/
+MVREXPORT unsigned int MvrLatencyHistogram::getPercentile(
+	double fraction) const
+{
+  unsigned long long total = 0;
+  unsigned long long target;
+  unsigned int max = getMax();
+  unsigned int bucketMax;
+  int i;
+
+  // add the buckets up instead of using myCount, so an add() that is
+  // halfway done can't leave us looking for more than there is
+  for (i = 0; i < NUM_BUCKETS; i++)
+    total += myBuckets[i].load(std::memory_order_relaxed);
+  if (total == 0)
+    return 0;
+  if (fraction < 0)
+    fraction = 0;
+  if (fraction > 1)
+    fraction = 1;
+  target = (unsigned long long)(fraction * total + .999999);
+  if (target < 1)
+    target = 1;
+
+  total = 0;
+  for (i = 0; i < NUM_BUCKETS; i++)
+  {
+    total += myBuckets[i].load(std::memory_order_relaxed);
+    if (total >= target)
+    {
+      bucketMax = getBucketMax(i);
+      return (bucketMax < max) ? bucketMax : max;
+    }
+  }
+  return max;
+}
+
+/**
+   @param uSecs where to put the times
+   @param maxNum how many times uSecs has room for
+   @return how many times were put into uSecs
+**/
+MVREXPORT int MvrLatencyHistogram::getRecent(unsigned int *uSecs,
+					     int maxNum) const
+{
+  unsigned long long recentNum = myRecentNum.load(std::memory_order_acquire);
+  unsigned long long num = recentNum;
+  unsigned long long i;
+
+  if (num > NUM_RECENT)
+    num = NUM_RECENT;
+  if (maxNum < 0)
+    maxNum = 0;
+  if (num > (unsigned long long)maxNum)
+    num = maxNum;
+  for (i = 0; i < num; i++)
+    uSecs[i] = myRecent[(recentNum - num + i) % NUM_RECENT].load(
+	    std::memory_order_relaxed);
+  return (int)num;
+}
+
+/**
+   @param numRecent how many of the most recent times to put on the
+   end of the line
+**/
+MVREXPORT std::string MvrLatencyHistogram::getSummary(int numRecent) const
+{
+  char buf[1024];
+  unsigned int recent[NUM_RECENT];
+  std::string ret;
+  int num;
+  int i;
+
+  snprintf(buf, sizeof(buf),
+	   "n %llu mean %.3f min %.3f p50 %.3f p99 %.3f p99.9 %.3f max %.3f ms",
+	   getCount(), getMean() / 1000.0, getMin() / 1000.0,
+	   getPercentile(.5) / 1000.0, getPercentile(.99) / 1000.0,
+	   getPercentile(.999) / 1000.0, getMax() / 1000.0);
+  ret = buf;
+  if (numRecent > NUM_RECENT)
+    numRecent = NUM_RECENT;
+  num = getRecent(recent, numRecent);
+  if (num > 0)
+  {
+    ret += " (last";
+    for (i = 0; i < num; i++)
+    {
+      snprintf(buf, sizeof(buf), " %.3f", recent[i] / 1000.0);
+      ret += buf;
+    }
+    ret += ")";
+  }
+  return ret;
+}
@@ -75,10 +75,9 @@ MVREXPORT std::map<int, MvrPose> *MvrLineFinder::getNonLinePoints(void)
 
 MVREXPORT void MvrLineFinder::fillPointsFromLaser(void)
 {
-  const std::list<MvrSensorReading *> *readings;
-  std::list<MvrSensorReading *>::const_iterator it;
-  std::list<MvrSensorReading *>::const_reverse_iterator rit;
-  MvrSensorReading *reading;
+  const MvrScan *scan;
+  int numReadings;
+  int i;
   int pointCount = 0;
 
   if (myPoints != NULL)
@@ -87,26 +86,23 @@ MVREXPORT void MvrLineFinder::fillPointsFromLaser(void)
   myPoints = new std::map<int, MvrPose>;
   
   myRangeDevice->lockDevice();
-  readings = myRangeDevice->getRawReadings();
+  scan = myRangeDevice->getRawScan();
+  numReadings = scan->getNumReadings();
 
   if (!myFlippedFound)
   {
-    if (readings->begin() != readings->end())
+    if (numReadings > 0)
     {
-      int size;
-      size = readings->size();
-      it = readings->begin();
-      // advance along 10 readings
-      for (int i = 0; i < 10 && i < size / 2; i++)
-	it++;
-      // see if we're flipped
-      if (MvrMath::subAngle((*(readings->begin()))->getSensorTh(), 
-			   (*it)->getSensorTh()) > 0)
+      // see if we're flipped, by looking 10 readings along
+      i = 10;
+      if (i > numReadings / 2)
+	i = numReadings / 2;
+      if (MvrMath::subAngle(scan->getTh(0), scan->getTh(i)) > 0)
 	myFlipped = true;
       else
 	myFlipped = false;
       myFlippedFound = true;
-      //printf("@@@ LINE %d %.0f\n", myFlipped, MvrMath::subAngle((*(readings->begin()))->getSensorTh(), (*it)->getSensorTh()));
+      //printf("@@@ LINE %d %.0f\n", myFlipped, MvrMath::subAngle(scan->getTh(0), scan->getTh(i)));
 
       
     }
@@ -115,32 +111,34 @@ MVREXPORT void MvrLineFinder::fillPointsFromLaser(void)
 
 
 
-  if (readings->begin() == readings->end())
+  if (numReadings == 0)
   {
     myRangeDevice->unlockDevice();
     return;
   }
-  myPoseTaken = (*readings->begin())->getPoseTaken();
+  myPoseTaken = scan->getPoseTaken();
 
+  const unsigned int *ranges = scan->getRanges();
+  const unsigned char *ignores = scan->getIgnores();
+  const double *xs = scan->getXs();
+  const double *ys = scan->getYs();
   if (myFlipped)
   {
-    for (rit = readings->rbegin(); rit != readings->rend(); rit++)
+    for (i = numReadings - 1; i >= 0; i--)
     {
-      reading = (*rit);
-      if (reading->getRange() > 5000 || reading->getIgnoreThisReading())
+      if (ranges[i] > 5000 || ignores[i])
 	continue;
-      (*myPoints)[pointCount] = reading->getPose();
+      (*myPoints)[pointCount] = MvrPose(xs[i], ys[i]);
       pointCount++;
     }
   }
   else
   {
-    for (it = readings->begin(); it != readings->end(); it++)
+    for (i = 0; i < numReadings; i++)
     {
-      reading = (*it);
-      if (reading->getRange() > 5000 || reading->getIgnoreThisReading())
+      if (ranges[i] > 5000 || ignores[i])
 	continue;
-      (*myPoints)[pointCount] = reading->getPose();
+      (*myPoints)[pointCount] = MvrPose(xs[i], ys[i]);
       pointCount++;
     }
   }
@@ -5,7 +5,10 @@
 #include <time.h>
 #include <stdarg.h>
 #include <ctype.h>
+#include <string.h>
 #include "mvriaInternal.h"
+#include "MvrFunctorASyncTask.h"
+#include "MvrBinaryLog.h"
 
 
 #ifdef WIN32
@@ -52,6 +55,89 @@ bool MvrLog::ourAramDaemonized = false;
 
 MvrFunctor1<const char *> *MvrLog::ourFunctor;
 
+std::atomic<bool> MvrLog::ourAsyncRunning(false);
+std::atomic<bool> MvrLog::ourAsyncWriterDone(true);
+std::atomic<int> MvrLog::ourAsyncOverflowPolicy(MvrLog::AsyncCount);
+std::atomic<size_t> MvrLog::ourAsyncBufferSize(65536);
+std::atomic<size_t> MvrLog::ourAsyncDropped(0);
+size_t MvrLog::ourAsyncDroppedReported = 0;
+std::atomic<unsigned long long> MvrLog::ourAsyncSequence(0);
+std::atomic<MvrLogAsyncRing *> MvrLog::ourAsyncRings[MvrLog::ASYNC_MAX_THREADS];
+MvrFunctorASyncTask *MvrLog::ourAsyncWriter = NULL;
+MvrGlobalRetFunctor1<void *, void *> MvrLog::ourAsyncWriterCB(
+	&MvrLog::asyncWriterThread);
+
+/**
+   Single producer, single consumer ring of log records for one thread.
+   Each record is the sequence number it was logged with, its length,
+   then the text (without a newline or terminating NUL); records wrap
+   around the end of the buffer.  Only the thread that owns the ring
+   adds to it, and only whoever holds MvrLog::ourMutex takes out of it.
+**/
+class MvrLogAsyncRing
+{
+public:
+  MvrLogAsyncRing(size_t size) :
+    myHead(0), myTail(0), myOrphaned(false)
+  {
+    mySize = 1024;
+    while (mySize < size)
+      mySize *= 2;
+    myMask = mySize - 1;
+    myBuf = new char[mySize];
+  }
+  ~MvrLogAsyncRing() { delete[] myBuf; }
+  enum { HEADER_SIZE = sizeof(unsigned long long) + sizeof(unsigned int) };
+  // the longest message that is ever put in the ring
+  size_t getMaxRecord(void) const { return mySize / 2 - HEADER_SIZE; }
+  void copyIn(size_t pos, const void *data, size_t len)
+  {
+    size_t start = pos & myMask;
+    size_t first = mySize - start;
+    if (first > len)
+      first = len;
+    memcpy(myBuf + start, data, first);
+    memcpy(myBuf, (const char *)data + first, len - first);
+  }
+  void copyOut(size_t pos, void *data, size_t len) const
+  {
+    size_t start = pos & myMask;
+    size_t first = mySize - start;
+    if (first > len)
+      first = len;
+    memcpy(data, myBuf + start, first);
+    memcpy((char *)data + first, myBuf, len - first);
+  }
+  char *myBuf;
+  size_t mySize;
+  size_t myMask;
+  // the writer's and logging thread's positions, on different cache lines
+  char myPad0[64];
+  std::atomic<size_t> myHead;
+  char myPad1[64];
+  std::atomic<size_t> myTail;
+  char myPad2[64];
+  // set when the owning thread has exited, so the writer can delete it
+  std::atomic<bool> myOrphaned;
+};
+
+// gives each thread its own ring, and lets the writer know when the
+// thread is gone
+class MvrLogAsyncRingHolder
+{
+public:
+  MvrLogAsyncRingHolder() : myRing(NULL), myIsWriter(false) {}
+  ~MvrLogAsyncRingHolder()
+  {
+    if (myRing != NULL)
+      myRing->myOrphaned.store(true);
+  }
+  MvrLogAsyncRing *myRing;
+  bool myIsWriter;
+};
+
+static thread_local MvrLogAsyncRingHolder ourAsyncThreadRing;
+
 
 MVREXPORT void MvrLog::logPlain(LogLevel level, const char *str)
 {
@@ -69,6 +155,16 @@ MVREXPORT void MvrLog::log(LogLevel level, const char *str, ...)
   if (level > ourLevel)
     return;
   
+  if (ourAsyncRunning.load())
+  {
+    va_list ptr;
+    va_start(ptr, str);
+    bool queued = asyncLog_v(level, "", str, ptr);
+    va_end(ptr);
+    if (queued)
+      return;
+  }
+
   //printf("logging %s\n", str);
 
   char buf[10000];
@@ -171,6 +267,20 @@ MVREXPORT void MvrLog::logErrorFromOS(LogLevel level, const char *str, ...)
   DWORD err = GetLastError();
 #endif 
 
+#ifndef WIN32
+  if (ourAsyncRunning.load())
+  {
+    char msg[10000];
+    va_list ptr;
+    va_start(ptr, str);
+    vsnprintf(msg, sizeof(msg), str, ptr);
+    va_end(ptr);
+    if (asyncLog(level, "%s | ErrorFromOSNum: %d ErrorFromOSString: %s",
+		 msg, err, strerror(err)))
+      return;
+  }
+#endif
+
   //printf("logging %s\n", str);
 
   char buf[10000];
@@ -205,9 +315,7 @@ MVREXPORT void MvrLog::logErrorFromOS(LogLevel level, const char *str, ...)
   char bufWithError[10200];  
 
 #ifndef WIN32
-  const char *errorString = NULL;
-  if (err < sys_nerr - 1)
-    errorString = sys_errlist[err];
+  const char *errorString = strerror(err);
   snprintf(bufWithError, sizeof(bufWithError) - 1, "%s | ErrorFromOSNum: %d ErrorFromOSString: %s", buf, err, errorString);
   bufWithError[sizeof(bufWithError) - 1] = '\0';
 #else
@@ -334,9 +442,7 @@ MVREXPORT void MvrLog::logErrorFromOSNoLock(LogLevel level, const char *str, ...
   char bufWithError[10200];  
 
 #ifndef WIN32
-  const char *errorString = NULL;
-  if (err < sys_nerr - 1)
-    errorString = sys_errlist[err];
+  const char *errorString = strerror(err);
   snprintf(bufWithError, sizeof(bufWithError) - 1, "%s | ErrorFromOSNum: %d ErrorFromOSString: %s", buf, err, errorString);
   bufWithError[sizeof(bufWithError) - 1] = '\0';
 #else
@@ -414,6 +520,8 @@ MVREXPORT bool MvrLog::init(LogType type, LogLevel level, const char *fileName,
   ourMutex.setLogName("MvrLog::ourMutex");
 
   ourMutex.lock();
+  // anything still waiting to be written goes to the old log
+  flush();
   
   // if we weren't or won't be doing a file then close any old file
   if (ourType != File || type != File)
@@ -526,6 +634,7 @@ MVREXPORT bool MvrLog::init(LogType type, LogLevel level, const char *fileName,
 
 MVREXPORT void MvrLog::close()
 {
+  flush();
   if (ourFP && (ourType == File))
   {
     fclose(ourFP);
@@ -886,46 +995,455 @@ MVREXPORT void MvrLog::log_v(LogLevel level, const char *prefix, const char *str
 
 MVREXPORT void MvrLog::info(const char *str, ...)
 {
-  ourMutex.lock();
   va_list ptr;
   va_start(ptr, str);
-  log_v(Normal, "", str, ptr);
+  if (!asyncLog_v(Normal, "", str, ptr))
+  {
+    ourMutex.lock();
+    log_v(Normal, "", str, ptr);
+    ourMutex.unlock();
+  }
   va_end(ptr);
-  ourMutex.unlock();
 }
 
 MVREXPORT void MvrLog::warning(const char *str, ...)
 {
-  ourMutex.lock();
   va_list ptr;
   va_start(ptr, str);
-  log_v(Terse, "Warning: ", str, ptr);
+  if (!asyncLog_v(Terse, "Warning: ", str, ptr))
+  {
+    ourMutex.lock();
+    log_v(Terse, "Warning: ", str, ptr);
+    ourMutex.unlock();
+  }
   va_end(ptr);
-  ourMutex.unlock();
 }
 
 MVREXPORT void MvrLog::error(const char *str, ...)
 {
-  ourMutex.lock();
   va_list ptr;
   va_start(ptr, str);
-  log_v(Terse, "Error: ", str, ptr);
+  if (!asyncLog_v(Terse, "Error: ", str, ptr))
+  {
+    ourMutex.lock();
+    log_v(Terse, "Error: ", str, ptr);
+    ourMutex.unlock();
+  }
   va_end(ptr);
-  ourMutex.unlock();
 }
 
 MVREXPORT void MvrLog::debug(const char *str, ...)
 {
-  ourMutex.lock();
   va_list ptr;
   va_start(ptr, str);
-  log_v(Terse, "[debug] ", str, ptr);
+  if (!asyncLog_v(Terse, "[debug] ", str, ptr))
+  {
+    ourMutex.lock();
+    log_v(Terse, "[debug] ", str, ptr);
+    ourMutex.unlock();
+  }
   va_end(ptr);
-  ourMutex.unlock();
 }
 
 MVREXPORT void MvrLog::setLogLevel(LogLevel level) {
 	ourMutex.lock();
 	ourLevel = level;
 	ourMutex.unlock();
-}
\ No newline at end of file
+}
+
+/**
+   With this on, MvrLog::log() and the other logging calls format the
+   message in the thread that is logging and put it in a buffer for
+   that thread, a background thread then writes them out.  Each thread
+   gets its own buffer the first time it logs (up to 256 threads,
+   threads past that keep logging the old way).  The messages that
+   aren't written until the log mutex is held (logNoLock() and
+   logErrorFromOSNoLock()) are still written right away.
+
+   Turning it off (which Mvria::uninit() does) stops the writer thread
+   and writes out everything that was waiting.  If the writer thread is
+   stopped some other way (like MvrThread::stopAll()) it writes
+   everything out and logging goes back to being done the old way.
+
+   This should only be called from one thread at a time.
+
+   @param async true to log from the writer thread, false to log from
+   whatever thread is logging
+
+   @param bufferSize the size of the buffer each thread logs into
+   (rounded up to a power of two), only buffers made after this is
+   called use the new size
+
+   @return true if logging is now done the way that was asked for,
+   false if the writer thread couldn't be started
+**/
+MVREXPORT bool MvrLog::setAsync(bool async, size_t bufferSize)
+{
+  ourAsyncBufferSize.store(bufferSize);
+
+  if (ourAsyncWriter != NULL)
+  {
+    if (async && ourAsyncRunning.load() && ourAsyncWriter->getRunning())
+      return true;
+    // the writer is detached, so wait for it to say it is done
+    ourAsyncWriter->stopRunning();
+    while (!ourAsyncWriterDone.load())
+      MvrUtil::sleep(1);
+    delete ourAsyncWriter;
+    ourAsyncWriter = NULL;
+  }
+  ourAsyncRunning.store(false);
+  // anything logged by threads that saw the writer running right as it
+  // was stopping
+  flush();
+
+  if (!async)
+    return true;
+
+  ourAsyncWriter = new MvrFunctorASyncTask(&ourAsyncWriterCB);
+  ourAsyncWriter->setThreadName("MvrLog writer");
+  ourAsyncWriterDone.store(false);
+  ourAsyncRunning.store(true);
+  if (ourAsyncWriter->create(false, false) != 0)
+  {
+    ourAsyncRunning.store(false);
+    ourAsyncWriterDone.store(true);
+    delete ourAsyncWriter;
+    ourAsyncWriter = NULL;
+    MvrLog::log(MvrLog::Terse,
+	       "MvrLog::setAsync: Could not start the writer thread, logging will not be async");
+    return false;
+  }
+  return true;
+}
+
+MVREXPORT bool MvrLog::getAsync(void)
+{
+  return ourAsyncRunning.load();
+}
+
+/**
+   The default is AsyncCount.  AsyncBlock makes the logging thread wait
+   for the writer (so nothing is lost, but the logging thread can be
+   held up by the disk again), though it still gives up on a message
+   after waiting a second so a thread that logs while holding the log
+   mutex can't hang the writer.
+**/
+MVREXPORT void MvrLog::setAsyncOverflowPolicy(AsyncOverflowPolicy policy)
+{
+  ourAsyncOverflowPolicy.store(policy);
+}
+
+MVREXPORT MvrLog::AsyncOverflowPolicy MvrLog::getAsyncOverflowPolicy(void)
+{
+  return (AsyncOverflowPolicy)ourAsyncOverflowPolicy.load();
+}
+
+MVREXPORT size_t MvrLog::getAsyncNumDropped(void)
+{
+  return ourAsyncDropped.load();
+}
+
+/**
+   Takes everything out of the async buffers and writes it, then
+   flushes the log.  This locks the log mutex, so it's safe to call
+   from anywhere (including while logging is synchronous, when it just
+   flushes).
+**/
+MVREXPORT void MvrLog::flush(void)
+{
+  ourMutex.lock();
+  asyncDrainNoLock();
+  if (ourFP)
+    fflush(ourFP);
+  ourMutex.unlock();
+}
+
+MVREXPORT bool MvrLog::asyncLog_v(LogLevel level, const char *prefix,
+				  const char *str, va_list ptr)
+{
+  char buf[10000];
+  size_t len = 0;
+  int ret;
+  va_list copy;
+
+  if (!ourAsyncRunning.load())
+    return false;
+  if (level > ourLevel)
+    return true;
+
+  if (ourLoggingTime)
+  {
+    char timeBuf[64];
+    time_t now = time(NULL);
+    // plain ctime isn't safe without the log locked
+#ifndef WIN32
+    ctime_r(&now, timeBuf);
+#else
+    ctime_s(timeBuf, sizeof(timeBuf), &now);
+#endif
+    // get take just the portion of the time we want
+    memcpy(buf, timeBuf, 20);
+    len = 20;
+  }
+  strncpy(buf + len, prefix, sizeof(buf) - len - 1);
+  buf[sizeof(buf) - 1] = '\0';
+  len += strlen(buf + len);
+
+  // copy it so the caller can still use ptr if this returns false
+  va_copy(copy, ptr);
+  ret = vsnprintf(buf + len, sizeof(buf) - len, str, copy);
+  va_end(copy);
+  if (ret > 0)
+    len += ret;
+  if (len > sizeof(buf) - 1)
+    len = sizeof(buf) - 1;
+  return asyncPush(buf, len);
+}
+
+MVREXPORT bool MvrLog::asyncLog(LogLevel level, const char *str, ...)
+{
+  bool ret;
+  va_list ptr;
+  va_start(ptr, str);
+  ret = asyncLog_v(level, "", str, ptr);
+  va_end(ptr);
+  return ret;
+}
+
+/**
+   @param buf the message, or an MvrBinaryLog record if binary is true
+   @param len the length of buf
+   @param binary whether this is an MvrBinaryLog record (which can't
+   be truncated, so false is returned if it is too long)
+
+   @return true if the message was taken care of (queued, or thrown
+   away because of the overflow policy), false if the caller should
+   log it the old way
+**/
+MVREXPORT bool MvrLog::asyncPush(const char *buf, size_t len, bool binary)
+{
+  MvrLogAsyncRing *ring = ourAsyncThreadRing.myRing;
+  MvrLogAsyncRing *empty;
+  unsigned long long seq;
+  unsigned int recordLen;
+  size_t tail;
+  size_t need;
+  int i;
+  int waited = 0;
+
+  if (ring == NULL)
+  {
+    ring = new MvrLogAsyncRing(ourAsyncBufferSize.load());
+    for (i = 0; i < ASYNC_MAX_THREADS; i++)
+    {
+      empty = NULL;
+      if (ourAsyncRings[i].compare_exchange_strong(empty, ring))
+	break;
+    }
+    if (i == ASYNC_MAX_THREADS)
+    {
+      delete ring;
+      return false;
+    }
+    ourAsyncThreadRing.myRing = ring;
+  }
+
+  if (binary && (len > ring->getMaxRecord() || len > ASYNC_MAX_RECORD - 1))
+    return false;
+  if (len > ring->getMaxRecord())
+    len = ring->getMaxRecord();
+  if (len > ASYNC_MAX_RECORD - 1)
+    len = ASYNC_MAX_RECORD - 1;
+  need = MvrLogAsyncRing::HEADER_SIZE + len;
+
+  tail = ring->myTail.load(std::memory_order_relaxed);
+  while (tail + need - ring->myHead.load(std::memory_order_acquire) >
+	 ring->mySize)
+  {
+    if (!ourAsyncRunning.load())
+      return false;
+    // the writer can't wait on itself to make room
+    if (ourAsyncOverflowPolicy.load() != AsyncBlock ||
+	ourAsyncThreadRing.myIsWriter || waited++ >= 1000)
+    {
+      ourAsyncDropped.fetch_add(1);
+      return true;
+    }
+    MvrUtil::sleep(1);
+  }
+
+  seq = ourAsyncSequence.fetch_add(1);
+  recordLen = len;
+  if (binary)
+    recordLen |= ASYNC_BINARY_RECORD;
+  ring->copyIn(tail, &seq, sizeof(seq));
+  ring->copyIn(tail + sizeof(seq), &recordLen, sizeof(recordLen));
+  ring->copyIn(tail + MvrLogAsyncRing::HEADER_SIZE, buf, len);
+  ring->myTail.store(tail + need, std::memory_order_release);
+  return true;
+}
+
+/**
+   Messages from different threads are written in the order they were
+   logged in, by merging the rings on the sequence numbers.  Rings of
+   threads that have exited are deleted once they are empty.
+
+   @return the number of messages written
+**/
+MVREXPORT size_t MvrLog::asyncDrainNoLock(void)
+{
+  MvrLogAsyncRing *rings[ASYNC_MAX_THREADS];
+  size_t tails[ASYNC_MAX_THREADS];
+  unsigned long long seqs[ASYNC_MAX_THREADS];
+  char buf[ASYNC_MAX_RECORD];
+  MvrLogAsyncRing *ring;
+  unsigned int len;
+  bool binary;
+  size_t head;
+  size_t tail;
+  size_t written = 0;
+  size_t dropped;
+  bool orphaned;
+  int num = 0;
+  int best;
+  int i;
+
+  for (i = 0; i < ASYNC_MAX_THREADS; i++)
+  {
+    if ((ring = ourAsyncRings[i].load()) == NULL)
+      continue;
+    // look at this before the tail, so if it is set everything the
+    // thread ever logged is already in the ring
+    orphaned = ring->myOrphaned.load();
+    tail = ring->myTail.load(std::memory_order_acquire);
+    head = ring->myHead.load(std::memory_order_relaxed);
+    if (head != tail)
+    {
+      rings[num] = ring;
+      tails[num] = tail;
+      ring->copyOut(head, &seqs[num], sizeof(seqs[num]));
+      num++;
+    }
+    else if (orphaned)
+    {
+      ourAsyncRings[i].store(NULL);
+      delete ring;
+    }
+  }
+
+  while (num > 0)
+  {
+    best = 0;
+    for (i = 1; i < num; i++)
+      if (seqs[i] < seqs[best])
+	best = i;
+    ring = rings[best];
+    head = ring->myHead.load(std::memory_order_relaxed);
+    ring->copyOut(head + sizeof(unsigned long long), &len, sizeof(len));
+    binary = (len & ASYNC_BINARY_RECORD) != 0;
+    len &= ~ASYNC_BINARY_RECORD;
+    ring->copyOut(head + MvrLogAsyncRing::HEADER_SIZE, buf, len);
+    buf[len] = '\0';
+    head += MvrLogAsyncRing::HEADER_SIZE + len;
+    // it's copied out, so the logging thread can have the space back
+    ring->myHead.store(head, std::memory_order_release);
+    if (binary)
+      MvrBinaryLog::writeNoLock(buf, len);
+    else
+      asyncWriteNoLock(buf, len);
+    written++;
+    if (head == tails[best])
+    {
+      num--;
+      rings[best] = rings[num];
+      tails[best] = tails[num];
+      seqs[best] = seqs[num];
+    }
+    else
+      ring->copyOut(head, &seqs[best], sizeof(seqs[best]));
+  }
+
+  dropped = ourAsyncDropped.load();
+  if (dropped != ourAsyncDroppedReported)
+  {
+    if (ourAsyncOverflowPolicy.load() == AsyncCount)
+    {
+      snprintf(buf, sizeof(buf),
+	       "MvrLog: %lu log messages were dropped because a thread's log buffer was full",
+	       (unsigned long)(dropped - ourAsyncDroppedReported));
+      asyncWriteNoLock(buf, strlen(buf));
+      written++;
+    }
+    ourAsyncDroppedReported = dropped;
+  }
+
+  // one flush for the whole batch, instead of one per message
+  if (written > 0)
+  {
+    if (ourFP)
+      fflush(ourFP);
+    else if (ourType != None && ourType != Colbert)
+      fflush(stdout);
+    if (ourAlsoPrint)
+      fflush(stdout);
+    MvrBinaryLog::flushNoLock();
+    checkFileSize();
+  }
+  return written;
+}
+
+/// Does what log() does with a message, except flushing
+MVREXPORT void MvrLog::asyncWriteNoLock(const char *buf, size_t len)
+{
+  if (ourType == Colbert)
+  {
+    if (colbertPrint)		// check if we have a print routine
+      (*colbertPrint)(ourColbertStream, buf);
+  }
+  else if (ourFP)
+  {
+    if (fwrite(buf, 1, len, ourFP) == len && fputc('\n', ourFP) != EOF)
+      ourCharsLogged += len + 1;
+  }
+  else if (ourType != None)
+    printf("%s\n", buf);
+  if (ourAlsoPrint)
+    printf("%s\n", buf);
+
+  invokeFunctor(buf);
+
+#ifndef MVRINTERFACE
+  if (ourUseAramBehavior && ourFP && ourAramLogSize > 0 && 
+      ourCharsLogged > ourAramLogSize)
+  {
+    filledAramLog();
+  }
+#endif // MVRINTERFACE
+
+#ifdef HAVEATL
+  ATLTRACE2("%s\n", buf);
+#endif
+}
+
+MVREXPORT void *MvrLog::asyncWriterThread(void *arg)
+{
+  size_t written;
+
+  ourAsyncThreadRing.myIsWriter = true;
+  while (ourAsyncWriter->getRunning())
+  {
+    ourMutex.lock();
+    written = asyncDrainNoLock();
+    ourMutex.unlock();
+    // if there was something there's probably more coming, otherwise
+    // let it pile up a little
+    if (written == 0)
+      MvrUtil::sleep(10);
+  }
+  // logging goes back to whoever logs, then whatever is left is written
+  ourAsyncRunning.store(false);
+  flush();
+  ourAsyncWriterDone.store(true);
+  return NULL;
+}
@@ -1872,9 +1872,9 @@ MVREXPORT void MvrModeLaser::userTask(void)
       myState = STATE_UNINITED;
     }
     rawReadings = myLaser->getRawReadings();
-    int middleReading = rawReadings->size() / 2;
-    if (rawReadings->begin() != rawReadings->end())
+    if (rawReadings != NULL && rawReadings->begin() != rawReadings->end())
     {
+      int middleReading = rawReadings->size() / 2;
       int i;
       for (rawIt = rawReadings->begin(), i = 0; 
 	   rawIt != rawReadings->end(); 
@@ -10,14 +10,168 @@
 #include "MvrLog.h"
 #include "mvriaInternal.h"
 #include "MvrFunctor.h"
+#include "MvrFunctorASyncTask.h"
 
 #include <sys/types.h>
 #include <unistd.h>     // for getpid()
+#include <atomic>
+#include <map>
+#include <vector>
+#include <algorithm>
 
 
 unsigned int MvrMutex::ourLockWarningMS = 0;
 unsigned int MvrMutex::ourUnlockWarningMS = 0;
 MvrFunctor *MvrMutex::ourNonRecursiveDeadlockFunctor = NULL;
+std::atomic<bool> MvrMutex::ourProfiling(false);
+
+/// What the profiler knows about the mutexes with one name (internal to MvrMutex)
+/**
+   The counts are added to by whoever locks the mutexes, the waiters
+   (which threads waited the longest) are only kept for the few threads
+   that waited the most, found with the space saving algorithm: once
+   the table is full a new thread replaces the one with the least time
+   and starts from its time, so the time shown for a thread can be more
+   than it really waited but never less.
+**/
+class MvrMutexProfile
+{
+public:
+  enum { NUM_WAITERS = 8 };
+  MvrMutexProfile(const char *name) : myName(name)
+    { pthread_mutex_init(&myWaitersMutex, NULL); reset(); }
+  void reset(void)
+    {
+      int i;
+      myNumLocks.store(0);
+      myNumContended.store(0);
+      myWaitUSec.store(0);
+      myMaxWaitUSec.store(0);
+      myHoldUSec.store(0);
+      myMaxHoldUSec.store(0);
+      pthread_mutex_lock(&myWaitersMutex);
+      for (i = 0; i < NUM_WAITERS; i++)
+      {
+	myWaiterNames[i] = "";
+	myWaiterUSec[i] = 0;
+	myWaiterCount[i] = 0;
+      }
+      pthread_mutex_unlock(&myWaitersMutex);
+    }
+  static void updateMax(std::atomic<unsigned long long> *max, 
+			unsigned long long val)
+    {
+      unsigned long long old = max->load(std::memory_order_relaxed);
+      while (val > old && 
+	     !max->compare_exchange_weak(old, val, std::memory_order_relaxed))
+	;
+    }
+  void addWait(const char *threadName, unsigned long long uSec)
+    {
+      int i;
+      int min = 0;
+
+      myNumContended.fetch_add(1, std::memory_order_relaxed);
+      myWaitUSec.fetch_add(uSec, std::memory_order_relaxed);
+      updateMax(&myMaxWaitUSec, uSec);
+      pthread_mutex_lock(&myWaitersMutex);
+      for (i = 0; i < NUM_WAITERS; i++)
+      {
+	if (myWaiterNames[i] == threadName)
+	  break;
+	if (myWaiterUSec[i] < myWaiterUSec[min])
+	  min = i;
+      }
+      if (i == NUM_WAITERS)
+      {
+	i = min;
+	myWaiterNames[i] = threadName;
+      }
+      myWaiterUSec[i] += uSec;
+      myWaiterCount[i]++;
+      pthread_mutex_unlock(&myWaitersMutex);
+    }
+  void addHold(unsigned long long uSec)
+    {
+      myHoldUSec.fetch_add(uSec, std::memory_order_relaxed);
+      updateMax(&myMaxHoldUSec, uSec);
+    }
+  std::string getReport(void)
+    {
+      char buf[1024];
+      std::string ret;
+      std::vector<std::pair<unsigned long long, int> > waiters;
+      unsigned long long numLocks = myNumLocks.load();
+      unsigned long long numContended = myNumContended.load();
+      int i;
+
+      snprintf(buf, sizeof(buf), 
+	       "%s: %llu locks, %llu contended (%.1f%%), waited %.3f ms (max %.3f), held %.3f ms (max %.3f)",
+	       myName.c_str(), numLocks, numContended, 
+	       numLocks > 0 ? 100.0 * numContended / numLocks : 0.0,
+	       myWaitUSec.load() / 1000.0, myMaxWaitUSec.load() / 1000.0,
+	       myHoldUSec.load() / 1000.0, myMaxHoldUSec.load() / 1000.0);
+      ret = buf;
+      pthread_mutex_lock(&myWaitersMutex);
+      for (i = 0; i < NUM_WAITERS; i++)
+	if (myWaiterCount[i] > 0)
+	  waiters.push_back(std::pair<unsigned long long, int>(
+				    myWaiterUSec[i], i));
+      std::sort(waiters.rbegin(), waiters.rend());
+      for (i = 0; i < (int)waiters.size(); i++)
+      {
+	snprintf(buf, sizeof(buf), "%s %s %.3f ms (%llu)", 
+		 i == 0 ? ", waiters:" : ",",
+		 myWaiterNames[waiters[i].second].c_str(), 
+		 waiters[i].first / 1000.0, 
+		 myWaiterCount[waiters[i].second]);
+	ret += buf;
+      }
+      pthread_mutex_unlock(&myWaitersMutex);
+      return ret;
+    }
+
+  std::string myName;
+  std::atomic<unsigned long long> myNumLocks;
+  std::atomic<unsigned long long> myNumContended;
+  std::atomic<unsigned long long> myWaitUSec;
+  std::atomic<unsigned long long> myMaxWaitUSec;
+  std::atomic<unsigned long long> myHoldUSec;
+  std::atomic<unsigned long long> myMaxHoldUSec;
+  // a plain pthread mutex, since this can't profile itself
+  pthread_mutex_t myWaitersMutex;
+  std::string myWaiterNames[NUM_WAITERS];
+  unsigned long long myWaiterUSec[NUM_WAITERS];
+  unsigned long long myWaiterCount[NUM_WAITERS];
+};
+
+// the profiles by name, they're never deleted since mutexes keep pointers
+static pthread_mutex_t ourProfilesMutex = PTHREAD_MUTEX_INITIALIZER;
+static std::map<std::string, MvrMutexProfile *> ourProfiles;
+// the name of this thread for the profiler, looked up before waiting
+// on a lock since looking it up locks the thread list
+static thread_local std::string ourProfileThreadName;
+static unsigned int ourProfileDumpMS = 0;
+static MvrFunctorASyncTask *ourProfileDumper = NULL;
+
+static void *profileDumperThread(void *arg)
+{
+  MvrTime lastDump;
+  while (ourProfileDumper != NULL && ourProfileDumper->getRunning())
+  {
+    MvrUtil::sleep(100);
+    if (ourProfileDumpMS > 0 && MvrMutex::getProfiling() && 
+	lastDump.mSecSince() >= (long)ourProfileDumpMS)
+    {
+      MvrMutex::logProfile();
+      lastDump.setToNow();
+    }
+  }
+  return NULL;
+}
+
+static MvrGlobalRetFunctor1<void *, void *> ourProfileDumperCB(
+	&profileDumperThread);
 
 
 
@@ -125,7 +279,11 @@ int MvrMutex::lock()
     }
 
     int ret;
-    if ((ret = pthread_mutex_lock(&myMutex)) != 0)
+    if (ourProfiling)
+        ret = profiledLock();
+    else
+        ret = pthread_mutex_lock(&myMutex);
+    if (ret != 0)
     {
         if (ret == EDEADLK)
         {
@@ -143,6 +301,15 @@ int MvrMutex::lock()
         }
     }
 
+    if (ourProfiling)
+    {
+        if (myProfile == NULL)
+            myProfile = getProfile();
+        myProfile->myNumLocks.fetch_add(1, std::memory_order_relaxed);
+        if (myProfileDepth++ == 0)
+            myProfileLockedUSec = MvrUtil::getTimeUSec();
+    }
+
     if (myNonRecursive)
     {
         if (myWasAlreadyLocked)
@@ -222,6 +389,15 @@ int MvrMutex::tryLock()
         }
     }
 
+    if (ourProfiling)
+    {
+        if (myProfile == NULL)
+            myProfile = getProfile();
+        myProfile->myNumLocks.fetch_add(1, std::memory_order_relaxed);
+        if (myProfileDepth++ == 0)
+            myProfileLockedUSec = MvrUtil::getTimeUSec();
+    }
+
     if (myNonRecursive)
     {
         if (myWasAlreadyLocked)
@@ -275,6 +451,11 @@ int MvrMutex::unlock()
 
     if(ourUnlockWarningMS > 0) checkUnlockTime();
 
+    // this is checked even if profiling was just turned off, so the
+    // depth gets back to 0
+    if (myProfileDepth > 0 && --myProfileDepth == 0 && myProfile != NULL)
+        myProfile->addHold(MvrUtil::getTimeUSec() - myProfileLockedUSec);
+
     if (myFailedInit)
     {
         MvrLog::logNoLock(MvrLog::Terse, "MvrMutex::unlock: Initialization of mutex '%s' from thread '%s' %d pid %d failed, failed unlock",
@@ -327,6 +508,9 @@ MVREXPORT void MvrMutex::setLogNameVar(const char *logName, ...)
 
 void MvrMutex::initLockTiming()
 {
+  myProfile = NULL;
+  myProfileDepth = 0;
+  myProfileLockedUSec = 0;
   myFirstLock = true;
   myLockTime = new MvrTime;
   myLockStarted = new MvrTime;
@@ -391,3 +575,136 @@ void MvrMutex::checkUnlockTime() {
 #endif
 		    myLockTime->mSecSince() / 1000.0);
 }
+
+MvrMutexProfile *MvrMutex::getProfile(void)
+{
+  std::map<std::string, MvrMutexProfile *>::iterator it;
+  MvrMutexProfile *profile;
+
+  pthread_mutex_lock(&ourProfilesMutex);
+  if ((it = ourProfiles.find(myLogName)) != ourProfiles.end())
+    profile = (*it).second;
+  else
+  {
+    profile = new MvrMutexProfile(myLogName.c_str());
+    ourProfiles[myLogName] = profile;
+  }
+  pthread_mutex_unlock(&ourProfilesMutex);
+  return profile;
+}
+
+/**
+   Tries the lock first, and only if someone else has it gets the time
+   and waits for it, so that locks nobody else has cost about the same
+   as when not profiling.
+**/
+int MvrMutex::profiledLock(void)
+{
+  int ret;
+  unsigned long long start;
+  unsigned long long waited;
+
+  if ((ret = pthread_mutex_trylock(&myMutex)) != EBUSY)
+    return ret;
+  if (ourProfileThreadName.empty())
+  {
+    // looking the name up locks the thread list mutex, which comes back
+    // through here if it's contended, so put something in first so
+    // that doesn't look it up again (and again...)
+    ourProfileThreadName = "?";
+    ourProfileThreadName = MvrThread::getThisThreadName();
+  }
+  start = MvrUtil::getTimeUSec();
+  if ((ret = pthread_mutex_lock(&myMutex)) != 0)
+    return ret;
+  waited = MvrUtil::getTimeUSec() - start;
+  // we have the lock now, so we can set myProfile
+  if (myProfile == NULL)
+    myProfile = getProfile();
+  myProfile->addWait(ourProfileThreadName.c_str(), waited);
+  return 0;
+}
+
+/**
+   Profiling keeps track of (for all the mutexes with the same log
+   name together): how many times they were locked (by lock() or
+   tryLock(), including recursive locks), how many times lock() had to
+   wait for another thread, how long it waited in total and at most,
+   how long they were held (from the first lock to the matching unlock)
+   in total and at most, and which threads waited the longest.  Locks
+   that don't have to wait only cost a couple of clock reads more.
+
+   Note that mutexes used with MvrCondition (or pthread_cond_wait) are
+   held while waiting on the condition as far as this can tell.
+
+   @linuxonly
+**/
+MVREXPORT void MvrMutex::setProfiling(bool profiling)
+{
+  ourProfiling = profiling;
+}
+
+MVREXPORT void MvrMutex::resetProfile(void)
+{
+  std::map<std::string, MvrMutexProfile *>::iterator it;
+
+  pthread_mutex_lock(&ourProfilesMutex);
+  for (it = ourProfiles.begin(); it != ourProfiles.end(); ++it)
+    (*it).second->reset();
+  pthread_mutex_unlock(&ourProfilesMutex);
+}
+
+/**
+   @param lines where to put the lines, one for each mutex name
+   that has been profiled, sorted by how long threads have waited for
+   them in total
+
+   @param maxMutexes the most lines to put in, 0 for all of them
+**/
+MVREXPORT void MvrMutex::getProfileReport(std::list<std::string> *lines,
+					  int maxMutexes)
+{
+  std::map<std::string, MvrMutexProfile *>::iterator it;
+  std::vector<std::pair<unsigned long long, MvrMutexProfile *> > profiles;
+  size_t i;
+
+  pthread_mutex_lock(&ourProfilesMutex);
+  for (it = ourProfiles.begin(); it != ourProfiles.end(); ++it)
+    profiles.push_back(std::pair<unsigned long long, MvrMutexProfile *>(
+			       (*it).second->myWaitUSec.load(), (*it).second));
+  pthread_mutex_unlock(&ourProfilesMutex);
+  std::stable_sort(profiles.rbegin(), profiles.rend());
+  for (i = 0; i < profiles.size(); i++)
+  {
+    if (maxMutexes > 0 && (int)i >= maxMutexes)
+      break;
+    lines->push_back(profiles[i].second->getReport());
+  }
+}
+
+MVREXPORT void MvrMutex::logProfile(int maxMutexes)
+{
+  std::list<std::string> lines;
+  std::list<std::string>::iterator it;
+
+  getProfileReport(&lines, maxMutexes);
+  MvrLog::log(MvrLog::Normal, "Mutex profile (%lu mutexes):", 
+	      (unsigned long)lines.size());
+  for (it = lines.begin(); it != lines.end(); it++)
+    MvrLog::log(MvrLog::Normal, "\t%s", (*it).c_str());
+}
+
+/**
+   The report is logged by a thread of its own, and only while
+   profiling is on.
+**/
+MVREXPORT void MvrMutex::setProfileDumpInterval(unsigned int ms)
+{
+  ourProfileDumpMS = ms;
+  if (ms > 0 && ourProfileDumper == NULL)
+  {
+    ourProfileDumper = new MvrFunctorASyncTask(&ourProfileDumperCB);
+    ourProfileDumper->setThreadName("MvrMutexProfileDumper");
+    ourProfileDumper->create(false, true);
+  }
+}
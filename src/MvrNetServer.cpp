@@ -8,6 +8,10 @@
 #include "MvrSyncTask.h"
 #include "MvrArgumentBuilder.h"
 #include "mvriaInternal.h"
+#include <algorithm>
+#ifdef __linux__
+#include <sys/epoll.h>
+#endif
 
 
 MvrNetServer::MvrNetServer(bool addMvrExitCB, bool doNotAddShutdownServer,
@@ -17,6 +21,7 @@ MvrNetServer::MvrNetServer(bool addMvrExitCB, bool doNotAddShutdownServer,
   myEchoCB(this, &MvrNetServer::internalEcho),
   myQuitCB(this, &MvrNetServer::internalQuit),
   myShutdownServerCB(this, &MvrNetServer::internalShutdownServer),
+  myTaskLatenciesCB(this, &MvrNetServer::internalTaskLatencies),
   myMvrExitCB(this, &MvrNetServer::close)
 {
   if (name != NULL)
@@ -33,9 +38,14 @@ MvrNetServer::MvrNetServer(bool addMvrExitCB, bool doNotAddShutdownServer,
   myLoggingDataSent = false;
   myLoggingDataReceived = false;
   mySquelchNormal = false;
+  myUseEpoll = false;
+  myMaxClientOutputQueue = 256 * 1024;
+  myEpollFD = -1;
   addCommand("help", &myHelpCB, "gives the listing of available commands");
   addCommand("echo", &myEchoCB, "with no args gets echo, with args sets echo");
   addCommand("quit", &myQuitCB, "closes this connection to the server");
+  addCommand("taskLatencies", &myTaskLatenciesCB, 
+	     "shows how long the robot's tasks take to run, 'reset' resets them, a number shows that many recent times");
   // MPL 2013_06_10 letting folks take out shutdownServer since it
   // can do no good and much ill
   if (!doNotAddShutdownServer)
@@ -125,6 +135,32 @@ MVREXPORT bool MvrNetServer::open(MvrRobot *robot, unsigned int port,
     return false;
   }
 
+  if (myUseEpoll)
+  {
+#ifdef __linux__
+    struct epoll_event event;
+    event.events = EPOLLIN;
+    event.data.ptr = &myServerSocket;
+    if ((myEpollFD = epoll_create1(EPOLL_CLOEXEC)) < 0 ||
+	epoll_ctl(myEpollFD, EPOLL_CTL_ADD, myServerSocket.getFD(), 
+		  &event) != 0)
+    {
+      MvrLog::logErrorFromOS(MvrLog::Terse, 
+			     "%s could not set up epoll, reading every client every cycle instead", 
+			     myName.c_str());
+      if (myEpollFD >= 0)
+	::close(myEpollFD);
+      myEpollFD = -1;
+      myUseEpoll = false;
+    }
+#else
+    MvrLog::log(MvrLog::Terse, 
+	       "%s: epoll is only on linux, reading every client every cycle instead", 
+	       myName.c_str());
+    myUseEpoll = false;
+#endif
+  }
+
   // add ourselves to the robot if we aren't already there
   if (myRobot != NULL && (rootTask = myRobot->getSyncTaskRoot()) != NULL)
   {    
@@ -349,6 +385,137 @@ MVREXPORT bool MvrNetServer::getUseWrongEndChars(void)
   return myUseWrongEndChars;
 }
 
+/**
+   This has to be called before open().
+
+   @param useEpoll if true the server uses epoll to find the clients
+   that have sent something and queues what is written to the clients
+   instead of ever waiting on them (see the class description)
+**/
+MVREXPORT void MvrNetServer::setUseEpoll(bool useEpoll)
+{
+  if (myOpened)
+  {
+    MvrLog::log(MvrLog::Normal, 
+	       "%s::setUseEpoll: Already open, this has to be set before open", 
+	       myName.c_str());
+    return;
+  }
+  myUseEpoll = useEpoll;
+}
+
+MVREXPORT bool MvrNetServer::getUseEpoll(void)
+{
+  return myUseEpoll;
+}
+
+/**
+   @param maxBytes how many bytes of output can be waiting to go out to
+   a client before it is disconnected for not keeping up (only used
+   with setUseEpoll())
+**/
+MVREXPORT void MvrNetServer::setMaxClientOutputQueue(size_t maxBytes)
+{
+  std::list<MvrSocket *>::iterator it;
+
+  myMaxClientOutputQueue = maxBytes;
+  if (!myUseEpoll)
+    return;
+  for (it = myConnectingConns.begin(); it != myConnectingConns.end(); ++it)
+    (*it)->setWriteQueueLimit(maxBytes);
+  for (it = myConns.begin(); it != myConns.end(); ++it)
+    (*it)->setWriteQueueLimit(maxBytes);
+}
+
+MVREXPORT size_t MvrNetServer::getMaxClientOutputQueue(void)
+{
+  return myMaxClientOutputQueue;
+}
+
+/**
+   The socket gets its writes queued and epoll starts watching it, it
+   also counts as ready this cycle so that anything it already sent
+   gets read like it would without epoll.
+**/
+void MvrNetServer::epollAdd(MvrSocket *socket)
+{
+  socket->setWriteQueueLimit(myMaxClientOutputQueue);
+#ifdef __linux__
+  struct epoll_event event;
+  event.events = EPOLLIN;
+  event.data.ptr = socket;
+  if (socket->getFD() >= 0 &&
+      epoll_ctl(myEpollFD, EPOLL_CTL_ADD, socket->getFD(), &event) != 0)
+    MvrLog::logErrorFromOS(MvrLog::Normal, 
+			   "%s: Could not add %s to epoll", myName.c_str(), 
+			   socket->getIPString());
+#endif
+  myReadySockets.insert(std::lower_bound(myReadySockets.begin(), 
+					 myReadySockets.end(), socket),
+			socket);
+}
+
+void MvrNetServer::epollRemove(MvrSocket *socket)
+{
+#ifdef __linux__
+  // closing the socket takes it out of epoll too, this is for the
+  // ones still open
+  if (socket->getFD() >= 0)
+    epoll_ctl(myEpollFD, EPOLL_CTL_DEL, socket->getFD(), NULL);
+#endif
+}
+
+bool MvrNetServer::epollWait(void)
+{
+  bool acceptReady = false;
+
+  myReadySockets.clear();
+#ifdef __linux__
+  struct epoll_event events[64];
+  int num;
+  int i;
+  // anything past the first 64 is still there next cycle
+  num = epoll_wait(myEpollFD, events, 64, 0);
+  for (i = 0; i < num; i++)
+  {
+    if (events[i].data.ptr == &myServerSocket)
+      acceptReady = true;
+    else
+      myReadySockets.push_back((MvrSocket *)events[i].data.ptr);
+  }
+  std::sort(myReadySockets.begin(), myReadySockets.end());
+#endif
+  return acceptReady;
+}
+
+bool MvrNetServer::isReady(MvrSocket *socket)
+{
+  return std::binary_search(myReadySockets.begin(), myReadySockets.end(), 
+			    socket);
+}
+
+void MvrNetServer::flushClients(void)
+{
+  std::list<MvrSocket *>::iterator it;
+  MvrSocket *socket;
+
+  for (it = myConnectingConns.begin(); it != myConnectingConns.end(); ++it)
+    (*it)->flushWriteQueue();
+  for (it = myConns.begin(); it != myConns.end(); ++it)
+  {
+    socket = (*it);
+    socket->flushWriteQueue();
+    if (socket->getWriteQueueOverflowed())
+    {
+      MvrLog::log(MvrLog::Normal, 
+		 "%s: Client from %s fell more than %lu bytes behind on output and is being disconnected.",
+		 myName.c_str(), socket->getIPString(), 
+		 (unsigned long)myMaxClientOutputQueue);
+      myDeleteList.push_front(socket);
+    }
+  }
+}
+
 MVREXPORT void MvrNetServer::runOnce(void)
 {
 
@@ -359,6 +526,7 @@ MVREXPORT void MvrNetServer::runOnce(void)
   std::list<MvrSocket *>::iterator it;
   MvrArgumentBuilder *args = NULL;
   std::string command;
+  bool acceptReady = true;
 
   if (!myOpened)
   {
@@ -378,8 +546,11 @@ MVREXPORT void MvrNetServer::runOnce(void)
 
 
   lock();
+  // with epoll only the sockets that have something get looked at
+  if (myUseEpoll)
+    acceptReady = epollWait();
   // get any new sockets that want to connect
-  while (myServerSocket.accept(&myAcceptingSocket) &&
+  while (acceptReady && myServerSocket.accept(&myAcceptingSocket) &&
 	 myAcceptingSocket.getFD() >= 0)
   {
     //myAcceptingSocket.setNonBlock();
@@ -404,6 +575,8 @@ MVREXPORT void MvrNetServer::runOnce(void)
       socket->transfer(&myAcceptingSocket);
       socket->setIPString((myName + "::" + socket->getIPString()).c_str());
       socket->setNonBlock();
+      if (myUseEpoll)
+	epollAdd(socket);
       if (!myPassword.empty())
       {
 	socket->writeString("Enter password:");
@@ -428,6 +601,8 @@ MVREXPORT void MvrNetServer::runOnce(void)
   for (it = myConnectingConns.begin(); it != myConnectingConns.end(); ++it)
   {
     socket = (*it);
+    if (myUseEpoll && !isReady(socket))
+      continue;
     // read in what the client has to say
     if ((str = socket->readString()) != NULL)
     {
@@ -500,6 +675,8 @@ MVREXPORT void MvrNetServer::runOnce(void)
   for (it = myConns.begin(); it != myConns.end() && myOpened; ++it)
   {
     socket = (*it);
+    if (myUseEpoll && !isReady(socket))
+      continue;
 
     // read in what the client has to say
     while ((str = socket->readString()) != NULL)
@@ -528,6 +705,11 @@ MVREXPORT void MvrNetServer::runOnce(void)
     }
   }
 
+  // send out what's been queued up and throw out anyone that's too
+  // far behind
+  if (myUseEpoll)
+    flushClients();
+
   // now we delete the ones we want to delete (we could do this above
   // but then it wouldn't be symetrical with above)
   while ((it = myDeleteList.begin()) != myDeleteList.end())
@@ -539,6 +721,12 @@ MVREXPORT void MvrNetServer::runOnce(void)
     // the same in the list if it lost connection exactly when it
     // parsed the quit
     myDeleteList.remove(socket);
+    if (myUseEpoll)
+    {
+      // try to get the last things (like the quit message) out
+      socket->flushWriteQueue();
+      epollRemove(socket);
+    }
     socket->close();
     delete socket;
   }
@@ -570,6 +758,7 @@ MVREXPORT void MvrNetServer::close(void)
   {
     socket = (*it);
     myConnectingConns.pop_front();
+    socket->flushWriteQueue();
     socket->close();
     delete socket;
   }
@@ -577,10 +766,17 @@ MVREXPORT void MvrNetServer::close(void)
   {
     socket = (*it);
     myConns.pop_front();
+    socket->flushWriteQueue();
     socket->close();
     delete socket;
   }
   myServerSocket.close();
+  if (myEpollFD >= 0)
+  {
+    ::close(myEpollFD);
+    myEpollFD = -1;
+  }
+  myReadySockets.clear();
 }
 
 MVREXPORT void MvrNetServer::internalGreeting(MvrSocket *socket)
@@ -658,6 +854,43 @@ MVREXPORT void MvrNetServer::internalShutdownServer(char **argv, int argc,
   
 }
 
+MVREXPORT void MvrNetServer::internalTaskLatencies(char **argv, int argc, 
+						    MvrSocket *socket)
+{
+  MvrSyncTask *rootTask;
+  std::list<std::string> lines;
+  std::list<std::string>::iterator it;
+  int numRecent = 0;
+
+  if (myRobot == NULL || (rootTask = myRobot->getSyncTaskRoot()) == NULL)
+  {
+    socket->writeString("There is no robot to get task latencies from.");
+    return;
+  }
+  if (argc == 2 && strcasecmp(argv[1], "reset") == 0)
+  {
+    rootTask->resetLatencies();
+    myRobot->resetCycleTimingStats();
+    socket->writeString("Task latencies reset.");
+    return;
+  }
+  if (argc == 2)
+    numRecent = atoi(argv[1]);
+  if (argc > 2 || numRecent < 0)
+  {
+    socket->writeString("usage: taskLatencies <reset/numRecent>");
+    return;
+  }
+  rootTask->getLatencies(&lines, 0, numRecent);
+  socket->writeString("Task latencies:");
+  for (it = lines.begin(); it != lines.end(); it++)
+    socket->writeString("%s", (*it).c_str());
+  socket->writeString("Cycle jitter (%llu missed deadlines): %s", 
+		      myRobot->getCycleNumMissedDeadlines(),
+		      myRobot->getCycleJitter()->getSummary(numRecent).c_str());
+  socket->writeString("End of task latencies");
+}
+
 MVREXPORT void MvrNetServer::parseCommandOnSocket(MvrArgumentBuilder *args, 
 						MvrSocket *socket, bool allowLog)
 {
@@ -694,6 +927,8 @@ MVREXPORT void MvrNetServer::internalAddSocketToList(MvrSocket *socket)
   {
     socket->setNonBlock();
     socket->setStringUseWrongEndChars(myUseWrongEndChars);
+    if (myUseEpoll)
+      epollAdd(socket);
   }
   myConns.push_front(socket);
 }
@@ -0,0 +1,376 @@
+#include "MvrExport.h"
+#include "mvriaOSDef.h"
+#include "MvrObstacleSnapshot.h"
+#include "MvrRangeDevice.h"
+#include "MvrTransform.h"
+#include <algorithm>
+
+MVREXPORT MvrObstacleSnapshot::MvrObstacleSnapshot()
+{
+  myMutex.setLogName("MvrObstacleSnapshot::myMutex");
+  myValid = false;
+  myCounter = 0;
+}
+
+MVREXPORT MvrObstacleSnapshot::~MvrObstacleSnapshot()
+{
+}
+
+/**
+   @param devices the devices to take the current readings of
+   @param robotPose the pose of the robot the readings are relative to
+   @param counter the robot cycle counter this snapshot is for
+**/
+MVREXPORT void MvrObstacleSnapshot::build(
+	const std::list<MvrRangeDevice *> *devices, MvrPose robotPose,
+	unsigned int counter)
+{
+  std::list<MvrRangeDevice *>::const_iterator it;
+  MvrRangeDevice *device;
+  const MvrRangeBufferStorage *storage;
+  DeviceData *data;
+  size_t i;
+  size_t num = 0;
+
+  // resize rather than clear so the vectors keep their memory
+  myDevices.resize(devices->size());
+  for (it = devices->begin(); it != devices->end(); ++it, num++)
+  {
+    device = (*it);
+    data = &myDevices[num];
+    data->myDevice = device;
+
+    device->lockDevice();
+    data->myLocationDependent = device->isLocationDependent();
+    data->myMaxRange = device->getMaxRange();
+    storage = device->getCurrentRangeBuffer()->getStorage();
+    myPoints.resize(storage->size());
+    for (i = 0; i < storage->size(); i++)
+    {
+      myPoints[i].first = storage->getX(i);
+      myPoints[i].second = storage->getY(i);
+    }
+    device->unlockDevice();
+
+    buildDevice(data, robotPose);
+  }
+
+  myRobotPose = robotPose;
+  myCounter = counter;
+  myValid = true;
+}
+
+void MvrObstacleSnapshot::buildDevice(DeviceData *data, MvrPose robotPose)
+{
+  size_t num = myPoints.size();
+  size_t i;
+  size_t k;
+  size_t len;
+  unsigned int a, b;
+  double robotX = robotPose.getX();
+  double robotY = robotPose.getY();
+  double robotTh = robotPose.getTh();
+
+  // the polar part, these are figured the same way as
+  // MvrRangeBuffer::getClosestPolarInStorage does
+  mySortPairs.resize(num);
+  for (i = 0; i < num; i++)
+  {
+    mySortPairs[i].first = MvrMath::subAngle(
+	    MvrMath::atan2(myPoints[i].second - robotY,
+			   myPoints[i].first - robotX), robotTh);
+    mySortPairs[i].second = MvrMath::distanceBetween(
+	    robotX, robotY, myPoints[i].first, myPoints[i].second);
+  }
+  std::sort(mySortPairs.begin(), mySortPairs.end());
+  data->myAngles.resize(num);
+  data->myDists.resize(num);
+  for (i = 0; i < num; i++)
+  {
+    data->myAngles[i] = mySortPairs[i].first;
+    data->myDists[i] = mySortPairs[i].second;
+  }
+
+  // table of range minimums, each level covers twice the last
+  k = 0;
+  for (len = 1; len <= num; len *= 2)
+    k++;
+  data->myMinTable.resize(k);
+  if (k > 0)
+  {
+    data->myMinTable[0].resize(num);
+    for (i = 0; i < num; i++)
+      data->myMinTable[0][i] = i;
+  }
+  for (k = 1, len = 2; len <= num; k++, len *= 2)
+  {
+    data->myMinTable[k].resize(num - len + 1);
+    for (i = 0; i + len <= num; i++)
+    {
+      a = data->myMinTable[k - 1][i];
+      b = data->myMinTable[k - 1][i + len / 2];
+      if (data->myDists[b] < data->myDists[a])
+	data->myMinTable[k][i] = b;
+      else
+	data->myMinTable[k][i] = a;
+    }
+  }
+
+  // the box part, these are figured the same way as
+  // MvrRangeBuffer::getClosestBoxInStorage does
+  MvrTransform trans;
+  MvrPose zeroPos(0, 0, 0);
+  MvrPose pose;
+  trans.setTransform(robotPose, zeroPos);
+  for (i = 0; i < num; i++)
+  {
+    pose = trans.doTransform(MvrPose(myPoints[i].first, myPoints[i].second));
+    mySortPairs[i].first = pose.getX();
+    mySortPairs[i].second = pose.getY();
+  }
+  data->myBoxTh = trans.doTransform(MvrPose(0, 0, 0)).getTh();
+  std::sort(mySortPairs.begin(), mySortPairs.end());
+  data->myBoxX.resize(num);
+  data->myBoxY.resize(num);
+  for (i = 0; i < num; i++)
+  {
+    data->myBoxX[i] = mySortPairs[i].first;
+    data->myBoxY[i] = mySortPairs[i].second;
+  }
+}
+
+unsigned int MvrObstacleSnapshot::rangeMin(const DeviceData *data,
+					   size_t first, size_t last) const
+{
+  size_t k = 0;
+  size_t len = 1;
+  unsigned int a, b;
+
+  while (len * 2 <= last - first)
+  {
+    len *= 2;
+    k++;
+  }
+  a = data->myMinTable[k][first];
+  b = data->myMinTable[k][last - len];
+  if (data->myDists[b] < data->myDists[a])
+    return b;
+  return a;
+}
+
+double MvrObstacleSnapshot::devicePolar(const DeviceData *data,
+					double startAngle, double endAngle,
+					double *angle) const
+{
+  size_t num = data->myAngles.size();
+  size_t ranges[2][2];
+  int numRanges = 0;
+  int r;
+  bool foundOne = false;
+  unsigned int best = 0;
+  unsigned int index;
+  std::vector<double>::const_iterator begin = data->myAngles.begin();
+  std::vector<double>::const_iterator end = data->myAngles.end();
+
+  startAngle = MvrMath::fixAngle(startAngle);
+  endAngle = MvrMath::fixAngle(endAngle);
+
+  // MvrMath::angleBetween is exclusive on both ends, and goes the
+  // long way around if the start is bigger than the end
+  if (startAngle < endAngle)
+  {
+    ranges[0][0] = std::upper_bound(begin, end, startAngle) - begin;
+    ranges[0][1] = std::lower_bound(begin, end, endAngle) - begin;
+    numRanges = 1;
+  }
+  else if (startAngle > endAngle)
+  {
+    ranges[0][0] = std::upper_bound(begin, end, startAngle) - begin;
+    ranges[0][1] = num;
+    ranges[1][0] = 0;
+    ranges[1][1] = std::lower_bound(begin, end, endAngle) - begin;
+    numRanges = 2;
+  }
+
+  for (r = 0; r < numRanges; r++)
+  {
+    if (ranges[r][0] >= ranges[r][1])
+      continue;
+    index = rangeMin(data, ranges[r][0], ranges[r][1]);
+    if (!foundOne || data->myDists[index] < data->myDists[best])
+    {
+      best = index;
+      foundOne = true;
+    }
+  }
+
+  if (!foundOne)
+    return data->myMaxRange;
+  if (angle != NULL)
+    *angle = data->myAngles[best];
+  if (data->myDists[best] > data->myMaxRange)
+    return data->myMaxRange;
+  else
+    return data->myDists[best];
+}
+
+double MvrObstacleSnapshot::deviceBox(const DeviceData *data,
+				      double x1, double y1,
+				      double x2, double y2,
+				      MvrPose *readingPos) const
+{
+  double closest = data->myMaxRange;
+  double dist;
+  MvrPose closestPos;
+  double temp;
+  size_t i;
+
+  if (x1 >= x2)
+  {
+    temp = x1;
+    x1 = x2;
+    x2 = temp;
+  }
+  if (y1 >= y2)
+  {
+    temp = y1;
+    y1 = y2;
+    y2 = temp;
+  }
+
+  // only the readings in the x span of the box can be in it
+  i = std::lower_bound(data->myBoxX.begin(), data->myBoxX.end(), x1) -
+    data->myBoxX.begin();
+  for (; i < data->myBoxX.size() && data->myBoxX[i] <= x2; i++)
+  {
+    if (data->myBoxY[i] < y1 || data->myBoxY[i] > y2)
+      continue;
+    dist = MvrMath::distanceBetween(data->myBoxX[i], data->myBoxY[i], 0, 0);
+    if (dist < closest)
+    {
+      closest = dist;
+      closestPos.setPose(data->myBoxX[i], data->myBoxY[i], data->myBoxTh);
+    }
+  }
+
+  if (readingPos != NULL)
+    *readingPos = closestPos;
+  if (closest > data->myMaxRange)
+    return data->myMaxRange;
+  else
+    return closest;
+}
+
+/**
+   The arguments and return are the same as
+   MvrRobot::checkRangeDevicesCurrentPolar().
+**/
+MVREXPORT double MvrObstacleSnapshot::checkCurrentPolar(
+	double startAngle, double endAngle, double *angle,
+	const MvrRangeDevice **rangeDevice,
+	bool useLocationDependentDevices) const
+{
+  double closest = 32000;
+  double closeAngle = 0, tempDist, tempAngle = 0;
+  std::vector<DeviceData>::const_iterator it;
+  bool foundOne = false;
+  const MvrRangeDevice *closestRangeDevice = NULL;
+
+  for (it = myDevices.begin(); it != myDevices.end(); ++it)
+  {
+    if (!useLocationDependentDevices && (*it).myLocationDependent)
+      continue;
+    tempDist = devicePolar(&(*it), startAngle, endAngle, &tempAngle);
+    if (!foundOne || tempDist < closest)
+    {
+      closest = tempDist;
+      closeAngle = tempAngle;
+      closestRangeDevice = (*it).myDevice;
+      foundOne = true;
+    }
+  }
+  if (!foundOne)
+    return -1;
+  if (angle != NULL)
+    *angle = closeAngle;
+  if (rangeDevice != NULL)
+    *rangeDevice = closestRangeDevice;
+  return closest;
+}
+
+/**
+   The arguments and return are the same as
+   MvrRobot::checkRangeDevicesCurrentBox().
+**/
+MVREXPORT double MvrObstacleSnapshot::checkCurrentBox(
+	double x1, double y1, double x2, double y2,
+	MvrPose *readingPos, const MvrRangeDevice **rangeDevice,
+	bool useLocationDependentDevices) const
+{
+  double closest = 32000;
+  double tempDist;
+  MvrPose closestPos, tempPos;
+  std::vector<DeviceData>::const_iterator it;
+  bool foundOne = false;
+  const MvrRangeDevice *closestRangeDevice = NULL;
+
+  for (it = myDevices.begin(); it != myDevices.end(); ++it)
+  {
+    if (!useLocationDependentDevices && (*it).myLocationDependent)
+      continue;
+    tempDist = deviceBox(&(*it), x1, y1, x2, y2, &tempPos);
+    if (!foundOne || tempDist < closest)
+    {
+      closest = tempDist;
+      closestPos = tempPos;
+      closestRangeDevice = (*it).myDevice;
+      foundOne = true;
+    }
+  }
+  if (!foundOne)
+    return -1;
+  if (readingPos != NULL)
+    *readingPos = closestPos;
+  if (rangeDevice != NULL)
+    *rangeDevice = closestRangeDevice;
+  return closest;
+}
+
+/**
+   The arguments are the same as
+   MvrRobot::checkRangeDevicesCurrentRegions().  The snapshot already
+   has the readings arranged for each kind of query, so this just
+   answers each region on its own.
+**/
+MVREXPORT void MvrObstacleSnapshot::checkCurrentRegions(
+	MvrRangeRegion *regions, size_t numRegions,
+	bool useLocationDependentDevices) const
+{
+  size_t r;
+  double dist;
+  double angle = 0;
+  MvrPose readingPos;
+  const MvrRangeDevice *rangeDevice;
+
+  for (r = 0; r < numRegions; r++)
+  {
+    rangeDevice = NULL;
+    if (regions[r].getType() == MvrRangeRegion::POLAR)
+    {
+      angle = 0;
+      dist = checkCurrentPolar(regions[r].getStartAngle(), 
+			       regions[r].getEndAngle(), &angle, 
+			       &rangeDevice, useLocationDependentDevices);
+      regions[r].setResult(dist, angle, MvrPose(), rangeDevice);
+    }
+    else
+    {
+      readingPos.setPose(0, 0, 0);
+      dist = checkCurrentBox(regions[r].getX1(), regions[r].getY1(),
+			     regions[r].getX2(), regions[r].getY2(),
+			     &readingPos, &rangeDevice, 
+			     useLocationDependentDevices);
+      regions[r].setResult(dist, 0, readingPos, rangeDevice);
+    }
+  }
+}
@@ -2,17 +2,24 @@
 #include "mvriaOSDef.h"
 #include "MvrRangeBuffer.h"
 #include "MvrLog.h"
+#include "MvrRangeBufferKernels.h"
+#include <math.h>
 
 /** @param size The size of the buffer, in number of readings */
-MVREXPORT MvrRangeBuffer::MvrRangeBuffer(int size)
+MVREXPORT MvrRangeBuffer::MvrRangeBuffer(int size) :
+  myStorage(size)
 {
   mySize = size;
+  myBufferViewGood = false;
+  myBufferViewChangeCount = 0;
+  myInvalidAny = false;
+  myRedoIndex = 0;
+  myNumRedone = 0;
+  myHitEnd = false;
 }
 
 MVREXPORT MvrRangeBuffer::~MvrRangeBuffer()
 {
-  MvrUtil::deleteSet(myBuffer.begin(), myBuffer.end());
-  MvrUtil::deleteSet(myInvalidBuffer.begin(), myInvalidBuffer.end());
 }
 
 MVREXPORT size_t MvrRangeBuffer::getSize(void) const
@@ -49,22 +56,8 @@ MVREXPORT void MvrRangeBuffer::setEncoderPoseTaken(MvrPose p)
 MVREXPORT void MvrRangeBuffer::setSize(size_t size) 
 {
   mySize = size;
-  // if its smaller then chop the lists down to size
-  while (myInvalidBuffer.size() + myBuffer.size() > mySize)
-  {
-    if ((myRevIterator = myInvalidBuffer.rbegin()) != myInvalidBuffer.rend())
-    {
-      myReading = (*myRevIterator);
-      myInvalidBuffer.pop_back();
-      delete myReading;
-    }
-    else if ((myRevIterator = myBuffer.rbegin()) != myBuffer.rend())
-    {
-      myReading = (*myRevIterator);
-      myBuffer.pop_back();
-      delete myReading;
-    }
-  }
+  // the storage keeps the newest readings if its smaller
+  myStorage.setCapacity(mySize);
 }
 
 /** 
@@ -74,10 +67,16 @@ MVREXPORT void MvrRangeBuffer::setSize(size_t size)
     any modification at all to the list unless you really know what you're 
     doing... and if you do you'd better lock the rangeDevice this came from
     so nothing messes with the list while you are doing so.
+
+    The list is a view of the readings that is rebuilt from the
+    storage (see getStorage()) whenever this is called after the
+    readings changed, so changes made to the poses in it are not kept
+    and it should not be held on to after the buffer changes.
     @return the list of positions this range buffer has
 */
 MVREXPORT const std::list<MvrPoseWithTime *> *MvrRangeBuffer::getBuffer(void) const
 { 
+  updateBufferView();
   return &myBuffer; 
 }
 
@@ -88,13 +87,45 @@ MVREXPORT const std::list<MvrPoseWithTime *> *MvrRangeBuffer::getBuffer(void) co
     any modification at all to the list unless you really know what you're 
     doing... and if you do you'd better lock the rangeDevice this came from
     so nothing messes with the list while you are doing so.
+
+    The list is a view of the readings that is rebuilt from the
+    storage (see getStorage()) whenever this is called after the
+    readings changed, so changes made to the poses in it are not kept
+    and it should not be held on to after the buffer changes.
     @return the list of positions this range buffer has
 */
 MVREXPORT std::list<MvrPoseWithTime *> *MvrRangeBuffer::getBuffer(void)
 { 
+  updateBufferView();
   return &myBuffer; 
 }
 
+void MvrRangeBuffer::updateBufferView(void) const
+{
+  if (myBufferViewGood && 
+      myBufferViewChangeCount == myStorage.getChangeCount())
+    return;
+
+  size_t i;
+  size_t num = myStorage.size();
+  std::list<MvrPoseWithTime *>::iterator it;
+
+  myBufferPoses.resize(num);
+  for (i = 0; i < num; i++)
+    myBufferPoses[i] = myStorage.getPoseWithTime(i);
+
+  // reuse the list nodes we have, then point them at the poses
+  while (myBuffer.size() > num)
+    myBuffer.pop_back();
+  while (myBuffer.size() < num)
+    myBuffer.push_back(NULL);
+  for (i = 0, it = myBuffer.begin(); it != myBuffer.end(); ++it, i++)
+    (*it) = &myBufferPoses[i];
+
+  myBufferViewChangeCount = myStorage.getChangeCount();
+  myBufferViewGood = true;
+}
+
 
 /**
    Gets the closest reading in a region defined by startAngle going to 
@@ -122,8 +153,8 @@ MVREXPORT double MvrRangeBuffer::getClosestPolar(double startAngle,
 					       unsigned int maxRange,
 					       double *angle) const
 {
-  return getClosestPolarInList(startAngle, endAngle, 
-			       startPos, maxRange, angle, &myBuffer);
+  return getClosestPolarInStorage(startAngle, endAngle, 
+				  startPos, maxRange, angle, &myStorage);
 }
 
 MVREXPORT double MvrRangeBuffer::getClosestPolarInList(
@@ -173,6 +204,68 @@ MVREXPORT double MvrRangeBuffer::getClosestPolarInList(
     return closest;  
 }
 
+/**
+   Same as getClosestPolarInList() but walks the contiguous arrays of
+   an MvrRangeBufferStorage.
+**/
+MVREXPORT double MvrRangeBuffer::getClosestPolarInStorage(
+	double startAngle, double endAngle, MvrPose startPos, 
+	unsigned int maxRange, double *angle, 
+	const MvrRangeBufferStorage *storage)
+{
+  double closest;
+  bool foundOne = false;
+  double closeX = 0;
+  double closeY = 0;
+  double bestDistSq = HUGE_VAL;
+  double span;
+  double startX = startPos.getX();
+  double startY = startPos.getY();
+  double startTh = startPos.getTh();
+  MvrRangeBufferStorage::Span spans[2];
+  int numSpans;
+  int s;
+  long best;
+
+  startAngle = MvrMath::fixAngle(startAngle);
+  endAngle = MvrMath::fixAngle(endAngle);
+  // MvrMath::angleBetween never matches when they're the same
+  if (startAngle == endAngle)
+    return maxRange;
+  span = endAngle - startAngle;
+  if (span < 0)
+    span += 360;
+
+  // the kernels check the sector with the directions of its edges and
+  // only compare squared distances, so we only need the one atan2 and
+  // sqrt for whatever is closest
+  numSpans = storage->getSpans(&spans[0], &spans[1]);
+  for (s = 0; s < numSpans; s++)
+  {
+    best = MvrRangeBufferKernels::closestInSector(
+	    spans[s].x, spans[s].y, spans[s].size, startX, startY,
+	    MvrMath::cos(startTh + startAngle), MvrMath::sin(startTh + startAngle),
+	    MvrMath::cos(startTh + endAngle), MvrMath::sin(startTh + endAngle),
+	    span > 180, &bestDistSq);
+    if (best >= 0)
+    {
+      closeX = spans[s].x[best];
+      closeY = spans[s].y[best];
+      foundOne = true;
+    }
+  }
+  if (!foundOne)
+    return maxRange;
+  closest = MvrMath::distanceBetween(startX, startY, closeX, closeY);
+  if (angle != NULL)
+    *angle = MvrMath::subAngle(MvrMath::atan2(closeY - startY, 
+					      closeX - startX), startTh);
+  if (closest > maxRange)
+    return maxRange;
+  else
+    return closest;  
+}
+
 /**
    Gets the closest reading in a region defined by two points (opposeite points
    of a rectangle).
@@ -198,8 +291,8 @@ MVREXPORT double MvrRangeBuffer::getClosestBox(double x1, double y1, double x2,
 					     MvrPose *readingPos,
 					     MvrPose targetPose) const
 {
-  return getClosestBoxInList(x1, y1, x2, y2, startPos, maxRange, readingPos, 
-			     targetPose, &myBuffer);
+  return getClosestBoxInStorage(x1, y1, x2, y2, startPos, maxRange, 
+				readingPos, targetPose, &myStorage);
 }
 
 /**
@@ -283,6 +376,181 @@ MVREXPORT double MvrRangeBuffer::getClosestBoxInList(
     return closest;
 }
 
+/**
+   Same as getClosestBoxInList() but walks the contiguous arrays of
+   an MvrRangeBufferStorage.
+**/
+MVREXPORT double MvrRangeBuffer::getClosestBoxInStorage(
+	double x1, double y1, double x2, double y2, MvrPose startPos,
+	unsigned int maxRange, MvrPose *readingPos, MvrPose targetPose,
+	const MvrRangeBufferStorage *storage)
+{
+  double closest = maxRange;
+  double bestDistSq = (double)maxRange * (double)maxRange;
+  MvrPose closestPos;
+  MvrTransform trans;
+  MvrPose zeroPos;
+  MvrRangeBufferStorage::Span spans[2];
+  int numSpans;
+  int s;
+  long best;
+  double temp;
+
+  zeroPos.setPose(0, 0, 0);
+  trans.setTransform(startPos, zeroPos);
+
+  if (x1 >= x2)
+  {
+    temp = x1, 
+    x1 = x2;
+    x2 = temp;
+  }
+  if (y1 >= y2)
+  {
+    temp = y1, 
+    y1 = y2;
+    y2 = temp;
+  }
+  
+  // the kernels do the same transform as trans.doTransform and only
+  // compare squared distances, the closest one gets redone for real
+  numSpans = storage->getSpans(&spans[0], &spans[1]);
+  for (s = 0; s < numSpans; s++)
+  {
+    best = MvrRangeBufferKernels::closestInBox(
+	    spans[s].x, spans[s].y, spans[s].size, 
+	    trans.getCos(), trans.getSin(), trans.getX(), trans.getY(),
+	    x1, y1, x2, y2, targetPose.getX(), targetPose.getY(), &bestDistSq);
+    if (best >= 0)
+      closestPos = trans.doTransform(MvrPose(spans[s].x[best], 
+					     spans[s].y[best]));
+  }
+  if (bestDistSq < (double)maxRange * (double)maxRange)
+    closest = closestPos.findDistanceTo(targetPose);
+
+  if (readingPos != NULL)
+    *readingPos = closestPos;
+  if (closest > maxRange)
+    return maxRange;
+  else
+    return closest;
+}
+
+/**
+   Finds the closest reading in each of the regions, the results for
+   each region are the same as getClosestPolar() or getClosestBox()
+   (with the default targetPose) would give for it, but each reading
+   is only looked at once no matter how many regions there are.
+
+   @param regions the regions to check, the distance, angle, and
+   reading position of each are set (the range device isn't touched)
+   @param numRegions the number of regions
+   @param position the position to find the closest readings to (usually
+   the robot's position)
+   @param maxRange the maximum range to return (and what a region gets if
+   nothing was found in it)
+**/
+MVREXPORT void MvrRangeBuffer::getClosestInRegions(
+	MvrRangeRegion *regions, size_t numRegions, MvrPose position, 
+	unsigned int maxRange) const
+{
+  getClosestInRegionsInStorage(regions, numRegions, position, maxRange,
+			       &myStorage);
+}
+
+/**
+   Same as getClosestInRegions() but from an arbitrary storage.
+**/
+MVREXPORT void MvrRangeBuffer::getClosestInRegionsInStorage(
+	MvrRangeRegion *regions, size_t numRegions, MvrPose position, 
+	unsigned int maxRange, const MvrRangeBufferStorage *storage)
+{
+  bool anyPolar = false;
+  bool anyBox = false;
+  double startX = position.getX();
+  double startY = position.getY();
+  double startTh = position.getTh();
+  double th = 0;
+  double polarDist = 0;
+  double boxDist;
+  MvrTransform trans;
+  MvrPose zeroPos(0, 0, 0);
+  MvrPose pose;
+  MvrPose closestPos;
+  MvrRangeBufferStorage::Span spans[2];
+  int numSpans;
+  int s;
+  size_t i;
+  size_t r;
+  MvrRangeRegion *region;
+
+  trans.setTransform(position, zeroPos);
+  for (r = 0; r < numRegions; r++)
+  {
+    region = &regions[r];
+    region->myDist = maxRange;
+    region->myAngle = 0;
+    region->myReadingPos.setPose(0, 0, 0);
+    region->myFound = false;
+    if (region->myType == MvrRangeRegion::POLAR)
+      anyPolar = true;
+    else
+      anyBox = true;
+  }
+
+  numSpans = storage->getSpans(&spans[0], &spans[1]);
+  for (s = 0; s < numSpans; s++)
+  {
+    const double *xs = spans[s].x;
+    const double *ys = spans[s].y;
+    for (i = 0; i < spans[s].size; i++)
+    {
+      // figure out the polar and local coords once for all the regions
+      if (anyPolar)
+      {
+	th = MvrMath::subAngle(MvrMath::atan2(ys[i] - startY, xs[i] - startX),
+			       startTh);
+	polarDist = MvrMath::distanceBetween(startX, startY, xs[i], ys[i]);
+      }
+      if (anyBox)
+	pose = trans.doTransform(MvrPose(xs[i], ys[i]));
+
+      for (r = 0; r < numRegions; r++)
+      {
+	region = &regions[r];
+	if (region->myType == MvrRangeRegion::POLAR)
+	{
+	  if (MvrMath::angleBetween(th, region->myStartAngle, 
+				    region->myEndAngle) &&
+	      (!region->myFound || polarDist < region->myDist))
+	  {
+	    region->myDist = polarDist;
+	    region->myAngle = th;
+	    region->myFound = true;
+	  }
+	}
+	else if (pose.getX() >= region->myX1 && pose.getX() <= region->myX2 &&
+		 pose.getY() >= region->myY1 && pose.getY() <= region->myY2)
+	{
+	  boxDist = pose.findDistanceTo(zeroPos);
+	  if (boxDist < region->myDist)
+	  {
+	    region->myDist = boxDist;
+	    region->myReadingPos = pose;
+	    region->myFound = true;
+	  }
+	}
+      }
+    }
+  }
+
+  for (r = 0; r < numRegions; r++)
+  {
+    if (regions[r].myDist > maxRange)
+      regions[r].myDist = maxRange;
+  }
+}
+
 /** 
     Applies a transform to the buffers.. this is mostly useful for translating
     to/from local/global coords, but may have other uses
@@ -290,7 +558,13 @@ MVREXPORT double MvrRangeBuffer::getClosestBoxInList(
 */    
 MVREXPORT void MvrRangeBuffer::applyTransform(MvrTransform trans)
 {
-  trans.doTransform(&myBuffer);
+  size_t i;
+  MvrPose pose;
+  for (i = 0; i < myStorage.size(); i++)
+  {
+    pose = trans.doTransform(MvrPose(myStorage.getX(i), myStorage.getY(i)));
+    myStorage.setXY(i, pose.getX(), pose.getY());
+  }
 }
 
 MVREXPORT void MvrRangeBuffer::clear(void)
@@ -306,13 +580,13 @@ MVREXPORT void MvrRangeBuffer::reset(void)
 
 MVREXPORT void MvrRangeBuffer::clearOlderThan(int milliSeconds)
 {
-  std::list<MvrPoseWithTime *>::iterator it;
+  size_t i;
 
   beginInvalidationSweep();
-  for (it = myBuffer.begin(); it != myBuffer.end(); ++it)
+  for (i = 0; i < myStorage.size(); i++)
   {
-    if ((*it)->getTime().mSecSince() > milliSeconds)
-      invalidateReading(it);
+    if (myStorage.getTime(i).mSecSince() > milliSeconds)
+      invalidateReading(i);
   }
   endInvalidationSweep();
 }
@@ -334,7 +608,7 @@ MVREXPORT void MvrRangeBuffer::clearOlderThanSeconds(int seconds)
 **/     
 MVREXPORT void MvrRangeBuffer::beginRedoBuffer(void)
 {
-  myRedoIt = myBuffer.begin();
+  myRedoIndex = 0;
   myHitEnd = false;
   myNumRedone = 0;
 }
@@ -346,10 +620,10 @@ MVREXPORT void MvrRangeBuffer::beginRedoBuffer(void)
 */
 MVREXPORT void MvrRangeBuffer::redoReading(double x, double y)
 {
-  if (myRedoIt != myBuffer.end() && !myHitEnd)
+  if (myRedoIndex < myStorage.size() && !myHitEnd)
   {
-    (*myRedoIt)->setPose(x, y);
-    myRedoIt++;
+    myStorage.setXY(myRedoIndex, x, y);
+    myRedoIndex++;
   }
   // if we don't, add more (its just moving from buffers here, 
   //but let the class for this do the work
@@ -366,17 +640,9 @@ MVREXPORT void MvrRangeBuffer::redoReading(double x, double y)
 **/
 MVREXPORT void MvrRangeBuffer::endRedoBuffer(void)
 {
+  // now we get rid of the extra readings on the end
   if (!myHitEnd)
-  {
-    // now we get rid of the extra readings on the end
-    beginInvalidationSweep();
-    while (myRedoIt != myBuffer.end())
-    {
-      invalidateReading(myRedoIt);
-      myRedoIt++;
-    }
-    endInvalidationSweep();
-  } 
+    myStorage.truncate(myRedoIndex);
 }
 
 /**
@@ -394,15 +660,14 @@ MVREXPORT void MvrRangeBuffer::addReadingConditional(
 {
   if (closeDistSquared >= 0)
   {  
-    std::list<MvrPoseWithTime *>::iterator it;
-    MvrPoseWithTime *pose;
-    for (it = myBuffer.begin(); it != myBuffer.end(); ++it)
+    size_t i;
+    for (i = 0; i < myStorage.size(); i++)
     {
-      pose = (*it);
-      if (MvrMath::squaredDistanceBetween(pose->getX(), pose->getY(),
+      if (MvrMath::squaredDistanceBetween(myStorage.getX(i), 
+					 myStorage.getY(i),
 					 x, y) < closeDistSquared)
       {
-	pose->setTimeToNow();
+	myStorage.setTime(i, MvrTime());
 	if (wasAdded != NULL)
 	  *wasAdded = false;
 	return;
@@ -421,27 +686,12 @@ MVREXPORT void MvrRangeBuffer::addReadingConditional(
 */
 MVREXPORT void MvrRangeBuffer::addReading(double x, double y) 
 {
-  if (myBuffer.size() < mySize)
-  {
-    if ((myIterator = myInvalidBuffer.begin()) != myInvalidBuffer.end())
-    {
-      myReading = (*myIterator);
-      myReading->setPose(x, y);
-      myReading->setTimeToNow();
-      myBuffer.push_front(myReading);
-      myInvalidBuffer.pop_front();
-    }
-    else
-      myBuffer.push_front(new MvrPoseWithTime(x, y));
-  }
-  else if ((myRevIterator = myBuffer.rbegin()) != myBuffer.rend())
-  {
-    myReading = (*myRevIterator);
-    myReading->setPose(x, y);
-    myReading->setTimeToNow();
-    myBuffer.pop_back();
-    myBuffer.push_front(myReading);
-  }
+  // if the buffer is full this replaces the oldest reading, so if
+  // we're in a sweep make sure the new reading doesn't inherit a mark
+  if (myInvalidAny && myStorage.size() == myStorage.capacity() &&
+      myStorage.size() > 0)
+    myInvalidMarks[myStorage.getSlot(myStorage.size() - 1)] = 0;
+  myStorage.push(x, y, MvrTime());
 }
 
 /**
@@ -451,13 +701,18 @@ MVREXPORT void MvrRangeBuffer::addReading(double x, double y)
    readings, and pass the iterator to a reading you want to invalidate to 
    invalidateReading, then after you are all through walking the list call 
    endInvalidationSweep.  Look at the description of getBuffer for additional
-   warnings.
+   warnings.  Instead of walking getBuffer you can walk getStorage and
+   pass the index of the reading to invalidateReading, which avoids
+   building the list.  Readings may be added with addReading during a
+   sweep, the readings already invalidated stay invalidated.
    @see invalidateReading
    @see endInvalidationSweep
 */
 void MvrRangeBuffer::beginInvalidationSweep(void)
 {
-  myInvalidSweepList.clear();
+  // the marks are by storage slot, so they survive readings being added
+  myInvalidMarks.assign(myStorage.capacity(), 0);
+  myInvalidAny = false;
 }
 
 /**
@@ -470,7 +725,30 @@ void MvrRangeBuffer::beginInvalidationSweep(void)
 MVREXPORT void MvrRangeBuffer::invalidateReading(
 	std::list<MvrPoseWithTime*>::iterator readingIt)
 {
-  myInvalidSweepList.push_front(readingIt);
+  // the list points into myBufferPoses in the same order as the storage
+  if (myBufferPoses.empty())
+    return;
+  MvrPoseWithTime *reading = (*readingIt);
+  if (reading < &myBufferPoses[0] || 
+      reading > &myBufferPoses[myBufferPoses.size() - 1])
+    return;
+  invalidateReading((size_t)(reading - &myBufferPoses[0]));
+}
+
+/**
+   See the description of beginInvalidationSweep, it describes how to use
+   this function.
+   @param index the index in getStorage of the reading you want to get rid of
+   @see beginInvaladationSweep
+   @see endInvalidationSweep
+*/
+MVREXPORT void MvrRangeBuffer::invalidateReading(size_t index)
+{
+  if (index >= myStorage.size() || 
+      myStorage.getSlot(index) >= myInvalidMarks.size())
+    return;
+  myInvalidMarks[myStorage.getSlot(index)] = 1;
+  myInvalidAny = true;
 }
 
 /**
@@ -481,16 +759,10 @@ MVREXPORT void MvrRangeBuffer::invalidateReading(
 */
 void MvrRangeBuffer::endInvalidationSweep(void)
 {
-  while ((myInvalidIt = myInvalidSweepList.begin()) != 
-	 myInvalidSweepList.end())
-  {
-    //printf("nuked one before %d %d\n", myBuffer.size(), myInvalidBuffer.size());
-    myReading = (*(*myInvalidIt));
-    myInvalidBuffer.push_front(myReading);
-    myBuffer.erase((*myInvalidIt));
-    myInvalidSweepList.pop_front();
-    //printf("after %d %d\n", myBuffer.size(), myInvalidBuffer.size());
-  }
+  if (myInvalidAny)
+    myStorage.removeMarked(myInvalidMarks);
+  myInvalidMarks.clear();
+  myInvalidAny = false;
 }
 
 /**
@@ -502,16 +774,13 @@ void MvrRangeBuffer::endInvalidationSweep(void)
 */
 MVREXPORT std::vector<MvrPoseWithTime> *MvrRangeBuffer::getBufferAsVector(void)
 {
-  std::list<MvrPoseWithTime *>::iterator it;
+  size_t i;
 
-  myVector.reserve(myBuffer.size());
   myVector.clear();
-  // start filling the array with the buffer until we run out of
-  // readings or its full
-  for (it = myBuffer.begin(); it != myBuffer.end(); it++)
-  {
-    myVector.insert(myVector.begin(), *(*it));
-  }
+  myVector.reserve(myStorage.size());
+  // fill the array oldest reading first
+  for (i = myStorage.size(); i > 0; i--)
+    myVector.push_back(myStorage.getPoseWithTime(i - 1));
   return &myVector;
 }
 
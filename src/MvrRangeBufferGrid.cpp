@@ -0,0 +1,211 @@
+#include "MvrExport.h"
+#include "mvriaOSDef.h"
+#include "MvrRangeBufferGrid.h"
+
+/** @param cellSize the size of the square cells, in mm */
+MVREXPORT MvrRangeBufferGrid::MvrRangeBufferGrid(double cellSize)
+{
+  myCellSize = cellSize;
+  if (myCellSize < 1)
+    myCellSize = 1;
+  myQuery = 0;
+  myNumEntries = 0;
+  setNumBuckets(0);
+}
+
+MVREXPORT MvrRangeBufferGrid::~MvrRangeBufferGrid()
+{
+}
+
+MVREXPORT void MvrRangeBufferGrid::setCellSize(double cellSize)
+{
+  if (cellSize < 1)
+    cellSize = 1;
+  myCellSize = cellSize;
+  clear();
+}
+
+void MvrRangeBufferGrid::setNumBuckets(size_t numReadings)
+{
+  // keep a power of two so we can mask instead of mod
+  size_t numBuckets = 64;
+  while (numBuckets < numReadings / 2)
+    numBuckets *= 2;
+  if (numBuckets == myBuckets.size())
+    return;
+  myBuckets.clear();
+  myBuckets.resize(numBuckets);
+  myBucketQuery.assign(numBuckets, 0);
+  myNumEntries = 0;
+}
+
+MVREXPORT void MvrRangeBufferGrid::clear(void)
+{
+  std::vector<std::vector<size_t> >::iterator it;
+  for (it = myBuckets.begin(); it != myBuckets.end(); ++it)
+    (*it).clear();
+  myNumEntries = 0;
+}
+
+/**
+   @param storage the storage to put every reading of in the grid
+**/
+MVREXPORT void MvrRangeBufferGrid::rebuild(
+	const MvrRangeBufferStorage *storage)
+{
+  size_t i;
+  size_t slot;
+
+  setNumBuckets(storage->capacity());
+  clear();
+  for (i = 0; i < storage->size(); i++)
+  {
+    slot = storage->getSlot(i);
+    add(slot, storage->getSlotX(slot), storage->getSlotY(slot));
+  }
+}
+
+MVREXPORT void MvrRangeBufferGrid::add(size_t slot, double x, double y)
+{
+  myBuckets[bucketOf(cellOf(x), cellOf(y))].push_back(slot);
+  myNumEntries++;
+}
+
+/**
+   @param slot the slot to remove
+   @param x the x the slot was added with
+   @param y the y the slot was added with
+   @return true if the slot was found and removed, false otherwise
+**/
+MVREXPORT bool MvrRangeBufferGrid::remove(size_t slot, double x, double y)
+{
+  std::vector<size_t> *bucket = &myBuckets[bucketOf(cellOf(x), cellOf(y))];
+  size_t i;
+  for (i = 0; i < bucket->size(); i++)
+  {
+    if ((*bucket)[i] == slot)
+    {
+      // order in a bucket doesn't matter so just swap the last one in
+      (*bucket)[i] = bucket->back();
+      bucket->pop_back();
+      myNumEntries--;
+      return true;
+    }
+  }
+  return false;
+}
+
+void MvrRangeBufferGrid::nextQuery(void)
+{
+  myQuery++;
+  // if we wrapped around forget which queries looked at the buckets
+  if (myQuery == 0)
+  {
+    myBucketQuery.assign(myBucketQuery.size(), 0);
+    myQuery = 1;
+  }
+}
+
+void MvrRangeBufferGrid::gatherCells(long cellXMin, long cellXMax,
+				     long cellYMin, long cellYMax,
+				     std::vector<size_t> *slots)
+{
+  long cellX;
+  long cellY;
+  size_t bucket;
+  for (cellX = cellXMin; cellX <= cellXMax; cellX++)
+  {
+    for (cellY = cellYMin; cellY <= cellYMax; cellY++)
+    {
+      bucket = bucketOf(cellX, cellY);
+      if (myBucketQuery[bucket] == myQuery)
+	continue;
+      myBucketQuery[bucket] = myQuery;
+      slots->insert(slots->end(), myBuckets[bucket].begin(),
+		    myBuckets[bucket].end());
+    }
+  }
+}
+
+/**
+   @param x the x of the point
+   @param y the y of the point
+   @param dist how far from the point to look
+   @param slots cleared then filled with the slots that may be in range
+**/
+MVREXPORT void MvrRangeBufferGrid::getSlotsNearPoint(
+	double x, double y, double dist, std::vector<size_t> *slots)
+{
+  slots->clear();
+  nextQuery();
+  gatherCells(cellOf(x - dist), cellOf(x + dist),
+	      cellOf(y - dist), cellOf(y + dist), slots);
+}
+
+/**
+   This walks the columns of cells the segment (grown by dist) crosses
+   and only looks at the rows near the part of the segment in each
+   column, so a long beam only looks at the cells along it.
+
+   @param x1 the x of one end of the segment
+   @param y1 the y of one end of the segment
+   @param x2 the x of the other end of the segment
+   @param y2 the y of the other end of the segment
+   @param dist how far from the segment to look
+   @param slots cleared then filled with the slots that may be in range
+**/
+MVREXPORT void MvrRangeBufferGrid::getSlotsNearSegment(
+	double x1, double y1, double x2, double y2, double dist,
+	std::vector<size_t> *slots)
+{
+  double temp;
+  long cellX;
+  double colMin, colMax;
+  double yA, yB;
+  double slope = 0;
+  bool vertical;
+
+  slots->clear();
+  nextQuery();
+
+  if (x1 > x2)
+  {
+    temp = x1;
+    x1 = x2;
+    x2 = temp;
+    temp = y1;
+    y1 = y2;
+    y2 = temp;
+  }
+  vertical = (x2 - x1 < .000001);
+  if (!vertical)
+    slope = (y2 - y1) / (x2 - x1);
+
+  for (cellX = cellOf(x1 - dist); cellX <= cellOf(x2 + dist); cellX++)
+  {
+    // the part of the segment that could be within dist of this column
+    colMin = cellX * myCellSize - dist;
+    colMax = (cellX + 1) * myCellSize + dist;
+    if (colMin < x1)
+      colMin = x1;
+    if (colMax > x2)
+      colMax = x2;
+    if (vertical)
+    {
+      yA = y1;
+      yB = y2;
+    }
+    else
+    {
+      yA = y1 + (colMin - x1) * slope;
+      yB = y1 + (colMax - x1) * slope;
+    }
+    if (yA > yB)
+    {
+      temp = yA;
+      yA = yB;
+      yB = temp;
+    }
+    gatherCells(cellX, cellX, cellOf(yA - dist), cellOf(yB + dist), slots);
+  }
+}
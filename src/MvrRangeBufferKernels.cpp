@@ -0,0 +1,404 @@
+#include "MvrExport.h"
+#include "mvriaOSDef.h"
+#include "MvrRangeBufferKernels.h"
+
+#if (defined(__GNUC__) || defined(__clang__)) && \
+  (defined(__x86_64__) || defined(__i386__))
+#define MVRRANGEBUFFERKERNELS_X86
+#include <immintrin.h>
+#endif
+
+MvrRangeBufferKernels::Level MvrRangeBufferKernels::ourLevel =
+  MvrRangeBufferKernels::getBestLevel();
+
+// Picks the lane with the smallest distance (and then the smallest
+// index) out of the per lane results of the vectorized loops, only
+// lanes that found something (index >= 0) count
+static long reduceLanes(const double *dists, const double *indices,
+			int numLanes, double *bestDistSq)
+{
+  long ret = -1;
+  int lane;
+  for (lane = 0; lane < numLanes; lane++)
+  {
+    if (indices[lane] < 0)
+      continue;
+    if (ret < 0 || dists[lane] < *bestDistSq ||
+	(dists[lane] == *bestDistSq && (long)indices[lane] < ret))
+    {
+      *bestDistSq = dists[lane];
+      ret = (long)indices[lane];
+    }
+  }
+  return ret;
+}
+
+static long closestInSectorScalar(
+	const double *x, const double *y, size_t start, size_t num,
+	double originX, double originY, double startDirX, double startDirY,
+	double endDirX, double endDirY, bool wide, double *bestDistSq)
+{
+  long ret = -1;
+  size_t i;
+  double dx, dy;
+  double cross1, cross2;
+  double distSq;
+  bool inside;
+
+  for (i = start; i < num; i++)
+  {
+    dx = x[i] - originX;
+    dy = y[i] - originY;
+    // which side of the start and end edges the reading is on
+    cross1 = startDirX * dy - startDirY * dx;
+    cross2 = dx * endDirY - dy * endDirX;
+    if (wide)
+      inside = (cross1 > 0 || cross2 > 0);
+    else
+      inside = (cross1 > 0 && cross2 > 0);
+    if (!inside)
+      continue;
+    distSq = dx * dx + dy * dy;
+    if (distSq < *bestDistSq)
+    {
+      *bestDistSq = distSq;
+      ret = i;
+    }
+  }
+  return ret;
+}
+
+static long closestInBoxScalar(
+	const double *x, const double *y, size_t start, size_t num,
+	double transCos, double transSin, double transX, double transY,
+	double x1, double y1, double x2, double y2,
+	double targetX, double targetY, double *bestDistSq)
+{
+  long ret = -1;
+  size_t i;
+  double localX, localY;
+  double dx, dy;
+  double distSq;
+
+  for (i = start; i < num; i++)
+  {
+    localX = transX + transCos * x[i] + transSin * y[i];
+    localY = transY + transCos * y[i] - transSin * x[i];
+    if (localX < x1 || localX > x2 || localY < y1 || localY > y2)
+      continue;
+    dx = localX - targetX;
+    dy = localY - targetY;
+    distSq = dx * dx + dy * dy;
+    if (distSq < *bestDistSq)
+    {
+      *bestDistSq = distSq;
+      ret = i;
+    }
+  }
+  return ret;
+}
+
+#ifdef MVRRANGEBUFFERKERNELS_X86
+
+__attribute__((target("sse2")))
+static long closestInSectorSSE2(
+	const double *x, const double *y, size_t num,
+	double originX, double originY, double startDirX, double startDirY,
+	double endDirX, double endDirY, bool wide, double *bestDistSq)
+{
+  const __m128d oX = _mm_set1_pd(originX);
+  const __m128d oY = _mm_set1_pd(originY);
+  const __m128d sX = _mm_set1_pd(startDirX);
+  const __m128d sY = _mm_set1_pd(startDirY);
+  const __m128d eX = _mm_set1_pd(endDirX);
+  const __m128d eY = _mm_set1_pd(endDirY);
+  const __m128d zero = _mm_setzero_pd();
+  const __m128d step = _mm_set1_pd(2);
+  __m128d best = _mm_set1_pd(*bestDistSq);
+  __m128d bestIndex = _mm_set1_pd(-1);
+  __m128d index = _mm_set_pd(1, 0);
+  __m128d dx, dy, cross1, cross2, inside, distSq, take;
+  double dists[2], indices[2];
+  long ret, tail;
+  size_t i;
+
+  for (i = 0; i + 2 <= num; i += 2)
+  {
+    dx = _mm_sub_pd(_mm_loadu_pd(x + i), oX);
+    dy = _mm_sub_pd(_mm_loadu_pd(y + i), oY);
+    cross1 = _mm_sub_pd(_mm_mul_pd(sX, dy), _mm_mul_pd(sY, dx));
+    cross2 = _mm_sub_pd(_mm_mul_pd(dx, eY), _mm_mul_pd(dy, eX));
+    if (wide)
+      inside = _mm_or_pd(_mm_cmpgt_pd(cross1, zero),
+			 _mm_cmpgt_pd(cross2, zero));
+    else
+      inside = _mm_and_pd(_mm_cmpgt_pd(cross1, zero),
+			  _mm_cmpgt_pd(cross2, zero));
+    distSq = _mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy));
+    take = _mm_and_pd(inside, _mm_cmplt_pd(distSq, best));
+    best = _mm_or_pd(_mm_and_pd(take, distSq), _mm_andnot_pd(take, best));
+    bestIndex = _mm_or_pd(_mm_and_pd(take, index),
+			  _mm_andnot_pd(take, bestIndex));
+    index = _mm_add_pd(index, step);
+  }
+  _mm_storeu_pd(dists, best);
+  _mm_storeu_pd(indices, bestIndex);
+  ret = reduceLanes(dists, indices, 2, bestDistSq);
+  tail = closestInSectorScalar(x, y, i, num, originX, originY,
+			       startDirX, startDirY, endDirX, endDirY,
+			       wide, bestDistSq);
+  if (tail >= 0)
+    return tail;
+  return ret;
+}
+
+__attribute__((target("sse2")))
+static long closestInBoxSSE2(
+	const double *x, const double *y, size_t num,
+	double transCos, double transSin, double transX, double transY,
+	double x1, double y1, double x2, double y2,
+	double targetX, double targetY, double *bestDistSq)
+{
+  const __m128d tCos = _mm_set1_pd(transCos);
+  const __m128d tSin = _mm_set1_pd(transSin);
+  const __m128d tX = _mm_set1_pd(transX);
+  const __m128d tY = _mm_set1_pd(transY);
+  const __m128d bX1 = _mm_set1_pd(x1);
+  const __m128d bY1 = _mm_set1_pd(y1);
+  const __m128d bX2 = _mm_set1_pd(x2);
+  const __m128d bY2 = _mm_set1_pd(y2);
+  const __m128d gX = _mm_set1_pd(targetX);
+  const __m128d gY = _mm_set1_pd(targetY);
+  const __m128d step = _mm_set1_pd(2);
+  __m128d best = _mm_set1_pd(*bestDistSq);
+  __m128d bestIndex = _mm_set1_pd(-1);
+  __m128d index = _mm_set_pd(1, 0);
+  __m128d px, py, localX, localY, inside, dx, dy, distSq, take;
+  double dists[2], indices[2];
+  long ret, tail;
+  size_t i;
+
+  for (i = 0; i + 2 <= num; i += 2)
+  {
+    px = _mm_loadu_pd(x + i);
+    py = _mm_loadu_pd(y + i);
+    localX = _mm_add_pd(_mm_add_pd(tX, _mm_mul_pd(tCos, px)),
+			_mm_mul_pd(tSin, py));
+    localY = _mm_sub_pd(_mm_add_pd(tY, _mm_mul_pd(tCos, py)),
+			_mm_mul_pd(tSin, px));
+    inside = _mm_and_pd(
+	    _mm_and_pd(_mm_cmpge_pd(localX, bX1), _mm_cmple_pd(localX, bX2)),
+	    _mm_and_pd(_mm_cmpge_pd(localY, bY1), _mm_cmple_pd(localY, bY2)));
+    dx = _mm_sub_pd(localX, gX);
+    dy = _mm_sub_pd(localY, gY);
+    distSq = _mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy));
+    take = _mm_and_pd(inside, _mm_cmplt_pd(distSq, best));
+    best = _mm_or_pd(_mm_and_pd(take, distSq), _mm_andnot_pd(take, best));
+    bestIndex = _mm_or_pd(_mm_and_pd(take, index),
+			  _mm_andnot_pd(take, bestIndex));
+    index = _mm_add_pd(index, step);
+  }
+  _mm_storeu_pd(dists, best);
+  _mm_storeu_pd(indices, bestIndex);
+  ret = reduceLanes(dists, indices, 2, bestDistSq);
+  tail = closestInBoxScalar(x, y, i, num, transCos, transSin, transX, transY,
+			    x1, y1, x2, y2, targetX, targetY, bestDistSq);
+  if (tail >= 0)
+    return tail;
+  return ret;
+}
+
+__attribute__((target("avx2")))
+static long closestInSectorAVX2(
+	const double *x, const double *y, size_t num,
+	double originX, double originY, double startDirX, double startDirY,
+	double endDirX, double endDirY, bool wide, double *bestDistSq)
+{
+  const __m256d oX = _mm256_set1_pd(originX);
+  const __m256d oY = _mm256_set1_pd(originY);
+  const __m256d sX = _mm256_set1_pd(startDirX);
+  const __m256d sY = _mm256_set1_pd(startDirY);
+  const __m256d eX = _mm256_set1_pd(endDirX);
+  const __m256d eY = _mm256_set1_pd(endDirY);
+  const __m256d zero = _mm256_setzero_pd();
+  const __m256d step = _mm256_set1_pd(4);
+  __m256d best = _mm256_set1_pd(*bestDistSq);
+  __m256d bestIndex = _mm256_set1_pd(-1);
+  __m256d index = _mm256_set_pd(3, 2, 1, 0);
+  __m256d dx, dy, cross1, cross2, inside, distSq, take;
+  double dists[4], indices[4];
+  long ret, tail;
+  size_t i;
+
+  for (i = 0; i + 4 <= num; i += 4)
+  {
+    dx = _mm256_sub_pd(_mm256_loadu_pd(x + i), oX);
+    dy = _mm256_sub_pd(_mm256_loadu_pd(y + i), oY);
+    cross1 = _mm256_sub_pd(_mm256_mul_pd(sX, dy), _mm256_mul_pd(sY, dx));
+    cross2 = _mm256_sub_pd(_mm256_mul_pd(dx, eY), _mm256_mul_pd(dy, eX));
+    if (wide)
+      inside = _mm256_or_pd(_mm256_cmp_pd(cross1, zero, _CMP_GT_OQ),
+			    _mm256_cmp_pd(cross2, zero, _CMP_GT_OQ));
+    else
+      inside = _mm256_and_pd(_mm256_cmp_pd(cross1, zero, _CMP_GT_OQ),
+			     _mm256_cmp_pd(cross2, zero, _CMP_GT_OQ));
+    distSq = _mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy));
+    take = _mm256_and_pd(inside, _mm256_cmp_pd(distSq, best, _CMP_LT_OQ));
+    best = _mm256_blendv_pd(best, distSq, take);
+    bestIndex = _mm256_blendv_pd(bestIndex, index, take);
+    index = _mm256_add_pd(index, step);
+  }
+  _mm256_storeu_pd(dists, best);
+  _mm256_storeu_pd(indices, bestIndex);
+  ret = reduceLanes(dists, indices, 4, bestDistSq);
+  tail = closestInSectorScalar(x, y, i, num, originX, originY,
+			       startDirX, startDirY, endDirX, endDirY,
+			       wide, bestDistSq);
+  if (tail >= 0)
+    return tail;
+  return ret;
+}
+
+__attribute__((target("avx2")))
+static long closestInBoxAVX2(
+	const double *x, const double *y, size_t num,
+	double transCos, double transSin, double transX, double transY,
+	double x1, double y1, double x2, double y2,
+	double targetX, double targetY, double *bestDistSq)
+{
+  const __m256d tCos = _mm256_set1_pd(transCos);
+  const __m256d tSin = _mm256_set1_pd(transSin);
+  const __m256d tX = _mm256_set1_pd(transX);
+  const __m256d tY = _mm256_set1_pd(transY);
+  const __m256d bX1 = _mm256_set1_pd(x1);
+  const __m256d bY1 = _mm256_set1_pd(y1);
+  const __m256d bX2 = _mm256_set1_pd(x2);
+  const __m256d bY2 = _mm256_set1_pd(y2);
+  const __m256d gX = _mm256_set1_pd(targetX);
+  const __m256d gY = _mm256_set1_pd(targetY);
+  const __m256d step = _mm256_set1_pd(4);
+  __m256d best = _mm256_set1_pd(*bestDistSq);
+  __m256d bestIndex = _mm256_set1_pd(-1);
+  __m256d index = _mm256_set_pd(3, 2, 1, 0);
+  __m256d px, py, localX, localY, inside, dx, dy, distSq, take;
+  double dists[4], indices[4];
+  long ret, tail;
+  size_t i;
+
+  for (i = 0; i + 4 <= num; i += 4)
+  {
+    px = _mm256_loadu_pd(x + i);
+    py = _mm256_loadu_pd(y + i);
+    localX = _mm256_add_pd(_mm256_add_pd(tX, _mm256_mul_pd(tCos, px)),
+			   _mm256_mul_pd(tSin, py));
+    localY = _mm256_sub_pd(_mm256_add_pd(tY, _mm256_mul_pd(tCos, py)),
+			   _mm256_mul_pd(tSin, px));
+    inside = _mm256_and_pd(
+	    _mm256_and_pd(_mm256_cmp_pd(localX, bX1, _CMP_GE_OQ),
+			  _mm256_cmp_pd(localX, bX2, _CMP_LE_OQ)),
+	    _mm256_and_pd(_mm256_cmp_pd(localY, bY1, _CMP_GE_OQ),
+			  _mm256_cmp_pd(localY, bY2, _CMP_LE_OQ)));
+    dx = _mm256_sub_pd(localX, gX);
+    dy = _mm256_sub_pd(localY, gY);
+    distSq = _mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy));
+    take = _mm256_and_pd(inside, _mm256_cmp_pd(distSq, best, _CMP_LT_OQ));
+    best = _mm256_blendv_pd(best, distSq, take);
+    bestIndex = _mm256_blendv_pd(bestIndex, index, take);
+    index = _mm256_add_pd(index, step);
+  }
+  _mm256_storeu_pd(dists, best);
+  _mm256_storeu_pd(indices, bestIndex);
+  ret = reduceLanes(dists, indices, 4, bestDistSq);
+  tail = closestInBoxScalar(x, y, i, num, transCos, transSin, transX, transY,
+			    x1, y1, x2, y2, targetX, targetY, bestDistSq);
+  if (tail >= 0)
+    return tail;
+  return ret;
+}
+
+#endif // MVRRANGEBUFFERKERNELS_X86
+
+MVREXPORT long MvrRangeBufferKernels::closestInSector(
+	const double *x, const double *y, size_t num,
+	double originX, double originY,
+	double startDirX, double startDirY,
+	double endDirX, double endDirY, bool wide,
+	double *bestDistSq)
+{
+#ifdef MVRRANGEBUFFERKERNELS_X86
+  if (ourLevel == AVX2)
+    return closestInSectorAVX2(x, y, num, originX, originY,
+			       startDirX, startDirY, endDirX, endDirY,
+			       wide, bestDistSq);
+  else if (ourLevel == SSE2)
+    return closestInSectorSSE2(x, y, num, originX, originY,
+			       startDirX, startDirY, endDirX, endDirY,
+			       wide, bestDistSq);
+#endif
+  return closestInSectorScalar(x, y, 0, num, originX, originY,
+			       startDirX, startDirY, endDirX, endDirY,
+			       wide, bestDistSq);
+}
+
+MVREXPORT long MvrRangeBufferKernels::closestInBox(
+	const double *x, const double *y, size_t num,
+	double transCos, double transSin, double transX, double transY,
+	double x1, double y1, double x2, double y2,
+	double targetX, double targetY, double *bestDistSq)
+{
+#ifdef MVRRANGEBUFFERKERNELS_X86
+  if (ourLevel == AVX2)
+    return closestInBoxAVX2(x, y, num, transCos, transSin, transX, transY,
+			    x1, y1, x2, y2, targetX, targetY, bestDistSq);
+  else if (ourLevel == SSE2)
+    return closestInBoxSSE2(x, y, num, transCos, transSin, transX, transY,
+			    x1, y1, x2, y2, targetX, targetY, bestDistSq);
+#endif
+  return closestInBoxScalar(x, y, 0, num, transCos, transSin, transX, transY,
+			    x1, y1, x2, y2, targetX, targetY, bestDistSq);
+}
+
+MVREXPORT MvrRangeBufferKernels::Level MvrRangeBufferKernels::getLevel(void)
+{
+  return ourLevel;
+}
+
+/**
+   @param level the instruction set to use
+   @return true if the level was set, false if the CPU doesn't support it
+   (in which case the level isn't changed)
+**/
+MVREXPORT bool MvrRangeBufferKernels::setLevel(Level level)
+{
+  if (level > getBestLevel())
+    return false;
+  ourLevel = level;
+  return true;
+}
+
+MVREXPORT MvrRangeBufferKernels::Level MvrRangeBufferKernels::getBestLevel(
+	void)
+{
+#ifdef MVRRANGEBUFFERKERNELS_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2"))
+    return AVX2;
+  if (__builtin_cpu_supports("sse2"))
+    return SSE2;
+#endif
+  return SCALAR;
+}
+
+MVREXPORT const char *MvrRangeBufferKernels::getLevelName(Level level)
+{
+  switch (level)
+  {
+  case AVX2:
+    return "AVX2";
+  case SSE2:
+    return "SSE2";
+  case SCALAR:
+  default:
+    return "scalar";
+  }
+}
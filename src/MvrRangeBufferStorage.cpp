@@ -0,0 +1,171 @@
+#include "MvrExport.h"
+#include "mvriaOSDef.h"
+#include "MvrRangeBufferStorage.h"
+
+/** @param capacity The number of readings the storage can hold */
+MVREXPORT MvrRangeBufferStorage::MvrRangeBufferStorage(size_t capacity)
+{
+  myCapacity = 0;
+  mySize = 0;
+  myEnd = 0;
+  myChanges = 0;
+  setCapacity(capacity);
+}
+
+MVREXPORT MvrRangeBufferStorage::~MvrRangeBufferStorage()
+{
+}
+
+/**
+   The readings that are kept are moved to the start of the arrays,
+   if the new capacity is smaller than the number of readings then the
+   oldest readings are dropped.
+   @param capacity the number of readings the storage can hold
+**/
+MVREXPORT void MvrRangeBufferStorage::setCapacity(size_t capacity)
+{
+  if (capacity == myCapacity)
+    return;
+
+  size_t keep = mySize;
+  if (keep > capacity)
+    keep = capacity;
+
+  std::vector<double> x(capacity);
+  std::vector<double> y(capacity);
+  std::vector<MvrTime> time(capacity);
+  size_t i;
+  size_t from;
+  // copy oldest to newest so the newest is at the end
+  for (i = 0; i < keep; i++)
+  {
+    from = physicalIndex(keep - 1 - i);
+    x[i] = myX[from];
+    y[i] = myY[from];
+    time[i] = myTime[from];
+  }
+  myX.swap(x);
+  myY.swap(y);
+  myTime.swap(time);
+  myCapacity = capacity;
+  mySize = keep;
+  if (myCapacity == 0 || keep == myCapacity)
+    myEnd = 0;
+  else
+    myEnd = keep;
+  myChanges++;
+}
+
+/**
+   @param x the x position of the reading
+   @param y the y position of the reading
+   @param time the time the reading was taken
+**/
+MVREXPORT void MvrRangeBufferStorage::push(double x, double y,
+					  const MvrTime &time)
+{
+  if (myCapacity == 0)
+    return;
+  myX[myEnd] = x;
+  myY[myEnd] = y;
+  myTime[myEnd] = time;
+  myEnd++;
+  if (myEnd == myCapacity)
+    myEnd = 0;
+  if (mySize < myCapacity)
+    mySize++;
+  myChanges++;
+}
+
+/**
+   @param newSize the number of readings to keep, if this is larger
+   than size() nothing happens
+**/
+MVREXPORT void MvrRangeBufferStorage::truncate(size_t newSize)
+{
+  if (newSize >= mySize)
+    return;
+  // the newest readings don't move, so just forget about the old ones
+  mySize = newSize;
+  myChanges++;
+}
+
+/**
+   The readings that are left keep their order (but may change slots).
+   @param marks has one entry per slot (see getSlot()), readings whose
+   slot's entry is non zero are removed
+**/
+MVREXPORT void MvrRangeBufferStorage::removeMarked(
+	const std::vector<unsigned char> &marks)
+{
+  size_t i;
+  size_t kept = 0;
+  size_t from;
+  size_t to;
+
+  // walk from the newest backwards, packing the ones we keep in
+  // behind the newest so the newest reading never moves
+  for (i = 0; i < mySize; i++)
+  {
+    from = physicalIndex(i);
+    // the marks for the slots we write to were already looked at
+    if (from < marks.size() && marks[from])
+      continue;
+    if (kept != i)
+    {
+      to = physicalIndex(kept);
+      myX[to] = myX[from];
+      myY[to] = myY[from];
+      myTime[to] = myTime[from];
+    }
+    kept++;
+  }
+  if (kept != mySize)
+  {
+    mySize = kept;
+    myChanges++;
+  }
+}
+
+MVREXPORT void MvrRangeBufferStorage::clear(void)
+{
+  mySize = 0;
+  myChanges++;
+}
+
+/**
+   Within each run the readings go from older to newer, the first run
+   is older than the second.  Use this when the order of the readings
+   doesn't matter, like finding the closest one.
+   @param first set to the first run of readings
+   @param second set to the second run of readings (if there is one)
+   @return the number of runs that have readings in them (0, 1, or 2)
+**/
+MVREXPORT int MvrRangeBufferStorage::getSpans(Span *first,
+					     Span *second) const
+{
+  first->x = NULL;
+  first->y = NULL;
+  first->time = NULL;
+  first->size = 0;
+  *second = *first;
+  if (mySize == 0)
+    return 0;
+
+  size_t start = physicalIndex(mySize - 1);
+  first->x = &myX[start];
+  first->y = &myY[start];
+  first->time = &myTime[start];
+  // if it doesn't wrap then it is all one run
+  if (start + mySize <= myCapacity)
+  {
+    first->size = mySize;
+    return 1;
+  }
+  first->size = myCapacity - start;
+  second->x = &myX[0];
+  second->y = &myY[0];
+  second->time = &myTime[0];
+  second->size = mySize - first->size;
+  return 2;
+}
@@ -60,6 +60,10 @@ MVREXPORT MvrRangeDevice::MvrRangeDevice(size_t currentBufferSize,
   myMaxRange = maxRange;
   myRawReadings = NULL;
   myAdjustedRawReadings = NULL;
+  myAdjustedFromGeneration = 0;
+  myRawReadingsGeneration = 0;
+  myAdjustedRawReadingsGeneration = 0;
+  myOwnRawReadings = false;
 
   // take out any spaces in the name since that'll break things
   int i;
@@ -92,6 +96,21 @@ MVREXPORT MvrRangeDevice::~MvrRangeDevice()
   if (myRobot != NULL)
     myRobot->remSensorInterpTask(&myFilterCB);
 
+  // if the readings were built from the scan they're ours
+  if (myOwnRawReadings && myRawReadings != NULL)
+  {
+    MvrUtil::deleteSet(myRawReadings->begin(), myRawReadings->end());
+    delete myRawReadings;
+    myRawReadings = NULL;
+  }
+  if (myAdjustedRawReadings != NULL)
+  {
+    MvrUtil::deleteSet(myAdjustedRawReadings->begin(), 
+		      myAdjustedRawReadings->end());
+    delete myAdjustedRawReadings;
+    myAdjustedRawReadings = NULL;
+  }
+
   if (myCurrentDrawingData != NULL && myOwnCurrentDrawingData)
   {
     delete myCurrentDrawingData;
@@ -133,7 +152,8 @@ MVREXPORT MvrRobot *MvrRangeDevice::getRobot(void)
 
 MVREXPORT void MvrRangeDevice::filterCallback(void)
 {
-  std::list<MvrPoseWithTime *>::iterator it;
+  const MvrRangeBufferStorage *storage;
+  size_t i;
   lockDevice();
 
   myMaxInsertDistCumulativePose = myRobot->getPose();
@@ -144,12 +164,11 @@ MVREXPORT void MvrRangeDevice::filterCallback(void)
   {
     // just walk through and make sure nothings too far away
     myCurrentBuffer.beginInvalidationSweep();
-    for (it = getCurrentBuffer()->begin(); 
-	 it != getCurrentBuffer()->end(); 
-	 ++it)
+    storage = myCurrentBuffer.getStorage();
+    for (i = 0; i < storage->size(); i++)
     {
-      if ((*it)->getTime().secSince() >= myMaxSecondsToKeepCurrent)
-	myCurrentBuffer.invalidateReading(it);
+      if (storage->getTime(i).secSince() >= myMaxSecondsToKeepCurrent)
+	myCurrentBuffer.invalidateReading(i);
     }
     myCurrentBuffer.endInvalidationSweep();
   }
@@ -176,19 +195,21 @@ MVREXPORT void MvrRangeDevice::filterCallback(void)
   }
 
   // just walk through and make sure nothings too far away
+  double robotX = myRobot->getX();
+  double robotY = myRobot->getY();
   myCumulativeBuffer.beginInvalidationSweep();
-  for (it = getCumulativeBuffer()->begin(); 
-       it != getCumulativeBuffer()->end(); 
-       ++it)
+  storage = myCumulativeBuffer.getStorage();
+  for (i = 0; i < storage->size(); i++)
   {
     // if its closer to a reading than the filter near dist, just return
     if (doingDist && 
-	(myRobot->getPose().squaredFindDistanceTo(*(*it)) > 
+	(MvrMath::squaredDistanceBetween(robotX, robotY, 
+					 storage->getX(i), storage->getY(i)) > 
 	 myMaxDistToKeepCumulativeSquared))
-      myCumulativeBuffer.invalidateReading(it);
+      myCumulativeBuffer.invalidateReading(i);
     else if (doingAge && 
-	     (*it)->getTime().secSince() >= myMaxSecondsToKeepCumulative)
-      myCumulativeBuffer.invalidateReading(it);
+	     storage->getTime(i).secSince() >= myMaxSecondsToKeepCumulative)
+      myCumulativeBuffer.invalidateReading(i);
   }
   myCumulativeBuffer.endInvalidationSweep();
   unlockDevice();
@@ -365,6 +386,31 @@ MVREXPORT double MvrRangeDevice::currentReadingBox(double x1, double y1,
 				       myMaxRange, pose);
 }
 
+/**
+   Gets the closest reading in the current buffer for each of the
+   regions, looking at each reading only once.  For each region the
+   results are the same as currentReadingPolar() or currentReadingBox()
+   would give for it.  If you override either of those you should
+   override this too.
+
+   @param regions the regions to check, see MvrRangeRegion
+   @param numRegions the number of regions
+*/
+MVREXPORT void MvrRangeDevice::currentReadingRegions(
+	MvrRangeRegion *regions, size_t numRegions) const
+{
+  MvrPose robotPose;
+  if (myRobot != NULL)
+      robotPose = myRobot->getPose();
+  else
+    {
+      MvrLog::log(MvrLog::Normal, "MvrRangeDevice %s: NULL robot, won't get reading regions correctly", getName());
+      robotPose.setPose(0, 0);
+    }
+  myCurrentBuffer.getClosestInRegions(regions, numRegions, robotPose,
+				      myMaxRange);
+}
+
 /**
    Get the closest reading in the cumulative buffer within a rectangular region 
    around the range device, defined by two points (opposeite points
@@ -410,6 +456,36 @@ MVREXPORT void MvrRangeDevice::applyTransform(MvrTransform trans,
     myCumulativeBuffer.applyTransform(trans);
 }
 
+/**
+   Lasers fill in myRawScan, and the list of readings is only built
+   from it when somebody calls getRawReadings() after the scan has
+   changed.
+**/
+MVREXPORT void MvrRangeDevice::fillRawReadingsFromScan(void) const
+{
+  if (myRawReadings == NULL)
+  {
+    myRawReadings = new std::list<MvrSensorReading *>;
+    myOwnRawReadings = true;
+  }
+  myRawScan.fillReadings(myRawReadings);
+  myRawReadingsGeneration = myRawScan.getGeneration();
+}
+
+MVREXPORT void MvrRangeDevice::fillAdjustedRawReadingsFromScan(void) const
+{
+  std::list<MvrSensorReading *>::iterator it;
+
+  if (myAdjustedRawReadings == NULL)
+    myAdjustedRawReadings = new std::list<MvrSensorReading *>;
+  myAdjustedRawScan.fillReadings(myAdjustedRawReadings);
+  for (it = myAdjustedRawReadings->begin(); 
+       it != myAdjustedRawReadings->end(); 
+       it++)
+    (*it)->setAdjusted(true);
+  myAdjustedRawReadingsGeneration = myAdjustedRawScan.getGeneration();
+}
+
 /** Copies the list into a vector.
  *  @swignote The return type will be named MvrSensorReadingVector instead
  *    of the std::vector template type.
@@ -417,14 +493,27 @@ MVREXPORT void MvrRangeDevice::applyTransform(MvrTransform trans,
 MVREXPORT std::vector<MvrSensorReading> *MvrRangeDevice::getRawReadingsAsVector(void)
 {
   
-  std::list<MvrSensorReading *>::const_iterator it;
+  std::list<MvrSensorReading *>::const_reverse_iterator it;
+  int i;
   myRawReadingsVector.clear();
+  // if the readings come from the scan build the vector straight from
+  // it, last reading first like it always has been
+  if (myRawScan.getGeneration() != 0)
+  {
+    myRawReadingsVector.reserve(myRawScan.getNumReadings());
+    for (i = myRawScan.getNumReadings() - 1; i >= 0; i--)
+    {
+      myRawReadingsVector.push_back(MvrSensorReading());
+      myRawScan.fillReading(i, &myRawReadingsVector.back());
+    }
+    return &myRawReadingsVector;
+  }
   // if we don't have any return an empty list
   if (myRawReadings == NULL)
     return &myRawReadingsVector;
   myRawReadingsVector.reserve(myRawReadings->size());
-  for (it = myRawReadings->begin(); it != myRawReadings->end(); it++)
-    myRawReadingsVector.insert(myRawReadingsVector.begin(), *(*it));
+  for (it = myRawReadings->rbegin(); it != myRawReadings->rend(); it++)
+    myRawReadingsVector.push_back(*(*it));
   return &myRawReadingsVector;
 }
 
@@ -435,17 +524,18 @@ MVREXPORT std::vector<MvrSensorReading> *MvrRangeDevice::getRawReadingsAsVector(
 MVREXPORT std::vector<MvrSensorReading> *MvrRangeDevice::getAdjustedRawReadingsAsVector(void)
 {
   
-  std::list<MvrSensorReading *>::const_iterator it;
+  int i;
   myAdjustedRawReadingsVector.clear();
   // if we don't have any return an empty list
-  if (myAdjustedRawReadings == NULL)
-    return &myRawReadingsVector;
-  myAdjustedRawReadingsVector.reserve(myRawReadings->size());
-  for (it = myAdjustedRawReadings->begin(); 
-       it != myAdjustedRawReadings->end(); 
-       it++)
-    myAdjustedRawReadingsVector.insert(myAdjustedRawReadingsVector.begin(), 
-				       *(*it));
+  if (myAdjustedRawScan.getGeneration() == 0)
+    return &myAdjustedRawReadingsVector;
+  myAdjustedRawReadingsVector.reserve(myAdjustedRawScan.getNumReadings());
+  for (i = myAdjustedRawScan.getNumReadings() - 1; i >= 0; i--)
+  {
+    myAdjustedRawReadingsVector.push_back(MvrSensorReading());
+    myAdjustedRawScan.fillReading(i, &myAdjustedRawReadingsVector.back());
+    myAdjustedRawReadingsVector.back().setAdjusted(true);
+  }
   return &myAdjustedRawReadingsVector;
 }
 
@@ -479,129 +569,64 @@ MVREXPORT  void MvrRangeDevice::setCumulativeDrawingData(
 
 MVREXPORT void MvrRangeDevice::adjustRawReadings(bool interlaced)
 {
-  std::list<MvrSensorReading *>::iterator rawIt;
-
-  // make sure we have raw readings and a robot, and a delay to
-  // correct for (note that if we don't have a delay to correct for
-  // but have already been adjusting (ie someone changed the delay)
-  // we'll just keep adjusting)
-  if (myRawReadings == NULL || myRobot == NULL || 
-      (myAdjustedRawReadings == NULL && myRobot->getOdometryDelay() == 0))
+  // make sure we have a robot, and a delay to correct for (note that
+  // if we don't have a delay to correct for but have already been
+  // adjusting (ie someone changed the delay) we'll just keep adjusting)
+  if (myRobot == NULL || 
+      (myAdjustedRawScan.getGeneration() == 0 && 
+       myRobot->getOdometryDelay() == 0))
     return;
   
-
-  // if we don't already have a list then make one
-  if (myAdjustedRawReadings == NULL)
-    myAdjustedRawReadings = new std::list<MvrSensorReading *>;
-  
-  // if we've already adjusted these readings then don't do it again
-  if (myRawReadings->begin() != myRawReadings->end() &&
-      myRawReadings->front()->getAdjusted())
+  // make sure we have a scan, and that we haven't already adjusted it
+  if (myRawScan.getGeneration() == 0 || myRawScan.getNumReadings() == 0 ||
+      myAdjustedFromGeneration == myRawScan.getGeneration())
     return;
-
-  std::list<MvrSensorReading *>::iterator adjIt;
-  MvrSensorReading *adjReading;
-  MvrSensorReading *rawReading;
+  myAdjustedFromGeneration = myRawScan.getGeneration();
 
   MvrTransform trans;
   MvrTransform encTrans;
   MvrTransform interlacedTrans;
   MvrTransform interlacedEncTrans;
 
-  bool first = true;
-  bool second = true;
-
-  int onReading;
-  for (rawIt = myRawReadings->begin(), adjIt = myAdjustedRawReadings->begin(), 
-       onReading = 0; 
-       rawIt != myRawReadings->end(); 
-       rawIt++, onReading++)
+  MvrPose origPose = myRawScan.getPoseTaken();
+  MvrPose origEncPose = myRawScan.getEncoderPoseTaken();
+  MvrPose corPose;
+  MvrPose corEncPose;
+
+  // the correction comes from when the first reading was taken, and
+  // for an interlaced scan the odd readings get their own from when
+  // the second one was
+  if (myRobot->getPoseInterpPosition(myRawScan.getTimeTaken(0), 
+				     &corPose) == 1 && 
+      myRobot->getEncoderPoseInterpPosition(myRawScan.getTimeTaken(0), 
+					    &corEncPose) == 1)
   {
-    rawReading = (*rawIt);
-    if (adjIt != myAdjustedRawReadings->end())
-    {
-      adjReading = (*adjIt);
-      adjIt++;
-    }
-    else
-    {
-      adjReading = new MvrSensorReading;
-      myAdjustedRawReadings->push_back(adjReading);
-    }
-    (*adjReading) = (*rawReading);
-    if (first || (interlaced && second))
-    {
-      MvrPose origPose;
-      MvrPose corPose;
-      MvrPose origEncPose;
-      MvrPose corEncPose;
-      MvrTime corTime;
-
-
-      corTime = rawReading->getTimeTaken();
-      //corTime.addMSec(-myRobot->getOdometryDelay());
-      if (myRobot->getPoseInterpPosition(corTime, 
-					 &corPose) == 1 && 
-	  myRobot->getEncoderPoseInterpPosition(corTime, 
-						&corEncPose) == 1)
-      {
-	origPose = rawReading->getPoseTaken();
-	origEncPose = rawReading->getEncoderPoseTaken();
-	/*
-	printf("Difference was %g %g %g (rotVel %.0f, rotvel/40 %g)\n", 
-	       origEncPose.getX() - corEncPose.getX(),
-	       origEncPose.getY() - corEncPose.getY(),
-	       origEncPose.getTh() - corEncPose.getTh(),
-	       myRobot->getRotVel(), myRobot->getRotVel() / 40);
-	*/
-	if (first)
-	{
-	  trans.setTransform(origPose, corPose);
-	  encTrans.setTransform(origEncPose, corEncPose);
-	}
-	else if (interlaced && second)
-	{
-	  interlacedTrans.setTransform(origPose, corPose);
-	  interlacedEncTrans.setTransform(origEncPose, corEncPose);
-	}
-      }
-      else
-      {
-	//printf("Couldn't correct\n");
-      }
-
-      if (first)
-	first = false;
-      else if (interlaced && second)
-	second = false;
+    trans.setTransform(origPose, corPose);
+    encTrans.setTransform(origEncPose, corEncPose);
+  }
+  if (interlaced && myRawScan.getNumReadings() > 1 &&
+      myRobot->getPoseInterpPosition(myRawScan.getTimeTaken(1), 
+				     &corPose) == 1 && 
+      myRobot->getEncoderPoseInterpPosition(myRawScan.getTimeTaken(1), 
+					    &corEncPose) == 1)
+  {
+    interlacedTrans.setTransform(origPose, corPose);
+    interlacedEncTrans.setTransform(origEncPose, corEncPose);
+  }
 
-    }
-    if (!interlaced && (onReading % 2) == 0)
-    {
-      adjReading->applyTransform(trans);
-      adjReading->applyEncoderTransform(encTrans);
-    }
-    else
-    {
-      adjReading->applyTransform(interlacedTrans);
-      adjReading->applyEncoderTransform(interlacedEncTrans);
-    }
-    /*
-    if (fabs(adjReading->getEncoderPoseTaken().getX() - 
-	     corEncPose.getX()) > 1 ||
-	fabs(adjReading->getEncoderPoseTaken().getY() - 
-	     corEncPose.getY()) > 1 || 
-	fabs(MvrMath::subAngle(adjReading->getEncoderPoseTaken().getTh(), 
-			      corEncPose.getTh())) > .2)
-      printf("(%.0f %.0f %.0f) should be (%.0f %.0f %.0f)\n", 
-	     adjReading->getEncoderPoseTaken().getX(),
-	     adjReading->getEncoderPoseTaken().getY(),
-	     adjReading->getEncoderPoseTaken().getTh(),
-	     corEncPose.getX(), corEncPose.getY(),  corEncPose.getTh());
-    */
-    adjReading->setAdjusted(true);
-    rawReading->setAdjusted(true);
-  }  
+  myAdjustedRawScan.copyScan(&myRawScan);
+  if (interlaced)
+  {
+    myAdjustedRawScan.applyTransform(trans, 0, 2);
+    myAdjustedRawScan.applyEncoderTransform(encTrans, 0, 2);
+    myAdjustedRawScan.applyTransform(interlacedTrans, 1, 2);
+    myAdjustedRawScan.applyEncoderTransform(interlacedEncTrans, 1, 2);
+  }
+  else
+  {
+    myAdjustedRawScan.applyTransform(trans);
+    myAdjustedRawScan.applyEncoderTransform(encTrans);
+  }
 }
 
 
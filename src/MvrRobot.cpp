@@ -2,9 +2,11 @@
 #include "mvriaOSDef.h"
 #include <time.h>
 #include <ctype.h>
+#include <string.h>
 
 #include "MvrRobot.h"
 #include "MvrLog.h"
+#include "MvrBinaryLog.h"
 #include "MvrDeviceConnection.h"
 #include "MvrTcpConnection.h"
 #include "MvrSerialConnection.h"
@@ -62,6 +64,7 @@ MVREXPORT MvrRobot::MvrRobot(const char *name, bool obsolete,
   myStateReflectorCB(this, &MvrRobot::stateReflector),
   myRobotLockerCB(this, &MvrRobot::robotLocker),
   myRobotUnlockerCB(this, &MvrRobot::robotUnlocker),
+  myObstacleSnapshotReadyCB(this, &MvrRobot::obstacleSnapshotReady),
   myKeyHandlerExitCB(this, &MvrRobot::keyHandlerExit),
   myGetCycleWarningTimeCB(this, &MvrRobot::getCycleWarningTime),
   myGetNoTimeWarningThisCycleCB(this, &MvrRobot::getNoTimeWarningThisCycle),
@@ -72,7 +75,6 @@ MVREXPORT MvrRobot::MvrRobot(const char *name, bool obsolete,
   myEncoderPoseInterpPositionCB(this, &MvrRobot::getEncoderPoseInterpPosition)
 {
   myMutex.setLogName("MvrRobot::myMutex");
-  myPacketMutex.setLogName("MvrRobot::myPacketMutex");
   myConnectionTimeoutMutex.setLogName("MvrRobot::myConnectionTimeoutMutex");
 
   setName(name);
@@ -129,11 +131,15 @@ MVREXPORT MvrRobot::MvrRobot(const char *name, bool obsolete,
   myLogSIPContents = false;
 
   myCycleTime = 100;
+  myCycleTimeUSec = 100000;
   myCycleWarningTime = 250;
   myConnectionCycleMultiplier = 2;
   myTimeoutTime = 8000;
   myStabilizingTime = 0;
   myCounter = 1;
+  myUseObstacleSnapshot = true;
+  myObstacleSnapshotReadyCounter = 0;
+  myStateSnapshotSeq.store(0);
   myResolver = NULL;
   myNumSonar = 0;
 
@@ -159,6 +165,8 @@ MVREXPORT MvrRobot::MvrRobot(const char *name, bool obsolete,
   
   mySyncLoop.setRobot(this);
   myPacketReader.setRobot(this);
+  // packets cleared out of the queue go back where they came from
+  myPacketQueue.setPacketPool(myReceiver.getPacketPool());
 
   if (doSigHandle)
     Mvria::addRobot(this);
@@ -175,7 +183,6 @@ MVREXPORT MvrRobot::MvrRobot(const char *name, bool obsolete,
   myConnectWithNoParams = false;
   myDoNotSwitchBaud = false;
 
-  myPacketReceivedCondition.setLogName("MvrRobot::myPacketReceivedCondition");
   myConnectCond.setLogName("MvrRobot::myConnectCond");
   myConnOrFailCond.setLogName("MvrRobot::myConnOrFailCond");
   myRunExitCond.setLogName("MvrRobot::myRunExitCond");
@@ -340,6 +347,8 @@ MVREXPORT void MvrRobot::setUpSyncList(void)
   mySyncTaskRoot->addNewLeaf("Packet Handler", 85, &myPacketHandlerCB);
   mySyncTaskRoot->addNewLeaf("Robot Locker", 70, &myRobotLockerCB);
   mySyncTaskRoot->addNewBranch("Sensor Interp", 65);
+  mySyncTaskRoot->addNewLeaf("Obstacle Snapshot", 60, 
+			     &myObstacleSnapshotReadyCB);
   mySyncTaskRoot->addNewLeaf("Action Handler", 55, &myActionHandlerCB);
   mySyncTaskRoot->addNewLeaf("State Reflector", 45, &myStateReflectorCB);
   mySyncTaskRoot->addNewBranch("User Tasks", 25);
@@ -4604,9 +4613,94 @@ MVREXPORT void MvrRobot::robotLocker(void)
 **/
 MVREXPORT void MvrRobot::robotUnlocker(void)
 {
+  publishStateSnapshot();
   unlock();
 }
 
+/**
+ * @internal
+   Copies the state getStateSnapshot() returns, this is called at the
+   end of each cycle (with the robot locked) from robotUnlocker().  The
+   copy is done under a sequence lock: the sequence is odd while it is
+   being written, and getStateSnapshot() tries again if the sequence
+   was odd or changed while it copied, so nothing ever waits on a lock.
+   Only the robot's thread writes it.
+**/
+MVREXPORT void MvrRobot::publishStateSnapshot(void)
+{
+  MvrRobotStateSnapshot snapshot;
+  unsigned int seq;
+
+  snapshot.myX = myGlobalPose.getX();
+  snapshot.myY = myGlobalPose.getY();
+  snapshot.myTh = myGlobalPose.getTh();
+  snapshot.myEncoderX = myEncoderPose.getX();
+  snapshot.myEncoderY = myEncoderPose.getY();
+  snapshot.myEncoderTh = myEncoderPose.getTh();
+  snapshot.myVel = myVel;
+  snapshot.myRotVel = myRotVel;
+  snapshot.myLatVel = myLatVel;
+  snapshot.myLeftVel = myLeftVel;
+  snapshot.myRightVel = myRightVel;
+  snapshot.myStallValue = myStallValue;
+  snapshot.myFlags = myFlags;
+  snapshot.myFaultFlags = myFaultFlags;
+  snapshot.myFlags3 = myFlags3;
+  snapshot.myBatteryVoltage = getBatteryVoltage();
+  snapshot.myRealBatteryVoltage = getRealBatteryVoltage();
+  snapshot.myStateOfCharge = getStateOfCharge();
+  snapshot.myTemperature = myTemperature;
+  snapshot.myCounter = myCounter;
+  snapshot.myIsConnected = myIsConnected;
+  snapshot.myTimeUSec = MvrUtil::getTimeUSec();
+
+  seq = myStateSnapshotSeq.load(std::memory_order_relaxed);
+  myStateSnapshotSeq.store(seq + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  memcpy(&myStateSnapshot, &snapshot, sizeof(snapshot));
+  myStateSnapshotSeq.store(seq + 2, std::memory_order_release);
+}
+
+/**
+   This is the robot's state as of the end of the last cycle (so at
+   most a cycle old), and doesn't lock the robot, so it can be called
+   from any thread without waiting for the robot's cycle (which has the
+   robot locked for the whole cycle).  If it has to look at more than
+   what is in the snapshot, or needs the state right now, lock the
+   robot and use the normal calls instead.
+
+   Until the first cycle finishes everything in it is 0 (see
+   MvrRobotStateSnapshot::getTimeUSec()).
+**/
+MVREXPORT MvrRobotStateSnapshot MvrRobot::getStateSnapshot(void) const
+{
+  MvrRobotStateSnapshot snapshot;
+  unsigned int seq;
+
+  while (true)
+  {
+    seq = myStateSnapshotSeq.load(std::memory_order_acquire);
+    // being written right now, it only takes as long as the copy
+    if (seq & 1)
+      continue;
+    memcpy(&snapshot, &myStateSnapshot, sizeof(snapshot));
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (myStateSnapshotSeq.load(std::memory_order_relaxed) == seq)
+      return snapshot;
+  }
+}
+
+/**
+   This runs right after the sensor interpretation tasks, after which
+   the current buffers shouldn't change again this cycle, so from here
+   on checkRangeDevicesCurrentPolar() and checkRangeDevicesCurrentBox()
+   can use a snapshot of them (see setUseObstacleSnapshot()).
+**/
+MVREXPORT void MvrRobot::obstacleSnapshotReady(void)
+{
+  myObstacleSnapshotReadyCounter = myCounter;
+}
+
 
 
 MVREXPORT void MvrRobot::packetHandler(void)
@@ -4756,7 +4850,12 @@ MVREXPORT void MvrRobot::packetHandlerThreadedProcessor(void)
   MvrTime start;
   bool sipHandled = false;
   bool anotherSip = false;
-  std::list<MvrRobotPacket *>::iterator it;
+  // packet tracking logs every packet, so it's logged in binary to
+  // keep the formatting off of this thread
+  static const int packetFormat = MvrBinaryLog::registerFormat(
+	  MvrLog::Normal, "Rcvd: Packet (%ld) 0x%x at %ld (%ld)");
+  static const int prePacketFormat = MvrBinaryLog::registerFormat(
+	  MvrLog::Normal, "Rcvd: prePacket (%ld) 0x%x at %ld (%ld)");
 
   if (myAsyncConnectFlag)
   {
@@ -4777,28 +4876,10 @@ MVREXPORT void MvrRobot::packetHandlerThreadedProcessor(void)
   // packet cycle), if we get the sip we stop...
   while (!sipHandled && isRunning())
   {
-    packet = NULL;
-    anotherSip = false;
-    myPacketMutex.lock();
-    if (!myPacketList.empty())
-    {
-      packet = myPacketList.front();
-      myPacketList.pop_front();
-      // see if there are more sips, since if so we'll keep chugging
-      // through the list
-      for (it = myPacketList.begin(); 
-	   !anotherSip && it != myPacketList.end(); 
-	   it++)
-      {
-	if (((*it)->getID() & 0xf0) == 0x30)
-	  anotherSip = true;
-      }
-      myPacketMutex.unlock();
-    }
-    else
-    {
-      myPacketMutex.unlock();
-    }
+    packet = myPacketQueue.pop();
+    // see if there are more sips, since if so we'll keep chugging
+    // through the queue
+    anotherSip = (packet != NULL && myPacketQueue.getNumPendingSips() > 0);
 
     if (packet == NULL)
     {
@@ -4807,14 +4888,11 @@ MVREXPORT void MvrRobot::packetHandlerThreadedProcessor(void)
       else
 	timeToWait = getCycleTime() - start.mSecSince();
 
-      int ret = 0;
-
-      if (timeToWait <= 0 ||
-	  (ret = myPacketReceivedCondition.timedWait(timeToWait)) != 0)
+      if (timeToWait <= 0 || !myPacketQueue.waitForPacket(timeToWait))
       {
 	if (myCycleWarningTime != 0)
-	  MvrLog::log(MvrLog::Normal, "MvrRobot::myPacketReader: Timed out (%d) at %d (%d into cycle after sleeping %d)", 	     
-		     ret, myPacketsReceivedTrackingStarted.mSecSince(), 
+	  MvrLog::log(MvrLog::Normal, "MvrRobot::myPacketReader: Timed out at %d (%d into cycle after sleeping %d)", 	     
+		     myPacketsReceivedTrackingStarted.mSecSince(), 
 		     start.mSecSince(), timeToWait);
 	break;
       }
@@ -4833,10 +4911,9 @@ MVREXPORT void MvrRobot::packetHandlerThreadedProcessor(void)
       
       if (myPacketsReceivedTracking)
       {
-	MvrLog::log(MvrLog::Normal, "Rcvd: Packet (%ld) 0x%x at %ld (%ld)", 
-		   myPacketsReceivedTrackingCount, 
-		   packet->getID(), start.mSecSince(), 
-		   myPacketsReceivedTrackingStarted.mSecSince());
+	MvrBinaryLog::log(packetFormat, myPacketsReceivedTrackingCount, 
+			  (int)packet->getID(), start.mSecSince(), 
+			  myPacketsReceivedTrackingStarted.mSecSince());
 	myPacketsReceivedTrackingCount++;
       }
     }
@@ -4844,16 +4921,14 @@ MVREXPORT void MvrRobot::packetHandlerThreadedProcessor(void)
     {
       if (myPacketsReceivedTracking)
       {
-	MvrLog::log(MvrLog::Normal, 
-		   "Rcvd: prePacket (%ld) 0x%x at %ld (%ld)", 
-		   myPacketsReceivedTrackingCount, 
-		   packet->getID(), start.mSecSince(), 
-		   myPacketsReceivedTrackingStarted.mSecSince());
+	MvrBinaryLog::log(prePacketFormat, myPacketsReceivedTrackingCount, 
+			  (int)packet->getID(), start.mSecSince(), 
+			  myPacketsReceivedTrackingStarted.mSecSince());
 	myPacketsReceivedTrackingCount++;
       }
     }
 
-    delete packet;
+    myReceiver.releasePacket(packet);
     packet = NULL;
   }
 
@@ -4904,6 +4979,9 @@ MVREXPORT void MvrRobot::packetHandlerThreadedReader(void)
 {
   bool isAllocatingPackets = myReceiver.isAllocatingPackets();
   myReceiver.setAllocatingPackets(true);
+  // enough packets up front that the queue and the processor don't
+  // make the pool allocate during normal running
+  myReceiver.getPacketPool()->preallocate(32);
 
   MvrTime lastPacketReceived;
 
@@ -4921,8 +4999,20 @@ MVREXPORT void MvrRobot::packetHandlerThreadedReader(void)
     {
 
       lastPacketReceived.setToNow();
-      myPacketMutex.lock();
-      myPacketList.push_back(packet);
+      // if the processor has fallen this far behind wait for it to
+      // make room, robot packets can't just be thrown away
+      if (!myPacketQueue.push(packet))
+      {
+	MvrLog::log(MvrLog::Normal, 
+		   "MvrRobot::packetReader: Packet queue full (%lu packets), waiting for the processor to catch up (full %lu times so far)",
+		   (unsigned long)myPacketQueue.getCapacity(),
+		   (unsigned long)myPacketQueue.getNumFull());
+	while (isRunning() && !myPacketQueue.push(packet))
+	  MvrUtil::sleep(1);
+	// only if we're shutting down
+	if (!isRunning())
+	  myReceiver.releasePacket(packet);
+      }
       /*
       MvrLog::log(MvrLog::Normal, "HTR: %x at %d (%x)",
 		 packet->getID(),
@@ -4930,8 +5020,6 @@ MVREXPORT void MvrRobot::packetHandlerThreadedReader(void)
 		 packet->getID() & 0xf0);
       */
       packet = NULL;
-      myPacketMutex.unlock();
-      myPacketReceivedCondition.broadcast();
     }
     /* this is taken out for now since it'd spam in cases when the receiver returns instantly and fill the log file
     else
@@ -5030,6 +5118,60 @@ MVREXPORT unsigned int MvrRobot::getCycleWarningTime(void)
 MVREXPORT void MvrRobot::setCycleTime(unsigned int ms)
 {
   myCycleTime = ms;
+  myCycleTimeUSec = ms * 1000;
+}
+
+/**
+   Like setCycleTime() but in microseconds, so that the cycle time can
+   be less than a ms.  Only absolute cycle timing (see
+   setAbsoluteCycleTiming()) sleeps for less than a ms, without it the
+   cycle time is rounded up to a whole ms; getCycleTime() is always the
+   cycle time rounded up to a whole ms.
+   @param uSec the number of microseconds between cycles
+ **/
+MVREXPORT void MvrRobot::setCycleTimeUSec(unsigned int uSec)
+{
+  myCycleTimeUSec = uSec;
+  myCycleTime = (uSec + 999) / 1000;
+}
+
+MVREXPORT unsigned int MvrRobot::getCycleTimeUSec(void) const
+{
+  return myCycleTimeUSec;
+}
+
+/**
+   @see MvrSyncLoop::setAbsoluteTiming
+**/
+MVREXPORT void MvrRobot::setAbsoluteCycleTiming(bool absoluteCycleTiming)
+{
+  mySyncLoop.setAbsoluteTiming(absoluteCycleTiming);
+}
+
+MVREXPORT bool MvrRobot::getAbsoluteCycleTiming(void)
+{
+  return mySyncLoop.getAbsoluteTiming();
+}
+
+/**
+   @see MvrSyncLoop::getJitter
+**/
+MVREXPORT const MvrLatencyHistogram *MvrRobot::getCycleJitter(void)
+{
+  return mySyncLoop.getJitter();
+}
+
+/**
+   @see MvrSyncLoop::getNumMissedDeadlines
+**/
+MVREXPORT unsigned long long MvrRobot::getCycleNumMissedDeadlines(void)
+{
+  return mySyncLoop.getNumMissedDeadlines();
+}
+
+MVREXPORT void MvrRobot::resetCycleTimingStats(void)
+{
+  mySyncLoop.resetTimingStats();
 }
 
 /**
@@ -5906,6 +6048,9 @@ MVREXPORT void MvrRobot::addRangeDevice(MvrRangeDevice *device)
 {
   device->setRobot(this);
   myRangeDeviceList.push_front(device);
+  myObstacleSnapshot.lock();
+  myObstacleSnapshot.invalidate();
+  myObstacleSnapshot.unlock();
 }
 
 /**
@@ -5919,6 +6064,9 @@ MVREXPORT void MvrRobot::remRangeDevice(const char *name)
     if (strcmp(name, (*it)->getName()) == 0)
     {
       myRangeDeviceList.erase(it);
+      myObstacleSnapshot.lock();
+      myObstacleSnapshot.invalidate();
+      myObstacleSnapshot.unlock();
       return;
     }
   }
@@ -5935,6 +6083,9 @@ MVREXPORT void MvrRobot::remRangeDevice(MvrRangeDevice *device)
     if ((*it) == device)
     {
       myRangeDeviceList.erase(it);
+      myObstacleSnapshot.lock();
+      myObstacleSnapshot.invalidate();
+      myObstacleSnapshot.unlock();
       return;
     }
   }
@@ -6019,6 +6170,10 @@ MVREXPORT bool MvrRobot::hasRangeDevice(MvrRangeDevice *device) const
  *  MvrRangeDevice::currentReadingPolar() to find a reading, then calls
  *  MvrRangeDevice::unlockDevice().
  *
+ *  Once sensor interpretation is done for the cycle this is answered
+ *  from a snapshot of the current readings instead (see
+ *  setUseObstacleSnapshot()).
+ *
  *  @copydoc MvrRangeDevice::currentReadingPolar()
  *  @param rangeDevice If not null, then a pointer to the MvrRangeDevice 
  *    that provided the returned reading is placed in this vmvriable.
@@ -6038,6 +6193,18 @@ MVREXPORT double MvrRobot::checkRangeDevicesCurrentPolar(
   bool foundOne = false;
   const MvrRangeDevice *closestRangeDevice = NULL;
 
+  if (myUseObstacleSnapshot && myObstacleSnapshotReadyCounter == myCounter)
+  {
+    myObstacleSnapshot.lock();
+    if (!myObstacleSnapshot.isValid(myCounter, getPose()))
+      myObstacleSnapshot.build(&myRangeDeviceList, getPose(), myCounter);
+    closest = myObstacleSnapshot.checkCurrentPolar(
+	    startAngle, endAngle, angle, rangeDevice, 
+	    useLocationDependentDevices);
+    myObstacleSnapshot.unlock();
+    return closest;
+  }
+
   for (it = myRangeDeviceList.begin(); it != myRangeDeviceList.end(); ++it)
   {
     device = (*it);
@@ -6146,7 +6313,10 @@ MVREXPORT double MvrRobot::checkRangeDevicesCumulativePolar(
    Gets the closest reading in a region defined by the two points of a 
    rectangle.
    This goes through all of the registered range devices and locks each,
-   calls currentReadingBox on it, and then unlocks it.
+   calls currentReadingBox on it, and then unlocks it.  Once sensor
+   interpretation is done for the cycle this is answered from a
+   snapshot of the current readings instead (see
+   setUseObstacleSnapshot()).
 
    @param x1 the x coordinate of one of the rectangle points
    @param y1 the y coordinate of one of the rectangle points
@@ -6175,6 +6345,18 @@ MVREXPORT double MvrRobot::checkRangeDevicesCurrentBox(
   bool foundOne = false;
   const MvrRangeDevice *closestRangeDevice = NULL;
 
+  if (myUseObstacleSnapshot && myObstacleSnapshotReadyCounter == myCounter)
+  {
+    myObstacleSnapshot.lock();
+    if (!myObstacleSnapshot.isValid(myCounter, getPose()))
+      myObstacleSnapshot.build(&myRangeDeviceList, getPose(), myCounter);
+    closest = myObstacleSnapshot.checkCurrentBox(
+	    x1, y1, x2, y2, readingPos, rangeDevice, 
+	    useLocationDependentDevices);
+    myObstacleSnapshot.unlock();
+    return closest;
+  }
+
   for (it = myRangeDeviceList.begin(); it != myRangeDeviceList.end(); ++it)
   {
     device = (*it);
@@ -6211,6 +6393,90 @@ MVREXPORT double MvrRobot::checkRangeDevicesCurrentBox(
   return closest;
 }
 
+/**
+   Finds the closest current reading in each of several regions (polar
+   or box, see MvrRangeRegion).  This goes through the registered range
+   devices once, locking each and calling
+   MvrRangeDevice::currentReadingRegions() on it, so each device's
+   readings are only walked once for all of the regions instead of once
+   per checkRangeDevicesCurrentPolar() or checkRangeDevicesCurrentBox()
+   call.  Once sensor interpretation is done for the cycle this is
+   answered from a snapshot of the current readings instead (see
+   setUseObstacleSnapshot()).
+
+   The results for each region are the same as
+   checkRangeDevicesCurrentPolar() or checkRangeDevicesCurrentBox()
+   would give for it, and are put in the region (see
+   MvrRangeRegion::getDist(), which is < 0 if there were no range
+   devices to check).
+
+   @param regions the regions to check
+   @param numRegions the number of regions
+   @param useLocationDependentDevices If false, ignore sensor devices that are "location dependent". If true, include them in this check.
+**/
+MVREXPORT void MvrRobot::checkRangeDevicesCurrentRegions(
+	MvrRangeRegion *regions, size_t numRegions,
+	bool useLocationDependentDevices) const
+{
+  std::list<MvrRangeDevice *>::const_iterator it;
+  MvrRangeDevice *device;
+  bool foundOne = false;
+  // callers only ask about a couple of regions, so these normally go
+  // on the stack
+  MvrRangeRegion stackRegions[8];
+  std::vector<MvrRangeRegion> heapRegions;
+  MvrRangeRegion *deviceRegions = stackRegions;
+  size_t r;
+
+  if (numRegions == 0)
+    return;
+
+  if (myUseObstacleSnapshot && myObstacleSnapshotReadyCounter == myCounter)
+  {
+    myObstacleSnapshot.lock();
+    if (!myObstacleSnapshot.isValid(myCounter, getPose()))
+      myObstacleSnapshot.build(&myRangeDeviceList, getPose(), myCounter);
+    myObstacleSnapshot.checkCurrentRegions(regions, numRegions,
+					   useLocationDependentDevices);
+    myObstacleSnapshot.unlock();
+    return;
+  }
+
+  if (numRegions > sizeof(stackRegions) / sizeof(stackRegions[0]))
+  {
+    heapRegions.assign(regions, regions + numRegions);
+    deviceRegions = &heapRegions[0];
+  }
+  else
+  {
+    std::copy(regions, regions + numRegions, stackRegions);
+  }
+
+  for (r = 0; r < numRegions; r++)
+    regions[r].clearResult();
+
+  for (it = myRangeDeviceList.begin(); it != myRangeDeviceList.end(); ++it)
+  {
+    device = (*it);
+    device->lockDevice();
+    if (!useLocationDependentDevices && device->isLocationDependent())
+    {
+      device->unlockDevice();
+      continue;
+    }
+    device->currentReadingRegions(deviceRegions, numRegions);
+    device->unlockDevice();
+    for (r = 0; r < numRegions; r++)
+    {
+      if (!foundOne || deviceRegions[r].getDist() < regions[r].getDist())
+	regions[r].setResult(deviceRegions[r].getDist(), 
+			     deviceRegions[r].getAngle(),
+			     deviceRegions[r].getReadingPos(), device);
+    }
+    foundOne = true;
+  }
+}
+
 /**
    Gets the closest reading in a region defined by the two points of a 
    rectangle.
@@ -7600,7 +7866,5 @@ MVREXPORT int MvrRobot::applyEncoderOffset(MvrPoseWithTime from, MvrTime to,
 MVREXPORT void MvrRobot::internalIgnoreNextPacket(void)
 {
   myIgnoreNextPacket = true;
-  myPacketMutex.lock();
-  myPacketList.clear();
-  myPacketMutex.unlock();
+  myPacketQueue.clear();
 }
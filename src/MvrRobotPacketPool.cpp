@@ -0,0 +1,162 @@
+#include "MvrExport.h"
+#include "mvriaOSDef.h"
+#include "MvrRobotPacketPool.h"
+#include "MvrRobotPacket.h"
+
+/**
+   @param sync1 the first sync byte for the packets
+   @param sync2 the second sync byte for the packets
+   @param maxFree the most free packets to keep around, any packets put
+   back beyond this are deleted
+**/
+MVREXPORT MvrRobotPacketPool::MvrRobotPacketPool(unsigned char sync1,
+						 unsigned char sync2,
+						 size_t maxFree) :
+  mySync1(sync1),
+  mySync2(sync2),
+  myMaxFree(maxFree),
+  myNumAllocated(0),
+  myNumGets(0),
+  myNumReused(0),
+  myNumOutstanding(0)
+{
+  myMutex.setLogName("MvrRobotPacketPool::myMutex");
+  myFree.reserve(myMaxFree);
+}
+
+MVREXPORT MvrRobotPacketPool::~MvrRobotPacketPool()
+{
+  std::vector<MvrRobotPacket *>::iterator it;
+  for (it = myFree.begin(); it != myFree.end(); it++)
+    delete (*it);
+  myFree.clear();
+}
+
+MVREXPORT MvrRobotPacket *MvrRobotPacketPool::get(void)
+{
+  MvrRobotPacket *packet = NULL;
+
+  myMutex.lock();
+  myNumGets++;
+  myNumOutstanding++;
+  if (!myFree.empty())
+  {
+    packet = myFree.back();
+    myFree.pop_back();
+    myNumReused++;
+  }
+  else
+    myNumAllocated++;
+  myMutex.unlock();
+
+  // allocate outside of the lock so put() doesn't wait on the heap
+  if (packet == NULL)
+    packet = new MvrRobotPacket(mySync1, mySync2);
+  return packet;
+}
+
+/**
+   @param packet the packet to put back, it must have come from get()
+   (on this pool or another one with the same sync bytes), if it is
+   NULL nothing happens
+**/
+MVREXPORT void MvrRobotPacketPool::put(MvrRobotPacket *packet)
+{
+  if (packet == NULL)
+    return;
+
+  myMutex.lock();
+  if (myNumOutstanding > 0)
+    myNumOutstanding--;
+  if (myFree.size() < myMaxFree)
+  {
+    myFree.push_back(packet);
+    packet = NULL;
+  }
+  myMutex.unlock();
+
+  if (packet != NULL)
+    delete packet;
+}
+
+/**
+   The packets made here count towards getNumAllocated(), so that
+   after preallocating the number can be checked to stay the same.
+**/
+MVREXPORT void MvrRobotPacketPool::preallocate(size_t num)
+{
+  MvrRobotPacket *packet;
+
+  if (num > myMaxFree)
+    num = myMaxFree;
+  myMutex.lock();
+  while (myFree.size() < num)
+  {
+    packet = new MvrRobotPacket(mySync1, mySync2);
+    myFree.push_back(packet);
+    myNumAllocated++;
+  }
+  myMutex.unlock();
+}
+
+MVREXPORT size_t MvrRobotPacketPool::getNumAllocated(void)
+{
+  size_t ret;
+  myMutex.lock();
+  ret = myNumAllocated;
+  myMutex.unlock();
+  return ret;
+}
+
+MVREXPORT size_t MvrRobotPacketPool::getNumGets(void)
+{
+  size_t ret;
+  myMutex.lock();
+  ret = myNumGets;
+  myMutex.unlock();
+  return ret;
+}
+
+MVREXPORT size_t MvrRobotPacketPool::getNumReused(void)
+{
+  size_t ret;
+  myMutex.lock();
+  ret = myNumReused;
+  myMutex.unlock();
+  return ret;
+}
+
+/**
+   Packets that were deleted instead of put back still count as being
+   out.
+**/
+MVREXPORT size_t MvrRobotPacketPool::getNumOutstanding(void)
+{
+  size_t ret;
+  myMutex.lock();
+  ret = myNumOutstanding;
+  myMutex.unlock();
+  return ret;
+}
+
+MVREXPORT size_t MvrRobotPacketPool::getNumFree(void)
+{
+  size_t ret;
+  myMutex.lock();
+  ret = myFree.size();
+  myMutex.unlock();
+  return ret;
+}
+
+/**
+   The number outstanding isn't reset, since those packets are still
+   out.
+**/
+MVREXPORT void MvrRobotPacketPool::resetCounters(void)
+{
+  myMutex.lock();
+  myNumAllocated = 0;
+  myNumGets = 0;
+  myNumReused = 0;
+  myMutex.unlock();
+}
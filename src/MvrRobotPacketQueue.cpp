@@ -0,0 +1,176 @@
+#include "MvrExport.h"
+#include "mvriaOSDef.h"
+#include "MvrRobotPacketQueue.h"
+#include "MvrRobotPacket.h"
+#include "MvrRobotPacketPool.h"
+#include "mvriaUtil.h"
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <time.h>
+#include <errno.h>
+#endif
+
+MVREXPORT MvrRobotPacketQueue::MvrRobotPacketQueue(size_t capacity) :
+  myPacketPool(NULL),
+  myHead(0),
+  myTail(0),
+  myPendingSips(0),
+  mySequence(0),
+  myWaiting(0),
+  myClearedBefore(0),
+  myNumFull(0)
+{
+  size_t size = 2;
+  while (size < capacity)
+    size *= 2;
+  mySlots.resize(size, NULL);
+  myMask = size - 1;
+}
+
+MVREXPORT MvrRobotPacketQueue::~MvrRobotPacketQueue()
+{
+  MvrRobotPacket *packet;
+  while ((packet = popOne()) != NULL)
+    delete packet;
+}
+
+MVREXPORT bool MvrRobotPacketQueue::isSip(MvrRobotPacket *packet)
+{
+  return ((packet->getID() & 0xf0) == 0x30);
+}
+
+/**
+   @param packet the packet to add, the queue owns it if this returns true
+
+   @return true if the packet was added, false if the queue was full
+   (the caller still owns the packet then, and should wait for the
+   consumer to make room and try again)
+**/
+MVREXPORT bool MvrRobotPacketQueue::push(MvrRobotPacket *packet)
+{
+  size_t tail = myTail.load(std::memory_order_relaxed);
+  bool sip = isSip(packet);
+
+  if (tail - myHead.load(std::memory_order_acquire) >= mySlots.size())
+  {
+    myNumFull.fetch_add(1);
+    return false;
+  }
+  // count the sip before it can be seen, so the count is never less
+  // than the number of sips the consumer could pop
+  if (sip)
+    myPendingSips.fetch_add(1);
+  mySlots[tail & myMask] = packet;
+  myTail.store(tail + 1, std::memory_order_release);
+  mySequence.fetch_add(1);
+  if (myWaiting.load() != 0)
+    wake();
+  return true;
+}
+
+MvrRobotPacket *MvrRobotPacketQueue::popOne(void)
+{
+  size_t head = myHead.load(std::memory_order_relaxed);
+  MvrRobotPacket *packet;
+
+  if (head == myTail.load(std::memory_order_acquire))
+    return NULL;
+  packet = mySlots[head & myMask];
+  mySlots[head & myMask] = NULL;
+  myHead.store(head + 1, std::memory_order_release);
+  if (isSip(packet))
+    myPendingSips.fetch_sub(1);
+  return packet;
+}
+
+/**
+   @return the oldest packet (which the caller now owns and should
+   give back to wherever it came from), or NULL if there isn't one
+**/
+MVREXPORT MvrRobotPacket *MvrRobotPacketQueue::pop(void)
+{
+  MvrRobotPacket *packet;
+  size_t clearedBefore = myClearedBefore.load(std::memory_order_acquire);
+
+  // throw away anything that was in the queue when clear() was called
+  while ((ptrdiff_t)(clearedBefore - myHead.load(std::memory_order_relaxed)) > 0 &&
+	 (packet = popOne()) != NULL)
+  {
+    if (myPacketPool != NULL)
+      myPacketPool->put(packet);
+    else
+      delete packet;
+  }
+  return popOne();
+}
+
+/**
+   Everything that is in the queue when this is called is gone as far
+   as the consumer is concerned: pop() will never return any of it,
+   even if the consumer is in the middle of going through the queue.
+   (The packets themselves are given back by the consumer, the next
+   time it calls pop(), so that only it takes things off the queue.)
+**/
+MVREXPORT void MvrRobotPacketQueue::clear(void)
+{
+  size_t tail = myTail.load(std::memory_order_acquire);
+  size_t clearedBefore = myClearedBefore.load();
+
+  // only ever move the clear point forward, in case two threads clear
+  while ((ptrdiff_t)(tail - clearedBefore) > 0 &&
+	 !myClearedBefore.compare_exchange_weak(clearedBefore, tail))
+    ;
+}
+
+void MvrRobotPacketQueue::wake(void)
+{
+#ifdef __linux__
+  syscall(SYS_futex, reinterpret_cast<int *>(&mySequence),
+	  FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+#endif
+}
+
+/**
+   @param msecs the longest to wait, in milliseconds
+
+   @return true if there is a packet to pop, false if there still
+   wasn't one after msecs
+**/
+MVREXPORT bool MvrRobotPacketQueue::waitForPacket(int msecs)
+{
+  MvrTime start;
+  int sequence;
+  long long left;
+
+  while (true)
+  {
+    myWaiting.store(1);
+    // read the sequence before looking at the queue, so if a push
+    // sneaks in after we look the futex won't sleep
+    sequence = mySequence.load();
+    if (myHead.load(std::memory_order_relaxed) !=
+	myTail.load(std::memory_order_acquire))
+    {
+      myWaiting.store(0);
+      return true;
+    }
+    left = msecs - start.mSecSinceLL();
+    if (left <= 0)
+    {
+      myWaiting.store(0);
+      return false;
+    }
+#ifdef __linux__
+    struct timespec timeout;
+    timeout.tv_sec = left / 1000;
+    timeout.tv_nsec = (left % 1000) * 1000000;
+    syscall(SYS_futex, reinterpret_cast<int *>(&mySequence),
+	    FUTEX_WAIT_PRIVATE, sequence, &timeout, NULL, 0);
+#else
+    MvrUtil::sleep(1);
+#endif
+  }
+}
@@ -5,6 +5,7 @@
 #include "MvrLogFileConnection.h"
 #include "MvrLog.h"
 #include "mvriaUtil.h"
+#include <string.h>
 
 
 /**
@@ -20,7 +21,8 @@
 MVREXPORT MvrRobotPacketReceiver::MvrRobotPacketReceiver(bool allocatePackets,
 						      unsigned char sync1,
 						      unsigned char sync2) : 
-  myPacket(sync1, sync2)
+  myPacket(sync1, sync2),
+  myPacketPool(sync1, sync2)
 {
   myAllocatePackets = allocatePackets;
 	myTracking = false;
@@ -29,6 +31,9 @@ MVREXPORT MvrRobotPacketReceiver::MvrRobotPacketReceiver(bool allocatePackets,
   mySync1 = sync1;
   mySync2 = sync2;
   myPacketReceivedCallback = NULL;
+  myReadStart = 0;
+  myReadEnd = 0;
+  myNumReadChunks = 0;
 }
 
 /**
@@ -45,7 +50,8 @@ MVREXPORT MvrRobotPacketReceiver::MvrRobotPacketReceiver(bool allocatePackets,
 MVREXPORT MvrRobotPacketReceiver::MvrRobotPacketReceiver(
 	MvrDeviceConnection *deviceConnection, bool allocatePackets,
 	unsigned char sync1, unsigned char sync2) :
-  myPacket(sync1, sync2)
+  myPacket(sync1, sync2),
+  myPacketPool(sync1, sync2)
 {
   myDeviceConn = deviceConnection;
 	myTracking = false;
@@ -54,6 +60,9 @@ MVREXPORT MvrRobotPacketReceiver::MvrRobotPacketReceiver(
   mySync1 = sync1;
   mySync2 = sync2;
   myPacketReceivedCallback = NULL;
+  myReadStart = 0;
+  myReadEnd = 0;
+  myNumReadChunks = 0;
 }
 
 /**
@@ -75,13 +84,17 @@ MVREXPORT MvrRobotPacketReceiver::MvrRobotPacketReceiver(
 	const char *trackingLogName) :
   myPacket(sync1, sync2),
 	myTracking(tracking),
-	myTrackingLogName(trackingLogName)
+	myTrackingLogName(trackingLogName),
+  myPacketPool(sync1, sync2)
 {
   myDeviceConn = deviceConnection;
   myAllocatePackets = allocatePackets;
   mySync1 = sync1;
   mySync2 = sync2;
   myPacketReceivedCallback = NULL;
+  myReadStart = 0;
+  myReadEnd = 0;
+  myNumReadChunks = 0;
 }
 
 MVREXPORT MvrRobotPacketReceiver::~MvrRobotPacketReceiver() 
@@ -93,6 +106,10 @@ MVREXPORT void MvrRobotPacketReceiver::setDeviceConnection(
 	MvrDeviceConnection *deviceConnection)
 {
   myDeviceConn = deviceConnection;
+  // anything buffered came from the old connection
+  myReadStart = 0;
+  myReadEnd = 0;
+  myNumReadChunks = 0;
 }
 
 MVREXPORT MvrDeviceConnection *MvrRobotPacketReceiver::getDeviceConnection(void)
@@ -104,15 +121,16 @@ MVREXPORT MvrDeviceConnection *MvrRobotPacketReceiver::getDeviceConnection(void)
     @param msWait how long to block for the start of a packet, nonblocking if 0
     @return NULL if there are no packets in alloted time, the device connection is closed, or other error. Otherwise a pointer
     to the packet received is returned. If allocatePackets is true than the caller 
-    must delete the packet. If allocatePackets is false then the packet object
-    will be reused in the next call; the caller must not store or use that packet object.
+    owns the packet and should give it back with releasePacket() when done with it
+    (deleting it works too, but then it can't be reused). If allocatePackets is false
+    then the packet object will be reused in the next call; the caller must not store
+    or use that packet object.
  */
 MVREXPORT MvrRobotPacket* MvrRobotPacketReceiver::receivePacket(unsigned int msWait)
 {
   MvrRobotPacket *packet;
   unsigned char c;
   char buf[256];
-  int count = 0;
   // state can be one of the STATE_ enums in the class
   int state = STATE_SYNC1;
   //unsigned int timeDone;
@@ -123,7 +141,7 @@ MVREXPORT MvrRobotPacket* MvrRobotPacketReceiver::receivePacket(unsigned int msW
   MvrTime packetReceived;
   int numRead;
   if (myAllocatePackets)
-    packet = new MvrRobotPacket(mySync1, mySync2);
+    packet = myPacketPool.get();
   else
     packet = &myPacket;
 
@@ -134,7 +152,7 @@ MVREXPORT MvrRobotPacket* MvrRobotPacketReceiver::receivePacket(unsigned int msW
       MvrLog::log(MvrLog::Normal, "%s: receivePacket: connection not open", myTrackingLogName.c_str());
     myDeviceConn->debugEndPacket(false, -10);
     if (myAllocatePackets)
-      delete packet;
+      myPacketPool.put(packet);
     return NULL;
   }
   
@@ -191,7 +209,7 @@ MVREXPORT MvrRobotPacket* MvrRobotPacketReceiver::receivePacket(unsigned int msW
     {
       myDeviceConn->debugEndPacket(false, -20);
       if (myAllocatePackets)
-	      delete packet;
+	      myPacketPool.put(packet);
      
       return NULL;
     }
@@ -207,16 +225,15 @@ MVREXPORT MvrRobotPacket* MvrRobotPacketReceiver::receivePacket(unsigned int msW
       if (state == STATE_SYNC1)
 	      myDeviceConn->debugStartPacket();
 
-      if (myDeviceConn->read((char *)&c, 1, timeToRunFor) == 0) 
+      if (myReadStart == myReadEnd && fillReadBuffer(timeToRunFor) == 0) 
       {
-        myDeviceConn->debugBytesRead(0);
           if (state == STATE_SYNC1)
             {
               myDeviceConn->debugEndPacket(false, -30);
               if (myAllocatePackets)
-                delete packet; 
+                myPacketPool.put(packet); 
               if (myTracking)
-                MvrLog::log(MvrLog::Normal, "%s: waiting for sync1 (got 0x%x).", myTrackingLogName.c_str(), c);
+                MvrLog::log(MvrLog::Normal, "%s: waiting for sync1 (no data).", myTrackingLogName.c_str());
               return NULL;
             }
           else
@@ -226,7 +243,12 @@ MVREXPORT MvrRobotPacket* MvrRobotPacketReceiver::receivePacket(unsigned int msW
             }
         }
 
-      myDeviceConn->debugBytesRead(1);
+      c = (unsigned char)myReadBuf[myReadStart];
+      // get the time before the byte's taken out, since that can
+      // throw away the chunk it came in with
+      if (state == STATE_SYNC1 && c == mySync1)
+        packetReceived = getReadBufferTime(myReadStart);
+      consumeReadBuffer(1);
 
       switch (state) {
       case STATE_SYNC1:
@@ -240,7 +262,6 @@ MVREXPORT MvrRobotPacket* MvrRobotPacketReceiver::receivePacket(unsigned int msW
             packet->empty();
             packet->setLength(0);
             packet->uByteToBuf(c);
-            packetReceived = myDeviceConn->getTimeRead(0);
             packet->setTimeReceived(packetReceived);
           }
         else
@@ -270,7 +291,6 @@ MVREXPORT MvrRobotPacket* MvrRobotPacketReceiver::receivePacket(unsigned int msW
         // so we'll just put it into the packet then get the rest of the data
         packet->uByteToBuf(c);
         // if c > 200 than there is a problem, spec says packet max size is 200
-        count = 0;
 	/** this case can't happen since c can't be over that so taking it out
         if (c > 255) 
           {
@@ -283,29 +303,21 @@ MVREXPORT MvrRobotPacket* MvrRobotPacketReceiver::receivePacket(unsigned int msW
         // we go 100 ms without data... its arbitrary but it doesn't happen often
         // and it'll mean a bad packet anyways
         lastDataRead.setToNow();
-        while (count < c)
+        while (myReadEnd - myReadStart < c)
           {
-            numRead = myDeviceConn->read(buf + count, c - count, 1);
-            if (numRead > 0)
-            {
-              myDeviceConn->debugBytesRead(numRead);
-                    lastDataRead.setToNow();
-            }
-            else
-            {
-              myDeviceConn->debugBytesRead(0);
-            }
+            if (fillReadBuffer(1) > 0)
+              lastDataRead.setToNow();
             if (lastDataRead.mSecTo() < -100)
             {
               myDeviceConn->debugEndPacket(false, -40);
               if (myAllocatePackets)
-                delete packet;
+                myPacketPool.put(packet);
               //printf("Bad time taken reading\n");
               return NULL;
             }
-            count += numRead;
           }
-        packet->dataToBuf(buf, c);
+        packet->dataToBuf(myReadBuf + myReadStart, c);
+        consumeReadBuffer(c);
         if (packet->verifyCheckSum()) 
         {
 	
@@ -365,11 +377,103 @@ MVREXPORT MvrRobotPacket* MvrRobotPacketReceiver::receivePacket(unsigned int msW
   myDeviceConn->debugEndPacket(false, -60);
   //printf("finished the loop...\n"); 
   if (myAllocatePackets)
-    delete packet;
+    myPacketPool.put(packet);
   return NULL;
 
 }
 
+/**
+   @param packet a packet this receiver returned from receivePacket()
+   while it was allocating packets, it goes back into the pool for
+   receivePacket() to use again
+**/
+MVREXPORT void MvrRobotPacketReceiver::releasePacket(MvrRobotPacket *packet)
+{
+  myPacketPool.put(packet);
+}
+
+/**
+   This pulls in whatever the connection has (waiting up to msWait for
+   something to show up) with one MvrDeviceConnection::readAvailable(),
+   and notes the time it was read so packets framed out of it get the
+   time their first byte showed up.
+
+   @return the number of bytes read, 0 if there weren't any
+**/
+int MvrRobotPacketReceiver::fillReadBuffer(unsigned int msWait)
+{
+  int numRead;
+  int i;
+
+  // slide what's left to the front when there's no more room after it
+  if (myReadEnd == READ_BUFFER_SIZE && myReadStart > 0)
+  {
+    memmove(myReadBuf, myReadBuf + myReadStart, myReadEnd - myReadStart);
+    for (i = 0; i < myNumReadChunks; i++)
+      myReadChunkEnds[i] -= myReadStart;
+    myReadEnd -= myReadStart;
+    myReadStart = 0;
+  }
+  if (myReadEnd == READ_BUFFER_SIZE)
+    return 0;
+
+  numRead = myDeviceConn->readAvailable(myReadBuf + myReadEnd,
+					READ_BUFFER_SIZE - myReadEnd, msWait);
+  if (numRead <= 0)
+  {
+    myDeviceConn->debugBytesRead(0);
+    return 0;
+  }
+  myDeviceConn->debugBytesRead(numRead);
+  myReadEnd += numRead;
+  // if there are too many chunks in the buffer (a packet dribbling in
+  // a few bytes at a time) the new bytes get lumped in with the last one
+  if (myNumReadChunks < MAX_READ_CHUNKS)
+  {
+    myReadChunkTimes[myNumReadChunks] = myDeviceConn->getTimeRead(0);
+    myNumReadChunks++;
+  }
+  myReadChunkEnds[myNumReadChunks - 1] = myReadEnd;
+  return numRead;
+}
+
+MvrTime MvrRobotPacketReceiver::getReadBufferTime(int index)
+{
+  int i;
+  for (i = 0; i < myNumReadChunks; i++)
+  {
+    if (index < myReadChunkEnds[i])
+      return myReadChunkTimes[i];
+  }
+  return MvrTime();
+}
+
+void MvrRobotPacketReceiver::consumeReadBuffer(int num)
+{
+  int i;
+  int done;
+
+  myReadStart += num;
+  if (myReadStart >= myReadEnd)
+  {
+    myReadStart = 0;
+    myReadEnd = 0;
+    myNumReadChunks = 0;
+    return;
+  }
+  // forget the chunks that have been used up
+  for (done = 0; done < myNumReadChunks && 
+	 myReadChunkEnds[done] <= myReadStart; done++);
+  if (done == 0)
+    return;
+  for (i = done; i < myNumReadChunks; i++)
+  {
+    myReadChunkEnds[i - done] = myReadChunkEnds[i];
+    myReadChunkTimes[i - done] = myReadChunkTimes[i];
+  }
+  myNumReadChunks -= done;
+}
+
 MVREXPORT void MvrRobotPacketReceiver::setPacketReceivedCallback(
 	MvrFunctor1<MvrRobotPacket *> *functor)
 {
@@ -516,6 +516,13 @@ MVREXPORT void MvrRobotParams::addLaserToConfig(
                 sizeof(laserData->myLaserReflectorBitsChoice)),
     section,
 	  MvrPriority::NORMAL);
+  config->addParam(
+	  MvrConfigArg("LaserProtocolChoice", 
+		            laserData->myLaserProtocolChoice, 
+		            "Protocol to talk to the laser with. Leave blank to use the default.",
+                sizeof(laserData->myLaserProtocolChoice)),
+    section,
+	  MvrPriority::NORMAL);
 
 }
 
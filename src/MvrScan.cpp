@@ -0,0 +1,251 @@
+#include "MvrExport.h"
+#include "mvriaOSDef.h"
+#include "MvrScan.h"
+
+MVREXPORT MvrScan::MvrScan()
+{
+  myNumReadings = 0;
+  myGeneration = 0;
+  myCounterTaken = 0;
+  myTransX = 0;
+  myTransY = 0;
+  myTransCos = 1;
+  myTransSin = 0;
+}
+
+MVREXPORT MvrScan::~MvrScan()
+{
+}
+
+/**
+   Readings past the old number of readings start out ignored with a
+   range of 0.
+**/
+MVREXPORT void MvrScan::setNumReadings(int numReadings)
+{
+  int i;
+  if (numReadings < 0)
+    numReadings = 0;
+  myRanges.resize(numReadings, 0);
+  myIntensities.resize(numReadings, 0);
+  myAngleIndexes.resize(numReadings, 0);
+  myIgnores.resize(numReadings, 1);
+  myTh.resize(numReadings, 0);
+  myCos.resize(numReadings, 1);
+  mySin.resize(numReadings, 0);
+  mySensorXs.resize(numReadings, 0);
+  mySensorYs.resize(numReadings, 0);
+  myLocalXs.resize(numReadings, 0);
+  myLocalYs.resize(numReadings, 0);
+  myXs.resize(numReadings, 0);
+  myYs.resize(numReadings, 0);
+  myTimeOffsets.resize(numReadings, 0);
+  for (i = 0; i < numReadings; i++)
+    myAngleIndexes[i] = i;
+  myNumReadings = numReadings;
+}
+
+/**
+   @param poseTaken the robot's pose when the scan was taken
+   @param encoderPoseTaken the robot's encoder pose when the scan was taken
+   @param toGlobal the transform from the robot's coordinates to
+   global ones (usually MvrTransform(poseTaken))
+   @param counterTaken the robot's counter when the scan was taken
+   @param timeTaken the time the scan was taken
+**/
+MVREXPORT void MvrScan::beginScan(MvrPose poseTaken, MvrPose encoderPoseTaken,
+				  MvrTransform toGlobal, 
+				  unsigned int counterTaken,
+				  MvrTime timeTaken)
+{
+  myPoseTaken = poseTaken;
+  myOrigPoseTaken = poseTaken;
+  myEncoderPoseTaken = encoderPoseTaken;
+  myCounterTaken = counterTaken;
+  myTimeTaken = timeTaken;
+  myToGlobal = toGlobal;
+  myTransX = toGlobal.getX();
+  myTransY = toGlobal.getY();
+  myTransCos = toGlobal.getCos();
+  myTransSin = toGlobal.getSin();
+  myAppliedTransforms.clear();
+}
+
+MVREXPORT MvrTime MvrScan::getTimeTaken(int i) const
+{
+  MvrTime ret = myTimeTaken;
+  if (myTimeOffsets[i] != 0)
+    ret.addMSec(myTimeOffsets[i]);
+  return ret;
+}
+
+MVREXPORT void MvrScan::applyTransform(MvrTransform trans)
+{
+  applyTransform(trans, 0, 1);
+}
+
+/**
+   getPoseTaken() is where the first reading was taken, so it only
+   changes if first is 0.
+**/
+MVREXPORT void MvrScan::applyTransform(MvrTransform trans, int first,
+				       int step)
+{
+  AppliedTransform applied;
+  int i;
+  double x;
+  double y;
+  double transX = trans.getX();
+  double transY = trans.getY();
+  double transCos = trans.getCos();
+  double transSin = trans.getSin();
+
+  for (i = first; i < myNumReadings; i += step)
+  {
+    x = myXs[i];
+    y = myYs[i];
+    myXs[i] = transX + transCos * x + transSin * y;
+    myYs[i] = transY + transCos * y - transSin * x;
+  }
+  if (first == 0)
+    myPoseTaken = trans.doTransform(myPoseTaken);
+  applied.myTrans = trans;
+  applied.myFirst = first;
+  applied.myStep = step;
+  applied.myEncoder = false;
+  myAppliedTransforms.push_back(applied);
+  myGeneration++;
+}
+
+/**
+   getEncoderPoseTaken() is where the first reading was taken, so it
+   only changes if first is 0.
+**/
+MVREXPORT void MvrScan::applyEncoderTransform(MvrTransform trans, int first,
+					      int step)
+{
+  AppliedTransform applied;
+
+  if (first == 0)
+    myEncoderPoseTaken = trans.doTransform(myEncoderPoseTaken);
+  applied.myTrans = trans;
+  applied.myFirst = first;
+  applied.myStep = step;
+  applied.myEncoder = true;
+  myAppliedTransforms.push_back(applied);
+  myGeneration++;
+}
+
+/**
+   This copies everything but the generation, which stays this scan's
+   own, so call endScan() after it.
+**/
+MVREXPORT void MvrScan::copyScan(const MvrScan *scan)
+{
+  myNumReadings = scan->myNumReadings;
+  myRanges = scan->myRanges;
+  myIntensities = scan->myIntensities;
+  myAngleIndexes = scan->myAngleIndexes;
+  myIgnores = scan->myIgnores;
+  myTh = scan->myTh;
+  myCos = scan->myCos;
+  mySin = scan->mySin;
+  mySensorXs = scan->mySensorXs;
+  mySensorYs = scan->mySensorYs;
+  myLocalXs = scan->myLocalXs;
+  myLocalYs = scan->myLocalYs;
+  myXs = scan->myXs;
+  myYs = scan->myYs;
+  myTimeOffsets = scan->myTimeOffsets;
+  myPoseTaken = scan->myPoseTaken;
+  myEncoderPoseTaken = scan->myEncoderPoseTaken;
+  myCounterTaken = scan->myCounterTaken;
+  myTimeTaken = scan->myTimeTaken;
+  myTransX = scan->myTransX;
+  myTransY = scan->myTransY;
+  myTransCos = scan->myTransCos;
+  myTransSin = scan->myTransSin;
+  myOrigPoseTaken = scan->myOrigPoseTaken;
+  myToGlobal = scan->myToGlobal;
+  myAppliedTransforms = scan->myAppliedTransforms;
+}
+
+/**
+   This swaps everything but the generations, so a driver can build
+   up a scan in one MvrScan and then swap it into the range device's
+   raw scan when it's done (and call endScan() on that).
+**/
+MVREXPORT void MvrScan::swapScan(MvrScan *scan)
+{
+  std::swap(myNumReadings, scan->myNumReadings);
+  myRanges.swap(scan->myRanges);
+  myIntensities.swap(scan->myIntensities);
+  myAngleIndexes.swap(scan->myAngleIndexes);
+  myIgnores.swap(scan->myIgnores);
+  myTh.swap(scan->myTh);
+  myCos.swap(scan->myCos);
+  mySin.swap(scan->mySin);
+  mySensorXs.swap(scan->mySensorXs);
+  mySensorYs.swap(scan->mySensorYs);
+  myLocalXs.swap(scan->myLocalXs);
+  myLocalYs.swap(scan->myLocalYs);
+  myXs.swap(scan->myXs);
+  myYs.swap(scan->myYs);
+  myTimeOffsets.swap(scan->myTimeOffsets);
+  std::swap(myPoseTaken, scan->myPoseTaken);
+  std::swap(myEncoderPoseTaken, scan->myEncoderPoseTaken);
+  std::swap(myCounterTaken, scan->myCounterTaken);
+  std::swap(myTimeTaken, scan->myTimeTaken);
+  std::swap(myTransX, scan->myTransX);
+  std::swap(myTransY, scan->myTransY);
+  std::swap(myTransCos, scan->myTransCos);
+  std::swap(myTransSin, scan->myTransSin);
+  std::swap(myOrigPoseTaken, scan->myOrigPoseTaken);
+  std::swap(myToGlobal, scan->myToGlobal);
+  myAppliedTransforms.swap(scan->myAppliedTransforms);
+}
+
+/**
+   The list is grown or shrunk to the number of readings (the
+   MvrSensorReadings in it are the caller's to delete), and each
+   reading gets the same data it would have if the driver had filled
+   it in with MvrSensorReading::newData() itself.
+**/
+MVREXPORT void MvrScan::fillReadings(
+	std::list<MvrSensorReading *> *readings) const
+{
+  std::list<MvrSensorReading *>::iterator it;
+  int i;
+
+  while ((int)readings->size() > myNumReadings)
+  {
+    delete readings->back();
+    readings->pop_back();
+  }
+  while ((int)readings->size() < myNumReadings)
+    readings->push_back(new MvrSensorReading);
+
+  for (it = readings->begin(), i = 0; it != readings->end(); it++, i++)
+    fillReading(i, *it);
+}
+
+MVREXPORT void MvrScan::fillReading(int i, MvrSensorReading *reading) const
+{
+  std::vector<AppliedTransform>::const_iterator transIt;
+
+  reading->resetSensorPosition(mySensorXs[i], mySensorYs[i], myTh[i]);
+  reading->newData(myRanges[i], myOrigPoseTaken, myEncoderPoseTaken,
+		   myToGlobal, myCounterTaken, getTimeTaken(i), 
+		   myIgnores[i] != 0, myIntensities[i]);
+  for (transIt = myAppliedTransforms.begin(); 
+       transIt != myAppliedTransforms.end();
+       transIt++)
+  {
+    if (i < transIt->myFirst || (i - transIt->myFirst) % transIt->myStep != 0)
+      continue;
+    if (transIt->myEncoder)
+      reading->applyEncoderTransform(transIt->myTrans);
+    else
+      reading->applyTransform(transIt->myTrans);
+  }
+}
@@ -519,6 +519,37 @@ MVREXPORT int MvrSerialConnection::read(const char *data, unsigned int size,
   return -1;
 }
 
+/**
+   This is one select and one read, instead of read()'s looping until
+   it has all of size.
+**/
+MVREXPORT int MvrSerialConnection::readAvailable(const char *data,
+						 unsigned int size,
+						 unsigned int msWait)
+{
+  struct timeval tp;
+  fd_set fdset;
+  int n;
+
+  if (myPort < 0)
+  {
+    MvrLog::log(MvrLog::Normal, "MvrSerialConnection::readAvailable:  Connection invalid.");
+    return -1;
+  }
+  tp.tv_sec = msWait / 1000;
+  tp.tv_usec = (msWait % 1000) * 1000;
+  FD_ZERO(&fdset);
+  FD_SET(myPort, &fdset);
+  if (select(myPort + 1, &fdset, NULL, NULL, &tp) <= 0)
+    return 0;
+  if ((n = ::read(myPort, const_cast<char *>(data), size)) == -1)
+  {
+    MvrLog::logErrorFromOS(MvrLog::Terse, "MvrSerialConnection::readAvailable:  Read failed.");
+    return -1;
+  }
+  return n;
+}
+
 MVREXPORT int MvrSerialConnection::getStatus(void)
 {
   return myStatus;
@@ -556,6 +587,13 @@ MVREXPORT bool MvrSerialConnection::isTimeStamping(void)
   return myTakingTimeStamps;
 }
 
+MVREXPORT int MvrSerialConnection::getPollFD(void)
+{
+  if (myStatus != STATUS_OPEN)
+    return -1;
+  return myPort;
+}
+
 
 MVREXPORT bool MvrSerialConnection::getCTS(void)
 {
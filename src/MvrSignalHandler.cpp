@@ -17,6 +17,9 @@ void MvrSignalHandler::signalCB(int sig)
   MvrLog::log(MvrLog::Verbose,
 	     "MvrSignalHandler::runThread: Received signal '%s' Number %d ",
 	     ourSigMap[sig].c_str(), sig);
+  // the handlers are likely to exit (or we're crashing), so get the
+  // async log written out first
+  MvrLog::flush();
   for (iter=ourHandlerList.begin(); iter != ourHandlerList.end(); ++iter)
     (*iter)->invoke(sig);
   if (ourHandlerList.begin() == ourHandlerList.end())
@@ -86,6 +86,10 @@ MVREXPORT MvrSimulatedLaser::MvrSimulatedLaser(MvrLaser *laser) :
   if (myLaser->canChooseAutoBaud())
     laserAllowAutoBaudChoices(myLaser->getAutoBaudChoice(), 
 			      myLaser->getAutoBaudChoices());
+
+  if (myLaser->canChooseProtocol())
+    laserAllowProtocolChoices(myLaser->getProtocolChoice(), 
+			      myLaser->getProtocolChoices());
   
   laserSetDefaultTcpPort(myLaser->getDefaultTcpPort());
   laserSetDefaultPortType(myLaser->getDefaultPortType());
@@ -94,10 +98,6 @@ MVREXPORT MvrSimulatedLaser::MvrSimulatedLaser(MvrLaser *laser) :
   myStartConnect = false;
   myIsConnected = false;
   myTryingToConnect = false;
-  myAssembleReadings = new std::list<MvrSensorReading *>;
-  myCurrentReadings = new std::list<MvrSensorReading *>;
-  myRawReadings = myCurrentReadings;
-  myIter = myAssembleReadings->begin();
   myDataCBList.setLogging(false);
   myReceivedData = false;
 }
@@ -313,6 +313,10 @@ MVREXPORT bool MvrSimulatedLaser::laserCheckParams(void)
       !myLaser->chooseAutoBaud(getAutoBaudChoice()))
     return false;
 
+  if (canChooseProtocol() && 
+      !myLaser->chooseProtocol(getProtocolChoice()))
+    return false;
+
   if (!myLaser->laserCheckParams())
     return false;
   
@@ -377,9 +381,9 @@ MVREXPORT bool MvrSimulatedLaser::simPacketHandler(MvrRobotPacket *packet)
   unsigned int readingNumber;
   double atDeg;
   unsigned int i;
-  MvrSensorReading *reading;
-  std::list<MvrSensorReading *>::iterator tempIt;
+  unsigned int onReading;
   unsigned int newReadings;
+  int timeOffset;
   int range;
   int refl = 0;
   MvrPose encoderPose;
@@ -416,47 +420,9 @@ MVREXPORT bool MvrSimulatedLaser::simPacketHandler(MvrRobotPacket *packet)
     mySimPacketCounter = myRobot->getCounter();
   }
   //printf("MvrSimulatedLaser::simPacketHandler: On reading number %d out of %d, new %d\n", readingNumber, totalNumReadings, newReadings);
-  // if we have too many readings in our list of raw readings, pop the extras
-  while (myAssembleReadings->size() > totalNumReadings)
-  {
-    MvrLog::log(MvrLog::Terse, "MvrSimulatedLaser::simPacketHandler, too many readings, popping one.");
-    tempIt = myAssembleReadings->begin();
-    if (tempIt != myAssembleReadings->end())
-      delete (*tempIt);
-    myAssembleReadings->pop_front();
-  }
-  
-  // If we don't have any sensor readings created at all, make 'em all now
-  if (myAssembleReadings->size() == 0)
-    for (i = 0; i < totalNumReadings; i++)
-      myAssembleReadings->push_back(new MvrSensorReading);
-  
-  // Okay, we know where we're at, so get an iterator to the right spot, or 
-  // make sure the one we keep around is in the right spot... if neither of
-  // these trigger, then the iter should be in the right spot
-  if ((readingNumber != myWhichReading + 1) || 
-      totalNumReadings != myTotalNumReadings)
-  {
-    //printf("2\n");
-    myWhichReading = readingNumber;
-    myTotalNumReadings = totalNumReadings;
-    for (i = 0, myIter = myAssembleReadings->begin(); i < readingNumber; i++)
-    {
-      tempIt = myIter;
-      tempIt++;
-      if (tempIt == myAssembleReadings->end() && (i + 1 != myTotalNumReadings))
-      {
-	myAssembleReadings->push_back(new MvrSensorReading);
-	//printf("@\n");
-      }
-      myIter++;
-    }
-  }
-  else
-  {
-    //printf("3\n");
-    myWhichReading = readingNumber;
-  }
+  // make sure the scan we're assembling is the right size
+  if (myAssembleScan.getNumReadings() != (int)totalNumReadings)
+    myAssembleScan.setNumReadings(totalNumReadings);
 
   //atDeg = (mySensorPose.getTh() - myOffsetAmount + 
   //readingNumber * myIncrementAmount);
@@ -464,15 +430,19 @@ MVREXPORT bool MvrSimulatedLaser::simPacketHandler(MvrRobotPacket *packet)
 	   readingNumber * mySimIncrement);
   //printf("4\n");
   encoderPose = mySimPacketEncoderTrans.doInvTransform(mySimPacketStart);
+  if (readingNumber == 0)
+    myAssembleScan.beginScan(mySimPacketStart, encoderPose, 
+			     mySimPacketTrans, mySimPacketCounter, 
+			     packet->getTimeReceived());
+  // the readings in this packet came in this long after the first ones
+  timeOffset = packet->getTimeReceived().mSecSince(
+	  myAssembleScan.getTimeTaken());
   // while we have in the readings and have stuff left we can read 
-  for (i = 0; 
-       //	 (myWhichReading < myTotalNumReadings && 
-       //	  packet->getReadLength() < packet->getLength() - 4);
+  for (i = 0, onReading = readingNumber; 
        i < newReadings;
-       i++, myWhichReading++, atDeg += mySimIncrement)
-       //i++, myWhichReading++, atDeg += myIncrementAmount)
+       i++, onReading++, atDeg += mySimIncrement)
+       //i++, onReading++, atDeg += myIncrementAmount)
   {
-    reading = (*myIter);
     range = packet->bufToUByte2();
     if(isExtendedPacket)
     {
@@ -501,25 +471,16 @@ MVREXPORT bool MvrSimulatedLaser::simPacketHandler(MvrRobotPacket *packet)
     if (myMaxRange != 0 && range > (int)myMaxRange)
       ignore = true;
     */
-    reading->resetSensorPosition(MvrMath::roundInt(mySensorPose.getX()),
-				 MvrMath::roundInt(mySensorPose.getY()),
-				 atDeg);
+    // the simulator shouldn't send more than it said it would, but
+    // don't write past the end if it does
+    if (onReading >= totalNumReadings)
+      continue;
     //printf("dist %d\n", dist);
-    reading->newData(range, mySimPacketStart, 
-		     encoderPose,
-		     mySimPacketTrans,
-		     mySimPacketCounter, packet->getTimeReceived(), ignore, refl);
-    
-    //addReading(reading->getX(), reading->getY());
-    tempIt = myIter;
-    tempIt++;
-    if (tempIt == myAssembleReadings->end() && 
-	myWhichReading + 1 != myTotalNumReadings)
-    {
-      printf("!\n");
-      myAssembleReadings->push_back(new MvrSensorReading);
-    }
-    myIter++;
+    myAssembleScan.setReading(onReading, range, 
+			      MvrMath::roundInt(mySensorPose.getX()),
+			      MvrMath::roundInt(mySensorPose.getY()),
+			      atDeg, ignore, refl);
+    myAssembleScan.setTimeOffset(onReading, timeOffset);
   }
 
   // check if the sensor set is complete
@@ -527,11 +488,9 @@ MVREXPORT bool MvrSimulatedLaser::simPacketHandler(MvrRobotPacket *packet)
   if (newReadings + readingNumber >= totalNumReadings)
   {
     //printf("Got all readings...\n");
-    // set MvrRangeDevice buffer
-    myRawReadings = myAssembleReadings;
-    // switch internal buffers
-    myAssembleReadings = myCurrentReadings;
-    myCurrentReadings = myRawReadings;
+    // switch the assembled scan in as the MvrRangeDevice raw scan
+    myRawScan.swapScan(&myAssembleScan);
+    myRawScan.endScan();
     // We have in all the readings, now sort 'em and update the current ones
     //filterReadings();
     laserProcessReadings();
@@ -4,6 +4,7 @@
 #include "MvrLog.h"
 #include <errno.h>
 #include <stdio.h>
+#include <string.h>
 #include <netdb.h>
 #include <arpa/inet.h>
 #include "MvrFunctor.h"
@@ -474,6 +475,12 @@ bool MvrSocket::close()
     MvrLog::log(MvrLog::Verbose, "Closing socket");
     if (myCloseFunctor != NULL)
         myCloseFunctor->invoke();
+    myStringReadStart = 0;
+    myStringReadEnd = 0;
+    myWriteQueueMutex.lock();
+    myWriteQueue.clear();
+    myWriteQueueStart = 0;
+    myWriteQueueMutex.unlock();
     if (myDoClose && ::close(myFD))
     {
         myFD=-1;
@@ -589,6 +596,8 @@ bool MvrSocket::copy(int fd, bool doclose)
     myFD=fd;
     myDoClose=doclose;
     myType=Unknown;
+    myStringReadStart = 0;
+    myStringReadEnd = 0;
 
     len=sizeof(struct sockaddr_in);
     if (getsockname(myFD, (struct sockaddr*)&mySin, &len))
@@ -725,6 +734,12 @@ void MvrSocket::internalInit(void)
   myStringBufEmpty[0] = '\0';
   myStringGotEscapeChars = false;
   myStringHaveEchoed = false;
+  myStringReadStart = 0;
+  myStringReadEnd = 0;
+  myWriteQueueMutex.setLogName("MvrMutex::myWriteQueueMutex");
+  myWriteQueueStart = 0;
+  myWriteQueueLimit = 0;
+  myWriteQueueOverflowed = false;
   myLastStringReadTime.setToNow();
   myLogWriteStrings = false;
   sprintf(myRawIPString, "none");
@@ -804,6 +819,9 @@ MVREXPORT int MvrSocket::write(const void *buff, size_t len)
     return 0;
   }
 
+  if (myWriteQueueLimit > 0)
+    return queueWrite(buff, len);
+
   struct timeval tval;
   fd_set fdSet;
   tval.tv_sec = 0;
@@ -852,6 +870,121 @@ MVREXPORT int MvrSocket::write(const void *buff, size_t len)
 }
 
 /**
+   With a limit set, write() sends what it can right away and queues
+   up the rest instead of dropping it, then flushWriteQueue() sends
+   the queued data as the socket can take it (the socket should be
+   nonblocking).  If a write would put more than maxBytes in the queue
+   it is thrown away instead and getWriteQueueOverflowed() becomes
+   true, which is how a client that isn't keeping up can be spotted.
+
+   @param maxBytes the most bytes to queue, 0 to not queue writes
+**/
+MVREXPORT void MvrSocket::setWriteQueueLimit(size_t maxBytes)
+{
+  myWriteQueueMutex.lock();
+  myWriteQueueLimit = maxBytes;
+  myWriteQueueMutex.unlock();
+}
+
+int MvrSocket::queueWrite(const void *buff, size_t len)
+{
+  int ret = 0;
+
+  myWriteQueueMutex.lock();
+  // only write straight out if nothing is waiting, or it'd get out of order
+  if (myWriteQueueStart == myWriteQueue.size())
+  {
+    myWriteQueue.clear();
+    myWriteQueueStart = 0;
+    ret = ::write(myFD, (char *)buff, len);
+    if (ret > 0)
+    {
+      mySends++;
+      myBytesSent += ret;
+    }
+    else if (ret < 0 && errno != EAGAIN)
+    {
+      if (myErrorTracking)
+	myBadWrite = true;
+      myWriteQueueMutex.unlock();
+      return ret;
+    }
+    else
+      ret = 0;
+  }
+  if ((size_t)ret < len)
+  {
+    if (myWriteQueue.size() - myWriteQueueStart + len - ret > 
+	myWriteQueueLimit)
+    {
+      if (!myWriteQueueOverflowed)
+	MvrLog::log(MvrLog::Normal, 
+		   "MvrSocket: More than %lu bytes backed up to %s, throwing away writes", 
+		   (unsigned long)myWriteQueueLimit, getIPString());
+      myWriteQueueOverflowed = true;
+      myWriteQueueMutex.unlock();
+      return ret;
+    }
+    myWriteQueue.append((const char *)buff + ret, len - ret);
+    ret = len;
+  }
+  myWriteQueueMutex.unlock();
+  return ret;
+}
+
+/**
+   @return true if everything queued has been sent, false if there's
+   still some waiting
+**/
+MVREXPORT bool MvrSocket::flushWriteQueue(void)
+{
+  int ret;
+  bool empty;
+
+  myWriteQueueMutex.lock();
+  while (myFD >= 0 && myWriteQueueStart < myWriteQueue.size())
+  {
+    ret = ::write(myFD, myWriteQueue.data() + myWriteQueueStart, 
+		  myWriteQueue.size() - myWriteQueueStart);
+    if (ret <= 0)
+    {
+      if (ret < 0 && errno != EAGAIN && myErrorTracking)
+	myBadWrite = true;
+      break;
+    }
+    mySends++;
+    myBytesSent += ret;
+    myWriteQueueStart += ret;
+  }
+  // don't let what's been sent pile up at the front
+  if (myWriteQueueStart == myWriteQueue.size())
+  {
+    myWriteQueue.clear();
+    myWriteQueueStart = 0;
+  }
+  else if (myWriteQueueStart > myWriteQueue.size() / 2)
+  {
+    myWriteQueue.erase(0, myWriteQueueStart);
+    myWriteQueueStart = 0;
+  }
+  empty = (myWriteQueueStart == myWriteQueue.size());
+  myWriteQueueMutex.unlock();
+  return empty;
+}
+
+MVREXPORT size_t MvrSocket::getWriteQueueBytes(void)
+{
+  size_t ret;
+  myWriteQueueMutex.lock();
+  ret = myWriteQueue.size() - myWriteQueueStart;
+  myWriteQueueMutex.unlock();
+  return ret;
+}
+
+/**
+   If readString() has data buffered that it hasn't used yet that is
+   returned first (without looking at the socket).
+
    @param buff buffer to read into
    @param len how many bytes to read
    @param msWait if 0, don't block, if > 0 wait this long for data
@@ -866,6 +999,14 @@ MVREXPORT int MvrSocket::read(void *buff, size_t len, unsigned int msWait)
   }
 
   int ret;
+  if (myStringReadStart < myStringReadEnd)
+  {
+    ret = MvrUtil::findMin((int)len, 
+			  (int)(myStringReadEnd - myStringReadStart));
+    memcpy(buff, &myStringReadBuf[myStringReadStart], ret);
+    myStringReadStart += ret;
+    return ret;
+  }
   if (msWait != 0)
   {
     struct timeval tval;
@@ -951,7 +1092,8 @@ MVREXPORT int MvrSocket::writeString(const char *str, ...)
     if (ret < 0)
       MvrLog::log(MvrLog::Normal, "Problem sending (ret %d errno %d) to %s: %s",
 		 ret, errno, getIPString(), buf);
-    else 
+    // a full write queue was already logged when it filled up
+    else if (!myWriteQueueOverflowed)
       MvrLog::log(MvrLog::Normal, "Problem sending (backed up) to %s: %s",
 		 getIPString(), buf);
   }
@@ -975,10 +1117,14 @@ void MvrSocket::setRawIPString(void)
 
 
   /**
-     @note This function can only read strings less than 512 characters
+     @note This function can only read strings less than 5000 characters
      long as it reads the characters into its own internal buffer (to
      compensate for some of the things the DOS telnet does).
 
+     Whatever is available on the socket is read in at once and kept
+     for the next calls, so a client sending lots of short commands
+     doesn't cost a read per character.
+
      @param msWait if 0, don't block, if > 0 wait this long for data
 
      @return Data read, or an empty string (first character will be '\\0') 
@@ -990,18 +1136,30 @@ MVREXPORT char *MvrSocket::readString(unsigned int msWait)
 {
   size_t i;
   int n;
+  size_t run;
+  char *start;
+  char *end;
 
   bool printing = false;
 
   myReadStringMutex.lock();
   myStringBufEmpty[0] = '\0';
 
-  // read one byte at a time
+  // go a character at a time through the buffered data, refilling it
+  // with whatever the socket has when it runs out
   for (i = myStringPos; i < sizeof(myStringBuf); i++)
   {
-    n = read(&myStringBuf[i], 1, msWait);
+    if (myStringReadStart < myStringReadEnd)
+      n = 1;
+    else if ((n = read(myStringReadBuf, sizeof(myStringReadBuf), 
+		       msWait)) > 0)
+    {
+      myStringReadStart = 0;
+      myStringReadEnd = n;
+    }
     if (n > 0)
     {
+      myStringBuf[i] = myStringReadBuf[myStringReadStart++];
       if (i == 0 && myStringBuf[i] < 0)
       {
 	myStringGotEscapeChars = true;
@@ -1067,9 +1225,24 @@ MVREXPORT char *MvrSocket::readString(unsigned int msWait)
 	myReadStringMutex.unlock();
 	return myStringBuf;
       }
-      // if its not an ending character but was good keep going
+      // if its not an ending character but was good keep going,
+      // everything up to the next end character is just part of the
+      // string so copy that over all at once
       else
+      {
+	run = myStringReadEnd - myStringReadStart;
+	if (run > sizeof(myStringBuf) - i - 1)
+	  run = sizeof(myStringBuf) - i - 1;
+	start = &myStringReadBuf[myStringReadStart];
+	if ((end = (char *)memchr(start, '\n', run)) != NULL)
+	  run = end - start;
+	if ((end = (char *)memchr(start, '\r', run)) != NULL)
+	  run = end - start;
+	memcpy(&myStringBuf[i + 1], start, run);
+	myStringReadStart += run;
+	i += run;
 	continue;
+      }
     }
     // failed
     else if (n == 0)
@@ -78,24 +78,21 @@ MVREXPORT void MvrSonarDevice::processReadings(void)
   }
 
   // delete too-far readings
-  std::list<MvrPoseWithTime *> *readingList;
-  std::list<MvrPoseWithTime *>::iterator it;
+  const MvrRangeBufferStorage *storage;
+  size_t j;
   double dx, dy, rx, ry;
     
   myCumulativeBuffer.beginInvalidationSweep();
-  readingList = myCumulativeBuffer.getBuffer();
+  storage = myCumulativeBuffer.getStorage();
   rx = myRobot->getX();
   ry = myRobot->getY();
-  // walk through the list and see if this makes any old readings bad
-  if (readingList != NULL)
+  // walk through the readings and see if this makes any old readings bad
+  for (j = 0; j < storage->size(); j++)
     {
-      for (it = readingList->begin(); it != readingList->end(); ++it)
-	{
-	  dx = (*it)->getX() - rx;
-	  dy = (*it)->getY() - ry;
-	  if ((dx*dx + dy*dy) > (myFilterFarDist * myFilterFarDist)) 
-	    myCumulativeBuffer.invalidateReading(it);
-	}
+      dx = storage->getX(j) - rx;
+      dy = storage->getY(j) - ry;
+      if ((dx*dx + dy*dy) > (myFilterFarDist * myFilterFarDist)) 
+	myCumulativeBuffer.invalidateReading(j);
     }
   myCumulativeBuffer.endInvalidationSweep();
   // leave this unlock here or the world WILL end
@@ -124,22 +121,19 @@ MVREXPORT void MvrSonarDevice::addReading(double x, double y)
   
   if (dist2 < myMaxDistToKeepCumulative * myMaxDistToKeepCumulative)
     {
-      std::list<MvrPoseWithTime *> *readingList;
-      std::list<MvrPoseWithTime *>::iterator it;
+      const MvrRangeBufferStorage *storage;
+      size_t i;
 
       myCumulativeBuffer.beginInvalidationSweep();
 
-      readingList = myCumulativeBuffer.getBuffer();
-      // walk through the list and see if this makes any old readings bad
-      if (readingList != NULL)
+      storage = myCumulativeBuffer.getStorage();
+      // walk through the readings and see if this makes any old readings bad
+      for (i = 0; i < storage->size(); i++)
 	{
-	  for (it = readingList->begin(); it != readingList->end(); ++it)
-	    {
-	      dx = (*it)->getX() - x;
-	      dy = (*it)->getY() - y;
-	      if ((dx*dx + dy*dy) < (myFilterNearDist * myFilterNearDist)) 
-		myCumulativeBuffer.invalidateReading(it);
-	    }
+	  dx = storage->getX(i) - x;
+	  dy = storage->getY(i) - y;
+	  if ((dx*dx + dy*dy) < (myFilterNearDist * myFilterNearDist)) 
+	    myCumulativeBuffer.invalidateReading(i);
 	}
       myCumulativeBuffer.endInvalidationSweep();
 
@@ -6,6 +6,7 @@
 
 #include "mvriaOSDef.h"
 #include "MvrSerialConnection.h"
+#include "MvrIOReactor.h"
 #include "mvriaInternal.h"
 #include <time.h>
 
@@ -38,7 +39,10 @@ MVREXPORT MvrSonarMTX::MvrSonarMTX (int sonarBoardNum,
 	myReceiver(NULL),
 	mySender(NULL),
 	myFirmwareVersion(0),
-	myMvrExitCB (this, &MvrSonarMTX::disconnect)
+	myMvrExitCB (this, &MvrSonarMTX::disconnect),
+	myIOReactor (NULL),
+	myReactorReadableCB (this, &MvrSonarMTX::reactorReadable),
+	myReactorTimeoutCB (this, &MvrSonarMTX::reactorTimeout)
 {
 
 	mySonarMap.clear();
@@ -65,6 +69,8 @@ MVREXPORT MvrSonarMTX::MvrSonarMTX (int sonarBoardNum,
 
 MVREXPORT MvrSonarMTX::~MvrSonarMTX()
 {
+	if (myIOReactor != NULL)
+		myIOReactor->remConnection (myConn);
 	if (myRobot != NULL) {
 		myRobot->remSensorInterpTask (&myProcessCB);
 	}
@@ -795,7 +801,7 @@ MVREXPORT bool MvrSonarMTX::blockingConnect (bool sendTracking, bool recvTrackin
 
 				myLastReading.setToNow();
 
-				runAsync();
+				startReading();
 
 				return true;
 
@@ -900,6 +906,54 @@ MVREXPORT const char * MvrSonarMTX::getNameWithBoard (void) const
 	return myNameWithBoard;
 }
 
+/**
+   With a reactor the sonar doesn't need a thread of its own, the
+   reactor calls it when there's data and checks for a lost connection
+   when there hasn't been any for a while.
+**/
+MVREXPORT void MvrSonarMTX::setIOReactor (MvrIOReactor *reactor)
+{
+	myIOReactor = reactor;
+}
+
+void MvrSonarMTX::startReading (void)
+{
+	if (myIOReactor != NULL &&
+	    myIOReactor->addConnection (myConn, &myReactorReadableCB,
+	                                &myReactorTimeoutCB, 400))
+		return;
+	runAsync();
+}
+
+void MvrSonarMTX::reactorReadable (void)
+{
+	MvrRobotPacket *packet;
+
+	// the data is already here, so this doesn't wait (except for the
+	// rest of a packet that's partway in)
+	while (myIsConnected && (packet = myReceiver->receivePacket (0)) != NULL) {
+		myPacketsMutex.lock();
+		myPackets.push_back (packet);
+		myPacketsMutex.unlock();
+		if (myRobot == NULL) // if no robot, then sensorinterp() won't be called as robot cycle task callback, so call it directly
+			sensorInterp();
+	}
+}
+
+void MvrSonarMTX::reactorTimeout (void)
+{
+	// only disconnect if transducers are on - if they are off we'll get no packets
+	if (myIsConnected && checkLostConnection() && myTransducersAreOn) {
+		MvrLog::log (MvrLog::Terse,
+		            "%s::reactorTimeout()  Lost connection to the MTX sonar because of error.  Nothing received for %g seconds (greater than the timeout of %g).", getNameWithBoard(),
+		            myLastReading.mSecSince() / 1000.0,
+		            getConnectionTimeoutSeconds() );
+		myIsConnected = false;
+		myIOReactor->remConnection (myConn);
+		disconnectOnError();
+	}
+}
+
 MVREXPORT void * MvrSonarMTX::runThread (void *arg)
 {
 	//char buf[1024];
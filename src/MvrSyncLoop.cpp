@@ -4,12 +4,16 @@
 #include "MvrLog.h"
 #include "mvriaUtil.h"
 #include "MvrRobot.h"
+#include <time.h>
+#include <errno.h>
 
 
 MVREXPORT MvrSyncLoop::MvrSyncLoop() :
   MvrASyncTask(),
   myStopRunIfNotConnected(false),
-  myRobot(0)
+  myRobot(0),
+  myAbsoluteTiming(false),
+  myNumMissedDeadlines(0)
 {
   setThreadName("MvrRobotSyncLoop");
   myInRun = false;
@@ -40,6 +44,12 @@ MVREXPORT void * MvrSyncLoop::runThread(void *arg)
   MvrTime lastLoop;
   bool firstLoop = true;
   bool warned = false;
+  bool absoluteTiming = false;
+  unsigned long long cycleTimeUSec = 0;
+  unsigned long long cycleStartUSec;
+  unsigned long long deadlineUSec;
+  unsigned long long nextDeadlineUSec = 0;
+  unsigned long long nowUSec;
 
   if (!myRobot)
   {
@@ -74,6 +84,18 @@ MVREXPORT void * MvrSyncLoop::runThread(void *arg)
     warned = false;
     lastLoop.setToNow();
 
+    cycleStartUSec = MvrUtil::getTimeUSec();
+    cycleTimeUSec = myRobot->getCycleTimeUSec();
+    // switching modes starts the deadlines over from this cycle
+    if (absoluteTiming != myAbsoluteTiming.load())
+    {
+      absoluteTiming = myAbsoluteTiming.load();
+      nextDeadlineUSec = 0;
+    }
+    if (!absoluteTiming || nextDeadlineUSec == 0)
+      deadlineUSec = cycleStartUSec + cycleTimeUSec;
+    else
+      deadlineUSec = nextDeadlineUSec;
     loopEndTime.setToNow();
     if (!loopEndTime.addMSec(myRobot->getCycleTime())) {
       MvrLog::log(MvrLog::Normal,
@@ -113,8 +135,48 @@ MVREXPORT void * MvrSyncLoop::runThread(void *arg)
     }
     
 
-    if (timeToSleep > 0)
-      MvrUtil::sleep(timeToSleep);
+    if (myRobot->isCycleChained() && myRobot->isConnected())
+    {
+      // the packets are doing the timing, so there's no deadline to
+      // keep (and the next one starts from whenever the cycle does)
+      nextDeadlineUSec = 0;
+    }
+    else if (absoluteTiming)
+    {
+      // sleep to the deadline instead of for however long is left, so
+      // the time spent here and how long the sleep really was don't
+      // add up from one cycle to the next
+      nowUSec = MvrUtil::getTimeUSec();
+      if (nowUSec < deadlineUSec)
+      {
+	sleepUntil(deadlineUSec);
+	nowUSec = MvrUtil::getTimeUSec();
+      }
+      else
+	myNumMissedDeadlines++;
+      myJitter.add(nowUSec - deadlineUSec > 0xffffffffULL ? 
+		   0xffffffffU : (unsigned int)(nowUSec - deadlineUSec));
+      nextDeadlineUSec = deadlineUSec + cycleTimeUSec;
+      // if it is more than a whole cycle behind, skip the cycles it
+      // missed instead of running them all back to back to catch up
+      if (nextDeadlineUSec <= nowUSec)
+      {
+	myNumMissedDeadlines += (nowUSec - nextDeadlineUSec) / 
+	  (cycleTimeUSec > 0 ? cycleTimeUSec : 1);
+	nextDeadlineUSec = nowUSec + cycleTimeUSec;
+      }
+    }
+    else
+    {
+      if (timeToSleep > 0)
+	MvrUtil::sleep(timeToSleep);
+      nowUSec = MvrUtil::getTimeUSec();
+      if (nowUSec > deadlineUSec + 1000)
+	myNumMissedDeadlines++;
+      myJitter.add(nowUSec <= deadlineUSec ? 0 :
+		   (nowUSec - deadlineUSec > 0xffffffffULL ? 
+		    0xffffffffU : (unsigned int)(nowUSec - deadlineUSec)));
+    }
   }   
   myRobot->lock();
   myRobot->wakeAllRunExitWaitingThreads();
@@ -132,6 +194,77 @@ MVREXPORT void * MvrSyncLoop::runThread(void *arg)
   return(0);
 }
 
+/**
+   Normally each cycle sleeps for however many ms are left in the cycle
+   time once the tasks are done, so every cycle is a little longer than
+   the cycle time (by the time taken outside of the tasks and by how
+   much longer than asked the sleep took), and the cycles drift.  With
+   absolute timing each cycle's deadline is the last one's plus the
+   cycle time, and the loop sleeps until that time on the monotonic
+   clock (with clock_nanosleep), so the cycles stay on schedule and the
+   cycle time can be less than a ms (see MvrRobot::setCycleTimeUSec()).
+
+   If a cycle runs past its deadline the next one starts right away
+   (and the one after that is short to get back on schedule), unless
+   it is more than a whole cycle behind, then the missed cycles are
+   skipped.  This doesn't change anything while the robot's cycle is
+   chained to its packets (MvrRobot::setCycleChained()).
+**/
+MVREXPORT void MvrSyncLoop::setAbsoluteTiming(bool absoluteTiming)
+{
+  myAbsoluteTiming.store(absoluteTiming);
+}
+
+MVREXPORT bool MvrSyncLoop::getAbsoluteTiming(void)
+{
+  return myAbsoluteTiming.load();
+}
+
+/**
+   Each cycle that isn't chained to the robot's packets adds how long
+   after its deadline the next cycle started (0 if it wasn't late), so
+   with absolute timing this is how late the sleep woke up, or how long
+   past the deadline the tasks ran.  Without absolute timing this also
+   includes the sleep only being in whole ms.
+**/
+MVREXPORT const MvrLatencyHistogram *MvrSyncLoop::getJitter(void)
+{
+  return &myJitter;
+}
+
+/**
+   With absolute timing this is the number of cycles whose tasks ran
+   past their deadline plus the cycles that were skipped to get back on
+   schedule, without absolute timing it is the number of cycles that
+   started more than a ms late.
+**/
+MVREXPORT unsigned long long MvrSyncLoop::getNumMissedDeadlines(void)
+{
+  return myNumMissedDeadlines.load();
+}
+
+MVREXPORT void MvrSyncLoop::resetTimingStats(void)
+{
+  myJitter.reset();
+  myNumMissedDeadlines.store(0);
+}
+
+void MvrSyncLoop::sleepUntil(unsigned long long uSec)
+{
+#if defined(_POSIX_TIMERS) && defined(_POSIX_MONOTONIC_CLOCK)
+  struct timespec tp;
+  tp.tv_sec = uSec / 1000000;
+  tp.tv_nsec = (uSec % 1000000) * 1000;
+  // interrupted by a signal just means going back to sleep
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &tp, NULL) == EINTR)
+    ;
+#else
+  unsigned long long now = MvrUtil::getTimeUSec();
+  if (uSec > now)
+    MvrUtil::sleep((uSec - now + 999) / 1000);
+#endif
+}
+
 MVREXPORT const char *MvrSyncLoop::getThreadActivity(void)
 {
   if (myRunning)
@@ -3,6 +3,182 @@
 #include "mvriaUtil.h"
 #include "MvrSyncTask.h"
 #include "MvrLog.h"
+#include "MvrFunctorASyncTask.h"
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+
+/// Threads that run lanes of independent sync tasks (internal to MvrSyncTask)
+/**
+   run() hands out the lanes to the workers and the calling thread, each
+   lane's tasks are run in order by whoever takes it, and it returns once
+   every lane is done.  Only one run() happens at a time (it is only
+   called from the thread running the root of the tree, and never from
+   inside a lane).
+
+   Everything the waits check is changed (or the change is signaled)
+   with myMutex locked, so no wake up is missed and none of the waits
+   need timeouts.
+**/
+class MvrSyncTaskWorkerPool
+{
+public:
+  MvrSyncTaskWorkerPool(const char *name, int numWorkers);
+  ~MvrSyncTaskWorkerPool();
+  int getNumWorkers(void) const { return myWorkers.size(); }
+  void run(std::vector<MvrSyncTask *> *lanes, int numLanes);
+  // if this thread is running a lane (so it shouldn't start more)
+  static thread_local bool ourInLane;
+protected:
+  void *workerThread(void *arg);
+  void runLanes(void);
+
+  std::mutex myMutex;
+  // workers wait on this for a new batch (or to stop)
+  std::condition_variable myWorkCond;
+  // run() waits on this for the lanes to be done, or for the workers
+  // to be out of the last batch, and the destructor for them to exit
+  std::condition_variable myDoneCond;
+  std::vector<MvrFunctorASyncTask *> myWorkers;
+  MvrRetFunctor1C<void *, MvrSyncTaskWorkerPool, void *> myWorkerCB;
+  // these are only changed with myMutex locked
+  bool myStopping;
+  int myNumExited;
+  unsigned long long myGeneration;
+  // workers that have started on the current batch and not finished
+  int myNumInBatch;
+  // what is being run, only changed with myMutex locked and no
+  // workers in the batch
+  std::vector<MvrSyncTask *> *myLanes;
+  int myNumLanes;
+  std::atomic<int> myNextLane;
+  // lanes not done yet, whoever takes it to 0 signals myDoneCond
+  std::atomic<int> myLanesLeft;
+};
+
+thread_local bool MvrSyncTaskWorkerPool::ourInLane = false;
+
+MvrSyncTaskWorkerPool::MvrSyncTaskWorkerPool(const char *name, 
+					     int numWorkers) :
+  myWorkerCB(this, &MvrSyncTaskWorkerPool::workerThread),
+  myStopping(false),
+  myNumExited(0),
+  myGeneration(0),
+  myNumInBatch(0),
+  myLanes(NULL),
+  myNumLanes(0),
+  myNextLane(0),
+  myLanesLeft(0)
+{
+  MvrFunctorASyncTask *worker;
+  char threadName[1024];
+  int i;
+
+  for (i = 0; i < numWorkers; i++)
+  {
+    worker = new MvrFunctorASyncTask(&myWorkerCB);
+    snprintf(threadName, sizeof(threadName), "%s worker %d", name, i + 1);
+    worker->setThreadName(threadName);
+    // detached, the destructor waits for them with myNumExited
+    if (worker->create(false, false) != 0)
+    {
+      MvrLog::log(MvrLog::Terse, 
+		  "MvrSyncTaskWorkerPool: Could not create worker %d for %s",
+		  i + 1, name);
+      delete worker;
+      break;
+    }
+    myWorkers.push_back(worker);
+  }
+}
+
+MvrSyncTaskWorkerPool::~MvrSyncTaskWorkerPool()
+{
+  size_t i;
+
+  {
+    std::unique_lock<std::mutex> lock(myMutex);
+    myStopping = true;
+    myWorkCond.notify_all();
+    while (myNumExited < (int)myWorkers.size())
+      myDoneCond.wait(lock);
+  }
+  for (i = 0; i < myWorkers.size(); i++)
+    delete myWorkers[i];
+  myWorkers.clear();
+}
+
+void MvrSyncTaskWorkerPool::run(std::vector<MvrSyncTask *> *lanes, 
+				int numLanes)
+{
+  std::unique_lock<std::mutex> lock(myMutex);
+  // a worker that woke up too late for the last batch could still be
+  // looking at it, so wait for it before changing anything
+  while (myNumInBatch > 0)
+    myDoneCond.wait(lock);
+  myLanes = lanes;
+  myNumLanes = numLanes;
+  myNextLane.store(0);
+  myLanesLeft.store(numLanes);
+  myGeneration++;
+  myWorkCond.notify_all();
+  lock.unlock();
+
+  ourInLane = true;
+  runLanes();
+  ourInLane = false;
+
+  lock.lock();
+  while (myLanesLeft.load() > 0)
+    myDoneCond.wait(lock);
+}
+
+void MvrSyncTaskWorkerPool::runLanes(void)
+{
+  int lane;
+  size_t i;
+
+  while ((lane = myNextLane.fetch_add(1)) < myNumLanes)
+  {
+    std::vector<MvrSyncTask *> &tasks = myLanes[lane];
+    for (i = 0; i < tasks.size(); i++)
+      tasks[i]->run();
+    if (myLanesLeft.fetch_sub(1) == 1)
+    {
+      // locked so this can't land between run()'s check and its wait
+      std::lock_guard<std::mutex> lock(myMutex);
+      myDoneCond.notify_all();
+    }
+  }
+}
+
+void *MvrSyncTaskWorkerPool::workerThread(void *arg)
+{
+  std::unique_lock<std::mutex> lock(myMutex);
+  // the generation the pool started at, so a batch that started before
+  // this thread got going still gets worked on
+  unsigned long long seen = 0;
+
+  ourInLane = true;
+  while (!myStopping)
+  {
+    if (myGeneration == seen)
+    {
+      myWorkCond.wait(lock);
+      continue;
+    }
+    seen = myGeneration;
+    myNumInBatch++;
+    lock.unlock();
+    runLanes();
+    lock.lock();
+    if (--myNumInBatch == 0)
+      myDoneCond.notify_all();
+  }
+  myNumExited++;
+  myDoneCond.notify_all();
+  return NULL;
+}
 
 /**
    New should never be called to create an MvrSyncTask except to create the 
@@ -16,6 +192,9 @@ MVREXPORT MvrSyncTask::MvrSyncTask(const char *name, MvrFunctor *functor,
   myFunctor = functor;
   myParent = parent;
   myIsDeleting = false;
+  myIndependent = false;
+  myRunPlanDirty = true;
+  myWorkerPool = NULL;
   setState(MvrTaskState::INIT);
   if (myParent != NULL)
   {
@@ -39,6 +218,11 @@ MVREXPORT MvrSyncTask::~MvrSyncTask()
   myIsDeleting = true;
   if (myParent != NULL && !myParent->isDeleting())
     myParent->remove(this);
+  if (myWorkerPool != NULL)
+  {
+    delete myWorkerPool;
+    myWorkerPool = NULL;
+  }
   
   MvrUtil::deleteSetPairs(myMultiMap.begin(), myMultiMap.end());  
   myMultiMap.clear();
@@ -165,6 +349,7 @@ MVREXPORT void MvrSyncTask::addNewBranch(const char *nameOfNew, int position,
 {
   MvrSyncTask *proc = new MvrSyncTask(nameOfNew, NULL, state, this);
   myMultiMap.insert(std::pair<int, MvrSyncTask *>(position, proc));
+  myRunPlanDirty = true;
 }
 
 /**
@@ -186,6 +371,7 @@ MVREXPORT void MvrSyncTask::addNewLeaf(const char *nameOfNew, int position,
 {
   MvrSyncTask *proc = new MvrSyncTask(nameOfNew, functor, state, this);
   myMultiMap.insert(std::pair<int, MvrSyncTask *>(position, proc));
+  myRunPlanDirty = true;
 }
 
 MVREXPORT void MvrSyncTask::remove(MvrSyncTask *proc)
@@ -197,6 +383,7 @@ MVREXPORT void MvrSyncTask::remove(MvrSyncTask *proc)
     if ((*it).second == proc)
     {
       myMultiMap.erase(it);
+      myRunPlanDirty = true;
       return;
     }
   }
@@ -225,6 +412,10 @@ MVREXPORT void MvrSyncTask::run(void)
   MvrTaskState::State state;
   MvrTime runTime;
   int took;  
+  unsigned long long startUSec;
+  unsigned long long tookUSec;
+  std::vector<RunStep>::iterator stepIt;
+  MvrSyncTaskWorkerPool *pool = NULL;
 
   state = getState();
   switch (state) 
@@ -242,6 +433,7 @@ MVREXPORT void MvrSyncTask::run(void)
     break;
   }
   
+  startUSec = MvrUtil::getTimeUSec();
   runTime.setToNow();
   if (myFunctor != NULL)
     myFunctor->invoke();
@@ -255,12 +447,38 @@ MVREXPORT void MvrSyncTask::run(void)
 	       myName.c_str(), took, (signed int)myWarningTimeCB->invokeR());
   
   
-  for (it = myMultiMap.rbegin(); it != myMultiMap.rend(); it++)
+  if (myRunPlanDirty)
+    buildRunPlan();
+  if (myRunLanes.empty() || MvrSyncTaskWorkerPool::ourInLane || 
+      (pool = getWorkerPool()) == NULL)
+  {
+    for (it = myMultiMap.rbegin(); it != myMultiMap.rend(); it++)
+    {
+      myInvokingOtherFunctor = (*it).second;
+      myInvokingOtherFunctor->run();
+    }
+  }
+  else
   {
-    myInvokingOtherFunctor = (*it).second;
-    myInvokingOtherFunctor->run();
+    for (stepIt = myRunSteps.begin(); stepIt != myRunSteps.end(); stepIt++)
+    {
+      if ((*stepIt).myTask != NULL)
+      {
+	myInvokingOtherFunctor = (*stepIt).myTask;
+	myInvokingOtherFunctor->run();
+      }
+      else
+      {
+	myInvokingOtherFunctor = NULL;
+	pool->run(&myRunLanes[(*stepIt).myFirstLane], (*stepIt).myNumLanes);
+      }
+    }
   }
   myInvokingOtherFunctor = NULL;
+
+  tookUSec = MvrUtil::getTimeUSec() - startUSec;
+  myLatency.add(tookUSec > 0xffffffffULL ? 0xffffffffU : 
+		(unsigned int)tookUSec);
 }
 
 /**
@@ -355,6 +573,208 @@ MVREXPORT void MvrSyncTask::log(int depth)
   
 }
 
+/**
+   Each line is the name of the task (indented by depth) and then the
+   summary from MvrLatencyHistogram::getSummary() of how long it has
+   been taking to run, which includes the time its children took.
+
+   @param lines the list to add the lines onto
+   @param depth how far to indent this node
+   @param numRecent how many of the most recent run times to put on each line
+**/
+MVREXPORT void MvrSyncTask::getLatencies(std::list<std::string> *lines,
+					 int depth, int numRecent)
+{
+  int i;
+  std::multimap<int, MvrSyncTask *>::reverse_iterator it;
+  std::string str = "";
+
+  for (i = 0; i < depth; i++)
+    str += "\t";
+  str += myName;
+  str += ": ";
+  str += myLatency.getSummary(numRecent);
+  lines->push_back(str);
+  for (it = myMultiMap.rbegin(); it != myMultiMap.rend(); it++)
+    (*it).second->getLatencies(lines, depth + 1, numRecent);
+}
+
+MVREXPORT void MvrSyncTask::logLatencies(int depth, int numRecent)
+{
+  std::list<std::string> lines;
+  std::list<std::string>::iterator it;
+
+  getLatencies(&lines, depth, numRecent);
+  for (it = lines.begin(); it != lines.end(); it++)
+    MvrLog::log(MvrLog::Terse, "%s", (*it).c_str());
+}
+
+/**
+   Independent tasks next to each other (in position order) can run at
+   the same time once the root has worker threads (see
+   setNumWorkerThreads()); the parent waits for them all before going on
+   to the next task that isn't independent.
+
+   @param independent whether this task can run at the same time as
+   its independent siblings
+
+   @param resource if this isn't NULL or empty, independent siblings
+   with the same resource run one after another instead of at the same
+   time (in the same order as they would without worker threads)
+**/
+MVREXPORT void MvrSyncTask::setIndependent(bool independent, 
+					   const char *resource)
+{
+  myIndependent = independent;
+  if (resource != NULL)
+    myResource = resource;
+  else
+    myResource = "";
+  if (myParent != NULL)
+    myParent->myRunPlanDirty = true;
+}
+
+MVREXPORT bool MvrSyncTask::getIndependent(void)
+{
+  return myIndependent;
+}
+
+MVREXPORT std::string MvrSyncTask::getResource(void)
+{
+  return myResource;
+}
+
+/**
+   The worker threads belong to the root of the tree, so calling this
+   on any node sets them for the whole tree.  This shouldn't be called
+   while the tree is running (ie from a task).
+
+   @param numWorkerThreads how many threads to run independent tasks on
+   besides the one running the tree, 0 runs everything one after another
+   like normal
+**/
+MVREXPORT void MvrSyncTask::setNumWorkerThreads(int numWorkerThreads)
+{
+  if (myParent != NULL)
+  {
+    myParent->setNumWorkerThreads(numWorkerThreads);
+    return;
+  }
+  if (myWorkerPool != NULL)
+  {
+    delete myWorkerPool;
+    myWorkerPool = NULL;
+  }
+  if (numWorkerThreads > 0)
+    myWorkerPool = new MvrSyncTaskWorkerPool(myName.c_str(), 
+					     numWorkerThreads);
+}
+
+MVREXPORT int MvrSyncTask::getNumWorkerThreads(void)
+{
+  MvrSyncTaskWorkerPool *pool = getWorkerPool();
+  if (pool == NULL)
+    return 0;
+  return pool->getNumWorkers();
+}
+
+MvrSyncTaskWorkerPool *MvrSyncTask::getWorkerPool(void)
+{
+  MvrSyncTask *root = this;
+  while (root->myParent != NULL)
+    root = root->myParent;
+  if (root->myWorkerPool == NULL || root->myWorkerPool->getNumWorkers() == 0)
+    return NULL;
+  return root->myWorkerPool;
+}
+
+/**
+   Goes through the children in the order they run, each child that
+   isn't independent is a step of its own, and each run of independent
+   children is one step of lanes, with children sharing a resource in
+   the same lane.  A run that ends up with only one lane is just run
+   one after another.  myRunLanes is left empty if nothing can be run
+   at the same time.
+**/
+void MvrSyncTask::buildRunPlan(void)
+{
+  std::multimap<int, MvrSyncTask *>::reverse_iterator it;
+  MvrSyncTask *task;
+  RunStep step;
+  int firstLane;
+  int lane;
+  size_t i;
+
+  myRunSteps.clear();
+  myRunLanes.clear();
+  it = myMultiMap.rbegin();
+  while (it != myMultiMap.rend())
+  {
+    task = (*it).second;
+    if (!task->myIndependent)
+    {
+      step.myTask = task;
+      step.myFirstLane = 0;
+      step.myNumLanes = 0;
+      myRunSteps.push_back(step);
+      it++;
+      continue;
+    }
+    firstLane = myRunLanes.size();
+    for (; it != myMultiMap.rend() && (*it).second->myIndependent; it++)
+    {
+      task = (*it).second;
+      lane = -1;
+      if (!task->myResource.empty())
+      {
+	for (i = firstLane; i < myRunLanes.size(); i++)
+	{
+	  if (myRunLanes[i].front()->myResource == task->myResource)
+	  {
+	    lane = i;
+	    break;
+	  }
+	}
+      }
+      if (lane < 0)
+      {
+	myRunLanes.push_back(std::vector<MvrSyncTask *>());
+	lane = myRunLanes.size() - 1;
+      }
+      myRunLanes[lane].push_back(task);
+    }
+    if (myRunLanes.size() - firstLane == 1)
+    {
+      // only one lane, so there's nothing to run at the same time
+      for (i = 0; i < myRunLanes.back().size(); i++)
+      {
+	step.myTask = myRunLanes.back()[i];
+	step.myFirstLane = 0;
+	step.myNumLanes = 0;
+	myRunSteps.push_back(step);
+      }
+      myRunLanes.pop_back();
+    }
+    else
+    {
+      step.myTask = NULL;
+      step.myFirstLane = firstLane;
+      step.myNumLanes = myRunLanes.size() - firstLane;
+      myRunSteps.push_back(step);
+    }
+  }
+  myRunPlanDirty = false;
+}
+
+MVREXPORT void MvrSyncTask::resetLatencies(void)
+{
+  std::multimap<int, MvrSyncTask *>::reverse_iterator it;
+
+  myLatency.reset();
+  for (it = myMultiMap.rbegin(); it != myMultiMap.rend(); it++)
+    (*it).second->resetLatencies();
+}
+
 
 /// Returns what this is running, if anything (recurses)
 MVREXPORT MvrSyncTask *MvrSyncTask::getRunning(void)
@@ -194,6 +194,28 @@ MVREXPORT int MvrTcpConnection::read(const char *data, unsigned int size,
   return bytesRead;
 }
 
+/**
+   This is one select (if msWait isn't 0) and one recv, instead of
+   read()'s looping until it has all of size.
+**/
+MVREXPORT int MvrTcpConnection::readAvailable(const char *data,
+					      unsigned int size,
+					      unsigned int msWait)
+{
+  int n;
+
+  if (getStatus() != STATUS_OPEN || mySocket->getFD() < 0) 
+  {
+    MvrLog::log(MvrLog::Terse, 
+	       "MvrTcpConnection::readAvailable: Attempt to use port that is not open.");
+    return -1;
+  }
+  // the socket is nonblocking, so nothing being there is just -1
+  if ((n = mySocket->read(const_cast<char *>(data), size, msWait)) < 0)
+    return 0;
+  return n;
+}
+
 MVREXPORT int MvrTcpConnection::write(const char *data, unsigned int size)
 {
   int ret;
@@ -241,6 +263,13 @@ MVREXPORT bool MvrTcpConnection::isTimeStamping(void)
   return false;
 }
 
+MVREXPORT int MvrTcpConnection::getPollFD(void)
+{
+  if (myStatus != STATUS_OPEN || mySocket == NULL)
+    return -1;
+  return mySocket->getFD();
+}
+
 MVREXPORT MvrTime MvrTcpConnection::getTimeRead(int index)
 {
   MvrTime now;
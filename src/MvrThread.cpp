@@ -12,6 +12,7 @@
 #include <sys/types.h>
 #include <unistd.h>
 #include "MvrSignalHandler.h"
+#include "MvrThreadScheduling.h"
 
 #ifndef MINGW
 #include <sys/syscall.h>
@@ -26,6 +27,9 @@ static void * run(void *arg)
     if (t->getBlockAllSignals())
         MvrSignalHandler::blockCommonThisThread();
 
+    // CPUs and real time scheduling set up for this thread's name
+    MvrThreadScheduling::applyToThisThread(t->getThreadName());
+
     if (dynamic_cast<MvrRetFunctor<void*>*>(t->getFunc()))
         ret=((MvrRetFunctor<void*>*)t->getFunc())->invokeR();
     else
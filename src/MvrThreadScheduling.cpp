@@ -0,0 +1,409 @@
+#include "MvrExport.h"
+#include "mvriaOSDef.h"
+#include "MvrThreadScheduling.h"
+#include "MvrConfig.h"
+#include "MvrLog.h"
+#include "mvriaUtil.h"
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#ifdef __linux__
+#include <sched.h>
+#include <sys/mman.h>
+#endif
+
+MvrMutex MvrThreadScheduling::ourMutex;
+std::map<std::string, MvrThreadScheduling> MvrThreadScheduling::ourSchedulings;
+std::map<std::string, MvrThreadScheduling::ConfigEntry *> 
+MvrThreadScheduling::ourConfigEntries;
+bool MvrThreadScheduling::ourConfigLockMemory = false;
+bool MvrThreadScheduling::ourMemoryLocked = false;
+MvrGlobalRetFunctor2<bool, char *, size_t> 
+MvrThreadScheduling::ourProcessFileCB(&MvrThreadScheduling::processFile);
+
+/**
+   @param cpus the CPUs the thread can run on, like "2" or "0,2-3",
+   NULL or empty to leave them alone
+
+   @param policy the scheduling policy
+
+   @param priority the priority, 1 (lowest) to 99 (highest) for FIFO and
+   RR, ignored for the other policies
+**/
+MVREXPORT MvrThreadScheduling::MvrThreadScheduling(const char *cpus, 
+						   Policy policy, 
+						   int priority)
+{
+  setCPUs(cpus);
+  myPolicy = policy;
+  myPriority = priority;
+}
+
+MVREXPORT MvrThreadScheduling::~MvrThreadScheduling()
+{
+}
+
+MVREXPORT void MvrThreadScheduling::setCPUs(const char *cpus)
+{
+  if (cpus != NULL)
+    myCPUs = cpus;
+  else
+    myCPUs = "";
+}
+
+bool MvrThreadScheduling::parseCPUs(const char *cpus, int *cpuList, 
+				    int maxCPUs, int *numCPUs)
+{
+  const char *str = cpus;
+  char *end;
+  long first;
+  long last;
+  long cpu;
+
+  *numCPUs = 0;
+  while (*str != '\0')
+  {
+    while (isspace(*str) || *str == ',')
+      str++;
+    if (*str == '\0')
+      break;
+    first = strtol(str, &end, 10);
+    if (end == str || first < 0)
+      return false;
+    str = end;
+    last = first;
+    if (*str == '-')
+    {
+      str++;
+      last = strtol(str, &end, 10);
+      if (end == str || last < first)
+	return false;
+      str = end;
+    }
+    if (*str != '\0' && *str != ',' && !isspace(*str))
+      return false;
+    for (cpu = first; cpu <= last; cpu++)
+    {
+      if (*numCPUs >= maxCPUs)
+	return false;
+      cpuList[(*numCPUs)++] = cpu;
+    }
+  }
+  return true;
+}
+
+/**
+   This can be called on any thread (not just the calling one).  
+
+   @param thread the thread to apply this to
+
+   @param threadName the name of the thread, for logging
+
+   @return true if everything was applied, false if anything couldn't
+   be (which will have been logged)
+**/
+MVREXPORT bool MvrThreadScheduling::apply(MvrThread::ThreadType thread,
+					  const char *threadName) const
+{
+  bool ret = true;
+#ifdef __linux__
+  int cpuList[CPU_SETSIZE];
+  int numCPUs;
+  int i;
+  int err;
+  cpu_set_t cpuSet;
+  struct sched_param param;
+  int policy;
+
+  if (threadName == NULL)
+    threadName = "";
+
+  if (!myCPUs.empty())
+  {
+    if (!parseCPUs(myCPUs.c_str(), cpuList, CPU_SETSIZE, &numCPUs) || 
+	numCPUs == 0)
+    {
+      MvrLog::log(MvrLog::Terse, 
+		  "MvrThreadScheduling: Bad CPUs '%s' for thread %s",
+		  myCPUs.c_str(), threadName);
+      ret = false;
+    }
+    else
+    {
+      CPU_ZERO(&cpuSet);
+      for (i = 0; i < numCPUs; i++)
+	CPU_SET(cpuList[i], &cpuSet);
+      if ((err = pthread_setaffinity_np(thread, sizeof(cpuSet), 
+					&cpuSet)) != 0)
+      {
+	MvrLog::log(MvrLog::Terse, 
+		    "MvrThreadScheduling: Could not put thread %s on CPUs %s: %s",
+		    threadName, myCPUs.c_str(), strerror(err));
+	ret = false;
+      }
+    }
+  }
+
+  if (myPolicy != INHERIT)
+  {
+    memset(&param, 0, sizeof(param));
+    if (myPolicy == FIFO || myPolicy == RR)
+    {
+      policy = (myPolicy == FIFO) ? SCHED_FIFO : SCHED_RR;
+      param.sched_priority = MvrUtil::findMax(
+	      sched_get_priority_min(policy), 
+	      MvrUtil::findMin(myPriority, sched_get_priority_max(policy)));
+    }
+    else
+      policy = SCHED_OTHER;
+    if ((err = pthread_setschedparam(thread, policy, &param)) != 0)
+    {
+      MvrLog::log(MvrLog::Terse, 
+		  "MvrThreadScheduling: Could not set thread %s to %s priority %d: %s",
+		  threadName, getPolicyName(myPolicy), param.sched_priority,
+		  strerror(err));
+      ret = false;
+    }
+  }
+
+  if (ret && (!myCPUs.empty() || myPolicy != INHERIT))
+    MvrLog::log(MvrLog::Normal, 
+		"MvrThreadScheduling: Thread %s on CPUs '%s' with policy %s priority %d",
+		threadName, myCPUs.c_str(), getPolicyName(myPolicy), 
+		myPriority);
+#endif // __linux__
+  return ret;
+}
+
+/**
+   Threads with this name apply the scheduling when they start, and it
+   is applied right away to any that are already running.
+**/
+MVREXPORT void MvrThreadScheduling::setForThread(
+	const char *threadName, const MvrThreadScheduling &scheduling)
+{
+  MvrThread::MapType::iterator it;
+  MvrThread *thread;
+
+  if (threadName == NULL)
+    return;
+  ourMutex.lock();
+  ourSchedulings[threadName] = scheduling;
+  ourMutex.unlock();
+
+  MvrThread::ourThreadsMutex.lock();
+  for (it = MvrThread::ourThreads.begin(); 
+       it != MvrThread::ourThreads.end(); 
+       ++it)
+  {
+    thread = (*it).second;
+    if (thread != NULL && thread->isThreadStarted() && 
+	!thread->isThreadFinished() && 
+	strcmp(thread->getThreadName(), threadName) == 0)
+      scheduling.apply(thread->getOSThread(), threadName);
+  }
+  MvrThread::ourThreadsMutex.unlock();
+}
+
+MVREXPORT bool MvrThreadScheduling::getForThread(
+	const char *threadName, MvrThreadScheduling *scheduling)
+{
+  std::map<std::string, MvrThreadScheduling>::iterator it;
+  bool ret = false;
+
+  if (threadName == NULL)
+    return false;
+  ourMutex.lock();
+  if ((it = ourSchedulings.find(threadName)) != ourSchedulings.end())
+  {
+    if (scheduling != NULL)
+      *scheduling = (*it).second;
+    ret = true;
+  }
+  ourMutex.unlock();
+  return ret;
+}
+
+/**
+   This doesn't change threads that already have the scheduling.
+**/
+MVREXPORT void MvrThreadScheduling::remForThread(const char *threadName)
+{
+  if (threadName == NULL)
+    return;
+  ourMutex.lock();
+  ourSchedulings.erase(threadName);
+  ourMutex.unlock();
+}
+
+/**
+   MvrThread calls this from each thread it creates before running the
+   thread's functor.
+**/
+MVREXPORT void MvrThreadScheduling::applyToThisThread(const char *threadName)
+{
+  MvrThreadScheduling scheduling;
+
+  if (threadName == NULL || threadName[0] == '\0' || 
+      !getForThread(threadName, &scheduling))
+    return;
+  scheduling.apply(MvrThread::osSelf(), threadName);
+}
+
+MVREXPORT bool MvrThreadScheduling::lockMemory(void)
+{
+#ifdef __linux__
+  ourMutex.lock();
+  if (ourMemoryLocked)
+  {
+    ourMutex.unlock();
+    return true;
+  }
+  if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+  {
+    ourMutex.unlock();
+    MvrLog::logErrorFromOS(MvrLog::Terse, 
+			   "MvrThreadScheduling::lockMemory: Could not lock memory");
+    return false;
+  }
+  ourMemoryLocked = true;
+  ourMutex.unlock();
+  MvrLog::log(MvrLog::Normal, "MvrThreadScheduling: Locked memory");
+  return true;
+#else
+  return false;
+#endif
+}
+
+/**
+   Adds ThreadName_CPUs, ThreadName_Policy and ThreadName_Priority
+   parameters (with ThreadName being the thread's name) to the section,
+   and a LockMemory parameter the first time it is called.  When the
+   config is processed the scheduling is set for the thread with
+   setForThread() (if anything is set for it).
+**/
+MVREXPORT void MvrThreadScheduling::addToConfig(MvrConfig *config, 
+						const char *threadName,
+						const char *section)
+{
+  ConfigEntry *entry;
+  std::string name;
+  bool first;
+
+  if (config == NULL || threadName == NULL)
+    return;
+  ourMutex.lock();
+  if (ourConfigEntries.find(threadName) != ourConfigEntries.end())
+  {
+    ourMutex.unlock();
+    return;
+  }
+  first = ourConfigEntries.empty();
+  entry = new ConfigEntry;
+  entry->myPolicy = "inherit";
+  entry->myPriority = 0;
+  ourConfigEntries[threadName] = entry;
+  ourMutex.unlock();
+
+  if (first)
+  {
+    config->addParam(
+	    MvrConfigArg("LockMemory", &ourConfigLockMemory,
+			 "True to lock all of the program's memory into RAM (so real time threads never wait for it to be paged in)"),
+	    section, MvrPriority::EXPERT);
+    ourProcessFileCB.setName("MvrThreadScheduling");
+    config->addProcessFileWithErrorCB(&ourProcessFileCB, 50);
+  }
+  name = threadName;
+  name += "_CPUs";
+  config->addParam(
+	  MvrConfigArg(name.c_str(), &entry->myCPUs,
+		       "The CPUs the thread can run on, like 2 or 0,2-3 (empty to leave it up to the OS)"),
+	  section, MvrPriority::EXPERT);
+  name = threadName;
+  name += "_Policy";
+  config->addParam(
+	  MvrConfigArg(name.c_str(), &entry->myPolicy,
+		       "The scheduling policy for the thread: inherit (leave it alone), other (normal), fifo or rr (real time)"),
+	  section, MvrPriority::EXPERT);
+  name = threadName;
+  name += "_Priority";
+  config->addParam(
+	  MvrConfigArg(name.c_str(), &entry->myPriority,
+		       "The real time priority for the thread (1 to 99, for fifo and rr)",
+		       0, 99),
+	  section, MvrPriority::EXPERT);
+}
+
+bool MvrThreadScheduling::processFile(char *errorBuffer, 
+				      size_t errorBufferLen)
+{
+  std::map<std::string, ConfigEntry *>::iterator it;
+  std::map<std::string, MvrThreadScheduling> toSet;
+  std::map<std::string, MvrThreadScheduling>::iterator setIt;
+  Policy policy;
+
+  ourMutex.lock();
+  for (it = ourConfigEntries.begin(); it != ourConfigEntries.end(); ++it)
+  {
+    if (!parsePolicy((*it).second->myPolicy.c_str(), &policy))
+    {
+      ourMutex.unlock();
+      if (errorBuffer != NULL)
+	snprintf(errorBuffer, errorBufferLen, 
+		 "%s_Policy is '%s' which isn't inherit, other, fifo or rr",
+		 (*it).first.c_str(), (*it).second->myPolicy.c_str());
+      return false;
+    }
+    toSet[(*it).first] = MvrThreadScheduling((*it).second->myCPUs.c_str(),
+					     policy, 
+					     (*it).second->myPriority);
+  }
+  ourMutex.unlock();
+
+  for (setIt = toSet.begin(); setIt != toSet.end(); ++setIt)
+  {
+    if (strlen((*setIt).second.getCPUs()) > 0 || 
+	(*setIt).second.getPolicy() != INHERIT)
+      setForThread((*setIt).first.c_str(), (*setIt).second);
+    else
+      remForThread((*setIt).first.c_str());
+  }
+  if (ourConfigLockMemory)
+    lockMemory();
+  return true;
+}
+
+MVREXPORT bool MvrThreadScheduling::parsePolicy(const char *str, 
+						Policy *policy)
+{
+  if (str == NULL || str[0] == '\0' || strcasecmp(str, "inherit") == 0)
+    *policy = INHERIT;
+  else if (strcasecmp(str, "other") == 0)
+    *policy = OTHER;
+  else if (strcasecmp(str, "fifo") == 0)
+    *policy = FIFO;
+  else if (strcasecmp(str, "rr") == 0)
+    *policy = RR;
+  else
+    return false;
+  return true;
+}
+
+MVREXPORT const char *MvrThreadScheduling::getPolicyName(Policy policy)
+{
+  switch (policy)
+  {
+  case INHERIT:
+    return "inherit";
+  case OTHER:
+    return "other";
+  case FIFO:
+    return "fifo";
+  case RR:
+    return "rr";
+  default:
+    return "unknown";
+  }
+}
@@ -11,7 +11,6 @@ MVREXPORT MvrUrg::MvrUrg(int laserNumber, const char *name) :
   myMvrExitCB(this, &MvrUrg::disconnect)
 {
   clear();
-  myRawReadings = NULL;
 
   Mvria::addExitCallback(&myMvrExitCB, -10);
 
@@ -73,13 +72,6 @@ MVREXPORT MvrUrg::~MvrUrg()
     myRobot->remLaser(this);
     myRobot->remSensorInterpTask(&mySensorInterpTask);
   }
-  if (myRawReadings != NULL)
-  {
-    MvrUtil::deleteSet(myRawReadings->begin(), myRawReadings->end());
-    myRawReadings->clear(); 
-    delete myRawReadings;
-    myRawReadings = NULL;
-  }
   lockDevice();
   if (isConnected())
     disconnect();
@@ -154,18 +146,9 @@ MVREXPORT bool MvrUrg::setParamsBySteps(int startingStep, int endingStep,
   if (myClusterCount > 1)
     myClusterMiddleAngle = myClusterCount * 0.3515625 / 2.0;
 
-  if (myRawReadings != NULL)
-  {
-    MvrUtil::deleteSet(myRawReadings->begin(), myRawReadings->end());
-    myRawReadings->clear();
-    delete myRawReadings;
-    myRawReadings = NULL;
-  }
-
-  myRawReadings = new std::list<MvrSensorReading *>;
-  
-
-  MvrSensorReading *reading;
+  // work out the angle of each reading once, here, so sensorInterp
+  // only has to fill in the ranges
+  myStepThs.clear();
   int onStep;
   double angle;
 
@@ -181,14 +164,9 @@ MVREXPORT bool MvrUrg::setParamsBySteps(int startingStep, int endingStep,
       angle = MvrMath::addAngle(MvrMath::addAngle(-135, onStep * 0.3515625), 
 			       myClusterMiddleAngle);
 			       
-    reading = new MvrSensorReading;
-    reading->resetSensorPosition(MvrMath::roundInt(mySensorPose.getX()),
-				 MvrMath::roundInt(mySensorPose.getY()),
-				 MvrMath::addAngle(angle, 
-						  mySensorPose.getTh()));
-    myRawReadings->push_back(reading);
-    //printf("%.1f ", reading->getSensorTh());
+    myStepThs.push_back(MvrMath::addAngle(angle, mySensorPose.getTh()));
   }
+  myRawScan.setNumReadings(myStepThs.size());
 
 
   myDataMutex.unlock();
@@ -643,13 +621,15 @@ void MvrUrg::sensorInterp(void)
   int little;
   //int onStep;
 
-  std::list<MvrSensorReading *>::reverse_iterator it;
-  MvrSensorReading *sReading;
-
+  // the ranges come in the opposite order from the readings
+  int onReading;
+  int sensorX = MvrMath::roundInt(mySensorPose.getX());
+  int sensorY = MvrMath::roundInt(mySensorPose.getY());
   bool ignore;
-  for (it = myRawReadings->rbegin(), i = 0; 
-       it != myRawReadings->rend() && i < len - 1; 
-       it++, i += 2)
+  myRawScan.beginScan(pose, encoderPose, transform, counter, time);
+  for (onReading = myRawScan.getNumReadings() - 1, i = 0; 
+       onReading >= 0 && i < len - 1; 
+       onReading--, i += 2)
   {
     ignore = false;
     big = reading[i] - 0x30;
@@ -666,10 +646,10 @@ void MvrUrg::sensorInterp(void)
       */
       range = 4096;
     }
-    sReading = (*it);
-    sReading->newData(range, pose, encoderPose, transform, counter, 
-		      time, ignore, 0);
+    myRawScan.setReading(onReading, range, sensorX, sensorY, 
+			 myStepThs[onReading], ignore, 0);
   }
+  myRawScan.endScan();
 
   myDataMutex.unlock();
 
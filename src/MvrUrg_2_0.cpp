@@ -4,6 +4,9 @@
 #include "MvrRobot.h"
 #include "MvrSerialConnection.h"
 #include "mvriaInternal.h"
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 MVREXPORT MvrUrg_2_0::MvrUrg_2_0(int laserNumber, const char *name) :
   MvrLaser(laserNumber, name, 262144),
@@ -11,7 +14,6 @@ MVREXPORT MvrUrg_2_0::MvrUrg_2_0(int laserNumber, const char *name) :
   myMvrExitCB(this, &MvrUrg_2_0::disconnect)
 {
   clear();
-  myRawReadings = NULL;
 
   Mvria::addExitCallback(&myMvrExitCB, -10);
 
@@ -73,13 +75,6 @@ MVREXPORT MvrUrg_2_0::~MvrUrg_2_0()
     myRobot->remLaser(this);
     myRobot->remSensorInterpTask(&mySensorInterpTask);
   }
-  if (myRawReadings != NULL)
-  {
-    MvrUtil::deleteSet(myRawReadings->begin(), myRawReadings->end());
-    myRawReadings->clear(); 
-    delete myRawReadings;
-    myRawReadings = NULL;
-  }
   lockDevice();
   if (isConnected())
     disconnect();
@@ -197,18 +192,9 @@ MVREXPORT bool MvrUrg_2_0::setParamsBySteps(int startingStep, int endingStep,
     //myClusterMiddleAngle = myClusterCount * 0.3515625 / 2.0;
     myClusterMiddleAngle = myClusterCount * myStepSize / 2.0;
 
-  if (myRawReadings != NULL)
-  {
-    MvrUtil::deleteSet(myRawReadings->begin(), myRawReadings->end());
-    myRawReadings->clear();
-    delete myRawReadings;
-    myRawReadings = NULL;
-  }
-
-  myRawReadings = new std::list<MvrSensorReading *>;
-  
-
-  MvrSensorReading *reading;
+  // work out the angle of each reading once, here, so sensorInterp
+  // only has to fill in the ranges
+  myStepThs.clear();
   int onStep;
   double angle;
 
@@ -230,14 +216,19 @@ MVREXPORT bool MvrUrg_2_0::setParamsBySteps(int startingStep, int endingStep,
 						onStep * myStepSize), 
 			       myClusterMiddleAngle);
 			       
-    reading = new MvrSensorReading;
-    reading->resetSensorPosition(MvrMath::roundInt(mySensorPose.getX()),
-				 MvrMath::roundInt(mySensorPose.getY()),
-				 MvrMath::addAngle(angle, 
-						  mySensorPose.getTh()));
-    myRawReadings->push_back(reading);
-    //printf("%.1f ", reading->getSensorTh());
+    myStepThs.push_back(MvrMath::addAngle(angle, mySensorPose.getTh()));
   }
+  myRawScan.setNumReadings(myStepThs.size());
+
+  // make room for the whole reading up front, so getting readings
+  // never allocates
+  myReadingMutex.lock();
+  myRanges.resize((myEndingStep - myStartingStep) / myClusterCount + 1);
+  myReadingRanges.resize(myRanges.size());
+  myInterpRanges.resize(myRanges.size());
+  myNumRanges = 0;
+  myReadingNumRanges = 0;
+  myReadingMutex.unlock();
 
 
   myDataMutex.unlock();
@@ -265,6 +256,12 @@ void MvrUrg_2_0::clear(void)
   myAMax = 0;
   myAFront = 0;
   myScan = 0;
+
+  myReceiveStart = 0;
+  myReceiveEnd = 0;
+  myNumRanges = 0;
+  myReadingNumRanges = 0;
+  myCarryCount = 0;
 }
 
 MVREXPORT void MvrUrg_2_0::log(void)
@@ -335,6 +332,45 @@ this MvrTime objects.
 bool MvrUrg_2_0::readLine(char *buf, unsigned int size, 
 			 unsigned int msWait, bool noChecksum, 
 			 bool stripLastSemicolon, MvrTime *firstByte)
+{
+  char *line;
+  unsigned int len;
+
+  buf[0] = '\0';
+  if (!nextLine(&line, &len, msWait, firstByte))
+    return false;
+
+  if (len >= size)
+    len = size - 1;
+  memcpy(buf, line, len);
+  buf[len] = '\0';
+
+  if (!noChecksum && !checkLine(buf, &len, stripLastSemicolon))
+    return false;
+
+  if (myLogMore)
+    MvrLog::log(MvrLog::Normal, "%s: '%s'", getName(), buf);
+  return true;
+}
+
+/**
+   This reads from the connection a buffer at a time (instead of a
+   byte at a time) and hands back the lines out of that buffer, so
+   the lines of a reading never get copied anywhere.
+
+   @param line set to the start of the line, which is null
+   terminated where its end of line was, this is only good until the
+   next call
+
+   @param len set to the length of the line
+
+   @param msWait how long to wait for the line, 0 to wait forever
+
+   @param firstByte if given set to the time the first byte of the
+   line was received
+**/
+bool MvrUrg_2_0::nextLine(char **line, unsigned int *len, 
+			  unsigned int msWait, MvrTime *firstByte)
 {
   if (myConn == NULL)
   {
@@ -346,67 +382,58 @@ bool MvrUrg_2_0::readLine(char *buf, unsigned int size,
   MvrTime started;
   started.setToNow();
 
-  buf[0] = '\0';
-  unsigned int onChar = 0;
-  int ret;
-
-  //long int rawCheckSum = 0;
-  unsigned char rawCheckSum = 0;
-  char checkSum;
   unsigned int i;
-  unsigned int iMax;
+  int ret;
 
   myConnMutex.lock();
-  while ((msWait == 0 || started.mSecSince() < (int)msWait) && 
-	 onChar < size)
+  if (firstByte != NULL && myReceiveStart < myReceiveEnd)
+    *firstByte = myReceiveTime;
+  i = myReceiveStart;
+  while (1)
   {
-    if ((ret = myConn->read(&buf[onChar], 1, 0)) > 0)
+    // see if we have a whole line already
+    for (; i < myReceiveEnd; i++)
     {
-      if (onChar == 0 && firstByte != NULL)
-	firstByte->setToNow();
-      if (buf[onChar] == '\n' || 
-	  buf[onChar] == '\r')
+      if (myReceiveBuf[i] == '\n' || myReceiveBuf[i] == '\r')
       {
-	//buf[onChar+1] = '\0';
-	buf[onChar] = '\0';
-	if (!noChecksum && onChar >= 1)
-	{
-	  if (stripLastSemicolon &&
-	      onChar > 2 && buf[onChar - 2] == ';')
-	    iMax = onChar - 2;
-          else
-	    iMax = onChar - 1;
-
-	  // find the checksum 
-	  for (i = 0; i < iMax; i++)
-	    rawCheckSum += buf[i];
-
-	  // see if it matches onChar - 1, then NULL out onchar -1
-	  checkSum = (rawCheckSum & 0x3f) + 0x30;
-	  
-	  if ((checkSum) != buf[onChar - 1])
-	  {
-	    MvrLog::log(MvrLog::Normal, 
-		       "%s: Bad checksum on '%s' it should be %c", 
-		       getName(), buf, checkSum);
-	    myConnMutex.unlock();
-	    return false;
-	  }
-	  // null out the checksum so it doesn't mess up other parsing
-	  buf[onChar - 1] = '\0';
-
-	  if (stripLastSemicolon &&
-	      onChar >= 2 && buf[onChar - 2] == ';')
-	  {
-	    buf[onChar - 2] = '\0';
-	  }
-	}
-	if (myLogMore)
-	  MvrLog::log(MvrLog::Normal, "%s: '%s'", getName(), buf);
+	myReceiveBuf[i] = '\0';
+	*line = &myReceiveBuf[myReceiveStart];
+	*len = i - myReceiveStart;
+	myReceiveStart = i + 1;
 	myConnMutex.unlock();
 	return true;
       }
-      onChar++;
+    }
+
+    if (msWait != 0 && started.mSecSince() >= (int)msWait)
+      break;
+
+    // make room for more
+    if (myReceiveStart > 0)
+    {
+      memmove(myReceiveBuf, &myReceiveBuf[myReceiveStart], 
+	      myReceiveEnd - myReceiveStart);
+      myReceiveEnd -= myReceiveStart;
+      i -= myReceiveStart;
+      myReceiveStart = 0;
+    }
+    if (myReceiveEnd >= sizeof(myReceiveBuf))
+    {
+      MvrLog::log(MvrLog::Normal, 
+		 "%s: Line too long (over %d bytes), dropping it", 
+		 getName(), (int)sizeof(myReceiveBuf));
+      myReceiveStart = myReceiveEnd = 0;
+      i = 0;
+    }
+
+    if ((ret = myConn->read(&myReceiveBuf[myReceiveEnd], 
+			    sizeof(myReceiveBuf) - myReceiveEnd, 0)) > 0)
+    {
+      myReceiveTime.setToNow();
+      if (firstByte != NULL && myReceiveEnd == 0)
+	*firstByte = myReceiveTime;
+      myReceiveEnd += ret;
+      continue;
     }
     if (ret < 0)
     {
@@ -414,13 +441,70 @@ bool MvrUrg_2_0::readLine(char *buf, unsigned int size,
       myConnMutex.unlock();
       return false;
     }
-    if (ret == 0)
-      MvrUtil::sleep(1);
+    MvrUtil::sleep(1);
   }
   myConnMutex.unlock();
   return false;
 }
 
+/**
+   Checks the SCIP checksum (the low 6 bits of the sum of the line
+   plus 0x30) on the end of a line, then takes it off the line.
+
+   @param line the line, which gets the checksum (and the semicolon
+   if stripLastSemicolon) nulled out
+
+   @param len the length of the line, which is changed to the length
+   without the checksum
+
+   @param stripLastSemicolon Some responses (to VV and PP) have a
+   semicolon to separate the string from the checksum... but that
+   semicolon is NOT included in the checksum, and shouldn't be
+   included in the string...   
+**/
+bool MvrUrg_2_0::checkLine(char *line, unsigned int *len, 
+			   bool stripLastSemicolon)
+{
+  unsigned char rawCheckSum = 0;
+  char checkSum;
+  unsigned int i;
+  unsigned int iMax;
+  unsigned int onChar = *len;
+
+  if (onChar < 1)
+    return true;
+
+  if (stripLastSemicolon && onChar > 2 && line[onChar - 2] == ';')
+    iMax = onChar - 2;
+  else
+    iMax = onChar - 1;
+
+  // find the checksum 
+  for (i = 0; i < iMax; i++)
+    rawCheckSum += line[i];
+  
+  // see if it matches onChar - 1, then NULL out onchar -1
+  checkSum = (rawCheckSum & 0x3f) + 0x30;
+  
+  if ((checkSum) != line[onChar - 1])
+  {
+    MvrLog::log(MvrLog::Normal, 
+	       "%s: Bad checksum on '%s' it should be %c", 
+	       getName(), line, checkSum);
+    return false;
+  }
+  // null out the checksum so it doesn't mess up other parsing
+  line[onChar - 1] = '\0';
+  *len = onChar - 1;
+  
+  if (stripLastSemicolon && onChar >= 2 && line[onChar - 2] == ';')
+  {
+    line[onChar - 2] = '\0';
+    *len = onChar - 2;
+  }
+  return true;
+}
+
 bool MvrUrg_2_0::sendCommandAndRecvStatus(
 	const char *command, const char *commandDesc, 
 	char *buf, unsigned int size, unsigned int msWait)
@@ -498,6 +582,8 @@ MVREXPORT bool MvrUrg_2_0::blockingConnect(void)
     failedToConnect();
     return false;
   }
+  myReceiveStart = 0;
+  myReceiveEnd = 0;
   myConnMutex.unlock();
 
   lockDevice();
@@ -801,20 +887,66 @@ MVREXPORT bool MvrUrg_2_0::disconnect(void)
 }
 
 
+/**
+   Decodes num SCIP values of width (2 or 3) characters each from data
+   into values.  With SSE2 the 2 character values are done 8 at a
+   time, each pair of characters is one 16 bit lane.  The 3 character
+   ones don't line up with any lane size (and SSE2 can't shuffle
+   bytes) so they're done one at a time.
+**/
+static void decodeSCIP(const char *data, int num, int width, int *values)
+{
+  const unsigned char *chars = (const unsigned char *)data;
+  int i = 0;
+
+  if (width == 3)
+  {
+    for (; i < num; i++, chars += 3)
+      values[i] = ((chars[0] - 0x30) << 12 | (chars[1] - 0x30) << 6 | 
+		   (chars[2] - 0x30));
+    return;
+  }
+
+#ifdef __SSE2__
+  const __m128i offset = _mm_set1_epi8(0x30);
+  const __m128i lowByte = _mm_set1_epi16(0xff);
+  const __m128i zero = _mm_setzero_si128();
+  __m128i lanes;
+  __m128i decoded;
+
+  for (; i + 8 <= num; i += 8, chars += 16)
+  {
+    lanes = _mm_sub_epi8(_mm_loadu_si128((const __m128i *)chars), offset);
+    // the first character is the low byte of each lane
+    decoded = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(lanes, lowByte), 6),
+			   _mm_srli_epi16(lanes, 8));
+    _mm_storeu_si128((__m128i *)(values + i), 
+		     _mm_unpacklo_epi16(decoded, zero));
+    _mm_storeu_si128((__m128i *)(values + i + 4), 
+		     _mm_unpackhi_epi16(decoded, zero));
+  }
+#endif
+
+  for (; i < num; i++, chars += 2)
+    values[i] = (chars[0] - 0x30) << 6 | (chars[1] - 0x30);
+}
+
 void MvrUrg_2_0::sensorInterp(void)
 {
   MvrTime readingRequested;
-  std::string reading;
+  int numRanges;
   myReadingMutex.lock();
-  if (myReading.empty())
+  if (myReadingNumRanges == 0)
   {
     myReadingMutex.unlock();
     return;
   }
 
   readingRequested = myReadingRequested;
-  reading = myReading;
-  myReading = "";
+  // take the reading without copying it
+  myReadingRanges.swap(myInterpRanges);
+  numRanges = myReadingNumRanges;
+  myReadingNumRanges = 0;
   myReadingMutex.unlock();
 
   MvrTime time = readingRequested;
@@ -849,59 +981,31 @@ void MvrUrg_2_0::sensorInterp(void)
 
   //double angle;
   int i;
-  int len = reading.size();
 
   int range;
-  int giant;
-  int big; 
-  int little;
   //int onStep;
 
-  std::list<MvrSensorReading *>::reverse_iterator it;
-  MvrSensorReading *sReading;
-  
-  int iMax;
-  int iIncr;
-
-  if (myUseThreeDataBytes)
-  {
-    iMax = len - 2;
-    iIncr = 3;
-  }
-  else
-  {
-    iMax = len - 1;
-    iIncr = 2;
-  }
-
+  // the ranges come in the opposite order from the readings
+  int onReading;
+  int sensorX = MvrMath::roundInt(mySensorPose.getX());
+  int sensorY = MvrMath::roundInt(mySensorPose.getY());
   bool ignore;
-  for (it = myRawReadings->rbegin(), i = 0; 
-       it != myRawReadings->rend() && i < iMax; //len - 2; 
-       it++, i += iIncr) //3)
+  myRawScan.beginScan(pose, encoderPose, transform, counter, time);
+  for (onReading = myRawScan.getNumReadings() - 1, i = 0; 
+       onReading >= 0 && i < numRanges;
+       onReading--, i++)
   {
     ignore = false;
 
-    if (myUseThreeDataBytes)
-    {
-      giant = reading[i] - 0x30;
-      big = reading[i+1] - 0x30;
-      little = reading[i+2] - 0x30;
-      range = (giant << 12 | big << 6 | little);
-    }
-    else
-    {
-      big = reading[i] - 0x30;
-      little = reading[i+1] - 0x30;
-      range = (big << 6 | little);
-    }
+    range = myInterpRanges[i];
     
     if (range < myDMin)
       range = myDMax+1;
 
-    sReading = (*it);
-    sReading->newData(range, pose, encoderPose, transform, counter, 
-		      time, ignore, 0);
+    myRawScan.setReading(onReading, range, sensorX, sensorY, 
+			 myStepThs[onReading], ignore, 0);
   }
+  myRawScan.endScan();
 
   myDataMutex.unlock();
 
@@ -961,10 +1065,10 @@ MVREXPORT void * MvrUrg_2_0::runThread(void *arg)
 bool MvrUrg_2_0::internalGetReading(void)
 {
   MvrTime readingRequested;
-  std::string reading;
   char buf[1024];
+  char *line;
+  unsigned int len;
 
-  reading = "";
   /*
   if (!writeLine(myRequestString))
   {
@@ -1005,25 +1109,74 @@ bool MvrUrg_2_0::internalGetReading(void)
     return false;
   }
   
-  while (readLine(buf, sizeof(buf), 100, false, false))
+  // decode each line of data as it comes in, straight out of the
+  // receive buffer
+  myNumRanges = 0;
+  myCarryCount = 0;
+  while (nextLine(&line, &len, 100))
   {
-    if (strlen(buf) == 0)
+    if (len == 0)
     {
       myReadingMutex.lock();
       myReadingRequested = readingRequested;
-      myReading = reading;
+      myRanges.swap(myReadingRanges);
+      myReadingNumRanges = myNumRanges;
       myReadingMutex.unlock();	
+      myNumRanges = 0;
       if (myRobot == NULL)
 	sensorInterp();
       return true;
     }
-    else
+    if (!checkLine(line, &len, false))
+      return false;
+    decodeLine(line, len);
+  }
+
+  return false;
+}
+
+/**
+   SCIP encodes each value as 2 or 3 characters of 6 bits each (plus
+   0x30), most significant first, and values can be split across the
+   end of a line.  This decodes the whole values in the line into
+   myRanges and keeps any leftover characters for the next line.
+**/
+void MvrUrg_2_0::decodeLine(const char *data, unsigned int len)
+{
+  int width = myUseThreeDataBytes ? 3 : 2;
+  int room = myRanges.size() - myNumRanges;
+  int num;
+  int numDecode;
+
+  // finish off a value that was split over the end of the last line
+  while (myCarryCount > 0 && myCarryCount < width && len > 0)
+  {
+    myCarry[myCarryCount++] = *data++;
+    len--;
+    if (myCarryCount == width)
     {
-      reading += buf;
+      if (room > 0)
+      {
+	decodeSCIP(myCarry, 1, width, &myRanges[myNumRanges]);
+	myNumRanges++;
+	room--;
+      }
+      myCarryCount = 0;
     }
   }
 
-  return false;
+  num = len / width;
+  numDecode = num;
+  if (numDecode > room)
+    numDecode = room;
+  if (numDecode > 0)
+  {
+    decodeSCIP(data, numDecode, width, &myRanges[myNumRanges]);
+    myNumRanges += numDecode;
+  }
+
+  for (data += num * width, len -= num * width; len > 0; data++, len--)
+    myCarry[myCarryCount++] = *data;
 }
 
 void MvrUrg_2_0::failedToConnect(void)
@@ -261,6 +261,8 @@ MVREXPORT void Mvria::uninit()
 #ifndef MVRINTERFACE
   MvrModuleLoader::closeAll();
 #endif // MVRINTERFACE
+  // stops the async log writer (if there is one) and writes out what's left
+  MvrLog::setAsync(false);
   MvrSocket::shutdown();
   MvrThread::shutdown();
 }
@@ -389,6 +391,8 @@ MVREXPORT void Mvria::callExitCallbacks(void)
   }
   MvrLog::log(ourExitCallbacksLogLevel, "Mvria::exit: Finished exit callbacks");
   ourExitCallbacksMutex.unlock();
+  // so nothing still waiting in the async log buffers is lost
+  MvrLog::flush();
 } 
  
 /**
@@ -170,6 +170,31 @@ MVREXPORT unsigned int MvrUtil::getTime(void)
 #endif
 }
 
+/**
+   This is the same clock as getTime() (so the same caveats apply), but
+   in microseconds, and it doesn't wrap.  It's meant for timing things
+   that take less than a millisecond.  On Windows it is only as accurate
+   as timeGetTime().
+   @return microsecond time
+*/
+MVREXPORT unsigned long long MvrUtil::getTimeUSec(void)
+{
+#if defined(_POSIX_TIMERS) && defined(_POSIX_MONOTONIC_CLOCK)
+  struct timespec tp;
+  if (clock_gettime(CLOCK_MONOTONIC, &tp) == 0)
+    return (unsigned long long)tp.tv_sec * 1000000 + tp.tv_nsec / 1000;
+#endif
+#if !defined(WIN32)
+  struct timeval tv;
+  if (gettimeofday(&tv,NULL) == 0)
+    return (unsigned long long)tv.tv_sec * 1000000 + tv.tv_usec;
+  else
+    return 0;
+#elif defined(WIN32)
+  return (unsigned long long)timeGetTime() * 1000;
+#endif
+}
+
 /*
    Takes a string and splits it into a list of words. It appends the words
    to the outList. If there is nothing found, it will not touch the outList.
@@ -0,0 +1,115 @@
+#include "Mvria.h"
+#include "MvrCRC16.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+/*
+  Checks MvrCRC16 against the standard check values, checks that the
+  slicing-by-8 block update gets the same answer as going a byte at a
+  time however the data is split up, then times both over a frame the
+  size of an S300 scan.
+*/
+
+const int frameSize = 1100;
+const int framesToTime = 100000;
+
+// the plain one table, one byte at a time CRC, to check against
+unsigned short byteAtATime(const unsigned char *data, int length,
+			   unsigned short crc)
+{
+  MvrCRC16 calc(crc);
+  int i;
+  for (i = 0; i < length; i++)
+    calc.update(data[i]);
+  return calc.getCRC();
+}
+
+int main(int argc, char **argv)
+{
+  Mvria::init();
+  const unsigned char check[] = "123456789";
+  unsigned char data[4096];
+  bool failed = false;
+  int i;
+  int length;
+  int split;
+  unsigned short want;
+  unsigned long long start;
+  volatile unsigned short sink = 0;
+
+  // CRC-16/CCITT-FALSE (what the S3 series uses) and CRC-16/XMODEM
+  // (what the SZ series uses)
+  if (MvrCRC16::calculate(check, 9, 0xffff) != 0x29b1 ||
+      byteAtATime(check, 9, 0xffff) != 0x29b1)
+  {
+    printf("FAILED: CRC of \"123456789\" from 0xffff should be 0x29b1, got 0x%04x and 0x%04x\n",
+	   MvrCRC16::calculate(check, 9, 0xffff),
+	   byteAtATime(check, 9, 0xffff));
+    failed = true;
+  }
+  if (MvrCRC16::calculate(check, 9, 0) != 0x31c3)
+  {
+    printf("FAILED: CRC of \"123456789\" from 0 should be 0x31c3, got 0x%04x\n",
+	   MvrCRC16::calculate(check, 9, 0));
+    failed = true;
+  }
+
+  srand(1);
+  for (i = 0; i < (int)sizeof(data); i++)
+    data[i] = rand() & 0xff;
+
+  for (length = 0; length < 300 && !failed; length++)
+  {
+    want = byteAtATime(data, length, 0xffff);
+    if (MvrCRC16::calculate(data, length) != want)
+    {
+      printf("FAILED: block CRC of %d bytes is 0x%04x, should be 0x%04x\n",
+	     length, MvrCRC16::calculate(data, length), want);
+      failed = true;
+    }
+    // a few bytes at a time then the rest, like the receivers do
+    for (split = 0; split <= length && !failed; split++)
+    {
+      MvrCRC16 crc;
+      int j;
+      for (j = 0; j < split; j++)
+	crc.update(data[j]);
+      crc.update(&data[split], length - split);
+      if (crc.getCRC() != want)
+      {
+	printf("FAILED: CRC of %d bytes split at %d is 0x%04x, should be 0x%04x\n",
+	       length, split, crc.getCRC(), want);
+	failed = true;
+      }
+      crc.reset();
+      crc.update(data, split);
+      crc.update(&data[split], length - split);
+      if (crc.getCRC() != want)
+      {
+	printf("FAILED: CRC of %d bytes in two blocks split at %d is 0x%04x, should be 0x%04x\n",
+	       length, split, crc.getCRC(), want);
+	failed = true;
+      }
+    }
+  }
+
+  start = MvrUtil::getTimeUSec();
+  for (i = 0; i < framesToTime; i++)
+    sink ^= byteAtATime(data, frameSize, 0xffff);
+  printf("Byte at a time:  %6.2f us per %d byte frame\n",
+	 (MvrUtil::getTimeUSec() - start) / (double)framesToTime, frameSize);
+  start = MvrUtil::getTimeUSec();
+  for (i = 0; i < framesToTime; i++)
+    sink ^= MvrCRC16::calculate(data, frameSize);
+  printf("Slicing by 8:    %6.2f us per %d byte frame\n",
+	 (MvrUtil::getTimeUSec() - start) / (double)framesToTime, frameSize);
+
+  if (failed)
+  {
+    printf("crc16Test FAILED\n");
+    Mvria::exit(1);
+  }
+  printf("crc16Test passed\n");
+  Mvria::exit(0);
+  return 0;
+}
@@ -0,0 +1,119 @@
+#include "Mvria.h"
+#include "MvrFastMutex.h"
+#include <stdio.h>
+#include <pthread.h>
+
+/*
+  Checks that MvrFastMutex keeps threads out of each other's way, then
+  times uncontended lock/unlock pairs for it, MvrMutex and a plain
+  pthread mutex.
+*/
+
+const int numThreads = 4;
+const int incrementsPerThread = 200000;
+const int pairsToTime = 10000000;
+
+MvrFastMutex fastMutex;
+// not atomic on purpose, the mutex is all that keeps this right
+long counter = 0;
+
+void *incrementer(void *arg)
+{
+  int i;
+  for (i = 0; i < incrementsPerThread; i++)
+  {
+    fastMutex.lock();
+    counter++;
+    fastMutex.unlock();
+  }
+  return NULL;
+}
+
+template <class Mutex>
+double timePairs(Mutex *mutex)
+{
+  unsigned long long start;
+  int i;
+
+  start = MvrUtil::getTimeUSec();
+  for (i = 0; i < pairsToTime; i++)
+  {
+    mutex->lock();
+    mutex->unlock();
+  }
+  return (MvrUtil::getTimeUSec() - start) * 1000.0 / pairsToTime;
+}
+
+// so timePairs can take a pthread mutex too
+class PlainMutex
+{
+public:
+  PlainMutex() { pthread_mutex_init(&myMutex, NULL); }
+  ~PlainMutex() { pthread_mutex_destroy(&myMutex); }
+  void lock(void) { pthread_mutex_lock(&myMutex); }
+  void unlock(void) { pthread_mutex_unlock(&myMutex); }
+protected:
+  pthread_mutex_t myMutex;
+};
+
+int main(int argc, char **argv)
+{
+  Mvria::init();
+  MvrGlobalRetFunctor1<void *, void *> incrementerCB(&incrementer);
+  MvrFunctorASyncTask *threads[numThreads];
+  MvrFastMutex fast;
+  MvrMutex recursive;
+  MvrMutex nonRecursive(false);
+  PlainMutex plain;
+  int i;
+  bool failed = false;
+
+  if (fast.tryLock() != 0 || 
+      fast.tryLock() != MvrMutex::STATUS_ALREADY_LOCKED)
+  {
+    printf("FAILED: tryLock on a free mutex should lock it, and then fail\n");
+    failed = true;
+  }
+  fast.unlock();
+  if (fast.tryLock() != 0)
+  {
+    printf("FAILED: tryLock after unlock should lock it\n");
+    failed = true;
+  }
+  fast.unlock();
+
+  for (i = 0; i < numThreads; i++)
+  {
+    threads[i] = new MvrFunctorASyncTask(&incrementerCB);
+    threads[i]->create(true, true);
+  }
+  for (i = 0; i < numThreads; i++)
+  {
+    threads[i]->join();
+    delete threads[i];
+  }
+  if (counter != (long)numThreads * incrementsPerThread)
+  {
+    printf("FAILED: %d threads each counting to %d got %ld\n", 
+	   numThreads, incrementsPerThread, counter);
+    failed = true;
+  }
+  else
+    printf("%d threads counted to %ld under the fast mutex\n", 
+	   numThreads, counter);
+
+  printf("Uncontended lock/unlock pair times:\n");
+  printf("  MvrFastMutex:             %6.1f ns\n", timePairs(&fast));
+  printf("  MvrMutex (recursive):     %6.1f ns\n", timePairs(&recursive));
+  printf("  MvrMutex (nonrecursive):  %6.1f ns\n", timePairs(&nonRecursive));
+  printf("  pthread_mutex_t:          %6.1f ns\n", timePairs(&plain));
+
+  if (failed)
+  {
+    printf("fastMutexTest FAILED\n");
+    Mvria::exit(1);
+  }
+  printf("fastMutexTest passed\n");
+  Mvria::exit(0);
+  return 0;
+}
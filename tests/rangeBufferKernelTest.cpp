@@ -0,0 +1,178 @@
+#include "Mvria.h"
+#include "MvrRangeBufferKernels.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+/*
+  Checks that the vectorized closest reading searches give the same
+  answers as the old one reading at a time searches (which are still
+  what MvrRangeBuffer::getClosestPolarInList and getClosestBoxInList
+  do), then times them all on buffers of different sizes.
+*/
+
+// about how many readings to look at for each timing
+const int readingsToTime = 5000000;
+
+double randomCoord(void)
+{
+  // the fraction keeps readings from landing right on box edges
+  return (rand() % 16000) - 8000 + .37;
+}
+
+void fillBuffer(MvrRangeBuffer *buffer, int size)
+{
+  int i;
+  buffer->setSize(size);
+  buffer->clear();
+  for (i = 0; i < size; i++)
+    buffer->addReading(randomCoord(), randomCoord());
+}
+
+bool checkPolar(MvrRangeBuffer *buffer, MvrPose robotPose, double start,
+		double end)
+{
+  double listAngle = 0, storageAngle = 0;
+  double listDist = MvrRangeBuffer::getClosestPolarInList(
+	  start, end, robotPose, 30000, &listAngle, buffer->getBuffer());
+  double storageDist = buffer->getClosestPolar(start, end, robotPose,
+					       30000, &storageAngle);
+  if (fabs(listDist - storageDist) > .0001 ||
+      (listDist < 30000 && fabs(listAngle - storageAngle) > .0001))
+  {
+    printf("Polar %.1f to %.1f: list %.4f at %.4f, storage %.4f at %.4f\n",
+	   start, end, listDist, listAngle, storageDist, storageAngle);
+    return false;
+  }
+  return true;
+}
+
+bool checkBox(MvrRangeBuffer *buffer, MvrPose robotPose, double x1,
+	      double y1, double x2, double y2)
+{
+  MvrPose listPos, storagePos;
+  double listDist = MvrRangeBuffer::getClosestBoxInList(
+	  x1, y1, x2, y2, robotPose, 30000, &listPos, MvrPose(0, 0, 0),
+	  buffer->getBuffer());
+  double storageDist = buffer->getClosestBox(x1, y1, x2, y2, robotPose,
+					     30000, &storagePos);
+  if (fabs(listDist - storageDist) > .0001 ||
+      listPos.findDistanceTo(storagePos) > .0001)
+  {
+    printf("Box %.0f %.0f %.0f %.0f: list %.4f, storage %.4f\n",
+	   x1, y1, x2, y2, listDist, storageDist);
+    return false;
+  }
+  return true;
+}
+
+// returns readings per second
+double timePolar(MvrRangeBuffer *buffer, MvrPose robotPose, bool useList)
+{
+  MvrTime start;
+  int i;
+  double sum = 0;
+  double angle;
+  const std::list<MvrPoseWithTime *> *list = buffer->getBuffer();
+  int numQueries = readingsToTime / buffer->getSize();
+  start.setToNow();
+  for (i = 0; i < numQueries; i++)
+  {
+    if (useList)
+      sum += MvrRangeBuffer::getClosestPolarInList(
+	      -90 + i % 45, 90 - i % 45, robotPose, 30000, &angle, list);
+    else
+      sum += buffer->getClosestPolar(-90 + i % 45, 90 - i % 45, robotPose,
+				     30000, &angle);
+  }
+  if (sum < 0)
+    printf("Impossible\n");
+  return ((double)numQueries * buffer->getSize() /
+	  MvrUtil::findMax((double)start.mSecSinceLL(), 1.0) * 1000.0);
+}
+
+// returns readings per second
+double timeBox(MvrRangeBuffer *buffer, MvrPose robotPose, bool useList)
+{
+  MvrTime start;
+  int i;
+  double sum = 0;
+  MvrPose pos;
+  const std::list<MvrPoseWithTime *> *list = buffer->getBuffer();
+  int numQueries = readingsToTime / buffer->getSize();
+  start.setToNow();
+  for (i = 0; i < numQueries; i++)
+  {
+    if (useList)
+      sum += MvrRangeBuffer::getClosestBoxInList(
+	      0, -400 - i, 3000 + i, 400 + i, robotPose, 30000, &pos,
+	      MvrPose(0, 0, 0), list);
+    else
+      sum += buffer->getClosestBox(0, -400 - i, 3000 + i, 400 + i,
+				   robotPose, 30000, &pos);
+  }
+  if (sum < 0)
+    printf("Impossible\n");
+  return ((double)numQueries * buffer->getSize() /
+	  MvrUtil::findMax((double)start.mSecSinceLL(), 1.0) * 1000.0);
+}
+
+int main(int argc, char **argv)
+{
+  Mvria::init();
+  MvrRangeBuffer buffer(1000);
+  MvrPose robotPose(250.5, -120.25, 37.5);
+  MvrRangeBufferKernels::Level best = MvrRangeBufferKernels::getBestLevel();
+  int sizes[] = { 1000, 5000, 10000, 50000 };
+  int numSizes = sizeof(sizes) / sizeof(sizes[0]);
+  int level;
+  int s;
+  int i;
+
+  srand(42);
+  printf("Best instruction set: %s\n",
+	 MvrRangeBufferKernels::getLevelName(best));
+
+  // make sure every level gets the same answers as the old way
+  for (level = MvrRangeBufferKernels::SCALAR; level <= best; level++)
+  {
+    MvrRangeBufferKernels::setLevel((MvrRangeBufferKernels::Level)level);
+    // odd sizes so the leftovers after the vector loops get checked too
+    fillBuffer(&buffer, 1003);
+    for (i = 0; i < 2000; i++)
+    {
+      if (!checkPolar(&buffer, robotPose, rand() % 720 - 360,
+		      rand() % 720 - 360) ||
+	  !checkBox(&buffer, robotPose, randomCoord(), randomCoord(),
+		    randomCoord(), randomCoord()))
+      {
+	printf("%s search doesn't match the list search\n",
+	       MvrRangeBufferKernels::getLevelName(
+		       (MvrRangeBufferKernels::Level)level));
+	exit(1);
+      }
+    }
+  }
+
+  printf("%8s %12s %14s %14s\n", "readings", "search", "polar rdg/sec",
+	 "box rdg/sec");
+  for (s = 0; s < numSizes; s++)
+  {
+    fillBuffer(&buffer, sizes[s]);
+    printf("%8d %12s %14.0f %14.0f\n", sizes[s], "list",
+	   timePolar(&buffer, robotPose, true),
+	   timeBox(&buffer, robotPose, true));
+    for (level = MvrRangeBufferKernels::SCALAR; level <= best; level++)
+    {
+      MvrRangeBufferKernels::setLevel((MvrRangeBufferKernels::Level)level);
+      printf("%8d %12s %14.0f %14.0f\n", sizes[s],
+	     MvrRangeBufferKernels::getLevelName(
+		     (MvrRangeBufferKernels::Level)level),
+	     timePolar(&buffer, robotPose, false),
+	     timeBox(&buffer, robotPose, false));
+    }
+  }
+  MvrRangeBufferKernels::setLevel(best);
+
+  MvrLog::log(MvrLog::Normal, "All tests completed.");
+  return 0;
+}
@@ -0,0 +1,212 @@
+#include "Mvria.h"
+#include <stdio.h>
+#include <math.h>
+
+/*
+  Fills an MvrScan the way the laser drivers do and checks that the
+  arrays, and the MvrSensorReading list MvrRangeDevice::getRawReadings()
+  builds from them, match readings filled in one at a time with
+  MvrSensorReading::newData(), including after a transform is applied
+  and after one scan is swapped in for another.  Then times filling a
+  scan against filling the old list of readings.
+*/
+
+const int numReadings = 541;
+const int scansToTime = 10000;
+
+// a range device whose raw scan can be filled in from out here
+class TestDevice : public MvrRangeDevice
+{
+public:
+  TestDevice() : MvrRangeDevice(100, 100, "scanTest", 30000) {}
+  MvrScan *getScan(void) { return &myRawScan; }
+};
+
+bool sameValue(double a, double b) { return fabs(a - b) < 1e-6; }
+
+int main(int argc, char **argv)
+{
+  Mvria::init();
+  TestDevice device;
+  MvrScan *scan = device.getScan();
+  std::vector<MvrSensorReading> want(numReadings);
+  std::list<MvrSensorReading *>::const_iterator it;
+  const std::list<MvrSensorReading *> *readings;
+  MvrPose pose(1000, -500, 33);
+  MvrPose encoderPose(10, 20, 5);
+  MvrTransform toGlobal(pose);
+  MvrTransform moved(MvrPose(5, 6, 7), MvrPose(-30, 40, 10));
+  MvrTime time;
+  MvrTime readingTime;
+  bool failed = false;
+  double th;
+  int range;
+  int i;
+  int j;
+  unsigned long long start;
+
+  // like sonar and bumpers, a device that's never had a scan has no
+  // raw readings at all
+  readings = device.getRawReadings();
+  if (readings != NULL)
+  {
+    printf("FAILED: a device with no scan yet should have NULL raw readings\n");
+    Mvria::exit(1);
+  }
+
+  scan->setNumReadings(numReadings);
+  scan->beginScan(pose, encoderPose, toGlobal, 77, time);
+  for (i = 0; i < numReadings; i++)
+  {
+    th = -135 + i * .5;
+    range = 500 + 13 * i;
+    scan->setReading(i, range, 120, -7, th, i % 17 == 0, i & 0xff);
+    readingTime = time;
+    // every other one came in earlier, like a deinterlaced LMS2xx
+    if (i % 2 == 1)
+    {
+      scan->setTimeOffset(i, -14);
+      readingTime.addMSec(-14);
+    }
+    want[i].resetSensorPosition(120, -7, th);
+    want[i].newData(range, pose, encoderPose, toGlobal, 77, readingTime,
+		    i % 17 == 0, i & 0xff);
+  }
+  scan->endScan();
+  scan->applyTransform(moved);
+  for (i = 0; i < numReadings; i++)
+    want[i].applyTransform(moved);
+
+  readings = device.getRawReadings();
+  if (readings == NULL || (int)readings->size() != numReadings)
+  {
+    printf("FAILED: should have %d raw readings\n", numReadings);
+    Mvria::exit(1);
+  }
+  if (device.getRawReadings() != readings)
+  {
+    printf("FAILED: the raw readings shouldn't be rebuilt if the scan didn't change\n");
+    failed = true;
+  }
+  for (it = readings->begin(), i = 0; it != readings->end() && !failed;
+       it++, i++)
+  {
+    if (!sameValue((*it)->getX(), want[i].getX()) ||
+	!sameValue((*it)->getY(), want[i].getY()) ||
+	!sameValue(scan->getX(i), want[i].getX()) ||
+	!sameValue(scan->getY(i), want[i].getY()) ||
+	!sameValue(scan->getLocalX(i), want[i].getLocalX()) ||
+	!sameValue(scan->getLocalY(i), want[i].getLocalY()) ||
+	!sameValue((*it)->getSensorTh(), want[i].getSensorTh()) ||
+	(*it)->getRange() != want[i].getRange() ||
+	(*it)->getIgnoreThisReading() != want[i].getIgnoreThisReading() ||
+	(*it)->getExtraInt() != want[i].getExtraInt() ||
+	(*it)->getTimeTaken().mSecSince(want[i].getTimeTaken()) != 0 ||
+	scan->getTimeTaken(i).mSecSince(want[i].getTimeTaken()) != 0 ||
+	(*it)->getPoseTaken().findDistanceTo(want[i].getPoseTaken()) > 1e-6 ||
+	scan->getPoseTaken().findDistanceTo(want[i].getPoseTaken()) > 1e-6)
+    {
+      printf("FAILED: reading %d is at %g %g (list %g %g), should be %g %g\n",
+	     i, scan->getX(i), scan->getY(i), (*it)->getX(), (*it)->getY(),
+	     want[i].getX(), want[i].getY());
+      failed = true;
+    }
+  }
+
+  // a transform on just the odd readings, like the second half of an
+  // interlaced scan corrected for the odometry delay
+  scan->applyTransform(moved, 1, 2);
+  scan->applyEncoderTransform(moved, 1, 2);
+  for (i = 1; i < numReadings; i += 2)
+  {
+    want[i].applyTransform(moved);
+    want[i].applyEncoderTransform(moved);
+  }
+  readings = device.getRawReadings();
+  for (it = readings->begin(), i = 0; it != readings->end() && !failed;
+       it++, i++)
+  {
+    if (!sameValue((*it)->getX(), want[i].getX()) ||
+	!sameValue((*it)->getY(), want[i].getY()) ||
+	!sameValue(scan->getX(i), want[i].getX()) ||
+	!sameValue(scan->getY(i), want[i].getY()) ||
+	(*it)->getPoseTaken().findDistanceTo(want[i].getPoseTaken()) > 1e-6 ||
+	(*it)->getEncoderPoseTaken().findDistanceTo(
+		want[i].getEncoderPoseTaken()) > 1e-6)
+    {
+      printf("FAILED: reading %d is at %g %g after transforming the odd readings, should be %g %g\n",
+	     i, (*it)->getX(), (*it)->getY(), want[i].getX(), want[i].getY());
+      failed = true;
+    }
+  }
+  if (scan->getPoseTaken().findDistanceTo(want[0].getPoseTaken()) > 1e-6 ||
+      scan->getEncoderPoseTaken().findDistanceTo(
+	      want[0].getEncoderPoseTaken()) > 1e-6)
+  {
+    printf("FAILED: transforming the odd readings moved where the scan was taken\n");
+    failed = true;
+  }
+
+  // build a short scan on the side and swap it in
+  MvrScan assemble;
+  assemble.setNumReadings(3);
+  assemble.beginScan(pose, encoderPose, toGlobal, 78, time);
+  for (i = 0; i < 3; i++)
+    assemble.setReading(i, 100 + i, 0, 0, i);
+  scan->swapScan(&assemble);
+  scan->endScan();
+  readings = device.getRawReadings();
+  if (readings->size() != 3 || readings->front()->getRange() != 100 ||
+      readings->back()->getRange() != 102 ||
+      assemble.getNumReadings() != numReadings)
+  {
+    printf("FAILED: swapping in a scan of 3 readings\n");
+    failed = true;
+  }
+  // the vector has always been in the opposite order from the list
+  std::vector<MvrSensorReading> *vec = device.getRawReadingsAsVector();
+  if (vec->size() != 3 || (*vec)[0].getRange() != 102 ||
+      (*vec)[2].getRange() != 100 ||
+      !sameValue((*vec)[0].getX(), readings->back()->getX()))
+  {
+    printf("FAILED: the raw readings as a vector\n");
+    failed = true;
+  }
+
+  // time filling a scan against filling the list the old way
+  std::list<MvrSensorReading *> list;
+  for (i = 0; i < numReadings; i++)
+    list.push_back(new MvrSensorReading);
+  scan->setNumReadings(numReadings);
+  start = MvrUtil::getTimeUSec();
+  for (j = 0; j < scansToTime; j++)
+  {
+    for (it = list.begin(), i = 0; it != list.end(); it++, i++)
+    {
+      (*it)->resetSensorPosition(120, -7, -135 + i * .5);
+      (*it)->newData(500 + i + j, pose, encoderPose, toGlobal, j, time);
+    }
+  }
+  printf("List of readings: %7.2f us per %d reading scan\n",
+	 (MvrUtil::getTimeUSec() - start) / (double)scansToTime, numReadings);
+  start = MvrUtil::getTimeUSec();
+  for (j = 0; j < scansToTime; j++)
+  {
+    scan->beginScan(pose, encoderPose, toGlobal, j, time);
+    for (i = 0; i < numReadings; i++)
+      scan->setReading(i, 500 + i + j, 120, -7, -135 + i * .5);
+    scan->endScan();
+  }
+  printf("MvrScan:          %7.2f us per %d reading scan\n",
+	 (MvrUtil::getTimeUSec() - start) / (double)scansToTime, numReadings);
+  MvrUtil::deleteSet(list.begin(), list.end());
+
+  if (failed)
+  {
+    printf("scanTest FAILED\n");
+    Mvria::exit(1);
+  }
+  printf("scanTest passed\n");
+  Mvria::exit(0);
+  return 0;
+}
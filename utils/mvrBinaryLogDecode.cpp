@@ -0,0 +1,40 @@
+#include "Mvria.h"
+#include <stdio.h>
+#include <string.h>
+
+/*
+  Turns a binary log written by MvrBinaryLog::open() back into the
+  text MvrLog would have written, on stdout.
+
+  Usage: mvrBinaryLogDecode [-noTime] <binaryLogFile>
+*/
+
+int main(int argc, char **argv)
+{
+  bool logTime = true;
+  const char *fileName = NULL;
+  int i;
+
+  for (i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "-noTime") == 0)
+      logTime = false;
+    else if (fileName == NULL)
+      fileName = argv[i];
+    else
+    {
+      fileName = NULL;
+      break;
+    }
+  }
+  if (fileName == NULL)
+  {
+    fprintf(stderr, "Usage: %s [-noTime] <binaryLogFile>\n", argv[0]);
+    return 1;
+  }
+
+  MvrLog::init(MvrLog::StdErr, MvrLog::Normal, "", false, false, false);
+  if (!MvrBinaryLog::decodeFile(fileName, stdout, logTime))
+    return 1;
+  return 0;
+}